@@ -186,6 +186,11 @@ endmacro()
 # This function sets the following variables in its parent scope:
 #     LINEAR_ALGEBRA_LIBRARIES  will be set as required to add libraries required for linear algebra
 #
+# With an external BLAS, it also checks for functions that set the
+# number of threads used by the library, setting the cache variables
+#     HAVE_OPENBLAS_SET_NUM_THREADS
+#     HAVE_MKL_SET_NUM_THREADS
+#
 function(gmxManageLinearAlgebraLibraries)
     include(CheckFunctionExists)
     # Probably not necessary to unset, but let's be clear about usage.
@@ -195,6 +200,18 @@ function(gmxManageLinearAlgebraLibraries)
     set(BLAS_FIND_QUIETLY ON)
     manage_linear_algebra_library(LAPACK cheev_)
 
+    # Multi-threaded BLAS libraries should use a single thread when
+    # called from our own OpenMP loops.
+    if(GMX_EXTERNAL_BLAS)
+        set(CMAKE_REQUIRED_LIBRARIES ${LINEAR_ALGEBRA_LIBRARIES})
+        if(HAVE_LIBMKL)
+            list(APPEND CMAKE_REQUIRED_LIBRARIES ${FFT_LIBRARIES})
+            set(CMAKE_REQUIRED_FLAGS "${FFT_LINKER_FLAGS}")
+        endif()
+        check_function_exists(openblas_set_num_threads HAVE_OPENBLAS_SET_NUM_THREADS)
+        check_function_exists(mkl_set_num_threads HAVE_MKL_SET_NUM_THREADS)
+    endif()
+
     # Propagate the new local value to the parent scope
     set(LINEAR_ALGEBRA_LIBRARIES "${LINEAR_ALGEBRA_LIBRARIES}" PARENT_SCOPE)
 endfunction()
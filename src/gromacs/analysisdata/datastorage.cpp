@@ -55,6 +55,7 @@
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/mutex.h"
 
 namespace gmx
 {
@@ -270,6 +271,15 @@ class AnalysisDataStorageImpl
          * frame (see \a frames_).
          */
         int                     nextIndex_;
+        /*! \brief
+         * Protects \a frames_ and \a builders_ when several frames are
+         * started and finished concurrently.
+         *
+         * Frames are only rotated out of the buffer in finishFrameSerial(),
+         * which is never called concurrently with other methods, so the
+         * contents of a started frame can be accessed without locking.
+         */
+        Mutex                   mutex_;
 };
 
 /********************************************************************
@@ -497,17 +507,26 @@ AnalysisDataStorageImpl::getFrameBuilder()
 void
 AnalysisDataStorageImpl::finishFrame(int index)
 {
-    const int storageIndex = computeStorageLocation(index);
-    GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
+    AnalysisDataStorageFrameData *storedFramePtr;
+    {
+        lock_guard<Mutex> lock(mutex_);
+        const int         storageIndex = computeStorageLocation(index);
+        GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
+        storedFramePtr = frames_[storageIndex].get();
+    }
 
-    AnalysisDataStorageFrameData &storedFrame = *frames_[storageIndex];
+    AnalysisDataStorageFrameData &storedFrame = *storedFramePtr;
     GMX_RELEASE_ASSERT(storedFrame.isStarted(),
                        "finishFrame() called for frame before startFrame()");
     GMX_RELEASE_ASSERT(!storedFrame.isFinished(),
                        "finishFrame() called twice for the same frame");
     GMX_RELEASE_ASSERT(storedFrame.frameIndex() == index,
                        "Inconsistent internal frame indexing");
-    builders_.push_back(storedFrame.finishFrame(isMultipoint()));
+    AnalysisDataFrameBuilderPointer builder(storedFrame.finishFrame(isMultipoint()));
+    {
+        lock_guard<Mutex> lock(mutex_);
+        builders_.push_back(std::move(builder));
+    }
     modules_->notifyParallelFrameFinish(storedFrame.header());
     if (pendingLimit_ == 1)
     {
@@ -868,29 +887,32 @@ AnalysisDataStorage::startFrame(const AnalysisDataFrameHeader &header)
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
     internal::AnalysisDataStorageFrameData *storedFrame;
-    if (impl_->storeAll())
     {
-        size_t size = header.index() + 1;
-        if (impl_->frames_.size() < size)
+        lock_guard<Mutex> lock(impl_->mutex_);
+        if (impl_->storeAll())
         {
-            impl_->extendBuffer(size);
+            size_t size = header.index() + 1;
+            if (impl_->frames_.size() < size)
+            {
+                impl_->extendBuffer(size);
+            }
+            storedFrame = impl_->frames_[header.index()].get();
         }
-        storedFrame = impl_->frames_[header.index()].get();
-    }
-    else
-    {
-        int storageIndex = impl_->computeStorageLocation(header.index());
-        if (storageIndex == -1)
+        else
         {
-            GMX_THROW(APIError("Out of bounds frame index"));
+            int storageIndex = impl_->computeStorageLocation(header.index());
+            if (storageIndex == -1)
+            {
+                GMX_THROW(APIError("Out of bounds frame index"));
+            }
+            storedFrame = impl_->frames_[storageIndex].get();
         }
-        storedFrame = impl_->frames_[storageIndex].get();
+        GMX_RELEASE_ASSERT(!storedFrame->isStarted(),
+                           "startFrame() called twice for the same frame");
+        GMX_RELEASE_ASSERT(storedFrame->frameIndex() == header.index(),
+                           "Inconsistent internal frame indexing");
+        storedFrame->startFrame(header, impl_->getFrameBuilder());
     }
-    GMX_RELEASE_ASSERT(!storedFrame->isStarted(),
-                       "startFrame() called twice for the same frame");
-    GMX_RELEASE_ASSERT(storedFrame->frameIndex() == header.index(),
-                       "Inconsistent internal frame indexing");
-    storedFrame->startFrame(header, impl_->getFrameBuilder());
     impl_->modules_->notifyParallelFrameStart(header);
     if (impl_->shouldNotifyImmediately())
     {
@@ -910,10 +932,15 @@ AnalysisDataStorage::startFrame(int index, real x, real dx)
 AnalysisDataStorageFrame &
 AnalysisDataStorage::currentFrame(int index)
 {
-    const int storageIndex = impl_->computeStorageLocation(index);
-    GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
+    internal::AnalysisDataStorageFrameData *storedFramePtr;
+    {
+        lock_guard<Mutex> lock(impl_->mutex_);
+        const int         storageIndex = impl_->computeStorageLocation(index);
+        GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
+        storedFramePtr = impl_->frames_[storageIndex].get();
+    }
 
-    internal::AnalysisDataStorageFrameData &storedFrame = *impl_->frames_[storageIndex];
+    internal::AnalysisDataStorageFrameData &storedFrame = *storedFramePtr;
     GMX_RELEASE_ASSERT(storedFrame.isStarted(),
                        "currentFrame() called for frame before startFrame()");
     GMX_RELEASE_ASSERT(!storedFrame.isFinished(),
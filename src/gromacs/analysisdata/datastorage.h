@@ -257,8 +257,11 @@ class AnalysisDataStorageFrame
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * With startParallelDataStorage(), startFrame(), currentFrame(), and
+ * finishFrame() (and the methods in AnalysisDataStorageFrame) can be called
+ * concurrently from multiple threads, as long as each thread operates on a
+ * different frame.  finishFrameSerial() and the other methods must not be
+ * called concurrently with any other method.
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
@@ -50,6 +50,7 @@
 
 #include "gromacs/analysisdata/dataframe.h"
 #include "gromacs/analysisdata/datastorage.h"
+#include "gromacs/analysisdata/framelocaldata.h"
 
 #include "frameaverager.h"
 
@@ -66,7 +67,7 @@ class AnalysisDataAverageModule::Impl
         Impl() : bDataSets_(false) {}
 
         //! Averaging helper objects for each input data set.
-        std::vector<AnalysisDataFrameAverager>  averagers_;
+        AnalysisDataParallelAverager            averagers_;
         //! Whether to average all columns in a data set into a single value.
         bool                                    bDataSets_;
 };
@@ -91,28 +92,32 @@ int AnalysisDataAverageModule::flags() const
            | efAllowMultipleDataSets;
 }
 
-void
-AnalysisDataAverageModule::dataStarted(AbstractAnalysisData *data)
+bool
+AnalysisDataAverageModule::parallelDataStarted(
+        AbstractAnalysisData              *data,
+        const AnalysisDataParallelOptions &options)
 {
     if (impl_->bDataSets_)
     {
         setColumnCount(1);
         setRowCount(data->dataSetCount());
-        impl_->averagers_.resize(1);
-        impl_->averagers_[0].setColumnCount(data->dataSetCount());
+        impl_->averagers_.setAveragerCount(1);
+        impl_->averagers_.setColumnCount(0, data->dataSetCount());
     }
     else
     {
         setColumnCount(data->dataSetCount());
-        impl_->averagers_.resize(data->dataSetCount());
+        impl_->averagers_.setAveragerCount(data->dataSetCount());
         int rowCount = 0;
         for (int i = 0; i < data->dataSetCount(); ++i)
         {
-            impl_->averagers_[i].setColumnCount(data->columnCount(i));
+            impl_->averagers_.setColumnCount(i, data->columnCount(i));
             rowCount = std::max(rowCount, data->columnCount(i));
         }
         setRowCount(rowCount);
     }
+    impl_->averagers_.init(options);
+    return true;
 }
 
 void
@@ -125,18 +130,21 @@ AnalysisDataAverageModule::pointsAdded(const AnalysisDataPointSetRef &points)
 {
     if (impl_->bDataSets_)
     {
-        const int dataSet = points.dataSetIndex();
+        const int                  dataSet  = points.dataSetIndex();
+        AnalysisDataFrameAverager &averager =
+            impl_->averagers_.frameAverager(points.frameIndex(), 0);
         for (int i = 0; i < points.columnCount(); ++i)
         {
             if (points.present(i))
             {
-                impl_->averagers_[0].addValue(dataSet, points.y(i));
+                averager.addValue(dataSet, points.y(i));
             }
         }
     }
     else
     {
-        impl_->averagers_[points.dataSetIndex()].addPoints(points);
+        impl_->averagers_.frameAverager(points.frameIndex(), points.dataSetIndex())
+            .addPoints(points);
     }
 }
 
@@ -145,18 +153,24 @@ AnalysisDataAverageModule::frameFinished(const AnalysisDataFrameHeader & /*heade
 {
 }
 
+void
+AnalysisDataAverageModule::frameFinishedSerial(int /*frameIndex*/)
+{
+}
+
 void
 AnalysisDataAverageModule::dataFinished()
 {
+    impl_->averagers_.finish();
     allocateValues();
     for (int i = 0; i < columnCount(); ++i)
     {
-        impl_->averagers_[i].finish();
+        const AnalysisDataFrameAverager &averager = impl_->averagers_.averager(i);
         int j = 0;
-        for (; j < impl_->averagers_[i].columnCount(); ++j)
+        for (; j < averager.columnCount(); ++j)
         {
-            value(j, i).setValue(impl_->averagers_[i].average(j),
-                                 std::sqrt(impl_->averagers_[i].variance(j)));
+            value(j, i).setValue(averager.average(j),
+                                 std::sqrt(averager.variance(j)));
         }
         for (; j < rowCount(); ++j)
         {
@@ -196,7 +210,7 @@ int AnalysisDataAverageModule::sampleCount(int dataSet, int column) const
                    "Column should be zero with setAverageDataSets(true)");
         std::swap(dataSet, column);
     }
-    return impl_->averagers_[dataSet].sampleCount(column);
+    return impl_->averagers_.averager(dataSet).sampleCount(column);
 }
 
 
@@ -207,10 +221,13 @@ int AnalysisDataAverageModule::sampleCount(int dataSet, int column) const
 class AnalysisDataFrameAverageModule::Impl
 {
     public:
+        //! Shorthand for the per-frame sample count data structure type.
+        typedef AnalysisDataFrameLocalData<int> FrameLocalData;
+
         //! Storage implementation object.
         AnalysisDataStorage     storage_;
         //! Number of samples in a frame for each data set.
-        std::vector<int>        sampleCount_;
+        FrameLocalData          sampleCount_;
 };
 
 AnalysisDataFrameAverageModule::AnalysisDataFrameAverageModule()
@@ -235,21 +252,25 @@ AnalysisDataFrameAverageModule::flags() const
            | efAllowMultipleDataSets;
 }
 
-void
-AnalysisDataFrameAverageModule::dataStarted(AbstractAnalysisData *data)
+bool
+AnalysisDataFrameAverageModule::parallelDataStarted(
+        AbstractAnalysisData              *data,
+        const AnalysisDataParallelOptions &options)
 {
     setColumnCount(0, data->dataSetCount());
-    impl_->sampleCount_.resize(data->dataSetCount());
-    impl_->storage_.startDataStorage(this, &moduleManager());
+    impl_->sampleCount_.setColumnCount(0, data->dataSetCount());
+    impl_->sampleCount_.init(options);
+    impl_->storage_.startParallelDataStorage(this, &moduleManager(), options);
+    return true;
 }
 
 void
 AnalysisDataFrameAverageModule::frameStarted(const AnalysisDataFrameHeader &header)
 {
     AnalysisDataStorageFrame &frame = impl_->storage_.startFrame(header);
+    impl_->sampleCount_.frameData(header.index()).clear();
     for (int i = 0; i < columnCount(); ++i)
     {
-        impl_->sampleCount_[i] = 0;
         frame.setValue(i, 0.0);
     }
 }
@@ -260,6 +281,8 @@ AnalysisDataFrameAverageModule::pointsAdded(const AnalysisDataPointSetRef &point
     const int                 dataSet = points.dataSetIndex();
     AnalysisDataStorageFrame &frame   =
         impl_->storage_.currentFrame(points.frameIndex());
+    int                      &samples =
+        impl_->sampleCount_.frameDataSet(points.frameIndex(), 0).value(dataSet);
     for (int i = 0; i < points.columnCount(); ++i)
     {
         if (points.present(i))
@@ -267,8 +290,8 @@ AnalysisDataFrameAverageModule::pointsAdded(const AnalysisDataPointSetRef &point
             // TODO: Consider using AnalysisDataFrameAverager
             const real y     = points.y(i);
             const real delta = y - frame.value(dataSet);
-            impl_->sampleCount_[dataSet] += 1;
-            frame.value(dataSet)         += delta / impl_->sampleCount_[dataSet];
+            samples              += 1;
+            frame.value(dataSet) += delta / samples;
         }
     }
 }
@@ -279,6 +302,12 @@ AnalysisDataFrameAverageModule::frameFinished(const AnalysisDataFrameHeader &hea
     impl_->storage_.finishFrame(header.index());
 }
 
+void
+AnalysisDataFrameAverageModule::frameFinishedSerial(int frameIndex)
+{
+    impl_->storage_.finishFrameSerial(frameIndex);
+}
+
 void
 AnalysisDataFrameAverageModule::dataFinished()
 {
@@ -80,7 +80,7 @@ namespace gmx
  * \ingroup module_analysisdata
  */
 class AnalysisDataAverageModule : public AbstractAnalysisArrayData,
-                                  public AnalysisDataModuleSerial
+                                  public AnalysisDataModuleParallel
 {
     public:
         AnalysisDataAverageModule();
@@ -105,10 +105,13 @@ class AnalysisDataAverageModule : public AbstractAnalysisArrayData,
 
         virtual int flags() const;
 
-        virtual void dataStarted(AbstractAnalysisData *data);
+        virtual bool parallelDataStarted(
+            AbstractAnalysisData              *data,
+            const AnalysisDataParallelOptions &options);
         virtual void frameStarted(const AnalysisDataFrameHeader &header);
         virtual void pointsAdded(const AnalysisDataPointSetRef &points);
         virtual void frameFinished(const AnalysisDataFrameHeader &header);
+        virtual void frameFinishedSerial(int frameIndex);
         virtual void dataFinished();
 
         /*! \brief
@@ -162,7 +165,7 @@ typedef boost::shared_ptr<AnalysisDataAverageModule>
  * \ingroup module_analysisdata
  */
 class AnalysisDataFrameAverageModule : public AbstractAnalysisData,
-                                       public AnalysisDataModuleSerial
+                                       public AnalysisDataModuleParallel
 {
     public:
         AnalysisDataFrameAverageModule();
@@ -172,10 +175,13 @@ class AnalysisDataFrameAverageModule : public AbstractAnalysisData,
 
         virtual int flags() const;
 
-        virtual void dataStarted(AbstractAnalysisData *data);
+        virtual bool parallelDataStarted(
+            AbstractAnalysisData              *data,
+            const AnalysisDataParallelOptions &options);
         virtual void frameStarted(const AnalysisDataFrameHeader &header);
         virtual void pointsAdded(const AnalysisDataPointSetRef &points);
         virtual void frameFinished(const AnalysisDataFrameHeader &header);
+        virtual void frameFinishedSerial(int frameIndex);
         virtual void dataFinished();
 
     private:
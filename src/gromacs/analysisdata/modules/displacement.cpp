@@ -43,12 +43,18 @@
 
 #include "displacement.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/analysisdata/dataframe.h"
 #include "gromacs/analysisdata/datamodulemanager.h"
 #include "gromacs/analysisdata/modules/histogram.h"
+#include "gromacs/correlationfunctions/meansquaredisplacement.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 namespace gmx
@@ -69,12 +75,23 @@ class AnalysisDataDisplacementModule::Impl
         Impl();
         ~Impl();
 
+        /*! \brief
+         * Computes displacements over all time origins from stored values.
+         *
+         * Fills \p msd with the averaged squared displacement of each
+         * particle (columns) for each time difference from one up to
+         * \p nlag (rows).
+         */
+        void computeAllOriginDisplacements(int nlag, std::vector<real> *msd) const;
+
         //! Maximum number of particles for which the displacements are calculated.
         int                     nmax;
         //! Maximum time for which the displacements are needed.
         real                    tmax;
         //! Number of dimensions per data point.
         int                     ndim;
+        //! Whether to compute displacements over all time origins at the end.
+        bool                    bAllOrigins;
 
         //! true if no frames have been read.
         bool                    bFirst;
@@ -101,7 +118,7 @@ class AnalysisDataDisplacementModule::Impl
 };
 
 AnalysisDataDisplacementModule::Impl::Impl()
-    : nmax(0), tmax(0.0), ndim(3),
+    : nmax(0), tmax(0.0), ndim(3), bAllOrigins(false),
       bFirst(true), t0(0.0), dt(0.0), t(0.0), ci(0),
       max_store(-1), nstored(0), oldval(NULL),
       histm(NULL)
@@ -113,6 +130,44 @@ AnalysisDataDisplacementModule::Impl::~Impl()
     sfree(oldval);
 }
 
+void
+AnalysisDataDisplacementModule::Impl::computeAllOriginDisplacements(
+        int nlag, std::vector<real> *msd) const
+{
+    const int nparticles = nmax / ndim;
+    msd->assign(nlag * nparticles, 0.0);
+    // Each particle is written to separate columns, so the result does not
+    // depend on how the particles are divided over the threads.
+#pragma omp parallel
+    {
+        gmx_msd_fft_t     fft;
+        int               status = gmx_msd_fft_init(&fft, nstored, ndim);
+        if (status != 0)
+        {
+            gmx_fatal(FARGS, "Invalid fft return status %d", status);
+        }
+        std::vector<real> result(nstored);
+#pragma omp for schedule(static)
+        for (int p = 0; p < nparticles; ++p)
+        {
+            try
+            {
+                for (int d = 0; d < ndim; ++d)
+                {
+                    gmx_msd_fft_set_component(fft, d, &oldval[p * ndim + d], nmax);
+                    gmx_msd_fft_correlate(fft, d, d, &result[0]);
+                    for (int k = 1; k <= nlag; ++k)
+                    {
+                        (*msd)[(k - 1) * nparticles + p] += result[k];
+                    }
+                }
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+        gmx_msd_fft_destroy(fft);
+    }
+}
+
 /********************************************************************
  * AnalysisDataDisplacementModule
  */
@@ -136,6 +191,13 @@ AnalysisDataDisplacementModule::setMaxTime(real tmax)
 }
 
 
+void
+AnalysisDataDisplacementModule::setAllTimeOrigins(bool bAllOrigins)
+{
+    _impl->bAllOrigins = bAllOrigins;
+}
+
+
 void
 AnalysisDataDisplacementModule::setMSDHistogram(
         AnalysisDataBinAverageModulePointer histm)
@@ -209,6 +271,21 @@ AnalysisDataDisplacementModule::frameStarted(const AnalysisDataFrameHeader &head
     }
     _impl->t = header.x();
 
+    // With all time origins, store the positions for all the frames.
+    if (_impl->bAllOrigins)
+    {
+        _impl->ci = _impl->nstored * _impl->nmax;
+        if (_impl->ci + _impl->nmax > _impl->max_store)
+        {
+            _impl->max_store = std::max(2 * _impl->max_store,
+                                        _impl->ci + _impl->nmax);
+            srenew(_impl->oldval, _impl->max_store);
+        }
+        _impl->nstored++;
+        _impl->bFirst = false;
+        return;
+    }
+
     // Allocate memory for all the positions once it is possible.
     if (_impl->max_store == -1 && !_impl->bFirst)
     {
@@ -252,7 +329,7 @@ AnalysisDataDisplacementModule::pointsAdded(const AnalysisDataPointSetRef &point
 void
 AnalysisDataDisplacementModule::frameFinished(const AnalysisDataFrameHeader & /*header*/)
 {
-    if (_impl->nstored <= 1)
+    if (_impl->bAllOrigins || _impl->nstored <= 1)
     {
         return;
     }
@@ -304,6 +381,37 @@ AnalysisDataDisplacementModule::frameFinished(const AnalysisDataFrameHeader & /*
 void
 AnalysisDataDisplacementModule::dataFinished()
 {
+    if (_impl->bAllOrigins && _impl->nstored >= 2)
+    {
+        int nlag = _impl->nstored - 1;
+        if (_impl->tmax > 0)
+        {
+            nlag = std::min(nlag, static_cast<int>(_impl->tmax/_impl->dt));
+        }
+        std::vector<real> msd;
+        _impl->computeAllOriginDisplacements(nlag, &msd);
+
+        if (_impl->histm)
+        {
+            _impl->histm->init(histogramFromBins(0, nlag + 1, _impl->dt).integerBins());
+        }
+        moduleManager().notifyDataStart(this);
+        AnalysisDataFrameHeader header(0, _impl->t, 0);
+        moduleManager().notifyFrameStart(header);
+        const int nparticles = _impl->nmax / _impl->ndim;
+        for (int step = 1; step <= nlag; ++step)
+        {
+            _impl->currValues_.clear();
+            _impl->currValues_.push_back(AnalysisDataValue(step * _impl->dt));
+            for (int p = 0; p < nparticles; ++p)
+            {
+                _impl->currValues_.push_back(
+                        AnalysisDataValue(msd[(step - 1) * nparticles + p]));
+            }
+            moduleManager().notifyPointsAdd(AnalysisDataPointSetRef(header, _impl->currValues_));
+        }
+        moduleManager().notifyFrameFinish(header);
+    }
     if (_impl->nstored >= 2)
     {
         moduleManager().notifyDataFinish();
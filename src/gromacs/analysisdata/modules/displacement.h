@@ -61,6 +61,9 @@ class AnalysisDataBinAverageModule;
  * The first column contains the time difference (backwards from the current
  * frame), and the remaining columns the sizes of the displacements.
  *
+ * With setAllTimeOrigins(), the output is instead produced for all time
+ * origins at once after all the input has been processed.
+ *
  * Current implementation is not very generic, but should be easy to extend.
  *
  * \inpublicapi
@@ -77,6 +80,21 @@ class AnalysisDataDisplacementModule : public AbstractAnalysisData,
          * Sets the largest displacement time to be calculated.
          */
         void setMaxTime(real tmax);
+        /*! \brief
+         * Sets whether to average the displacements over all time origins.
+         *
+         * If set, the module stores the input for all frames, and produces
+         * no output until dataFinished().  It then produces a single frame,
+         * with one point for each time difference up to the maximum time
+         * (or up to the length of the data if no maximum time is set).
+         * Each point holds the squared displacements of the particles,
+         * averaged over all possible time origins.  These are computed with
+         * FFTs, which costs O(T log T) per particle for T frames, with the
+         * particles divided over OpenMP threads.
+         *
+         * Must be called before the data is started.
+         */
+        void setAllTimeOrigins(bool bAllOrigins);
         /*! \brief
          * Sets an histogram module that will receive a MSD histogram.
          *
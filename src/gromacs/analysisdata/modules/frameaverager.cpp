@@ -34,7 +34,8 @@
  */
 /*! \internal \file
  * \brief
- * Implements gmx::AnalysisDataFrameAverager.
+ * Implements gmx::AnalysisDataFrameAverager and
+ * gmx::AnalysisDataParallelAverager.
  *
  * \author Teemu Murtola <teemu.murtola@gmail.com>
  * \ingroup module_analysisdata
@@ -44,6 +45,7 @@
 #include "frameaverager.h"
 
 #include "gromacs/analysisdata/dataframe.h"
+#include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/gmxassert.h"
 
 namespace gmx
@@ -81,9 +83,87 @@ void AnalysisDataFrameAverager::addPoints(const AnalysisDataPointSetRef &points)
 
 }
 
+void AnalysisDataFrameAverager::combine(const AnalysisDataFrameAverager &other)
+{
+    GMX_RELEASE_ASSERT(other.values_.size() == values_.size(),
+                       "Cannot combine averagers with different column counts");
+    GMX_ASSERT(!bFinished_ && !other.bFinished_,
+               "Cannot combine averagers after finish()");
+    for (size_t i = 0; i < values_.size(); ++i)
+    {
+        AverageItem       &item      = values_[i];
+        const AverageItem &otherItem = other.values_[i];
+        if (otherItem.samples == 0)
+        {
+            continue;
+        }
+        // Combines the averages and the sums of squared deviations
+        // (Chan et al., 1979).
+        const int    samples = item.samples + otherItem.samples;
+        const double delta   = otherItem.average - item.average;
+        item.average    += delta * otherItem.samples / samples;
+        item.squaredSum += otherItem.squaredSum
+            + delta * delta * item.samples * otherItem.samples / samples;
+        item.samples     = samples;
+    }
+}
+
 void AnalysisDataFrameAverager::finish()
 {
     bFinished_ = true;
 }
 
+/********************************************************************
+ * AnalysisDataParallelAverager
+ */
+
+void AnalysisDataParallelAverager::setAveragerCount(int averagerCount)
+{
+    GMX_RELEASE_ASSERT(!isInitialized(),
+                       "Cannot change averager count after init()");
+    GMX_RELEASE_ASSERT(averagerCount >= 0, "Invalid averager count");
+    columnCounts_.resize(averagerCount);
+}
+
+void AnalysisDataParallelAverager::setColumnCount(int index, int columnCount)
+{
+    GMX_RELEASE_ASSERT(!isInitialized(),
+                       "Cannot change column count after init()");
+    GMX_RELEASE_ASSERT(index >= 0 && index < averagerCount(),
+                       "Invalid averager index");
+    columnCounts_[index] = columnCount;
+}
+
+void AnalysisDataParallelAverager::init(const AnalysisDataParallelOptions &opt)
+{
+    GMX_RELEASE_ASSERT(!isInitialized(), "init() called multiple times");
+    averagers_.resize(opt.parallelizationFactor());
+    for (size_t i = 0; i < averagers_.size(); ++i)
+    {
+        averagers_[i].resize(columnCounts_.size());
+        for (size_t j = 0; j < columnCounts_.size(); ++j)
+        {
+            averagers_[i][j].setColumnCount(columnCounts_[j]);
+        }
+    }
+}
+
+void AnalysisDataParallelAverager::finish()
+{
+    GMX_RELEASE_ASSERT(isInitialized(), "finish() called before init()");
+    std::vector<AnalysisDataFrameAverager> &result = averagers_[0];
+    for (size_t i = 1; i < averagers_.size(); ++i)
+    {
+        for (size_t j = 0; j < result.size(); ++j)
+        {
+            result[j].combine(averagers_[i][j]);
+        }
+    }
+    averagers_.resize(1);
+    for (size_t j = 0; j < result.size(); ++j)
+    {
+        result[j].finish();
+    }
+}
+
 } // namespace gmx
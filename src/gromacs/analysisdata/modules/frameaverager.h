@@ -34,7 +34,8 @@
  */
 /*! \internal \file
  * \brief
- * Declares gmx::AnalysisDataFrameAverager.
+ * Declares gmx::AnalysisDataFrameAverager and
+ * gmx::AnalysisDataParallelAverager.
  *
  * \author Teemu Murtola <teemu.murtola@gmail.com>
  * \ingroup module_analysisdata
@@ -50,6 +51,7 @@
 namespace gmx
 {
 
+class AnalysisDataParallelOptions;
 class AnalysisDataPointSetRef;
 
 /*! \internal
@@ -64,9 +66,9 @@ class AnalysisDataPointSetRef;
  * This class takes care of accumulating the values and computing their
  * variance.  It allows different number of samples for each input column.
  * Accumulation is always in double precision and uses a formula that is
- * relatively stable numerically.  For now, does nothing fancy,
- * but provides ground for other implementation (e.g., related to
- * parallelization) that would benefit all such modules.
+ * relatively stable numerically.  Averages accumulated separately (e.g., in
+ * different threads) can be merged with combine(); see
+ * AnalysisDataParallelAverager.
  *
  * Methods in this class do not throw unless otherwise indicated.
  *
@@ -110,6 +112,16 @@ class AnalysisDataFrameAverager
          * does not need to be called for every frame.
          */
         void addPoints(const AnalysisDataPointSetRef &points);
+        /*! \brief
+         * Adds all values accumulated in another averager to this averager.
+         *
+         * \param[in] other  Averager to add (must have the same number of
+         *     columns, and finish() not called).
+         *
+         * The result is the same as if the values had been added to this
+         * averager directly, up to rounding.
+         */
+        void combine(const AnalysisDataFrameAverager &other);
         /*! \brief
          * Finalizes the calculation of the averages and variances.
          *
@@ -179,6 +191,97 @@ class AnalysisDataFrameAverager
         bool                     bFinished_;
 };
 
+/*! \internal
+ * \brief
+ * Set of frame averagers that supports parallel data processing.
+ *
+ * This class manages a set of AnalysisDataFrameAverager objects (typically,
+ * one for each input data set) for modules that average values over frames
+ * and support parallel processing.  The object is initialized by setting the
+ * number of averagers and the number of columns for each with
+ * setAveragerCount() and setColumnCount(), followed by a call to init(),
+ * typically in IAnalysisDataModule::parallelDataStarted().
+ *
+ * Like AnalysisDataFrameLocalData, the class keeps a separate copy of the
+ * averagers for each of the frames that may be processed concurrently.
+ * Values for a frame are accumulated into the copy returned by
+ * frameAverager(), which is selected by the frame index.  finish() then
+ * combines the copies in a fixed order, such that the result does not
+ * depend on how the frames were distributed to threads.
+ * With serial processing, there is only a single copy, and the results are
+ * identical to using AnalysisDataFrameAverager directly.
+ *
+ * Methods in this class do not throw except where indicated.
+ *
+ * \ingroup module_analysisdata
+ */
+class AnalysisDataParallelAverager
+{
+    public:
+        //! Whether init() has been called.
+        bool isInitialized() const { return !averagers_.empty(); }
+        //! Returns the number of averagers.
+        int averagerCount() const { return columnCounts_.size(); }
+
+        /*! \brief
+         * Sets the number of averagers.
+         *
+         * \throws std::bad_alloc if out of memory.
+         *
+         * Cannot be called after init().
+         */
+        void setAveragerCount(int averagerCount);
+        /*! \brief
+         * Sets the number of columns for an averager.
+         *
+         * Must be called for each averager.  Cannot be called after init().
+         */
+        void setColumnCount(int index, int columnCount);
+        /*! \brief
+         * Initializes the averagers to support specified parallelism.
+         *
+         * \throws std::bad_alloc if out of memory.
+         */
+        void init(const AnalysisDataParallelOptions &opt);
+
+        //! Returns an averager to accumulate the values for a frame into.
+        AnalysisDataFrameAverager &frameAverager(int frameIndex, int index)
+        {
+            GMX_ASSERT(frameIndex >= 0, "Invalid frame index");
+            GMX_ASSERT(isInitialized(), "Cannot access data before init()");
+            GMX_ASSERT(index >= 0 && index < averagerCount(),
+                       "Invalid averager index");
+            return averagers_[frameIndex % averagers_.size()][index];
+        }
+        /*! \brief
+         * Combines the values from all frames and finalizes the averages.
+         *
+         * Typically called from IAnalysisDataModule::dataFinished().
+         */
+        void finish();
+        /*! \brief
+         * Returns the combined averager.
+         *
+         * If called before finish(), the results are undefined.
+         */
+        const AnalysisDataFrameAverager &averager(int index) const
+        {
+            GMX_ASSERT(index >= 0 && index < averagerCount(),
+                       "Invalid averager index");
+            return averagers_[0][index];
+        }
+
+    private:
+        //! Number of columns for each averager.
+        std::vector<int>                                        columnCounts_;
+        /*! \brief
+         * Averagers for each concurrently processed frame.
+         *
+         * After finish(), the first element holds the combined values.
+         */
+        std::vector<std::vector<AnalysisDataFrameAverager> >    averagers_;
+};
+
 } // namespace gmx
 
 #endif
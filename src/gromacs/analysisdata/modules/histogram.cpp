@@ -429,7 +429,7 @@ namespace internal
  * \ingroup module_analysisdata
  */
 class BasicAverageHistogramModule : public AbstractAverageHistogram,
-                                    public AnalysisDataModuleSerial
+                                    public AnalysisDataModuleParallel
 {
     public:
         BasicAverageHistogramModule();
@@ -440,15 +440,18 @@ class BasicAverageHistogramModule : public AbstractAverageHistogram,
 
         virtual int flags() const;
 
-        virtual void dataStarted(AbstractAnalysisData *data);
+        virtual bool parallelDataStarted(
+            AbstractAnalysisData              *data,
+            const AnalysisDataParallelOptions &options);
         virtual void frameStarted(const AnalysisDataFrameHeader &header);
         virtual void pointsAdded(const AnalysisDataPointSetRef &points);
         virtual void frameFinished(const AnalysisDataFrameHeader &header);
+        virtual void frameFinishedSerial(int frameIndex);
         virtual void dataFinished();
 
     private:
         //! Averaging helper objects for each input data set.
-        std::vector<AnalysisDataFrameAverager> averagers_;
+        AnalysisDataParallelAverager averagers_;
 
         // Copy and assign disallowed by base.
 };
@@ -472,17 +475,21 @@ BasicAverageHistogramModule::flags() const
 }
 
 
-void
-BasicAverageHistogramModule::dataStarted(AbstractAnalysisData *data)
+bool
+BasicAverageHistogramModule::parallelDataStarted(
+        AbstractAnalysisData              *data,
+        const AnalysisDataParallelOptions &options)
 {
     setColumnCount(data->dataSetCount());
-    averagers_.resize(data->dataSetCount());
+    averagers_.setAveragerCount(data->dataSetCount());
     for (int i = 0; i < data->dataSetCount(); ++i)
     {
         GMX_RELEASE_ASSERT(rowCount() == data->columnCount(i),
                            "Inconsistent data sizes, something is wrong in the initialization");
-        averagers_[i].setColumnCount(data->columnCount(i));
+        averagers_.setColumnCount(i, data->columnCount(i));
     }
+    averagers_.init(options);
+    return true;
 }
 
 
@@ -495,7 +502,8 @@ BasicAverageHistogramModule::frameStarted(const AnalysisDataFrameHeader & /*head
 void
 BasicAverageHistogramModule::pointsAdded(const AnalysisDataPointSetRef &points)
 {
-    averagers_[points.dataSetIndex()].addPoints(points);
+    averagers_.frameAverager(points.frameIndex(), points.dataSetIndex())
+        .addPoints(points);
 }
 
 
@@ -505,17 +513,24 @@ BasicAverageHistogramModule::frameFinished(const AnalysisDataFrameHeader & /*hea
 }
 
 
+void
+BasicAverageHistogramModule::frameFinishedSerial(int /*frameIndex*/)
+{
+}
+
+
 void
 BasicAverageHistogramModule::dataFinished()
 {
+    averagers_.finish();
     allocateValues();
     for (int i = 0; i < columnCount(); ++i)
     {
-        averagers_[i].finish();
+        const AnalysisDataFrameAverager &averager = averagers_.averager(i);
         for (int j = 0; j < rowCount(); ++j)
         {
-            value(j, i).setValue(averagers_[i].average(j),
-                                 std::sqrt(averagers_[i].variance(j)));
+            value(j, i).setValue(averager.average(j),
+                                 std::sqrt(averager.variance(j)));
         }
     }
 }
@@ -952,7 +967,7 @@ class AnalysisDataBinAverageModule::Impl
         //! Histogram settings.
         AnalysisHistogramSettings               settings_;
         //! Averaging helper objects for each input data set.
-        std::vector<AnalysisDataFrameAverager>  averagers_;
+        AnalysisDataParallelAverager            averagers_;
 };
 
 AnalysisDataBinAverageModule::AnalysisDataBinAverageModule()
@@ -1001,15 +1016,19 @@ AnalysisDataBinAverageModule::flags() const
 }
 
 
-void
-AnalysisDataBinAverageModule::dataStarted(AbstractAnalysisData *data)
+bool
+AnalysisDataBinAverageModule::parallelDataStarted(
+        AbstractAnalysisData              *data,
+        const AnalysisDataParallelOptions &options)
 {
     setColumnCount(data->dataSetCount());
-    impl_->averagers_.resize(data->dataSetCount());
+    impl_->averagers_.setAveragerCount(data->dataSetCount());
     for (int i = 0; i < data->dataSetCount(); ++i)
     {
-        impl_->averagers_[i].setColumnCount(rowCount());
+        impl_->averagers_.setColumnCount(i, rowCount());
     }
+    impl_->averagers_.init(options);
+    return true;
 }
 
 
@@ -1029,7 +1048,8 @@ AnalysisDataBinAverageModule::pointsAdded(const AnalysisDataPointSetRef &points)
     int bin = settings().findBin(points.y(0));
     if (bin != -1)
     {
-        AnalysisDataFrameAverager &averager = impl_->averagers_[points.dataSetIndex()];
+        AnalysisDataFrameAverager &averager =
+            impl_->averagers_.frameAverager(points.frameIndex(), points.dataSetIndex());
         for (int i = 1; i < points.columnCount(); ++i)
         {
             averager.addValue(bin, points.y(i));
@@ -1044,14 +1064,20 @@ AnalysisDataBinAverageModule::frameFinished(const AnalysisDataFrameHeader & /*he
 }
 
 
+void
+AnalysisDataBinAverageModule::frameFinishedSerial(int /*frameIndex*/)
+{
+}
+
+
 void
 AnalysisDataBinAverageModule::dataFinished()
 {
+    impl_->averagers_.finish();
     allocateValues();
     for (int i = 0; i < columnCount(); ++i)
     {
-        AnalysisDataFrameAverager &averager = impl_->averagers_[i];
-        averager.finish();
+        const AnalysisDataFrameAverager &averager = impl_->averagers_.averager(i);
         for (int j = 0; j < rowCount(); ++j)
         {
             value(j, i).setValue(averager.average(j),
@@ -53,6 +53,7 @@
 #include <gtest/gtest.h>
 
 #include "gromacs/analysisdata/analysisdata.h"
+#include "gromacs/analysisdata/paralleloptions.h"
 
 #include "gromacs/analysisdata/tests/datatest.h"
 #include "testutils/testasserts.h"
@@ -234,6 +235,52 @@ TEST_F(AverageModuleTest, HandlesDataSetAveraging)
     ASSERT_NO_THROW_GMX(presentAllData(input, &data));
 }
 
+TEST_F(AverageModuleTest, HandlesParallelData)
+{
+    const AnalysisDataTestInput &input = MultiDataSetInputData::get();
+    gmx::AnalysisData            serialData;
+    gmx::AnalysisData            data;
+    ASSERT_NO_THROW_GMX(setupDataObject(input, &serialData));
+    ASSERT_NO_THROW_GMX(setupDataObject(input, &data));
+
+    gmx::AnalysisDataAverageModulePointer serialModule(
+            new gmx::AnalysisDataAverageModule);
+    serialData.addModule(serialModule);
+    gmx::AnalysisDataAverageModulePointer module(
+            new gmx::AnalysisDataAverageModule);
+    data.addModule(module);
+
+    ASSERT_NO_THROW_GMX(presentAllData(input, &serialData));
+    // Present the frames out of order through two handles, as is done when
+    // frames are processed in parallel.
+    gmx::AnalysisDataHandle          handle1;
+    gmx::AnalysisDataHandle          handle2;
+    gmx::AnalysisDataParallelOptions options(2);
+    ASSERT_NO_THROW_GMX(handle1 = data.startData(options));
+    ASSERT_NO_THROW_GMX(handle2 = data.startData(options));
+    ASSERT_NO_THROW_GMX(presentDataFrame(input, 1, handle1));
+    ASSERT_NO_THROW_GMX(presentDataFrame(input, 0, handle2));
+    ASSERT_NO_THROW_GMX(data.finishFrameSerial(0));
+    ASSERT_NO_THROW_GMX(data.finishFrameSerial(1));
+    ASSERT_NO_THROW_GMX(presentDataFrame(input, 2, handle1));
+    ASSERT_NO_THROW_GMX(data.finishFrameSerial(2));
+    ASSERT_NO_THROW_GMX(handle1.finishData());
+    ASSERT_NO_THROW_GMX(handle2.finishData());
+
+    for (int i = 0; i < input.dataSetCount(); ++i)
+    {
+        for (int j = 0; j < input.columnCount(i); ++j)
+        {
+            EXPECT_EQ(serialModule->sampleCount(i, j), module->sampleCount(i, j));
+            EXPECT_REAL_EQ_TOL(serialModule->average(i, j), module->average(i, j),
+                               gmx::test::ulpTolerance(10));
+            EXPECT_REAL_EQ_TOL(serialModule->standardDeviation(i, j),
+                               module->standardDeviation(i, j),
+                               gmx::test::ulpTolerance(10));
+        }
+    }
+}
+
 TEST_F(AverageModuleTest, CanCustomizeXAxis)
 {
     const AnalysisDataTestInput &input = SimpleInputData::get();
@@ -45,6 +45,7 @@
 #include "crosscorr.h"
 
 #include "gromacs/fft/fft.h"
+#include "gromacs/math/gmxcomplex.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -65,13 +66,12 @@ static int zeroPaddingSize(int n)
  * \param[in] in1 first complex number
  * \param[in] in2 second complex number
  */
-static void complexConjugatMult(double in1[], double in2[])
+static void complexConjugatMult(t_complex *in1, const t_complex *in2)
 {
-    double res[2];
-    res[0]  = in1[0] * in2[0] + in1[1] * in2[1];
-    res[1]  = in1[0] * -in2[1] + in1[1] * in2[0];
-    in1[0]  = res[0];
-    in1[1]  = res[1];
+    t_complex res;
+    res.re  = in1->re * in2->re + in1->im * in2->im;
+    res.im  = in1->re * -in2->im + in1->im * in2->re;
+    *in1    = res;
 }
 
 /*! \brief
@@ -87,29 +87,25 @@ static void cross_corr_low(int n, real f[], real g[], real corr[], gmx_fft_t fft
 {
     int             i;
     const int       size = zeroPaddingSize(n);
-    double    **    in1, ** in2;
+    t_complex      *in1, *in2;
+
+    /* The FFT routines work on contiguous arrays of complex numbers */
     snew(in1, size);
     snew(in2, size);
 
-    for (i = 0; i < size; i++)
-    {
-        snew(in1[i], 2);
-        snew(in2[i], 2);
-    }
-
     for (i = 0; i < n; i++)
     {
-        in1[i][0]  = (double)f[i];
-        in1[i][1]  = 0;
-        in2[i][0]  = (double)g[i];
-        in2[i][1]  = 0;
+        in1[i].re  = f[i];
+        in1[i].im  = 0;
+        in2[i].re  = g[i];
+        in2[i].im  = 0;
     }
     for (; i < size; i++)
     {
-        in1[i][0]  = 0;
-        in1[i][1]  = 0;
-        in2[i][0]  = 0;
-        in2[i][1]  = 0;
+        in1[i].re  = 0;
+        in1[i].im  = 0;
+        in2[i].re  = 0;
+        in2[i].im  = 0;
     }
 
 
@@ -118,20 +114,15 @@ static void cross_corr_low(int n, real f[], real g[], real corr[], gmx_fft_t fft
 
     for (i = 0; i < size; i++)
     {
-        complexConjugatMult(in1[i], in2[i]);
-        in1[i][0] /= size;
+        complexConjugatMult(&in1[i], &in2[i]);
+        in1[i].re /= size;
+        in1[i].im /= size;
     }
     gmx_fft_1d(fft, GMX_FFT_BACKWARD, in1, in1);
 
     for (i = 0; i < n; i++)
     {
-        corr[i] = (real)(in1[i][0]);
-    }
-
-    for (i = 0; i < size; i++)
-    {
-        sfree(in1[i]);
-        sfree(in2[i]);
+        corr[i] = in1[i].re;
     }
 
     sfree(in1);
@@ -0,0 +1,216 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal
+ * \file
+ * \brief
+ * Implements routines for computing mean square displacements over all
+ * time origins using FFTs
+ *
+ * \ingroup module_correlationfunctions
+ */
+#include "gmxpre.h"
+
+#include "meansquaredisplacement.h"
+
+#include "gromacs/fft/fft.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
+
+struct gmx_msd_fft
+{
+    int        nframes; /* Number of frames in a series */
+    int        nfft;    /* Zero-padded transform length */
+    int        ncomp;   /* Number of stored components */
+    gmx_fft_t  fft;     /* Real-to-complex setup of length nfft */
+    real     **x;       /* Mean-shifted values for each component */
+    real     **spec;    /* Transforms for each component, nfft+2 reals */
+    real      *work;    /* Work array for the inverse transform */
+};
+
+/*! \brief
+ * Returns the smallest length >= n with only factors 2, 3 and 5.
+ *
+ * All FFT libraries handle such lengths efficiently.  The result is even
+ * for any n >= 2, as required for the real-to-complex storage.
+ */
+static int fftFriendlySize(int n)
+{
+    for (;; n++)
+    {
+        int m = n;
+        while (m % 2 == 0)
+        {
+            m /= 2;
+        }
+        while (m % 3 == 0)
+        {
+            m /= 3;
+        }
+        while (m % 5 == 0)
+        {
+            m /= 5;
+        }
+        if (m == 1 && n % 2 == 0)
+        {
+            return n;
+        }
+    }
+}
+
+int gmx_msd_fft_init(gmx_msd_fft_t *msd, int nframes, int ncomp)
+{
+    gmx_msd_fft_t m;
+    int           i, status;
+
+    GMX_RELEASE_ASSERT(nframes > 0 && ncomp > 0, "Invalid series dimensions");
+    snew(m, 1);
+    m->nframes = nframes;
+    /* Padding to at least 2*nframes-1 avoids wrap-around in the
+     * circular correlation for all lags up to nframes-1.
+     */
+    m->nfft    = fftFriendlySize(2*nframes);
+    m->ncomp   = ncomp;
+    snew(m->x, ncomp);
+    snew(m->spec, ncomp);
+    for (i = 0; i < ncomp; i++)
+    {
+        snew(m->x[i], nframes);
+        snew(m->spec[i], m->nfft + 2);
+    }
+    snew(m->work, m->nfft + 2);
+    *msd   = m;
+
+    status = gmx_fft_init_1d_real(&m->fft, m->nfft, GMX_FFT_FLAG_CONSERVATIVE);
+    if (status != 0)
+    {
+        m->fft = NULL;
+    }
+    return status;
+}
+
+void gmx_msd_fft_set_component(gmx_msd_fft_t msd, int comp,
+                               const real *x, int stride)
+{
+    double mean;
+    real  *spec;
+    int    t;
+
+    GMX_ASSERT(comp >= 0 && comp < msd->ncomp, "Invalid component index");
+    mean = 0;
+    for (t = 0; t < msd->nframes; t++)
+    {
+        mean += x[t*stride];
+    }
+    mean /= msd->nframes;
+
+    spec = msd->spec[comp];
+    for (t = 0; t < msd->nframes; t++)
+    {
+        msd->x[comp][t] = x[t*stride] - mean;
+        spec[t]         = msd->x[comp][t];
+    }
+    for (; t < msd->nfft + 2; t++)
+    {
+        spec[t] = 0;
+    }
+    gmx_fft_1d_real(msd->fft, GMX_FFT_REAL_TO_COMPLEX, spec, spec);
+}
+
+void gmx_msd_fft_correlate(gmx_msd_fft_t msd, int comp1, int comp2,
+                           real result[])
+{
+    const real *x1    = msd->x[comp1];
+    const real *x2    = msd->x[comp2];
+    const real *spec1 = msd->spec[comp1];
+    const real *spec2 = msd->spec[comp2];
+    const int   n     = msd->nframes;
+    double      sum;
+    int         k, t;
+
+    GMX_ASSERT(comp1 >= 0 && comp1 < msd->ncomp
+               && comp2 >= 0 && comp2 < msd->ncomp, "Invalid component index");
+
+    /* The spectrum of sum_t a(t) b(t+k) + b(t) a(t+k) is
+     * conj(A) B + A conj(B) = 2 Re(conj(A) B), which is real.
+     */
+    for (k = 0; k <= msd->nfft/2; k++)
+    {
+        msd->work[2*k]   = 2*(spec1[2*k]*spec2[2*k] + spec1[2*k+1]*spec2[2*k+1]);
+        msd->work[2*k+1] = 0;
+    }
+    gmx_fft_1d_real(msd->fft, GMX_FFT_COMPLEX_TO_REAL, msd->work, msd->work);
+
+    /* The remaining terms sum_t a(t+k) b(t+k) + a(t) b(t) are obtained by
+     * removing one product from each end of the full sum for every lag.
+     */
+    sum = 0;
+    for (t = 0; t < n; t++)
+    {
+        sum += 2.0*x1[t]*x2[t];
+    }
+    for (k = 0; k < n; k++)
+    {
+        if (k > 0)
+        {
+            sum -= static_cast<double>(x1[k-1])*x2[k-1]
+                + static_cast<double>(x1[n-k])*x2[n-k];
+        }
+        result[k] = (sum - msd->work[k]/msd->nfft)/(n - k);
+    }
+    result[0] = 0;
+}
+
+void gmx_msd_fft_destroy(gmx_msd_fft_t msd)
+{
+    int i;
+
+    if (msd == NULL)
+    {
+        return;
+    }
+    if (msd->fft != NULL)
+    {
+        gmx_fft_destroy(msd->fft);
+    }
+    for (i = 0; i < msd->ncomp; i++)
+    {
+        sfree(msd->x[i]);
+        sfree(msd->spec[i]);
+    }
+    sfree(msd->x);
+    sfree(msd->spec);
+    sfree(msd->work);
+    sfree(msd);
+}
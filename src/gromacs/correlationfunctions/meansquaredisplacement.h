@@ -0,0 +1,117 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal
+ * \file
+ * \brief
+ * Declares routines for computing mean square displacements over all
+ * time origins using FFTs
+ *
+ * \inlibraryapi
+ * \ingroup module_correlationfunctions
+ */
+#ifndef GMX_MEANSQUAREDISPLACEMENT_H
+#define GMX_MEANSQUAREDISPLACEMENT_H
+
+#include "gromacs/utility/real.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \brief
+ * Work data for computing displacement correlations with FFTs.
+ *
+ * For a time series with T equally spaced frames, the displacement
+ * correlation of two coordinate components a and b at lag k is
+ *
+ *   r_ab(k) = 1/(T-k) sum_{t=0}^{T-1-k} (a(t+k)-a(t)) (b(t+k)-b(t)),
+ *
+ * i.e., the average over all T-k time origins.  For a == b this is the
+ * one-dimensional mean square displacement.  The sum is split into a
+ * part that only needs prefix sums of a(t) b(t) and a cross correlation
+ * that is computed with zero-padded FFTs, which makes the cost
+ * O(T log T) instead of O(T^2) per series.
+ *
+ * The data structure holds FFT setup and work arrays and must only be
+ * used by one thread at a time; create one per thread for OpenMP loops.
+ */
+typedef struct gmx_msd_fft *gmx_msd_fft_t;
+
+/*! \brief
+ * Initializes work data for series of \p nframes frames.
+ *
+ * \param[out] msd     Work data to initialize.
+ * \param[in]  nframes Number of frames in each series.
+ * \param[in]  ncomp   Maximum number of components stored at the same time.
+ * \return fft error code, or zero if everything went fine (see fft/fft.h)
+ */
+int gmx_msd_fft_init(gmx_msd_fft_t *msd, int nframes, int ncomp);
+
+/*! \brief
+ * Stores and Fourier transforms one component of a series.
+ *
+ * \param[in] msd    Work data.
+ * \param[in] comp   Component index, smaller than \p ncomp given for init.
+ * \param[in] x      Values, x[t*stride] is used for frame t.
+ * \param[in] stride Distance between consecutive frames in \p x.
+ *
+ * The values are shifted by their mean before the transform; the
+ * displacements do not depend on it, and this avoids losing precision
+ * for particles far from the origin.
+ */
+void gmx_msd_fft_set_component(gmx_msd_fft_t msd, int comp,
+                               const real *x, int stride);
+
+/*! \brief
+ * Computes the displacement correlation of two stored components.
+ *
+ * \param[in]  msd    Work data.
+ * \param[in]  comp1  First component index.
+ * \param[in]  comp2  Second component index (can equal \p comp1).
+ * \param[out] result Correlation r(k) for k = 0, ..., nframes-1.
+ */
+void gmx_msd_fft_correlate(gmx_msd_fft_t msd, int comp1, int comp2,
+                           real result[]);
+
+/*! \brief
+ * Frees work data allocated by gmx_msd_fft_init().
+ */
+void gmx_msd_fft_destroy(gmx_msd_fft_t msd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements test of FFT-based cross correlation routines
+ *
+ * \ingroup module_correlationfunctions
+ */
+#include "gmxpre.h"
+
+#include "gromacs/correlationfunctions/crosscorr.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+/*! \brief
+ * Computes sum_t f(t+k) g(t) directly.
+ */
+std::vector<double> directCrossCorrelation(const std::vector<real> &f,
+                                           const std::vector<real> &g)
+{
+    const int           n = f.size();
+    std::vector<double> result(n);
+    for (int k = 0; k < n; ++k)
+    {
+        double sum = 0;
+        for (int t = 0; t + k < n; ++t)
+        {
+            sum += static_cast<double>(f[t+k])*g[t];
+        }
+        result[k] = sum;
+    }
+    return result;
+}
+
+class CrossCorrelationTest : public ::testing::Test
+{
+    public:
+        CrossCorrelationTest()
+        {
+            const int n = 24;
+            for (int t = 0; t < n; ++t)
+            {
+                f_.push_back(std::sin(0.4*t) + 0.1*t);
+                g_.push_back((t % 3 == 0) ? 1 : 0);
+            }
+        }
+
+        void checkCorrelation(const std::vector<real> &reference,
+                              const std::vector<real> &result)
+        {
+            for (size_t k = 0; k < reference.size(); ++k)
+            {
+                EXPECT_NEAR(reference[k], result[k], 1e-4)
+                << "lag " << k;
+            }
+        }
+
+        std::vector<real> f_;
+        std::vector<real> g_;
+};
+
+TEST_F(CrossCorrelationTest, MatchesDirectSum)
+{
+    std::vector<double> reference = directCrossCorrelation(f_, g_);
+    std::vector<real>   result(f_.size());
+    cross_corr(f_.size(), &f_[0], &g_[0], &result[0]);
+    checkCorrelation(std::vector<real>(reference.begin(), reference.end()), result);
+}
+
+TEST_F(CrossCorrelationTest, ManyMatchesSingle)
+{
+    std::vector<real> single(f_.size());
+    cross_corr(f_.size(), &g_[0], &f_[0], &single[0]);
+
+    std::vector<real> result1(f_.size()), result2(f_.size());
+    int               nData[2] = { static_cast<int>(f_.size()), static_cast<int>(f_.size()) };
+    real             *f[2]     = { &f_[0], &g_[0] };
+    real             *g[2]     = { &g_[0], &f_[0] };
+    real             *corr[2]  = { &result1[0], &result2[0] };
+    many_cross_corr(2, nData, f, g, corr);
+    std::vector<double> reference = directCrossCorrelation(f_, g_);
+    checkCorrelation(std::vector<real>(reference.begin(), reference.end()), result1);
+    checkCorrelation(single, result2);
+}
+
+} // namespace
+} // namespace gmx
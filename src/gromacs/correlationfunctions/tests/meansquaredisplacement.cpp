@@ -0,0 +1,158 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements test of FFT-based mean square displacement routines
+ *
+ * \ingroup module_correlationfunctions
+ */
+#include "gmxpre.h"
+
+#include "gromacs/correlationfunctions/meansquaredisplacement.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fft/fft.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+/*! \brief
+ * Computes the displacement correlation of two series directly.
+ */
+std::vector<double> directCorrelation(const std::vector<real> &a,
+                                      const std::vector<real> &b)
+{
+    const int           n = a.size();
+    std::vector<double> result(n);
+    for (int k = 0; k < n; ++k)
+    {
+        double sum = 0;
+        for (int t = 0; t + k < n; ++t)
+        {
+            sum += static_cast<double>(a[t+k] - a[t])*(b[t+k] - b[t]);
+        }
+        result[k] = sum/(n - k);
+    }
+    return result;
+}
+
+class MeanSquareDisplacementTest : public ::testing::Test
+{
+    public:
+        MeanSquareDisplacementTest()
+        {
+            // Drifting, oscillating series far from the origin, with a
+            // frame count that is not a power of two.
+            const int nframes = 37;
+            for (int t = 0; t < nframes; ++t)
+            {
+                x_.push_back(25.0 + 0.02*t + 0.3*std::sin(0.7*t));
+                y_.push_back(-4.0 - 0.05*t + 0.2*std::cos(1.3*t + 0.4));
+            }
+        }
+
+        static void TearDownTestCase()
+        {
+            gmx_fft_cleanup();
+        }
+
+        void checkCorrelation(gmx_msd_fft_t msd, int comp1, int comp2,
+                              const std::vector<real> &a,
+                              const std::vector<real> &b)
+        {
+            std::vector<double> reference = directCorrelation(a, b);
+            std::vector<real>   result(a.size());
+            gmx_msd_fft_correlate(msd, comp1, comp2, &result[0]);
+            for (size_t k = 0; k < a.size(); ++k)
+            {
+                EXPECT_NEAR(reference[k], result[k], 1e-4)
+                << "lag " << k;
+            }
+        }
+
+        std::vector<real> x_;
+        std::vector<real> y_;
+};
+
+TEST_F(MeanSquareDisplacementTest, MatchesDirectSum)
+{
+    gmx_msd_fft_t msd;
+    ASSERT_EQ(0, gmx_msd_fft_init(&msd, x_.size(), 2));
+    gmx_msd_fft_set_component(msd, 0, &x_[0], 1);
+    gmx_msd_fft_set_component(msd, 1, &y_[0], 1);
+    checkCorrelation(msd, 0, 0, x_, x_);
+    checkCorrelation(msd, 1, 1, y_, y_);
+    checkCorrelation(msd, 0, 1, x_, y_);
+    checkCorrelation(msd, 1, 0, y_, x_);
+    gmx_msd_fft_destroy(msd);
+}
+
+TEST_F(MeanSquareDisplacementTest, HandlesStridedInput)
+{
+    std::vector<real> xy;
+    for (size_t t = 0; t < x_.size(); ++t)
+    {
+        xy.push_back(x_[t]);
+        xy.push_back(y_[t]);
+    }
+    gmx_msd_fft_t msd;
+    ASSERT_EQ(0, gmx_msd_fft_init(&msd, x_.size(), 1));
+    gmx_msd_fft_set_component(msd, 0, &xy[1], 2);
+    checkCorrelation(msd, 0, 0, y_, y_);
+    gmx_msd_fft_destroy(msd);
+}
+
+TEST_F(MeanSquareDisplacementTest, HandlesSingleFrame)
+{
+    gmx_msd_fft_t msd;
+    ASSERT_EQ(0, gmx_msd_fft_init(&msd, 1, 1));
+    gmx_msd_fft_set_component(msd, 0, &x_[0], 1);
+    real          result;
+    gmx_msd_fft_correlate(msd, 0, 0, &result);
+    EXPECT_EQ(0, result);
+    gmx_msd_fft_destroy(msd);
+}
+
+} // namespace
+} // namespace gmx
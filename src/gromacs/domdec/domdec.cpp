@@ -1262,10 +1262,10 @@ void dd_collect_vec(gmx_domdec_t *dd,
 }
 
 
-void dd_collect_state(gmx_domdec_t *dd,
-                      t_state *state_local, t_state *state)
+void dd_collect_state_nondistributed(gmx_domdec_t *dd,
+                                     t_state *state_local, t_state *state)
 {
-    int est, i, j, nh;
+    int i, j, nh;
 
     nh = state->nhchainlength;
 
@@ -1302,6 +1302,15 @@ void dd_collect_state(gmx_domdec_t *dd,
             }
         }
     }
+}
+
+void dd_collect_state(gmx_domdec_t *dd,
+                      t_state *state_local, t_state *state)
+{
+    int est;
+
+    dd_collect_state_nondistributed(dd, state_local, state);
+
     for (est = 0; est < estNR; est++)
     {
         if (EST_DISTR(est) && (state_local->flags & (1<<est)))
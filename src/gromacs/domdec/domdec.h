@@ -213,6 +213,10 @@ void setup_dd_grid(FILE *fplog, struct gmx_domdec_t *dd);
 void dd_collect_vec(struct gmx_domdec_t *dd,
                     t_state *state_local, rvec *lv, rvec *v);
 
+/*! \brief Copies the entries of \p state_local that are not distributed over the ranks to \p state on the master rank */
+void dd_collect_state_nondistributed(struct gmx_domdec_t *dd,
+                                     t_state *state_local, t_state *state);
+
 /*! \brief Collects the local state \p state_local to \p state on the master rank */
 void dd_collect_state(struct gmx_domdec_t *dd,
                       t_state *state_local, t_state *state);
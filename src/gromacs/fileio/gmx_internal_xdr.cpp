@@ -46,6 +46,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "gromacs/utility/futil.h"
 
 /* NB - THIS FILE IS ONLY USED ON MICROSOFT WINDOWS, since that
  * system doesn't provide any standard XDR system libraries. It will
@@ -796,6 +797,176 @@ xdrstdio_create (XDR *xdrs, FILE *file, enum xdr_op op)
     xdrs->x_base         = 0;
 }
 
+
+
+static bool_t xdrmmap_getbytes (XDR *, char *, unsigned int);
+static bool_t xdrmmap_putbytes (XDR *, char *, unsigned int);
+static unsigned int xdrmmap_getpos (XDR *);
+static bool_t xdrmmap_setpos (XDR *, unsigned int);
+static xdr_int32_t *xdrmmap_inline (XDR *, int);
+static void xdrmmap_destroy (XDR *);
+static bool_t xdrmmap_getint32 (XDR *, xdr_int32_t *);
+static bool_t xdrmmap_putint32 (XDR *, xdr_int32_t *);
+static bool_t xdrmmap_getuint32 (XDR *, xdr_uint32_t *);
+static bool_t xdrmmap_putuint32 (XDR *, xdr_uint32_t *);
+
+static struct xdrmmap_region *
+xdrmmap_get_region (XDR *xdrs)
+{
+    return reinterpret_cast<struct xdrmmap_region *>(xdrs->x_private);
+}
+
+/*
+ * Destroy a memory xdr stream.
+ * The region is owned by the caller, so there is nothing to clean up.
+ */
+static void
+xdrmmap_destroy (XDR *xdrs)
+{
+    (void)xdrs;
+}
+
+static bool_t
+xdrmmap_getbytes (XDR *xdrs, char *addr, unsigned int len)
+{
+    struct xdrmmap_region *region = xdrmmap_get_region(xdrs);
+    size_t                 nleft, nread;
+
+    nleft = (region->pos < region->size ? region->size - region->pos : 0);
+    if (len <= nleft)
+    {
+        memcpy(addr, region->base + region->pos, len);
+        region->pos += len;
+        return TRUE;
+    }
+
+    /* Like fread, consume what is left before failing */
+    if (nleft > 0)
+    {
+        memcpy(addr, region->base + region->pos, nleft);
+        region->pos += nleft;
+    }
+    if (region->fp == NULL)
+    {
+        return FALSE;
+    }
+    /* The rest might have been appended to the file after mapping it */
+    if (gmx_fseek(region->fp, static_cast<gmx_off_t>(region->pos), SEEK_SET) != 0)
+    {
+        return FALSE;
+    }
+    nread        = fread(addr + nleft, 1, len - nleft, region->fp);
+    region->pos += nread;
+    return (nread == len - nleft);
+}
+
+static bool_t
+xdrmmap_putbytes (XDR *xdrs, char *addr, unsigned int len)
+{
+    (void)xdrs;
+    (void)addr;
+    (void)len;
+    /* The region is read-only */
+    return FALSE;
+}
+
+static unsigned int
+xdrmmap_getpos (XDR *xdrs)
+{
+    return static_cast<unsigned int>(xdrmmap_get_region(xdrs)->pos);
+}
+
+static bool_t
+xdrmmap_setpos (XDR *xdrs, unsigned int pos)
+{
+    struct xdrmmap_region *region = xdrmmap_get_region(xdrs);
+
+    if (pos > region->size && region->fp == NULL)
+    {
+        return FALSE;
+    }
+    region->pos = pos;
+    return TRUE;
+}
+
+static xdr_int32_t *
+xdrmmap_inline (XDR *xdrs, int len)
+{
+    (void)xdrs;
+    (void)len;
+    /* The region has no guaranteed alignment, so we don't do this. */
+    return NULL;
+}
+
+static bool_t
+xdrmmap_getint32 (XDR *xdrs, xdr_int32_t *ip)
+{
+    xdr_int32_t mycopy;
+
+    if (!xdrmmap_getbytes(xdrs, reinterpret_cast<char *>(&mycopy), 4))
+    {
+        return FALSE;
+    }
+    *ip = xdr_ntohl (mycopy);
+    return TRUE;
+}
+
+static bool_t
+xdrmmap_putint32 (XDR *xdrs, xdr_int32_t *ip)
+{
+    return xdrmmap_putbytes(xdrs, reinterpret_cast<char *>(ip), 4);
+}
+
+static bool_t
+xdrmmap_getuint32 (XDR *xdrs, xdr_uint32_t *ip)
+{
+    xdr_uint32_t mycopy;
+
+    if (!xdrmmap_getbytes(xdrs, reinterpret_cast<char *>(&mycopy), 4))
+    {
+        return FALSE;
+    }
+    *ip = xdr_ntohl (mycopy);
+    return TRUE;
+}
+
+static bool_t
+xdrmmap_putuint32 (XDR *xdrs, xdr_uint32_t *ip)
+{
+    return xdrmmap_putbytes(xdrs, reinterpret_cast<char *>(ip), 4);
+}
+
+/*
+ * Ops vector for memory-region type XDR
+ */
+static struct XDR::xdr_ops xdrmmap_ops =
+{
+    xdrmmap_getbytes,  /* deserialize counted bytes */
+    xdrmmap_putbytes,  /* serialize counted bytes */
+    xdrmmap_getpos,    /* get offset in the stream */
+    xdrmmap_setpos,    /* set offset in the stream */
+    xdrmmap_inline,    /* prime stream for inline macros */
+    xdrmmap_destroy,   /* destroy stream */
+    xdrmmap_getint32,  /* deserialize a int */
+    xdrmmap_putint32,  /* serialize a int */
+    xdrmmap_getuint32, /* deserialize a int */
+    xdrmmap_putuint32  /* serialize a int */
+};
+
+/*
+ * Initialize a decoding xdr stream on a memory region.
+ * Reading starts at the current position of the region.
+ */
+void
+xdrmmap_create (XDR *xdrs, struct xdrmmap_region *region)
+{
+    xdrs->x_op           = XDR_DECODE;
+    xdrs->x_ops          = &xdrmmap_ops;
+    xdrs->x_private      = reinterpret_cast<char *>(region);
+    xdrs->x_handy        = 0;
+    xdrs->x_base         = 0;
+}
+
 #else
 int gmx_internal_xdr_empty;
 #endif /* GMX_INTERNAL_XDR */
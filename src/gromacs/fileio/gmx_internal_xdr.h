@@ -251,6 +251,21 @@ bool_t xdr_float (XDR *__xdrs, float *__fp);
 bool_t xdr_double (XDR *__xdrs, double *__dp);
 void xdrstdio_create (XDR *__xdrs, FILE *__file, enum xdr_op __xop);
 
+/* A read-only memory region, e.g. a mapped file, read by an xdrmmap stream.
+ * The position is kept here with 64 bits, so the owner can get and set it
+ * also beyond the range of xdr_getpos() and xdr_setpos().
+ * When fp is set, bytes beyond the end of the region are read from fp at
+ * the same offset, so data appended to a file after mapping it is read.
+ */
+struct xdrmmap_region
+{
+    const char *base; /* start of the region */
+    size_t      size; /* number of bytes in the region */
+    size_t      pos;  /* current offset from base */
+    FILE       *fp;   /* file to read beyond size from, or NULL */
+};
+void xdrmmap_create (XDR *__xdrs, struct xdrmmap_region *__region);
+
 /* free memory buffers for xdr */
 void xdr_free (xdrproc_t __proc, char *__objp);
 
@@ -69,6 +69,17 @@ struct t_fileio
     enum xdr_op  xdrmode;              /* the xdr mode */
     int          iFTP;                 /* the file type identifier */
 
+    unsigned char *chksum_buf;         /* the bytes of the file used for the
+                                          checkpoint checksum, stored at the
+                                          file offset modulo the buffer size,
+                                          NULL when not used yet */
+    gmx_off_t      chksum_end;         /* the file offset up to which
+                                          chksum_buf is filled */
+
+    struct xdrmmap_region *map;        /* the memory map of a file open for
+                                          reading only that xdr reads from,
+                                          NULL when xdr uses fp */
+
     t_fileio    *next, *prev;          /* next and previous file pointers in the
                                           linked list */
     tMPI_Lock_t  mtx;                  /* content locking mutex. This is a fast lock
@@ -42,8 +42,11 @@
 
 #include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+
 #ifdef HAVE_IO_H
 #include <io.h>
 #endif
@@ -51,6 +54,17 @@
 #include <unistd.h>
 #endif
 
+/* Reading through a memory map uses our own XDR stream on the mapped
+ * memory, so it needs the internal XDR implementation and POSIX mmap().
+ */
+#if GMX_INTERNAL_XDR && defined HAVE_UNISTD_H && !defined GMX_NATIVE_WINDOWS
+#define GMX_FIO_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define GMX_FIO_HAVE_MMAP 0
+#endif
+
 #include "thread_mpi/threads.h"
 
 #include "gromacs/fileio/filenm.h"
@@ -69,6 +83,11 @@
        it is initialized when the first file is opened. */
 static t_fileio *open_files = NULL;
 
+/* The number of bytes at the end of an output file used for the checksum
+ * in checkpoints. 1MB: large size important to catch almost identical files.
+ */
+#define CPT_CHK_LEN  1048576
+
 
 /* this mutex locks the open_files structure so that no two threads can
    modify it.
@@ -87,6 +106,79 @@ static tMPI_Thread_mutex_t open_file_mutex = TMPI_THREAD_MUTEX_INITIALIZER;
  *
  ******************************************************************/
 
+/* Maps an XDR file opened for reading only into memory and lets fio->xdr
+ * read from the map, avoiding a stdio call and copy per item read.
+ * This is only done when GMX_FIO_MMAP is set, since a file that is
+ * truncated while it is mapped gives SIGBUS instead of a read error.
+ * Data appended to the file after mapping is read through fp.
+ * Leaves fio unchanged when the file can not be mapped, e.g. because it
+ * is a pipe from a decompressor.
+ */
+static void gmx_fio_int_map(t_fileio *fio)
+{
+#if GMX_FIO_HAVE_MMAP
+    struct stat st;
+    void       *base;
+    size_t      size;
+    int         fd;
+
+    if (getenv("GMX_FIO_MMAP") == NULL)
+    {
+        return;
+    }
+    fd = fileno(fio->fp);
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        return;
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (static_cast<gmx_off_t>(size) != st.st_size)
+    {
+        /* Too large for the address space */
+        return;
+    }
+    base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return;
+    }
+#ifdef MADV_SEQUENTIAL
+    /* Trajectories are mostly read front to back */
+    madvise(base, size, MADV_SEQUENTIAL);
+#endif
+    snew(fio->map, 1);
+    fio->map->base = static_cast<const char *>(base);
+    fio->map->size = size;
+    fio->map->pos  = 0;
+    fio->map->fp   = fio->fp;
+    xdr_destroy(fio->xdr);
+    xdrmmap_create(fio->xdr, fio->map);
+#else
+    GMX_UNUSED_VALUE(fio);
+#endif
+}
+
+/* Lets fio->xdr read through fp again, positioned where reading from
+ * the map stopped. Needed before code accesses fp directly.
+ */
+static void gmx_fio_int_unmap(t_fileio *fio)
+{
+#if GMX_FIO_HAVE_MMAP
+    if (fio->map == NULL)
+    {
+        return;
+    }
+    gmx_fseek(fio->fp, static_cast<gmx_off_t>(fio->map->pos), SEEK_SET);
+    xdr_destroy(fio->xdr);
+    xdrstdio_create(fio->xdr, fio->fp, fio->xdrmode);
+    munmap(const_cast<char *>(fio->map->base), fio->map->size);
+    sfree(fio->map);
+    fio->map = NULL;
+#else
+    GMX_UNUSED_VALUE(fio);
+#endif
+}
+
 static int gmx_fio_int_flush(t_fileio* fio)
 {
     int rc = 0;
@@ -314,6 +406,7 @@ t_fileio *gmx_fio_open(const char *fn, const char *mode)
     bReadWrite = (newmode[1] == '+');
     fio->fp    = NULL;
     fio->xdr   = NULL;
+    fio->map   = NULL;
     if (fn)
     {
         if (fn2ftp(fn) == efTNG)
@@ -338,6 +431,10 @@ t_fileio *gmx_fio_open(const char *fn, const char *mode)
             }
             snew(fio->xdr, 1);
             xdrstdio_create(fio->xdr, fio->fp, fio->xdrmode);
+            if (bRead)
+            {
+                gmx_fio_int_map(fio);
+            }
         }
 
         /* for appending seek to end of file to make sure ftell gives correct position
@@ -367,6 +464,7 @@ static int gmx_fio_close_locked(t_fileio *fio)
 
     if (fio->xdr != NULL)
     {
+        gmx_fio_int_unmap(fio);
         xdr_destroy(fio->xdr);
         sfree(fio->xdr);
     }
@@ -376,6 +474,7 @@ static int gmx_fio_close_locked(t_fileio *fio)
         rc = gmx_ffclose(fio->fp); /* fclose returns 0 if happy */
 
     }
+    sfree(fio->chksum_buf);
 
     return rc;
 }
@@ -453,16 +552,44 @@ int gmx_fio_fclose(FILE *fp)
     return rc;
 }
 
-/* internal variant of get_file_md5 that operates on a locked file */
+/* Reads the bytes [start, end) of the file into the checksum ring buffer,
+ * returns 0 on success.
+ */
+static int gmx_fio_int_read_chksum_buf(t_fileio *fio, gmx_off_t start,
+                                       gmx_off_t end)
+{
+    gmx_off_t pos, n;
+    int       i;
+
+    if (gmx_fseek(fio->fp, start, SEEK_SET))
+    {
+        return -1;
+    }
+    for (pos = start; pos < end; pos += n)
+    {
+        i = pos % CPT_CHK_LEN;
+        n = std::min(end - pos, static_cast<gmx_off_t>(CPT_CHK_LEN - i));
+        if ((gmx_off_t)fread(fio->chksum_buf + i, 1, n, fio->fp) != n)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* internal variant of get_file_md5 that operates on a locked file.
+ * The last CPT_CHK_LEN bytes are kept in memory between calls, so only
+ * the part of the file written since the previous call is read.
+ */
 static int gmx_fio_int_get_file_md5(t_fileio *fio, gmx_off_t offset,
                                     unsigned char digest[])
 {
-    /*1MB: large size important to catch almost identical files */
-#define CPT_CHK_LEN  1048576
     md5_state_t    state;
-    unsigned char *buf;
     gmx_off_t      read_len;
     gmx_off_t      seek_offset;
+    gmx_off_t      read_offset;
+    int            i, n;
     int            ret = -1;
 
     seek_offset = offset - CPT_CHK_LEN;
@@ -472,23 +599,26 @@ static int gmx_fio_int_get_file_md5(t_fileio *fio, gmx_off_t offset,
     }
     read_len = offset - seek_offset;
 
+    if (!(fio->fp && fio->bReadWrite))
+    {
+        return -1;
+    }
 
-    if (fio->fp && fio->bReadWrite)
+    if (fio->chksum_buf == NULL)
     {
-        ret = gmx_fseek(fio->fp, seek_offset, SEEK_SET);
-        if (ret)
-        {
-            gmx_fseek(fio->fp, 0, SEEK_END);
-        }
+        snew(fio->chksum_buf, CPT_CHK_LEN);
+        fio->chksum_end = 0;
     }
-    if (ret) /*either no fp, not readwrite, or fseek not successful */
+    /* Only use the buffer contents when the file has not been truncated */
+    read_offset = seek_offset;
+    if (fio->chksum_end >= seek_offset && fio->chksum_end <= offset)
     {
-        return -1;
+        read_offset = fio->chksum_end;
     }
 
-    snew(buf, CPT_CHK_LEN);
     /* the read puts the file position back to offset */
-    if ((gmx_off_t)fread(buf, 1, read_len, fio->fp) != read_len)
+    ret = gmx_fio_int_read_chksum_buf(fio, read_offset, offset);
+    if (ret)
     {
         /* not fatal: md5sum check to prevent overwriting files
          * works (less safe) without
@@ -518,26 +648,32 @@ static int gmx_fio_int_get_file_md5(t_fileio *fio, gmx_off_t offset,
                     fio->fn);
         }
 
-        gmx_fseek(fio->fp, 0, SEEK_END);
-
-        ret = -1;
+        ret             = -1;
+        fio->chksum_end = 0;
+    }
+    else
+    {
+        fio->chksum_end = offset;
     }
     gmx_fseek(fio->fp, 0, SEEK_END); /*is already at end, but under windows
                                         it gives problems otherwise*/
 
     if (debug)
     {
-        fprintf(debug, "chksum %s readlen %ld\n", fio->fn, (long int)read_len);
+        fprintf(debug, "chksum %s readlen %ld\n", fio->fn, (long int)(offset - read_offset));
     }
 
     if (!ret)
     {
+        /* The window [seek_offset, offset) can wrap around the buffer end */
+        i = seek_offset % CPT_CHK_LEN;
+        n = std::min(read_len, static_cast<gmx_off_t>(CPT_CHK_LEN - i));
         gmx_md5_init(&state);
-        gmx_md5_append(&state, buf, read_len);
+        gmx_md5_append(&state, fio->chksum_buf + i, n);
+        gmx_md5_append(&state, fio->chksum_buf, read_len - n);
         gmx_md5_finish(&state, digest);
         ret = read_len;
     }
-    sfree(buf);
     return ret;
 }
 
@@ -658,7 +794,11 @@ void gmx_fio_rewind(t_fileio* fio)
 {
     gmx_fio_lock(fio);
 
-    if (fio->xdr)
+    if (fio->map)
+    {
+        fio->map->pos = 0;
+    }
+    else if (fio->xdr)
     {
         xdr_destroy(fio->xdr);
         frewind(fio->fp);
@@ -668,6 +808,7 @@ void gmx_fio_rewind(t_fileio* fio)
     {
         frewind(fio->fp);
     }
+    fio->chksum_end = 0;
     gmx_fio_unlock(fio);
 }
 
@@ -750,7 +891,11 @@ gmx_off_t gmx_fio_ftell(t_fileio* fio)
     gmx_off_t ret = 0;
 
     gmx_fio_lock(fio);
-    if (fio->fp)
+    if (fio->map)
+    {
+        ret = static_cast<gmx_off_t>(fio->map->pos);
+    }
+    else if (fio->fp)
     {
         ret = gmx_ftell(fio->fp);
     }
@@ -763,9 +908,19 @@ int gmx_fio_seek(t_fileio* fio, gmx_off_t fpos)
     int rc;
 
     gmx_fio_lock(fio);
-    if (fio->fp)
+    if (fio->map)
+    {
+        /* Like fseek, allow seeking beyond the end of the map,
+         * reads there go through fp.
+         */
+        fio->map->pos = static_cast<size_t>(fpos);
+        rc            = 0;
+    }
+    else if (fio->fp)
     {
         rc = gmx_fseek(fio->fp, fpos, SEEK_SET);
+        /* The file contents could change after the new position */
+        fio->chksum_end = std::min(fio->chksum_end, fpos);
     }
     else
     {
@@ -781,6 +936,8 @@ FILE *gmx_fio_getfp(t_fileio *fio)
     FILE *ret = NULL;
 
     gmx_fio_lock(fio);
+    /* The caller will access the file directly */
+    gmx_fio_int_unmap(fio);
     if (fio->fp)
     {
         ret = fio->fp;
@@ -805,6 +962,8 @@ int xtc_seek_time(t_fileio *fio, real time, int natoms, gmx_bool bSeekForwardOnl
     int ret;
 
     gmx_fio_lock(fio);
+    /* The seek mixes stdio and XDR calls */
+    gmx_fio_int_unmap(fio);
     ret = xdr_xtc_seek_time(time, fio->fp, fio->xdr, natoms, bSeekForwardOnly);
     gmx_fio_unlock(fio);
 
@@ -410,15 +410,14 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
     int          lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
     int          minidx, maxidx;
     unsigned     sizeint[3], sizesmall[3], bitsizeint[3], size3, *luip;
-    int          flag, k;
+    int          k;
     int          smallnum, smaller, larger, i, is_small, is_smaller, run, prevrun;
     float       *lfp, lf;
     int          tmp, *thiscoord,  prevcoord[3];
     unsigned int tmpcoord[30];
 
-    int          bufsize, lsize;
+    int          bufsize;
     unsigned int bitsize;
-    float        inv_precision;
     int          errval = 1;
     int          rc;
 
@@ -778,231 +777,668 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
     }
     else
     {
-
         /* xdrs is open for reading */
+        t_xdr3dfcoord_data data;
 
-        if (xdr_int(xdrs, &lsize) == 0)
+        xdr3dfcoord_data_init(&data);
+        rc = xdr3dfcoord_read_data(xdrs, &data);
+        if (rc)
         {
-            return 0;
+            if (*size != 0 && data.size != *size)
+            {
+                fprintf(stderr, "wrong number of coordinates in xdr3dfcoord; "
+                        "%d arg vs %d in file", *size, data.size);
+            }
+            *size      = data.size;
+            *precision = data.precision;
+            rc         = xdr3dfcoord_decompress(&data, fp);
         }
-        if (*size != 0 && lsize != *size)
+        xdr3dfcoord_data_done(&data);
+
+        return rc;
+    }
+}
+
+/*____________________________________________________________________________
+ |
+ | Fast decoding of compressed coordinates.
+ |
+ | The routines below produce exactly the same output as receivebits() and
+ | receiveints(), but keep the next bits of the stream in a 64-bit word that
+ | is refilled with (unaligned) 8-byte reads, and do the base conversion of
+ | receiveints() with multiplications by precomputed reciprocals instead of
+ | a byte-wise long division whenever the combined integer fits in 64 bits.
+ */
+
+/* Number of zero ints after the compressed bytes, so that xtc_bitreader
+ * can always read 8 bytes at a time.
+ */
+static const int c_bitreaderPadding = 2;
+
+/* Reads bits from a compressed stream, most significant bit first */
+typedef struct
+{
+    const unsigned char *ptr;   /* Next byte to load into bits */
+    gmx_uint64_t         bits;  /* Buffered bits, left aligned */
+    int                  nbits; /* Number of valid bits in bits */
+} xtc_bitreader;
+
+static void bitreader_init(xtc_bitreader *br, const unsigned char *ptr)
+{
+    br->ptr   = ptr;
+    br->bits  = 0;
+    br->nbits = 0;
+}
+
+/* Makes sure that at least 56 bits are buffered */
+static inline void bitreader_refill(xtc_bitreader *br)
+{
+    const unsigned char *p = br->ptr;
+    gmx_uint64_t         word;
+
+    word = (static_cast<gmx_uint64_t>(p[0]) << 56) |
+        (static_cast<gmx_uint64_t>(p[1]) << 48) |
+        (static_cast<gmx_uint64_t>(p[2]) << 40) |
+        (static_cast<gmx_uint64_t>(p[3]) << 32) |
+        (static_cast<gmx_uint64_t>(p[4]) << 24) |
+        (static_cast<gmx_uint64_t>(p[5]) << 16) |
+        (static_cast<gmx_uint64_t>(p[6]) << 8) |
+        static_cast<gmx_uint64_t>(p[7]);
+    br->bits  |= word >> br->nbits;
+    br->ptr   += (63 - br->nbits) >> 3;
+    br->nbits |= 56;
+}
+
+/* Returns the next num_of_bits bits, num_of_bits should be at most 56 */
+static inline unsigned int bitreader_get(xtc_bitreader *br, int num_of_bits)
+{
+    gmx_uint64_t num;
+
+    if (num_of_bits == 0)
+    {
+        return 0;
+    }
+    if (br->nbits < num_of_bits)
+    {
+        bitreader_refill(br);
+    }
+    num        = br->bits >> (64 - num_of_bits);
+    br->bits <<= num_of_bits;
+    br->nbits -= num_of_bits;
+
+    return static_cast<unsigned int>(num);
+}
+
+/* Divisor with a precomputed reciprocal for division without a divide
+ * instruction, see T. Granlund and P. L. Montgomery, "Division by invariant
+ * integers using multiplication", PLDI 1994, figure 4.1.
+ */
+typedef struct
+{
+    gmx_uint64_t multiplier;
+    int          shift1;
+    int          shift2;
+    unsigned int divisor;
+} xtc_divisor;
+
+static void divisor_init(xtc_divisor *div, unsigned int d)
+{
+    gmx_uint64_t r, hi, lo;
+    int          l = 0;
+
+    while (l < 32 && (static_cast<gmx_uint64_t>(1) << l) < d)
+    {
+        l++;
+    }
+    /* multiplier = floor(2^64 (2^l - d) / d) + 1, with 2^l - d < d < 2^32 */
+    r               = (static_cast<gmx_uint64_t>(1) << l) - d;
+    hi              = (r << 32) / d;
+    r               = (r << 32) % d;
+    lo              = (r << 32) / d;
+    div->multiplier = ((hi << 32) | lo) + 1;
+    div->shift1     = (l > 0 ? 1 : 0);
+    div->shift2     = (l > 0 ? l - 1 : 0);
+    div->divisor    = d;
+}
+
+static inline gmx_uint64_t mulhi64(gmx_uint64_t a, gmx_uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128;
+    return static_cast<gmx_uint64_t>((static_cast<uint128>(a) * b) >> 64);
+#else
+    gmx_uint64_t a_lo = a & 0xffffffffU, a_hi = a >> 32;
+    gmx_uint64_t b_lo = b & 0xffffffffU, b_hi = b >> 32;
+    gmx_uint64_t lolo = a_lo * b_lo;
+    gmx_uint64_t hilo = a_hi * b_lo;
+    gmx_uint64_t lohi = a_lo * b_hi;
+    gmx_uint64_t mid  = (lolo >> 32) + (hilo & 0xffffffffU) + lohi;
+    return a_hi * b_hi + (hilo >> 32) + (mid >> 32);
+#endif
+}
+
+/* Divides num by div, returning the quotient and storing the remainder */
+static inline gmx_uint64_t divisor_divide(gmx_uint64_t num, const xtc_divisor *div,
+                                          unsigned int *remainder)
+{
+    gmx_uint64_t t, q;
+
+    t          = mulhi64(div->multiplier, num);
+    q          = (t + ((num - t) >> div->shift1)) >> div->shift2;
+    *remainder = static_cast<unsigned int>(num - q*div->divisor);
+
+    return q;
+}
+
+/* Same as receiveints() for three integers, divs should hold the divisors
+ * for sizes[1] and sizes[2].
+ */
+static inline void bitreader_receiveints(xtc_bitreader *br, int num_of_bits,
+                                         const unsigned int sizes[],
+                                         const xtc_divisor divs[], int nums[])
+{
+    if (num_of_bits <= 64)
+    {
+        gmx_uint64_t num, word;
+        unsigned int rem;
+        int          nfull = (num_of_bits - 1) >> 3;
+        int          nlast = num_of_bits - 8*nfull;
+
+        /* The integer is stored as little-endian bytes, each read with
+         * the most significant bit first, followed by a partial byte.
+         */
+        num = 0;
+        if (nfull > 0)
         {
-            fprintf(stderr, "wrong number of coordinates in xdr3dfcoord; "
-                    "%d arg vs %d in file", *size, lsize);
+            word = bitreader_get(br, 8);
+            num  = word;
+            for (int j = 1; j < nfull; j++)
+            {
+                word = bitreader_get(br, 8);
+                num |= word << (8*j);
+            }
         }
-        *size = lsize;
-        size3 = *size * 3;
-        if (*size <= 9)
+        word    = bitreader_get(br, nlast);
+        num    |= word << (8*nfull);
+
+        num     = divisor_divide(num, &divs[2], &rem);
+        nums[2] = rem;
+        num     = divisor_divide(num, &divs[1], &rem);
+        nums[1] = rem;
+        nums[0] = static_cast<int>(num & 0xffffffffU);
+    }
+    else
+    {
+        /* The combined integer does not fit in 64 bits, do the long
+         * division over the bytes as receiveints() does.
+         */
+        int bytes[32];
+        int i, j, num_of_bytes, p, num;
+
+        bytes[0]     = bytes[1] = bytes[2] = bytes[3] = 0;
+        num_of_bytes = 0;
+        while (num_of_bits > 8)
         {
-            *precision = -1;
-            return (xdr_vector(xdrs, reinterpret_cast<char *>(fp), static_cast<unsigned int>(size3),
-                               static_cast<unsigned int>(sizeof(*fp)), (xdrproc_t)xdr_float));
+            bytes[num_of_bytes++] = bitreader_get(br, 8);
+            num_of_bits          -= 8;
         }
-        if (xdr_float(xdrs, precision) == 0)
+        bytes[num_of_bytes++] = bitreader_get(br, num_of_bits);
+        for (i = 2; i > 0; i--)
         {
-            return 0;
+            num = 0;
+            for (j = num_of_bytes-1; j >= 0; j--)
+            {
+                num      = (num << 8) | bytes[j];
+                p        = num / sizes[i];
+                bytes[j] = p;
+                num      = num - p * sizes[i];
+            }
+            nums[i] = num;
         }
+        nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+    }
+}
 
-        if (size3 <= prealloc_size)
+int xdr3dfcoord_decompress(const t_xdr3dfcoord_data *data, float *fp)
+{
+    xtc_bitreader br;
+    xtc_divisor   sizediv[3], smalldiv[LASTIDX][3];
+    int           minint[3];
+    unsigned int  sizeint[3], bitsizeint[3];
+    unsigned int  bitsize;
+    int           smallidx, smallnum, smaller, is_smaller, run, flag, k, i;
+    int           thiscoord[3], prevcoord[3], tmp;
+    float        *lfp;
+    float         inv_precision;
+    const int     lsize = data->size;
+
+    if (lsize <= 9)
+    {
+        memcpy(fp, data->buf, 3*lsize*sizeof(*fp));
+        return 1;
+    }
+
+    minint[0] = data->minint[0];
+    minint[1] = data->minint[1];
+    minint[2] = data->minint[2];
+
+    sizeint[0] = data->maxint[0] - minint[0]+1;
+    sizeint[1] = data->maxint[1] - minint[1]+1;
+    sizeint[2] = data->maxint[2] - minint[2]+1;
+    if (sizeint[0] == 0 || sizeint[1] == 0 || sizeint[2] == 0)
+    {
+        return 0;
+    }
+
+    bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
+    /* check if one of the sizes is to big to be multiplied */
+    if ((sizeint[0] | sizeint[1] | sizeint[2] ) > 0xffffff)
+    {
+        bitsizeint[0] = sizeofint(sizeint[0]);
+        bitsizeint[1] = sizeofint(sizeint[1]);
+        bitsizeint[2] = sizeofint(sizeint[2]);
+        bitsize       = 0; /* flag the use of large sizes */
+    }
+    else
+    {
+        bitsize = sizeofints(3, sizeint);
+    }
+    divisor_init(&sizediv[1], sizeint[1]);
+    divisor_init(&sizediv[2], sizeint[2]);
+    for (k = FIRSTIDX; k < LASTIDX; k++)
+    {
+        divisor_init(&smalldiv[k][1], magicints[k]);
+        smalldiv[k][2] = smalldiv[k][1];
+    }
+
+    smallidx = data->smallidx;
+    smaller  = magicints[std::max(FIRSTIDX, smallidx-1)] / 2;
+    smallnum = magicints[smallidx] / 2;
+
+    bitreader_init(&br, reinterpret_cast<const unsigned char *>(&(data->buf[3])));
+
+    lfp           = fp;
+    inv_precision = 1.0 / data->precision;
+    run           = 0;
+    i             = 0;
+    while (i < lsize)
+    {
+        if (bitsize == 0)
         {
-            ip  = prealloc_ip;
-            buf = prealloc_buf;
+            thiscoord[0] = bitreader_get(&br, bitsizeint[0]);
+            thiscoord[1] = bitreader_get(&br, bitsizeint[1]);
+            thiscoord[2] = bitreader_get(&br, bitsizeint[2]);
         }
         else
         {
-            we_should_free = 1;
-            bufsize        = static_cast<int>(size3 * 1.2);
-            ip             = reinterpret_cast<int *>(malloc(size3 * sizeof(*ip)));
-            buf            = reinterpret_cast<int *>(malloc(bufsize * sizeof(*buf)));
-            if (ip == NULL || buf == NULL)
-            {
-                fprintf(stderr, "malloc failed\n");
-                exit(1);
-            }
+            bitreader_receiveints(&br, bitsize, sizeint, sizediv, thiscoord);
         }
 
-        buf[0] = buf[1] = buf[2] = 0;
+        i++;
+        thiscoord[0] += minint[0];
+        thiscoord[1] += minint[1];
+        thiscoord[2] += minint[2];
 
-        if ( (xdr_int(xdrs, &(minint[0])) == 0) ||
-             (xdr_int(xdrs, &(minint[1])) == 0) ||
-             (xdr_int(xdrs, &(minint[2])) == 0) ||
-             (xdr_int(xdrs, &(maxint[0])) == 0) ||
-             (xdr_int(xdrs, &(maxint[1])) == 0) ||
-             (xdr_int(xdrs, &(maxint[2])) == 0))
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+
+        flag       = bitreader_get(&br, 1);
+        is_smaller = 0;
+        if (flag == 1)
         {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buf);
-            }
-            return 0;
+            run        = bitreader_get(&br, 5);
+            is_smaller = run % 3;
+            run       -= is_smaller;
+            is_smaller--;
         }
-
-        sizeint[0] = maxint[0] - minint[0]+1;
-        sizeint[1] = maxint[1] - minint[1]+1;
-        sizeint[2] = maxint[2] - minint[2]+1;
-
-        /* check if one of the sizes is to big to be multiplied */
-        if ((sizeint[0] | sizeint[1] | sizeint[2] ) > 0xffffff)
+        if (run > 0)
         {
-            bitsizeint[0] = sizeofint(sizeint[0]);
-            bitsizeint[1] = sizeofint(sizeint[1]);
-            bitsizeint[2] = sizeofint(sizeint[2]);
-            bitsize       = 0; /* flag the use of large sizes */
+            unsigned int sizesmall[3];
+
+            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+            for (k = 0; k < run; k += 3)
+            {
+                bitreader_receiveints(&br, smallidx, sizesmall, smalldiv[smallidx], thiscoord);
+                i++;
+                thiscoord[0] += prevcoord[0] - smallnum;
+                thiscoord[1] += prevcoord[1] - smallnum;
+                thiscoord[2] += prevcoord[2] - smallnum;
+                if (k == 0)
+                {
+                    /* interchange first with second atom for better
+                     * compression of water molecules
+                     */
+                    tmp          = thiscoord[0]; thiscoord[0] = prevcoord[0];
+                    prevcoord[0] = tmp;
+                    tmp          = thiscoord[1]; thiscoord[1] = prevcoord[1];
+                    prevcoord[1] = tmp;
+                    tmp          = thiscoord[2]; thiscoord[2] = prevcoord[2];
+                    prevcoord[2] = tmp;
+                    *lfp++       = prevcoord[0] * inv_precision;
+                    *lfp++       = prevcoord[1] * inv_precision;
+                    *lfp++       = prevcoord[2] * inv_precision;
+                }
+                else
+                {
+                    prevcoord[0] = thiscoord[0];
+                    prevcoord[1] = thiscoord[1];
+                    prevcoord[2] = thiscoord[2];
+                }
+                *lfp++ = thiscoord[0] * inv_precision;
+                *lfp++ = thiscoord[1] * inv_precision;
+                *lfp++ = thiscoord[2] * inv_precision;
+            }
         }
         else
         {
-            bitsize = sizeofints(3, sizeint);
+            *lfp++ = thiscoord[0] * inv_precision;
+            *lfp++ = thiscoord[1] * inv_precision;
+            *lfp++ = thiscoord[2] * inv_precision;
         }
-
-        if (xdr_int(xdrs, &smallidx) == 0)
+        smallidx += is_smaller;
+        if (is_smaller < 0)
         {
-            if (we_should_free)
+            smallnum = smaller;
+            if (smallidx > FIRSTIDX)
             {
-                free(ip);
-                free(buf);
+                smaller = magicints[smallidx - 1] /2;
+            }
+            else
+            {
+                smaller = 0;
             }
-            return 0;
         }
+        else if (is_smaller > 0)
+        {
+            smaller  = smallnum;
+            smallnum = magicints[smallidx] / 2;
+        }
+    }
 
-        smaller      = magicints[std::max(FIRSTIDX, smallidx-1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    return 1;
+}
 
-        /* buf[0] holds the length in bytes */
+void xdr3dfcoord_data_init(t_xdr3dfcoord_data *data)
+{
+    data->size      = 0;
+    data->precision = -1;
+    data->smallidx  = 0;
+    data->nbytes    = 0;
+    data->nalloc    = 0;
+    data->buf       = NULL;
+    for (int d = 0; d < 3; d++)
+    {
+        data->minint[d] = 0;
+        data->maxint[d] = 0;
+    }
+}
 
-        if (xdr_int(xdrs, &(buf[0])) == 0)
+void xdr3dfcoord_data_done(t_xdr3dfcoord_data *data)
+{
+    free(data->buf);
+    data->buf    = NULL;
+    data->nalloc = 0;
+}
+
+/* Makes sure data->buf can hold n ints, returns 0 when out of memory */
+static int xdr3dfcoord_data_reserve(t_xdr3dfcoord_data *data, int n)
+{
+    if (n > data->nalloc)
+    {
+        int *buf = reinterpret_cast<int *>(realloc(data->buf, n*sizeof(*buf)));
+        if (buf == NULL)
         {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buf);
-            }
             return 0;
         }
+        data->buf    = buf;
+        data->nalloc = n;
+    }
+    return 1;
+}
 
+int xdr3dfcoord_read_data(XDR *xdrs, t_xdr3dfcoord_data *data)
+{
+    int nbytes;
 
-        if (xdr_opaque(xdrs, reinterpret_cast<char *>(&(buf[3])), static_cast<unsigned int>(buf[0])) == 0)
-        {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buf);
-            }
-            return 0;
-        }
+    if (xdr_int(xdrs, &data->size) == 0)
+    {
+        return 0;
+    }
+    if (data->size <= 9)
+    {
+        /* Small frames are stored as plain floats */
+        data->precision = -1;
+        return (xdr3dfcoord_data_reserve(data, 3*data->size) &&
+                xdr_vector(xdrs, reinterpret_cast<char *>(data->buf),
+                           static_cast<unsigned int>(3*data->size),
+                           static_cast<unsigned int>(sizeof(float)), (xdrproc_t)xdr_float));
+    }
+    if (xdr_float(xdrs, &data->precision) == 0 ||
+        xdr_int(xdrs, &(data->minint[0])) == 0 ||
+        xdr_int(xdrs, &(data->minint[1])) == 0 ||
+        xdr_int(xdrs, &(data->minint[2])) == 0 ||
+        xdr_int(xdrs, &(data->maxint[0])) == 0 ||
+        xdr_int(xdrs, &(data->maxint[1])) == 0 ||
+        xdr_int(xdrs, &(data->maxint[2])) == 0 ||
+        xdr_int(xdrs, &data->smallidx) == 0 ||
+        xdr_int(xdrs, &nbytes) == 0)
+    {
+        return 0;
+    }
+    if (data->smallidx < FIRSTIDX || data->smallidx >= LASTIDX || nbytes < 0)
+    {
+        return 0;
+    }
+    /* The three leading ints hold the state of receivebits(), the
+     * compressed bytes are followed by padding for the word-wise reads
+     * done by xtc_bitreader.
+     */
+    const int nints = 3 + (nbytes + sizeof(int) - 1)/sizeof(int);
+    if (!xdr3dfcoord_data_reserve(data, nints + c_bitreaderPadding))
+    {
+        return 0;
+    }
+    for (int i = nints - 1; i < nints + c_bitreaderPadding; i++)
+    {
+        data->buf[i] = 0;
+    }
+    data->buf[0] = nbytes;
+    data->nbytes = nbytes;
 
+    return xdr_opaque(xdrs, reinterpret_cast<char *>(&(data->buf[3])), static_cast<unsigned int>(nbytes));
+}
 
+int xdr3dfcoord_write_data(XDR *xdrs, const t_xdr3dfcoord_data *data)
+{
+    int size   = data->size;
+    int nbytes = data->nbytes;
 
-        buf[0] = buf[1] = buf[2] = 0;
+    if (xdr_int(xdrs, &size) == 0)
+    {
+        return 0;
+    }
+    if (size <= 9)
+    {
+        return xdr_vector(xdrs, reinterpret_cast<char *>(data->buf),
+                          static_cast<unsigned int>(3*size),
+                          static_cast<unsigned int>(sizeof(float)), (xdrproc_t)xdr_float);
+    }
+    /* The xdr routines do not modify the values they write */
+    t_xdr3dfcoord_data *d = const_cast<t_xdr3dfcoord_data *>(data);
+
+    return (xdr_float(xdrs, &d->precision) &&
+            xdr_int(xdrs, &(d->minint[0])) &&
+            xdr_int(xdrs, &(d->minint[1])) &&
+            xdr_int(xdrs, &(d->minint[2])) &&
+            xdr_int(xdrs, &(d->maxint[0])) &&
+            xdr_int(xdrs, &(d->maxint[1])) &&
+            xdr_int(xdrs, &(d->maxint[2])) &&
+            xdr_int(xdrs, &d->smallidx) &&
+            xdr_int(xdrs, &nbytes) &&
+            xdr_opaque(xdrs, reinterpret_cast<char *>(&(d->buf[3])), static_cast<unsigned int>(nbytes)));
+}
 
-        lfp           = fp;
-        inv_precision = 1.0 / *precision;
-        run           = 0;
-        i             = 0;
-        lip           = ip;
-        while (i < lsize)
-        {
-            thiscoord = reinterpret_cast<int *>(lip) + i * 3;
+int xdr3dfcoord_decompress_reference(t_xdr3dfcoord_data *data, float *fp)
+{
+    int          *ip, *buf;
+    int           minint[3], *lip;
+    int           smallidx;
+    unsigned      sizeint[3], sizesmall[3], bitsizeint[3];
+    int           flag, k;
+    int           smallnum, smaller, i, is_smaller, run;
+    float        *lfp;
+    int           tmp, *thiscoord,  prevcoord[3];
+    unsigned int  bitsize;
+    float         inv_precision;
+    const int     lsize = data->size;
+
+    if (lsize <= 9)
+    {
+        memcpy(fp, data->buf, 3*lsize*sizeof(*fp));
+        return 1;
+    }
 
-            if (bitsize == 0)
-            {
-                thiscoord[0] = receivebits(buf, bitsizeint[0]);
-                thiscoord[1] = receivebits(buf, bitsizeint[1]);
-                thiscoord[2] = receivebits(buf, bitsizeint[2]);
-            }
-            else
-            {
-                receiveints(buf, 3, bitsize, sizeint, thiscoord);
-            }
+    ip = reinterpret_cast<int *>(malloc(3 * lsize * sizeof(*ip)));
+    if (ip == NULL)
+    {
+        fprintf(stderr, "malloc failed\n");
+        exit(1);
+    }
+    buf = data->buf;
 
-            i++;
-            thiscoord[0] += minint[0];
-            thiscoord[1] += minint[1];
-            thiscoord[2] += minint[2];
+    minint[0] = data->minint[0];
+    minint[1] = data->minint[1];
+    minint[2] = data->minint[2];
 
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
+    sizeint[0] = data->maxint[0] - minint[0]+1;
+    sizeint[1] = data->maxint[1] - minint[1]+1;
+    sizeint[2] = data->maxint[2] - minint[2]+1;
 
+    bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
+    /* check if one of the sizes is to big to be multiplied */
+    if ((sizeint[0] | sizeint[1] | sizeint[2] ) > 0xffffff)
+    {
+        bitsizeint[0] = sizeofint(sizeint[0]);
+        bitsizeint[1] = sizeofint(sizeint[1]);
+        bitsizeint[2] = sizeofint(sizeint[2]);
+        bitsize       = 0; /* flag the use of large sizes */
+    }
+    else
+    {
+        bitsize = sizeofints(3, sizeint);
+    }
 
-            flag       = receivebits(buf, 1);
-            is_smaller = 0;
-            if (flag == 1)
-            {
-                run        = receivebits(buf, 5);
-                is_smaller = run % 3;
-                run       -= is_smaller;
-                is_smaller--;
-            }
-            if (run > 0)
+    smallidx     = data->smallidx;
+    smaller      = magicints[std::max(FIRSTIDX, smallidx-1)] / 2;
+    smallnum     = magicints[smallidx] / 2;
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+
+    buf[0] = buf[1] = buf[2] = 0;
+
+    lfp           = fp;
+    inv_precision = 1.0 / data->precision;
+    run           = 0;
+    i             = 0;
+    lip           = ip;
+    while (i < lsize)
+    {
+        thiscoord = reinterpret_cast<int *>(lip) + i * 3;
+
+        if (bitsize == 0)
+        {
+            thiscoord[0] = receivebits(buf, bitsizeint[0]);
+            thiscoord[1] = receivebits(buf, bitsizeint[1]);
+            thiscoord[2] = receivebits(buf, bitsizeint[2]);
+        }
+        else
+        {
+            receiveints(buf, 3, bitsize, sizeint, thiscoord);
+        }
+
+        i++;
+        thiscoord[0] += minint[0];
+        thiscoord[1] += minint[1];
+        thiscoord[2] += minint[2];
+
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+
+
+        flag       = receivebits(buf, 1);
+        is_smaller = 0;
+        if (flag == 1)
+        {
+            run        = receivebits(buf, 5);
+            is_smaller = run % 3;
+            run       -= is_smaller;
+            is_smaller--;
+        }
+        if (run > 0)
+        {
+            thiscoord += 3;
+            for (k = 0; k < run; k += 3)
             {
-                thiscoord += 3;
-                for (k = 0; k < run; k += 3)
+                receiveints(buf, 3, smallidx, sizesmall, thiscoord);
+                i++;
+                thiscoord[0] += prevcoord[0] - smallnum;
+                thiscoord[1] += prevcoord[1] - smallnum;
+                thiscoord[2] += prevcoord[2] - smallnum;
+                if (k == 0)
                 {
-                    receiveints(buf, 3, smallidx, sizesmall, thiscoord);
-                    i++;
-                    thiscoord[0] += prevcoord[0] - smallnum;
-                    thiscoord[1] += prevcoord[1] - smallnum;
-                    thiscoord[2] += prevcoord[2] - smallnum;
-                    if (k == 0)
-                    {
-                        /* interchange first with second atom for better
-                         * compression of water molecules
-                         */
-                        tmp          = thiscoord[0]; thiscoord[0] = prevcoord[0];
-                        prevcoord[0] = tmp;
-                        tmp          = thiscoord[1]; thiscoord[1] = prevcoord[1];
-                        prevcoord[1] = tmp;
-                        tmp          = thiscoord[2]; thiscoord[2] = prevcoord[2];
-                        prevcoord[2] = tmp;
-                        *lfp++       = prevcoord[0] * inv_precision;
-                        *lfp++       = prevcoord[1] * inv_precision;
-                        *lfp++       = prevcoord[2] * inv_precision;
-                    }
-                    else
-                    {
-                        prevcoord[0] = thiscoord[0];
-                        prevcoord[1] = thiscoord[1];
-                        prevcoord[2] = thiscoord[2];
-                    }
-                    *lfp++ = thiscoord[0] * inv_precision;
-                    *lfp++ = thiscoord[1] * inv_precision;
-                    *lfp++ = thiscoord[2] * inv_precision;
+                    /* interchange first with second atom for better
+                     * compression of water molecules
+                     */
+                    tmp          = thiscoord[0]; thiscoord[0] = prevcoord[0];
+                    prevcoord[0] = tmp;
+                    tmp          = thiscoord[1]; thiscoord[1] = prevcoord[1];
+                    prevcoord[1] = tmp;
+                    tmp          = thiscoord[2]; thiscoord[2] = prevcoord[2];
+                    prevcoord[2] = tmp;
+                    *lfp++       = prevcoord[0] * inv_precision;
+                    *lfp++       = prevcoord[1] * inv_precision;
+                    *lfp++       = prevcoord[2] * inv_precision;
+                }
+                else
+                {
+                    prevcoord[0] = thiscoord[0];
+                    prevcoord[1] = thiscoord[1];
+                    prevcoord[2] = thiscoord[2];
                 }
-            }
-            else
-            {
                 *lfp++ = thiscoord[0] * inv_precision;
                 *lfp++ = thiscoord[1] * inv_precision;
                 *lfp++ = thiscoord[2] * inv_precision;
             }
-            smallidx += is_smaller;
-            if (is_smaller < 0)
+        }
+        else
+        {
+            *lfp++ = thiscoord[0] * inv_precision;
+            *lfp++ = thiscoord[1] * inv_precision;
+            *lfp++ = thiscoord[2] * inv_precision;
+        }
+        smallidx += is_smaller;
+        if (is_smaller < 0)
+        {
+            smallnum = smaller;
+            if (smallidx > FIRSTIDX)
             {
-                smallnum = smaller;
-                if (smallidx > FIRSTIDX)
-                {
-                    smaller = magicints[smallidx - 1] /2;
-                }
-                else
-                {
-                    smaller = 0;
-                }
+                smaller = magicints[smallidx - 1] /2;
             }
-            else if (is_smaller > 0)
+            else
             {
-                smaller  = smallnum;
-                smallnum = magicints[smallidx] / 2;
+                smaller = 0;
             }
-            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
         }
+        else if (is_smaller > 0)
+        {
+            smaller  = smallnum;
+            smallnum = magicints[smallidx] / 2;
+        }
+        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
     }
-    if (we_should_free)
-    {
-        free(ip);
-        free(buf);
-    }
+    free(ip);
+
     return 1;
 }
 
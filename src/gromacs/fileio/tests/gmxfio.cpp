@@ -0,0 +1,267 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for file handling in gmxfio.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/gmxfio.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio-xdr.h"
+#include "gromacs/fileio/md5.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Number of bytes at the end of a file that is covered by the checksum.
+const int c_chksumLength = 1048576;
+
+class FileChecksumTest : public ::testing::Test
+{
+    public:
+        FileChecksumTest()
+        {
+            filename_ = fileManager_.getTemporaryFilePath("output.log");
+            fio_      = gmx_fio_open(filename_.c_str(), "w+");
+        }
+        ~FileChecksumTest()
+        {
+            gmx_fio_close(fio_);
+        }
+
+        //! Appends n bytes to the file and to the reference contents.
+        void write(int n)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                contents_.push_back(static_cast<unsigned char>((contents_.size()*7919) >> 3));
+            }
+            ASSERT_EQ(static_cast<size_t>(n),
+                      std::fwrite(&contents_[contents_.size() - n], 1, n, gmx_fio_getfp(fio_)));
+        }
+
+        //! Checks the checksum stored in a checkpoint against the reference contents.
+        void checkChecksum()
+        {
+            gmx_file_position_t *outputfiles;
+            int                  nfiles;
+
+            gmx_fio_get_output_file_positions(&outputfiles, &nfiles);
+            ASSERT_EQ(1, nfiles);
+            EXPECT_EQ(static_cast<gmx_off_t>(contents_.size()), outputfiles[0].offset);
+
+            int           length = std::min(static_cast<int>(contents_.size()), c_chksumLength);
+            md5_state_t   state;
+            unsigned char digest[16];
+            gmx_md5_init(&state);
+            gmx_md5_append(&state, &contents_[contents_.size() - length], length);
+            gmx_md5_finish(&state, digest);
+
+            EXPECT_EQ(length, outputfiles[0].chksum_size);
+            for (int i = 0; i < 16; ++i)
+            {
+                EXPECT_EQ(digest[i], outputfiles[0].chksum[i]);
+            }
+            sfree(outputfiles);
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+        t_fileio                  *fio_;
+        std::vector<unsigned char> contents_;
+};
+
+TEST_F(FileChecksumTest, MatchesContentsOfGrowingFile)
+{
+    write(1000);
+    checkChecksum();
+    write(1);
+    checkChecksum();
+    // Wrap around the end of the kept bytes
+    write(c_chksumLength - 500);
+    checkChecksum();
+    write(3000);
+    checkChecksum();
+    // Write more than is covered by the checksum between checks
+    write(2*c_chksumLength + 17);
+    checkChecksum();
+    checkChecksum();
+}
+
+TEST_F(FileChecksumTest, MatchesContentsAfterRewind)
+{
+    write(5000);
+    checkChecksum();
+    gmx_fio_rewind(fio_);
+    contents_.clear();
+    write(300);
+    checkChecksum();
+}
+
+//! Sets or clears GMX_FIO_MMAP, which selects reading through a memory map.
+void setUseMemoryMap(bool bUseMemoryMap)
+{
+#ifdef _MSC_VER
+    _putenv_s("GMX_FIO_MMAP", bUseMemoryMap ? "1" : "");
+#else
+    if (bUseMemoryMap)
+    {
+        setenv("GMX_FIO_MMAP", "1", 1);
+    }
+    else
+    {
+        unsetenv("GMX_FIO_MMAP");
+    }
+#endif
+}
+
+/*! \brief
+ * Test fixture for reading a file of integers, with the parameter
+ * selecting whether the file is read through a memory map.
+ */
+class FileReadTest : public ::testing::TestWithParam<bool>
+{
+    public:
+        FileReadTest()
+        {
+            filename_ = fileManager_.getTemporaryFilePath("input.trr");
+            t_fileio *fio = gmx_fio_open(filename_.c_str(), "w");
+            for (int i = 0; i < c_valueCount; ++i)
+            {
+                int value = i*i;
+                gmx_fio_do_int(fio, value);
+            }
+            gmx_fio_close(fio);
+            setUseMemoryMap(GetParam());
+            fio_ = gmx_fio_open(filename_.c_str(), "r");
+        }
+        ~FileReadTest()
+        {
+            gmx_fio_close(fio_);
+            setUseMemoryMap(false);
+        }
+
+        //! Appends values first to last-1 to the file using a separate handle.
+        void append(int first, int last)
+        {
+            t_fileio *fio = gmx_fio_open(filename_.c_str(), "a");
+            for (int i = first; i < last; ++i)
+            {
+                int value = i*i;
+                gmx_fio_do_int(fio, value);
+            }
+            gmx_fio_close(fio);
+        }
+
+        //! Reads values first to last-1 and checks them and the position.
+        void checkRead(int first, int last)
+        {
+            for (int i = first; i < last; ++i)
+            {
+                EXPECT_EQ(static_cast<gmx_off_t>(4*i), gmx_fio_ftell(fio_));
+                int value = -1;
+                ASSERT_TRUE(gmx_fio_do_int(fio_, value));
+                EXPECT_EQ(i*i, value);
+            }
+        }
+
+        //! Number of integers in the file.
+        static const int           c_valueCount = 1000;
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+        t_fileio                  *fio_;
+};
+
+TEST_P(FileReadTest, ReadsSeeksAndRewinds)
+{
+    checkRead(0, 10);
+    ASSERT_EQ(0, gmx_fio_seek(fio_, 4*500));
+    checkRead(500, 600);
+    gmx_fio_rewind(fio_);
+    checkRead(0, 5);
+    ASSERT_EQ(0, gmx_fio_seek(fio_, 4*(c_valueCount - 2)));
+    checkRead(c_valueCount - 2, c_valueCount);
+    int value;
+    EXPECT_FALSE(gmx_fio_do_int(fio_, value));
+}
+
+TEST_P(FileReadTest, ContinuesAfterDirectFileAccess)
+{
+    checkRead(0, 100);
+    FILE *fp = gmx_fio_getfp(fio_);
+    ASSERT_TRUE(fp != NULL);
+    EXPECT_EQ(4*100, std::ftell(fp));
+    checkRead(100, c_valueCount);
+    int value;
+    EXPECT_FALSE(gmx_fio_do_int(fio_, value));
+}
+
+// Tools like gmx check can read a trajectory mdrun is still writing
+TEST_P(FileReadTest, ReadsDataAppendedAfterOpening)
+{
+    checkRead(0, c_valueCount - 3);
+    append(c_valueCount, c_valueCount + 200);
+    checkRead(c_valueCount - 3, c_valueCount + 100);
+    ASSERT_EQ(0, gmx_fio_seek(fio_, 4*(c_valueCount + 150)));
+    checkRead(c_valueCount + 150, c_valueCount + 200);
+    int value;
+    EXPECT_FALSE(gmx_fio_do_int(fio_, value));
+    append(c_valueCount + 200, c_valueCount + 201);
+    ASSERT_EQ(0, gmx_fio_seek(fio_, 4*(c_valueCount + 200)));
+    checkRead(c_valueCount + 200, c_valueCount + 201);
+    gmx_fio_rewind(fio_);
+    checkRead(0, 5);
+}
+
+INSTANTIATE_TEST_CASE_P(WithAndWithoutMemoryMap, FileReadTest,
+                            ::testing::Bool());
+
+} // namespace
@@ -0,0 +1,208 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the xtc coordinate decompression routines.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xdrf.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/timing/walltime_accounting.h"
+#include "gromacs/utility/real.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+class XdrCoordinateTest : public ::testing::Test
+{
+    public:
+        XdrCoordinateTest() : seed_(12345)
+        {
+            xdr3dfcoord_data_init(&data_);
+            filename_ = fileManager_.getTemporaryFilePath("coords.xdr");
+        }
+        ~XdrCoordinateTest()
+        {
+            xdr3dfcoord_data_done(&data_);
+        }
+
+        //! Returns a pseudo-random number in [0, 1).
+        float random()
+        {
+            seed_ = seed_*1103515245U + 12345U;
+            return ((seed_ >> 8) & 0xffffff)/static_cast<float>(0x1000000);
+        }
+
+        /*! \brief
+         * Generates water-like coordinates in a cubic box of size boxSize.
+         *
+         * Every third atom is placed randomly, with the next two atoms
+         * close to it, which exercises the run-length encoding of small
+         * differences.
+         */
+        void generateCoordinates(int natoms, float boxSize)
+        {
+            x_.resize(3*natoms);
+            for (int i = 0; i < natoms; ++i)
+            {
+                for (int d = 0; d < 3; ++d)
+                {
+                    if (i % 3 == 0)
+                    {
+                        x_[3*i + d] = boxSize*random();
+                    }
+                    else
+                    {
+                        x_[3*i + d] = x_[3*(i - i % 3) + d] + 0.1f*(random() - 0.5f);
+                    }
+                }
+            }
+        }
+
+        //! Compresses x_ to the file and reads back the compressed data.
+        void compressAndReadData(float precision)
+        {
+            int   size = x_.size()/3;
+            FILE *fp   = std::fopen(filename_.c_str(), "wb");
+            XDR   xd;
+            ASSERT_TRUE(fp != NULL);
+            xdrstdio_create(&xd, fp, XDR_ENCODE);
+            ASSERT_EQ(1, xdr3dfcoord(&xd, &x_[0], &size, &precision));
+            xdr_destroy(&xd);
+            std::fclose(fp);
+
+            fp = std::fopen(filename_.c_str(), "rb");
+            ASSERT_TRUE(fp != NULL);
+            xdrstdio_create(&xd, fp, XDR_DECODE);
+            ASSERT_EQ(1, xdr3dfcoord_read_data(&xd, &data_));
+            xdr_destroy(&xd);
+            std::fclose(fp);
+            ASSERT_EQ(size, data_.size);
+        }
+
+        //! Checks that both decoders produce identical coordinates.
+        void testDecodersAgree(int natoms, float boxSize, float precision)
+        {
+            generateCoordinates(natoms, boxSize);
+            compressAndReadData(precision);
+            std::vector<float> fast(x_.size()), reference(x_.size());
+            ASSERT_EQ(1, xdr3dfcoord_decompress(&data_, &fast[0]));
+            ASSERT_EQ(1, xdr3dfcoord_decompress_reference(&data_, &reference[0]));
+            for (size_t i = 0; i < x_.size(); ++i)
+            {
+                ASSERT_EQ(reference[i], fast[i]) << "at index " << i;
+                // Large coordinates can not be represented to within 1/precision
+                EXPECT_NEAR(x_[i], fast[i], 1.0/precision + std::abs(x_[i])*GMX_FLOAT_EPS);
+            }
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+        unsigned int               seed_;
+        std::vector<float>         x_;
+        t_xdr3dfcoord_data         data_;
+};
+
+TEST_F(XdrCoordinateTest, DecodersAgreeForSmallFrames)
+{
+    testDecodersAgree(7, 3.0, 1000);
+}
+
+TEST_F(XdrCoordinateTest, DecodersAgreeForWater)
+{
+    testDecodersAgree(3000, 5.0, 1000);
+}
+
+TEST_F(XdrCoordinateTest, DecodersAgreeForHighPrecision)
+{
+    testDecodersAgree(3000, 5.0, 1e5);
+}
+
+TEST_F(XdrCoordinateTest, DecodersAgreeForLargeCombinedIntegers)
+{
+    // Coordinate ranges just below 2^24 need more than 64 bits for three
+    // combined integers.
+    testDecodersAgree(300, 8000.0, 1000);
+}
+
+TEST_F(XdrCoordinateTest, DecodersAgreeForLargeRanges)
+{
+    // Coordinate ranges above 2^24 are stored with separate bit sizes.
+    testDecodersAgree(300, 30000.0, 1000);
+}
+
+/*! \brief
+ * Compares the speed of the fast and the reference decoder.
+ *
+ * Run with --gtest_also_run_disabled_tests.
+ */
+TEST_F(XdrCoordinateTest, DISABLED_BenchmarkDecompression)
+{
+    const int natoms  = 3000000;
+    const int nrepeat = 5;
+    generateCoordinates(natoms, 31.0);
+    compressAndReadData(1000);
+    std::vector<float> x(x_.size());
+
+    double             start = gmx_gettime();
+    for (int i = 0; i < nrepeat; ++i)
+    {
+        xdr3dfcoord_decompress_reference(&data_, &x[0]);
+    }
+    double             referenceTime = (gmx_gettime() - start)/nrepeat;
+    start = gmx_gettime();
+    for (int i = 0; i < nrepeat; ++i)
+    {
+        xdr3dfcoord_decompress(&data_, &x[0]);
+    }
+    double             fastTime = (gmx_gettime() - start)/nrepeat;
+    std::printf("Decompressing %d atoms: reference %.3f s, fast %.3f s, speedup %.2f\n",
+                natoms, referenceTime, fastTime, referenceTime/fastTime);
+}
+
+} // namespace
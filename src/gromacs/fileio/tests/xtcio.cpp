@@ -0,0 +1,258 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for xtc frame index files and read-ahead buffers.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Number of atoms in the test trajectory.
+const int c_natoms  = 20;
+//! Number of frames in the test trajectory.
+const int c_nframes = 10;
+
+class XtcTest : public ::testing::Test
+{
+    public:
+        XtcTest()
+            : index_(NULL), x_(c_natoms)
+        {
+            filename_ = fileManager_.getTemporaryFilePath("traj.xtc");
+            fileManager_.getTemporaryFilePath("traj.xtc.idx");
+            clear_mat(box_);
+            box_[XX][XX] = box_[YY][YY] = box_[ZZ][ZZ] = 3;
+        }
+        ~XtcTest()
+        {
+            xtc_index_done(index_);
+        }
+
+        //! Writes c_nframes frames to the trajectory, indexing the first nindexed.
+        void writeTrajectory(int nindexed)
+        {
+            index_ = xtc_index_init();
+            t_fileio *fio = open_xtc(filename_.c_str(), "w");
+            for (int frame = 0; frame < c_nframes; ++frame)
+            {
+                for (int i = 0; i < c_natoms; ++i)
+                {
+                    x_[i] = gmx::RVec(0.1*i, 0.01*frame, 0.5 + 0.02*(i % 3));
+                }
+                if (frame < nindexed)
+                {
+                    xtc_index_add_frame(index_, gmx_fio_ftell(fio), c_natoms,
+                                        10*frame, 0.5*frame);
+                }
+                ASSERT_EQ(1, write_xtc(fio, c_natoms, 10*frame, 0.5*frame, box_,
+                                       as_rvec_array(&x_[0]), 1000));
+            }
+            close_xtc(fio);
+        }
+
+        //! Reads the next frame from fio and returns its step.
+        int readNextStep(t_fileio *fio)
+        {
+            int      step;
+            real     time, prec;
+            gmx_bool bOK;
+            EXPECT_EQ(1, read_next_xtc(fio, c_natoms, &step, &time, box_,
+                                       as_rvec_array(&x_[0]), &prec, &bOK));
+            return step;
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                filename_;
+        t_xtc_index               *index_;
+        std::vector<gmx::RVec>     x_;
+        matrix                     box_;
+};
+
+TEST_F(XtcTest, IndexReadsWhatWasWritten)
+{
+    writeTrajectory(c_nframes);
+    ASSERT_EQ(1, xtc_index_write(index_, filename_.c_str()));
+    t_xtc_index *index = xtc_index_read(filename_.c_str());
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ(c_nframes, xtc_index_nframes(index));
+    xtc_index_done(index);
+}
+
+TEST_F(XtcTest, IndexReturnsNullWithoutIndexFile)
+{
+    writeTrajectory(0);
+    EXPECT_TRUE(xtc_index_read(filename_.c_str()) == NULL);
+}
+
+TEST_F(XtcTest, IndexSeeksToTime)
+{
+    writeTrajectory(c_nframes);
+    t_fileio *fio = open_xtc(filename_.c_str(), "r");
+    EXPECT_EQ(0, xtc_index_seek_time(fio, index_, 3.2, c_natoms));
+    EXPECT_EQ(70, readNextStep(fio));
+    EXPECT_EQ(0, xtc_index_seek_time(fio, index_, 1.0, c_natoms));
+    EXPECT_EQ(20, readNextStep(fio));
+    EXPECT_EQ(0, xtc_index_seek_time(fio, index_, 0.0, c_natoms));
+    EXPECT_EQ(0, readNextStep(fio));
+    close_xtc(fio);
+}
+
+TEST_F(XtcTest, IndexRejectsIndexOfOtherFile)
+{
+    writeTrajectory(c_nframes);
+    t_xtc_index *index = xtc_index_init();
+    xtc_index_add_frame(index, 0, c_natoms, 0, 0.0);
+    xtc_index_add_frame(index, gmx_off_t(100), c_natoms, 10, 0.5);
+    t_fileio *fio = open_xtc(filename_.c_str(), "r");
+    EXPECT_EQ(1, xtc_index_seek_time(fio, index, 0.5, c_natoms));
+    EXPECT_EQ(0, readNextStep(fio));
+    EXPECT_EQ(1, xtc_index_seek_time(fio, index_, 1.0, c_natoms + 1));
+    close_xtc(fio);
+    xtc_index_done(index);
+}
+
+TEST_F(XtcTest, IndexIsCompletedFromTrajectory)
+{
+    writeTrajectory(4);
+    t_fileio *fio = open_xtc(filename_.c_str(), "r");
+    gmx_fseek(gmx_fio_getfp(fio), 0, SEEK_END);
+    gmx_off_t end = gmx_ftell(gmx_fio_getfp(fio));
+    index_        = xtc_index_complete(index_, filename_.c_str(), end);
+    EXPECT_EQ(c_nframes, xtc_index_nframes(index_));
+    EXPECT_EQ(0, xtc_index_seek_time(fio, index_, 4.5, c_natoms));
+    EXPECT_EQ(90, readNextStep(fio));
+    close_xtc(fio);
+}
+
+TEST_F(XtcTest, IndexIsBuiltFromTrajectoryUpToEnd)
+{
+    writeTrajectory(0);
+    t_fileio *fio = open_xtc(filename_.c_str(), "r");
+    for (int frame = 0; frame < 7; ++frame)
+    {
+        readNextStep(fio);
+    }
+    gmx_off_t    end   = gmx_fio_ftell(fio);
+    t_xtc_index *index = xtc_index_complete(NULL, filename_.c_str(), end);
+    EXPECT_EQ(7, xtc_index_nframes(index));
+    EXPECT_EQ(0, xtc_index_seek_time(fio, index, 3.0, c_natoms));
+    EXPECT_EQ(60, readNextStep(fio));
+    close_xtc(fio);
+    xtc_index_done(index);
+}
+
+TEST_F(XtcTest, ReadaheadMatchesDirectReading)
+{
+    writeTrajectory(c_nframes);
+    t_fileio        *fio   = open_xtc(filename_.c_str(), "r");
+    t_fileio        *fioRA = open_xtc(filename_.c_str(), "r");
+    t_xtc_readahead *ra    = xtc_readahead_init(c_natoms, 3);
+    std::vector<gmx::RVec> x(c_natoms), xRA(c_natoms);
+    int              step, stepRA;
+    real             time, timeRA, prec, precRA;
+    matrix           box, boxRA;
+    gmx_bool         bOK, bOKRA;
+    gmx_off_t        offset;
+
+    for (int frame = 0; frame < c_nframes; ++frame)
+    {
+        gmx_off_t expectedOffset = gmx_fio_ftell(fio);
+        ASSERT_EQ(1, read_next_xtc(fio, c_natoms, &step, &time, box,
+                                   as_rvec_array(&x[0]), &prec, &bOK));
+        ASSERT_EQ(1, read_next_xtc_readahead(fioRA, ra, &stepRA, &timeRA, boxRA,
+                                             as_rvec_array(&xRA[0]), &precRA,
+                                             &bOKRA, &offset));
+        EXPECT_EQ(expectedOffset, offset);
+        EXPECT_EQ(step, stepRA);
+        EXPECT_EQ(time, timeRA);
+        EXPECT_EQ(prec, precRA);
+        for (int i = 0; i < c_natoms; ++i)
+        {
+            EXPECT_EQ(x[i][XX], xRA[i][XX]);
+            EXPECT_EQ(x[i][YY], xRA[i][YY]);
+            EXPECT_EQ(x[i][ZZ], xRA[i][ZZ]);
+        }
+    }
+    EXPECT_EQ(0, read_next_xtc_readahead(fioRA, ra, &stepRA, &timeRA, boxRA,
+                                         as_rvec_array(&xRA[0]), &precRA,
+                                         &bOKRA, &offset));
+    EXPECT_TRUE(bOKRA);
+    xtc_readahead_done(ra);
+    close_xtc(fioRA);
+    close_xtc(fio);
+}
+
+TEST_F(XtcTest, ReadaheadDiscardRestoresPosition)
+{
+    writeTrajectory(c_nframes);
+    t_fileio        *fio = open_xtc(filename_.c_str(), "r");
+    t_xtc_readahead *ra  = xtc_readahead_init(c_natoms, 4);
+    int              step;
+    real             time, prec;
+    gmx_bool         bOK;
+    gmx_off_t        offset;
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        ASSERT_EQ(1, read_next_xtc_readahead(fio, ra, &step, &time, box_,
+                                             as_rvec_array(&x_[0]), &prec,
+                                             &bOK, &offset));
+        EXPECT_EQ(10*frame, step);
+    }
+    xtc_readahead_discard(fio, ra);
+    EXPECT_EQ(20, readNextStep(fio));
+    xtc_readahead_done(ra);
+    close_xtc(fio);
+}
+
+} // namespace
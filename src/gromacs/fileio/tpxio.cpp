@@ -97,6 +97,7 @@ enum tpxv {
     tpxv_PullGeomDirRel,                                     /**< add pull geometry direction-relative */
     tpxv_IntermolecularBondeds,                              /**< permit inter-molecular bonded interactions in the topology */
     tpxv_CompElWithSwapLayerOffset,                          /**< added parameters for improved CompEl setups */
+    tpxv_MultipleTimeStepping,                               /**< multiple time stepping for long-range nonbonded forces */
     tpxv_Count                                               /**< the total number of tpxv versions */
 };
 
@@ -1004,6 +1005,16 @@ static void do_inputrec(t_fileio *fio, t_inputrec *ir, gmx_bool bRead,
         /* Calculate at NS steps */
         ir->nstcalclr = ir->nstlist;
     }
+    if (file_version >= tpxv_MultipleTimeStepping)
+    {
+        gmx_fio_do_int(fio, ir->mts_level2_forces);
+        gmx_fio_do_int(fio, ir->mts_level2_factor);
+    }
+    else
+    {
+        ir->mts_level2_forces = emtsNONE;
+        ir->mts_level2_factor = 1;
+    }
     gmx_fio_do_int(fio, ir->coulombtype);
     if (file_version < 32 && ir->coulombtype == eelRF)
     {
@@ -234,6 +234,13 @@ do_trr_frame(t_fileio *fio, bool bRead, int *step, real *t, real *lambda,
     return bOK;
 }
 
+/* Returns the number of bytes of data following the header of a frame */
+static int trr_frame_data_size(const gmx_trr_header_t *sh)
+{
+    return (sh->box_size + sh->vir_size + sh->pres_size +
+            sh->x_size + sh->v_size + sh->f_size);
+}
+
 /************************************************************
  *
  *  The following routines are the exported ones
@@ -294,6 +301,44 @@ gmx_bool gmx_trr_read_frame_data(t_fileio *fio, gmx_trr_header_t *header,
     return do_trr_frame_data(fio, header, box, x, v, f);
 }
 
+gmx_bool gmx_trr_read_frame_raw(t_fileio *fio, gmx_trr_header_t *header,
+                                int *nalloc, char **data, gmx_bool *bOK)
+{
+    int nbytes;
+
+    if (!do_trr_frame_header(fio, true, header, bOK))
+    {
+        return FALSE;
+    }
+    if (header->ir_size || header->e_size || header->top_size || header->sym_size)
+    {
+        gmx_file("Unsupported data in trr file");
+    }
+    nbytes = trr_frame_data_size(header);
+    if (nbytes > *nalloc)
+    {
+        *nalloc = nbytes;
+        srenew(*data, *nalloc);
+    }
+    /* All sizes are multiples of four bytes, so there is no padding */
+    *bOK = xdr_opaque(gmx_fio_getxdr(fio), *data, nbytes);
+
+    return *bOK;
+}
+
+void gmx_trr_write_frame_raw(t_fileio *fio, gmx_trr_header_t *header,
+                             const char *data)
+{
+    gmx_bool bOK;
+
+    if (!do_trr_frame_header(fio, false, header, &bOK) ||
+        !xdr_opaque(gmx_fio_getxdr(fio), const_cast<char *>(data),
+                    trr_frame_data_size(header)))
+    {
+        gmx_file("Cannot write trajectory frame; maybe you are out of disk space?");
+    }
+}
+
 t_fileio *gmx_trr_open(const char *fn, const char *mode)
 {
     return gmx_fio_open(fn, mode);
@@ -115,6 +115,22 @@ void gmx_trr_write_frame(struct t_fileio *fio, int step, real t, real lambda,
                          rvec *box, int natoms, rvec *x, rvec *v, rvec *f);
 /* Write a trr frame to file fp, box, x, v, f may be NULL */
 
+gmx_bool gmx_trr_read_frame_raw(struct t_fileio *fio, gmx_trr_header_t *header,
+                                int *nalloc, char **data, gmx_bool *bOK);
+/* Read a trr frame without converting its contents. The header is
+ * stored in header and the box, coordinate, velocity and force data
+ * following it are stored as they are in the file in *data, which is
+ * reallocated to *nalloc bytes when it is too small.
+ * Return FALSE if there is no frame, bOK tells if the frame is complete.
+ */
+
+void gmx_trr_write_frame_raw(struct t_fileio *fio, gmx_trr_header_t *header,
+                             const char *data);
+/* Write a frame read with gmx_trr_read_frame_raw(), the step, time and
+ * lambda in header may be changed in between. The precision of the
+ * frame is kept.
+ */
+
 void gmx_trr_read_single_header(const char *fn, gmx_trr_header_t *header);
 /* Read the header of a trr file from fn, and close the file afterwards.
  */
@@ -42,6 +42,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #include "gromacs/fileio/confio.h"
@@ -66,6 +67,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 #ifdef GMX_USE_PLUGINS
@@ -88,6 +90,9 @@ struct t_trxstatus
     double                  DT, BOX[3];
     gmx_bool                bReadBox;
     char                   *persistent_line; /* Persistent line for reading g96 trajectories */
+    struct t_xtc_index     *xtcIndex;        /* Frame index of an xtc file, or NULL */
+    gmx_bool                bXtcIndexWrite;  /* Whether xtcIndex is being filled and should be written */
+    struct t_xtc_readahead *xtcReadahead;    /* Read-ahead buffer for xtc files, or NULL */
 };
 
 /* utility functions */
@@ -165,6 +170,38 @@ static void status_init(t_trxstatus *status)
     status->__frame         = -1;
     status->persistent_line = NULL;
     status->tng             = NULL;
+    status->xtcIndex        = NULL;
+    status->bXtcIndexWrite  = FALSE;
+    status->xtcReadahead    = NULL;
+}
+
+/* Stops filling the xtc index, writing it when bWrite is set */
+static void finish_xtc_index(t_trxstatus *status, gmx_bool bWrite)
+{
+    if (status->bXtcIndexWrite && bWrite)
+    {
+        if (!xtc_index_write(status->xtcIndex, gmx_fio_getname(status->fio)))
+        {
+            gmx_warning("Could not write the frame index for %s",
+                        gmx_fio_getname(status->fio));
+        }
+    }
+    if (status->bXtcIndexWrite)
+    {
+        xtc_index_done(status->xtcIndex);
+        status->xtcIndex       = NULL;
+        status->bXtcIndexWrite = FALSE;
+    }
+}
+
+/* Records an xtc frame whose header starts at offset in the index */
+static void add_xtc_index_frame(t_trxstatus *status, gmx_off_t offset,
+                                int natoms, const t_trxframe *fr)
+{
+    if (status->bXtcIndexWrite)
+    {
+        xtc_index_add_frame(status->xtcIndex, offset, natoms, fr->step, fr->time);
+    }
 }
 
 
@@ -396,6 +433,7 @@ int write_trxframe_indexed(t_trxstatus *status, t_trxframe *fr, int nind,
             gmx_write_tng_from_trxframe(status->tng, fr, nind);
             break;
         case efXTC:
+            add_xtc_index_frame(status, gmx_fio_ftell(status->fio), nind, fr);
             write_xtc(status->fio, nind, fr->step, fr->time, fr->box, xout, prec);
             break;
         case efTRR:
@@ -548,6 +586,7 @@ int write_trxframe(t_trxstatus *status, t_trxframe *fr, gmx_conect gc)
     switch (gmx_fio_getftp(status->fio))
     {
         case efXTC:
+            add_xtc_index_frame(status, gmx_fio_ftell(status->fio), fr->natoms, fr);
             write_xtc(status->fio, fr->natoms, fr->step, fr->time, fr->box, fr->x, prec);
             break;
         case efTRR:
@@ -616,8 +655,11 @@ void close_trx(t_trxstatus *status)
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
+        finish_xtc_index(status, !gmx_fio_getread(status->fio));
         gmx_fio_close(status->fio);
     }
+    xtc_index_done(status->xtcIndex);
+    xtc_readahead_done(status->xtcReadahead);
     sfree(status);
 }
 
@@ -633,6 +675,11 @@ t_trxstatus *open_trx(const char *outfile, const char *filemode)
     status_init(stat);
 
     stat->fio = gmx_fio_open(outfile, filemode);
+    if (gmx_fio_getftp(stat->fio) == efXTC)
+    {
+        stat->xtcIndex       = xtc_index_open_for_writing(stat->fio, filemode[0] == 'a');
+        stat->bXtcIndexWrite = (stat->xtcIndex != NULL);
+    }
     return stat;
 }
 
@@ -791,10 +838,11 @@ static int pdb_first_x(t_trxstatus *status, FILE *fp, t_trxframe *fr)
 
 gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_trxframe *fr)
 {
-    real     pt;
-    int      ct;
-    gmx_bool bOK, bRet, bMissingData = FALSE, bSkip = FALSE;
-    int      ftp;
+    real      pt;
+    int       ct;
+    gmx_bool  bOK, bRet, bMissingData = FALSE, bSkip = FALSE;
+    int       ftp;
+    gmx_off_t offset;
 
     bRet = FALSE;
     pt   = fr->tf;
@@ -843,15 +891,57 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
                  */
                 if (bTimeSet(TBEGIN) && (fr->tf < rTimeValue(TBEGIN)))
                 {
-                    if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
+                    int ret = 1;
+
+                    /* An index built while reading would miss frames */
+                    finish_xtc_index(status, FALSE);
+                    if (status->xtcReadahead)
+                    {
+                        xtc_readahead_discard(status->fio, status->xtcReadahead);
+                    }
+                    if (status->xtcIndex)
+                    {
+                        ret = xtc_index_seek_time(status->fio, status->xtcIndex,
+                                                  rTimeValue(TBEGIN), fr->natoms);
+                        if (ret == 1)
+                        {
+                            /* The index does not match the file, ignore it */
+                            xtc_index_done(status->xtcIndex);
+                            status->xtcIndex = NULL;
+                        }
+                    }
+                    if (ret == 1)
+                    {
+                        ret = xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE);
+                    }
+                    if (ret)
                     {
                         gmx_fatal(FARGS, "Specified frame (time %f) doesn't exist or file corrupt/inconsistent.",
                                   rTimeValue(TBEGIN));
                     }
                     initcount(status);
                 }
-                bRet = read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box,
-                                     fr->x, &fr->prec, &bOK);
+                if (status->xtcReadahead)
+                {
+                    bRet = read_next_xtc_readahead(status->fio, status->xtcReadahead,
+                                                   &fr->step, &fr->time, fr->box,
+                                                   fr->x, &fr->prec, &bOK, &offset);
+                }
+                else
+                {
+                    offset = gmx_fio_ftell(status->fio);
+                    bRet   = read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box,
+                                           fr->x, &fr->prec, &bOK);
+                }
+                if (bRet)
+                {
+                    add_xtc_index_frame(status, offset, fr->natoms, fr);
+                }
+                else
+                {
+                    /* Only an index of the complete file is written */
+                    finish_xtc_index(status, bOK);
+                }
                 fr->bPrec = (bRet && fr->prec > 0);
                 fr->bStep = bRet;
                 fr->bTime = bRet;
@@ -1005,6 +1095,30 @@ int read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
                 fr->bX    = TRUE;
                 fr->bBox  = TRUE;
                 printcount(*status, oenv, fr->time, FALSE);
+
+                (*status)->xtcIndex = xtc_index_read(fn);
+                if ((*status)->xtcIndex == NULL && getenv("GMX_XTC_INDEX") != NULL)
+                {
+                    /* Build the index while reading, it is written when
+                     * the end of the file is reached.
+                     */
+                    (*status)->xtcIndex       = xtc_index_init();
+                    (*status)->bXtcIndexWrite = TRUE;
+                    add_xtc_index_frame(*status, 0, fr->natoms, fr);
+                }
+
+                /* Decompress frames in parallel when requested and there
+                 * are threads available. This is opt-in, since the file
+                 * position is then ahead of the returned frame, which
+                 * affects callers using the position from trx_get_fileio().
+                 * Small frames are not compressed.
+                 */
+                int nthreads = gmx_omp_get_max_threads();
+                if (getenv("GMX_XTC_READAHEAD") != NULL &&
+                    nthreads > 1 && fr->natoms > 9)
+                {
+                    (*status)->xtcReadahead = xtc_readahead_init(fr->natoms, nthreads);
+                }
             }
             bFirst = FALSE;
             break;
@@ -1116,13 +1230,145 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
     return bRet;
 }
 
+struct t_trxframe_raw
+{
+    int                     ftp;       /* File type of the frame */
+    struct t_xtc_raw_frame *xtc;       /* Frame data of an xtc frame */
+    gmx_trr_header_t        trrHeader; /* Header of a trr frame */
+    int                     trrNalloc; /* Allocation size of trrData */
+    char                   *trrData;   /* Data of a trr frame */
+};
+
+t_trxframe_raw *trxframe_raw_init(void)
+{
+    t_trxframe_raw *raw;
+
+    snew(raw, 1);
+    raw->ftp       = efXTC;
+    raw->xtc       = xtc_raw_frame_init();
+    raw->trrNalloc = 0;
+    raw->trrData   = NULL;
+
+    return raw;
+}
+
+void trxframe_raw_done(t_trxframe_raw *raw)
+{
+    if (raw)
+    {
+        xtc_raw_frame_done(raw->xtc);
+        sfree(raw->trrData);
+        sfree(raw);
+    }
+}
+
+gmx_bool trx_format_supports_raw(int ftp)
+{
+    return (ftp == efXTC || ftp == efTRR);
+}
+
+gmx_bool read_first_frame_raw(t_trxstatus **status, const char *fn,
+                              t_trxframe *fr, t_trxframe_raw *raw)
+{
+    if (!trx_format_supports_raw(fn2ftp(fn)))
+    {
+        gmx_fatal(FARGS, "Can not read raw frames from %s files",
+                  ftp2ext(fn2ftp(fn)));
+    }
+    snew(*status, 1);
+    status_init(*status);
+    (*status)->fio = gmx_fio_open(fn, "r");
+    clear_trxframe(fr, TRUE);
+
+    return read_next_frame_raw(*status, fr, raw);
+}
+
+gmx_bool read_next_frame_raw(t_trxstatus *status, t_trxframe *fr,
+                             t_trxframe_raw *raw)
+{
+    gmx_bool bOK  = TRUE;
+    gmx_bool bRet = FALSE;
+
+    raw->ftp   = gmx_fio_getftp(status->fio);
+    fr->not_ok = 0;
+    switch (raw->ftp)
+    {
+        case efXTC:
+            bRet = read_next_xtc_raw(status->fio, raw->xtc, &fr->natoms,
+                                     &fr->step, &fr->time, &bOK);
+            break;
+        case efTRR:
+            bRet = gmx_trr_read_frame_raw(status->fio, &raw->trrHeader,
+                                          &raw->trrNalloc, &raw->trrData, &bOK);
+            if (bRet)
+            {
+                fr->natoms  = raw->trrHeader.natoms;
+                fr->step    = raw->trrHeader.step;
+                fr->time    = raw->trrHeader.t;
+                fr->lambda  = raw->trrHeader.lambda;
+                fr->bLambda = TRUE;
+            }
+            break;
+        default:
+            gmx_incons("Raw frame of unsupported file type");
+    }
+    if (!bOK)
+    {
+        fr->not_ok = DATA_NOT_OK;
+        printincomp(status, fr);
+        bRet = FALSE;
+    }
+    if (bRet)
+    {
+        fr->bStep = TRUE;
+        fr->bTime = TRUE;
+        status->__frame++;
+    }
+
+    return bRet;
+}
+
+void write_trxframe_raw(t_trxstatus *status, const t_trxframe *fr,
+                        const t_trxframe_raw *raw)
+{
+    gmx_trr_header_t header;
+
+    if (gmx_fio_getftp(status->fio) != raw->ftp)
+    {
+        gmx_fatal(FARGS, "Can not write a raw %s frame to a %s file",
+                  ftp2ext(raw->ftp), ftp2ext(gmx_fio_getftp(status->fio)));
+    }
+    switch (raw->ftp)
+    {
+        case efXTC:
+            add_xtc_index_frame(status, gmx_fio_ftell(status->fio), fr->natoms, fr);
+            if (!write_xtc_raw(status->fio, raw->xtc, fr->step, fr->time))
+            {
+                gmx_file("Cannot write trajectory frame; maybe you are out of disk space?");
+            }
+            break;
+        case efTRR:
+            header        = raw->trrHeader;
+            header.step   = fr->step;
+            header.t      = fr->time;
+            header.lambda = fr->lambda;
+            gmx_trr_write_frame_raw(status->fio, &header, raw->trrData);
+            break;
+        default:
+            gmx_incons("Raw frame of unsupported file type");
+    }
+}
+
 void close_trj(t_trxstatus *status)
 {
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
+        finish_xtc_index(status, FALSE);
         gmx_fio_close(status->fio);
     }
+    xtc_index_done(status->xtcIndex);
+    xtc_readahead_done(status->xtcReadahead);
 
     /* The memory in status->xframe is lost here,
      * but the read_first_x/read_next_x functions are deprecated anyhow.
@@ -1135,6 +1381,11 @@ void rewind_trj(t_trxstatus *status)
 {
     initcount(status);
 
+    finish_xtc_index(status, FALSE);
+    if (status->xtcReadahead)
+    {
+        xtc_readahead_discard(status->fio, status->xtcReadahead);
+    }
     gmx_fio_rewind(status->fio);
 }
 
@@ -94,6 +94,12 @@ int write_trxframe(t_trxstatus *status, struct t_trxframe *fr, gmx_conect gc);
  * gc is important for pdb file writing only and may be NULL.
  */
 
+void write_trxframe_raw(t_trxstatus *status, const struct t_trxframe *fr,
+                        const struct t_trxframe_raw *raw);
+/* Write a frame read with read_next_frame_raw to a file of the same type,
+ * using the step, time and lambda of fr instead of those read.
+ */
+
 int write_trx(t_trxstatus *status, int nind, const atom_id *ind, struct t_atoms *atoms,
               int step, real time, matrix box, rvec x[], rvec *v,
               gmx_conect gc);
@@ -214,6 +220,36 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status,
  * Returns TRUE when succeeded, FALSE otherwise.
  */
 
+/* Raw frames hold an xtc or trr frame as it is stored in the file,
+ * so frames can be copied between files of the same format without
+ * decoding and encoding the coordinates.
+ */
+struct t_trxframe_raw;
+
+struct t_trxframe_raw *trxframe_raw_init(void);
+/* Return an empty raw frame, which can be reused for reading several frames */
+
+void trxframe_raw_done(struct t_trxframe_raw *raw);
+/* Free the raw frame, raw can be NULL */
+
+gmx_bool trx_format_supports_raw(int ftp);
+/* Return whether frames of files of type ftp can be read as raw frames */
+
+gmx_bool read_first_frame_raw(t_trxstatus **status, const char *fn,
+                              struct t_trxframe *fr, struct t_trxframe_raw *raw);
+/* Open the xtc or trr file fn and read the first frame into raw.
+ * Only the header information in fr is set: natoms, step, time and,
+ * for trr files, lambda. The time options of the program are not
+ * applied. The file should be closed with close_trj.
+ * Returns TRUE when succeeded, FALSE otherwise.
+ */
+
+gmx_bool read_next_frame_raw(t_trxstatus *status, struct t_trxframe *fr,
+                             struct t_trxframe_raw *raw);
+/* Read the next frame into raw, see read_first_frame_raw.
+ * Returns TRUE when succeeded, FALSE otherwise.
+ */
+
 int read_first_x(const gmx_output_env_t *oenv, t_trxstatus **status,
                  const char *fn, real *t, rvec **x, matrix box);
 /* These routines read first coordinates and box, and allocates
@@ -63,6 +63,52 @@ extern "C" {
 int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision);
 
 
+/* Compressed coordinates of one frame, as stored in an xdr file.
+ * Reading these with xdr3dfcoord_read_data() and decompressing them with
+ * xdr3dfcoord_decompress() is equivalent to reading with xdr3dfcoord(),
+ * but allows the decompression to be done later, e.g. on another thread.
+ */
+typedef struct
+{
+    int    size;      /* Number of coordinate triplets */
+    float  precision; /* Precision, -1 for uncompressed small frames */
+    int    minint[3]; /* Minimum of the integer coordinates */
+    int    maxint[3]; /* Maximum of the integer coordinates */
+    int    smallidx;  /* Initial index into the table of small sizes */
+    int    nbytes;    /* Number of compressed bytes */
+    int    nalloc;    /* Allocation size of buf in ints */
+    int   *buf;       /* Decoder state and compressed bytes, or plain floats */
+} t_xdr3dfcoord_data;
+
+/* Initialize data to empty */
+void xdr3dfcoord_data_init(t_xdr3dfcoord_data *data);
+
+/* Free the buffer of data */
+void xdr3dfcoord_data_done(t_xdr3dfcoord_data *data);
+
+/* Read the compressed coordinates of one frame without decompressing them,
+ * data can be reused for several frames.
+ */
+int xdr3dfcoord_read_data(XDR *xdrs, t_xdr3dfcoord_data *data);
+
+/* Write compressed coordinates read with xdr3dfcoord_read_data() as they
+ * are, so frames can be copied between files without recompressing them.
+ */
+int xdr3dfcoord_write_data(XDR *xdrs, const t_xdr3dfcoord_data *data);
+
+/* Decompress data->size coordinate triplets into fp.
+ * data is not modified, so different frames can be decompressed
+ * concurrently.
+ */
+int xdr3dfcoord_decompress(const t_xdr3dfcoord_data *data, float *fp);
+
+/* Same as xdr3dfcoord_decompress(), but using the original bit-by-bit
+ * decoder, which is kept for testing and benchmarking the fast one.
+ * Modifies the decoder state stored in data->buf.
+ */
+int xdr3dfcoord_decompress_reference(t_xdr3dfcoord_data *data, float *fp);
+
+
 /* Read or write a *real* value (stored as float) */
 int xdr_real(XDR *xdrs, real *r);
 
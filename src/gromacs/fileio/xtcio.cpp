@@ -38,18 +38,38 @@
 
 #include "xtcio.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <string>
+
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio-xdr.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 #define XTC_MAGIC 1995
 
+/* Magic number ("XIDX") and format version of xtc index files */
+#define XTC_INDEX_MAGIC   0x58494458
+#define XTC_INDEX_VERSION 1
+
+struct t_xtc_index
+{
+    int        natoms;  /* Number of atoms in each frame, -1 if unknown */
+    int        nframes; /* Number of indexed frames */
+    int        nalloc;  /* Allocation size of the arrays below */
+    int       *step;    /* Step of each frame */
+    real      *time;    /* Time of each frame */
+    gmx_off_t *offset;  /* File offset of the header of each frame */
+};
+
 
 static int xdr_r2f(XDR *xdrs, real *r, gmx_bool gmx_unused bRead)
 {
@@ -285,3 +305,549 @@ int read_next_xtc(t_fileio* fio,
 
     return *bOK;
 }
+
+struct t_xtc_raw_frame
+{
+    int                natoms; /* Number of atoms */
+    matrix             box;    /* Box, stored as floats in the file */
+    t_xdr3dfcoord_data data;   /* Compressed coordinates */
+};
+
+t_xtc_raw_frame *xtc_raw_frame_init(void)
+{
+    t_xtc_raw_frame *frame;
+
+    snew(frame, 1);
+    xdr3dfcoord_data_init(&frame->data);
+
+    return frame;
+}
+
+void xtc_raw_frame_done(t_xtc_raw_frame *frame)
+{
+    if (frame)
+    {
+        xdr3dfcoord_data_done(&frame->data);
+        sfree(frame);
+    }
+}
+
+/* Reads or writes the box of a raw frame */
+static int xtc_raw_box(XDR *xd, matrix box, gmx_bool bRead)
+{
+    int result = 1;
+
+    for (int i = 0; i < DIM && result; i++)
+    {
+        for (int j = 0; j < DIM && result; j++)
+        {
+            result = XTC_CHECK("box", xdr_r2f(xd, &(box[i][j]), bRead));
+        }
+    }
+
+    return result;
+}
+
+int read_next_xtc_raw(t_fileio *fio, t_xtc_raw_frame *frame,
+                      int *natoms, int *step, real *time, gmx_bool *bOK)
+{
+    int  magic;
+    XDR *xd;
+
+    *bOK = TRUE;
+    xd   = gmx_fio_getxdr(fio);
+
+    if (!xtc_header(xd, &magic, &frame->natoms, step, time, TRUE, bOK))
+    {
+        return 0;
+    }
+    check_xtc_magic(magic);
+    *natoms = frame->natoms;
+
+    *bOK = (xtc_raw_box(xd, frame->box, TRUE) &&
+            XTC_CHECK("x", xdr3dfcoord_read_data(xd, &frame->data)) &&
+            frame->data.size == frame->natoms);
+
+    return *bOK;
+}
+
+int write_xtc_raw(t_fileio *fio, const t_xtc_raw_frame *frame,
+                  int step, real time)
+{
+    int      magic_number = XTC_MAGIC;
+    int      natoms       = frame->natoms;
+    matrix   box;
+    XDR     *xd;
+    gmx_bool bDum;
+
+    xd = gmx_fio_getxdr(fio);
+    copy_mat(frame->box, box);
+    if (xtc_header(xd, &magic_number, &natoms, &step, &time, FALSE, &bDum) == 0 ||
+        !xtc_raw_box(xd, box, FALSE) ||
+        !XTC_CHECK("x", xdr3dfcoord_write_data(xd, &frame->data)))
+    {
+        return 0;
+    }
+
+    return (gmx_fio_flush(fio) == 0);
+}
+
+/* A frame in the read-ahead buffer */
+struct t_xtc_readahead_frame
+{
+    gmx_off_t          offset; /* File offset of the frame header */
+    int                step;   /* Step of the frame */
+    real               time;   /* Time of the frame */
+    matrix             box;    /* Box of the frame */
+    t_xdr3dfcoord_data data;   /* Compressed coordinates */
+    float             *x;      /* Decompressed coordinates */
+    int                bOK;    /* Whether decompression succeeded */
+};
+
+struct t_xtc_readahead
+{
+    int                    natoms;  /* Maximum number of atoms per frame */
+    int                    nframes; /* Size of the buffer */
+    t_xtc_readahead_frame *frames;  /* The buffered frames */
+    int                    nread;   /* Number of frames in the current batch */
+    int                    next;    /* Index of the next frame to return */
+    gmx_bool               bEnd;    /* Whether reading stopped after the batch */
+    gmx_bool               bEndOK;  /* bOK to return when reading stopped */
+};
+
+t_xtc_readahead *xtc_readahead_init(int natoms, int nframes)
+{
+    t_xtc_readahead *ra;
+
+    snew(ra, 1);
+    ra->natoms  = natoms;
+    ra->nframes = nframes;
+    snew(ra->frames, nframes);
+    for (int i = 0; i < nframes; i++)
+    {
+        xdr3dfcoord_data_init(&ra->frames[i].data);
+        snew(ra->frames[i].x, natoms*DIM);
+    }
+    ra->nread  = 0;
+    ra->next   = 0;
+    ra->bEnd   = FALSE;
+    ra->bEndOK = TRUE;
+
+    return ra;
+}
+
+void xtc_readahead_done(t_xtc_readahead *ra)
+{
+    if (ra)
+    {
+        for (int i = 0; i < ra->nframes; i++)
+        {
+            xdr3dfcoord_data_done(&ra->frames[i].data);
+            sfree(ra->frames[i].x);
+        }
+        sfree(ra->frames);
+        sfree(ra);
+    }
+}
+
+/* Reads the next batch of frames and decompresses them */
+static void xtc_readahead_fill(t_fileio *fio, t_xtc_readahead *ra)
+{
+    XDR *xd = gmx_fio_getxdr(fio);
+
+    ra->nread = 0;
+    ra->next  = 0;
+    while (ra->nread < ra->nframes && !ra->bEnd)
+    {
+        t_xtc_readahead_frame *frame = &ra->frames[ra->nread];
+        int                    magic, natoms, result;
+
+        frame->offset = gmx_fio_ftell(fio);
+        if (!xtc_header(xd, &magic, &natoms, &frame->step, &frame->time, TRUE, &ra->bEndOK))
+        {
+            ra->bEnd = TRUE;
+            break;
+        }
+        check_xtc_magic(magic);
+        if (natoms > ra->natoms)
+        {
+            gmx_fatal(FARGS, "Frame contains more atoms (%d) than expected (%d)",
+                      natoms, ra->natoms);
+        }
+        result = 1;
+        for (int i = 0; i < DIM && result; i++)
+        {
+            for (int j = 0; j < DIM && result; j++)
+            {
+                result = XTC_CHECK("box", xdr_r2f(xd, &(frame->box[i][j]), TRUE));
+            }
+        }
+        if (!result || !xdr3dfcoord_read_data(xd, &frame->data) ||
+            frame->data.size > ra->natoms)
+        {
+            ra->bEnd   = TRUE;
+            ra->bEndOK = FALSE;
+            break;
+        }
+        ra->nread++;
+    }
+
+    const int nread = ra->nread;
+#pragma omp parallel for num_threads(std::max(nread, 1)) schedule(static, 1)
+    for (int i = 0; i < nread; i++)
+    {
+        ra->frames[i].bOK = xdr3dfcoord_decompress(&ra->frames[i].data, ra->frames[i].x);
+    }
+}
+
+int read_next_xtc_readahead(t_fileio *fio, t_xtc_readahead *ra,
+                            int *step, real *time, matrix box, rvec *x,
+                            real *prec, gmx_bool *bOK, gmx_off_t *offset)
+{
+    t_xtc_readahead_frame *frame;
+
+    if (ra->next == ra->nread)
+    {
+        if (!ra->bEnd)
+        {
+            xtc_readahead_fill(fio, ra);
+        }
+        if (ra->next == ra->nread)
+        {
+            *bOK = ra->bEndOK;
+            return 0;
+        }
+    }
+
+    frame   = &ra->frames[ra->next++];
+    *offset = frame->offset;
+    *step   = frame->step;
+    *time   = frame->time;
+    copy_mat(frame->box, box);
+    for (int i = 0; i < frame->data.size; i++)
+    {
+        x[i][XX] = frame->x[DIM*i + XX];
+        x[i][YY] = frame->x[DIM*i + YY];
+        x[i][ZZ] = frame->x[DIM*i + ZZ];
+    }
+    *prec = frame->data.precision;
+    *bOK  = frame->bOK;
+
+    return frame->bOK;
+}
+
+void xtc_readahead_discard(t_fileio *fio, t_xtc_readahead *ra)
+{
+    if (ra->next < ra->nread)
+    {
+        gmx_fio_seek(fio, ra->frames[ra->next].offset);
+    }
+    ra->nread  = 0;
+    ra->next   = 0;
+    ra->bEnd   = FALSE;
+    ra->bEndOK = TRUE;
+}
+
+t_xtc_index *xtc_index_init(void)
+{
+    t_xtc_index *index;
+
+    snew(index, 1);
+    index->natoms  = -1;
+    index->nframes = 0;
+    index->nalloc  = 0;
+    index->step    = NULL;
+    index->time    = NULL;
+    index->offset  = NULL;
+
+    return index;
+}
+
+void xtc_index_done(t_xtc_index *index)
+{
+    if (index)
+    {
+        sfree(index->step);
+        sfree(index->time);
+        sfree(index->offset);
+        sfree(index);
+    }
+}
+
+void xtc_index_add_frame(t_xtc_index *index, gmx_off_t offset,
+                         int natoms, int step, real time)
+{
+    if (index->nframes == 0)
+    {
+        index->natoms = natoms;
+    }
+    else if (natoms != index->natoms)
+    {
+        gmx_incons("All frames in an xtc file should have the same number of atoms");
+    }
+    if (index->nframes == index->nalloc)
+    {
+        index->nalloc = over_alloc_large(index->nframes + 1);
+        srenew(index->step, index->nalloc);
+        srenew(index->time, index->nalloc);
+        srenew(index->offset, index->nalloc);
+    }
+    index->step[index->nframes]   = step;
+    index->time[index->nframes]   = time;
+    index->offset[index->nframes] = offset;
+    index->nframes++;
+}
+
+int xtc_index_nframes(const t_xtc_index *index)
+{
+    return index->nframes;
+}
+
+static std::string xtc_index_filename(const char *xtcfn)
+{
+    return std::string(xtcfn) + ".idx";
+}
+
+/* Reads or writes the contents of an index, returns 1 on success */
+static int do_xtc_index(XDR *xd, t_xtc_index *index, gmx_bool bRead)
+{
+    int magic   = XTC_INDEX_MAGIC;
+    int version = XTC_INDEX_VERSION;
+    int nframes = index->nframes;
+
+    if (!xdr_int(xd, &magic) || magic != XTC_INDEX_MAGIC ||
+        !xdr_int(xd, &version) || version != XTC_INDEX_VERSION ||
+        !xdr_int(xd, &index->natoms) ||
+        !xdr_int(xd, &nframes) || nframes < 0)
+    {
+        return 0;
+    }
+    if (bRead)
+    {
+        index->nframes = nframes;
+        index->nalloc  = nframes;
+        snew(index->step, nframes);
+        snew(index->time, nframes);
+        snew(index->offset, nframes);
+    }
+    for (int i = 0; i < nframes; i++)
+    {
+        gmx_int64_t offset = index->offset[i];
+
+        if (!xdr_int(xd, &index->step[i]) ||
+            !xdr_r2f(xd, &index->time[i], bRead) ||
+            !xdr_int64(xd, &offset))
+        {
+            return 0;
+        }
+        index->offset[i] = offset;
+    }
+
+    return 1;
+}
+
+t_xtc_index *xtc_index_read(const char *xtcfn)
+{
+    std::string  fn = xtc_index_filename(xtcfn);
+    t_xtc_index *index;
+    FILE *fp;
+    XDR          xd;
+    int          bOK;
+
+    /* Not using gmx_ffopen, since a missing index is not an error */
+    fp = fopen(fn.c_str(), "rb");
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+    index = xtc_index_init();
+    xdrstdio_create(&xd, fp, XDR_DECODE);
+    bOK = do_xtc_index(&xd, index, TRUE);
+    xdr_destroy(&xd);
+    fclose(fp);
+    if (!bOK)
+    {
+        if (debug)
+        {
+            fprintf(debug, "Ignoring invalid xtc index file %s\n", fn.c_str());
+        }
+        xtc_index_done(index);
+        index = NULL;
+    }
+
+    return index;
+}
+
+int xtc_index_write(const t_xtc_index *index, const char *xtcfn)
+{
+    std::string fn = xtc_index_filename(xtcfn);
+    FILE       *fp;
+    XDR         xd;
+    int         bOK;
+
+    /* Not using gmx_ffopen, since the index should not be backed up */
+    fp = fopen(fn.c_str(), "wb");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    xdrstdio_create(&xd, fp, XDR_ENCODE);
+    bOK = do_xtc_index(&xd, const_cast<t_xtc_index *>(index), FALSE);
+    xdr_destroy(&xd);
+    if (fclose(fp) != 0)
+    {
+        bOK = 0;
+    }
+
+    return bOK;
+}
+
+/* Checks that the header at the indexed offset of frame matches the index,
+ * leaves fio positioned just after that header.
+ */
+static gmx_bool xtc_index_check_frame(t_fileio *fio, const t_xtc_index *index,
+                                      int frame)
+{
+    int      magic, natoms, step;
+    real     time;
+    gmx_bool bOK;
+
+    return (gmx_fio_seek(fio, index->offset[frame]) == 0 &&
+            xtc_header(gmx_fio_getxdr(fio), &magic, &natoms, &step, &time, TRUE, &bOK) &&
+            magic == XTC_MAGIC && natoms == index->natoms &&
+            step == index->step[frame] && time == index->time[frame]);
+}
+
+t_xtc_index *xtc_index_complete(t_xtc_index *index, const char *xtcfn,
+                                gmx_off_t end)
+{
+    t_fileio        *fio;
+    t_xtc_raw_frame *frame;
+    gmx_off_t        start, offset;
+    int              natoms, step;
+    real             time;
+    gmx_bool         bOK;
+
+    if (index == NULL)
+    {
+        index = xtc_index_init();
+    }
+    while (index->nframes > 0 && index->offset[index->nframes - 1] >= end)
+    {
+        index->nframes--;
+    }
+
+    fio   = open_xtc(xtcfn, "r");
+    start = 0;
+    if (index->nframes > 0)
+    {
+        if (xtc_index_check_frame(fio, index, index->nframes - 1))
+        {
+            /* Continue from the last indexed frame, which is re-added */
+            index->nframes--;
+            start = index->offset[index->nframes];
+        }
+        else
+        {
+            if (debug)
+            {
+                fprintf(debug, "Rebuilding the index of %s, since it does not match the file\n",
+                        xtcfn);
+            }
+            index->nframes = 0;
+        }
+    }
+
+    frame = xtc_raw_frame_init();
+    gmx_fio_seek(fio, start);
+    offset = start;
+    while (offset < end &&
+           read_next_xtc_raw(fio, frame, &natoms, &step, &time, &bOK) &&
+           gmx_fio_ftell(fio) <= end)
+    {
+        xtc_index_add_frame(index, offset, natoms, step, time);
+        offset = gmx_fio_ftell(fio);
+    }
+    xtc_raw_frame_done(frame);
+    close_xtc(fio);
+
+    return index;
+}
+
+t_xtc_index *xtc_index_open_for_writing(t_fileio *fio, gmx_bool bAppend)
+{
+    FILE *fp;
+
+    if (fio == NULL || getenv("GMX_XTC_INDEX") == NULL)
+    {
+        return NULL;
+    }
+    if (!bAppend)
+    {
+        return xtc_index_init();
+    }
+
+    /* Frames that are no longer present, e.g. after truncation of the
+     * trajectory at a checkpoint, are dropped and frames written without
+     * updating the index, e.g. by a run that was killed, are added.
+     */
+    fp = gmx_fio_getfp(fio);
+    if (gmx_fseek(fp, 0, SEEK_END) != 0)
+    {
+        return NULL;
+    }
+
+    return xtc_index_complete(xtc_index_read(gmx_fio_getname(fio)),
+                              gmx_fio_getname(fio), gmx_ftell(fp));
+}
+
+int xtc_index_seek_time(t_fileio *fio, const t_xtc_index *index,
+                        real time, int natoms)
+{
+    gmx_off_t pos;
+    int       low, high, mid;
+
+    if (index->nframes == 0 || index->natoms != natoms)
+    {
+        return 1;
+    }
+
+    /* Binary search for the first frame with time >= time,
+     * assuming times increase, as xtc_seek_time() also does.
+     */
+    low  = 0;
+    high = index->nframes;
+    while (low < high)
+    {
+        mid = (low + high)/2;
+        if (index->time[mid] < time)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    pos = gmx_fio_ftell(fio);
+    if (low == index->nframes)
+    {
+        /* The file was extended after indexing, search forward
+         * from the header of the last indexed frame.
+         */
+        if (!xtc_index_check_frame(fio, index, low - 1))
+        {
+            gmx_fio_seek(fio, pos);
+            return 1;
+        }
+        return xtc_seek_time(fio, time, natoms, TRUE);
+    }
+    if (!xtc_index_check_frame(fio, index, low))
+    {
+        gmx_fio_seek(fio, pos);
+        return 1;
+    }
+
+    return gmx_fio_seek(fio, index->offset[low]);
+}
@@ -40,6 +40,7 @@
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
 #include "gromacs/utility/real.h"
 
 #ifdef __cplusplus
@@ -73,6 +74,113 @@ int write_xtc(struct t_fileio *fio,
               matrix box, rvec *x, real prec);
 /* Write a frame to xtc file */
 
+/* Read-ahead buffer for reading xtc files.
+ *
+ * Frames are read in batches of the buffer size. The compressed
+ * coordinates of a batch are read serially, after which the frames are
+ * decompressed in parallel using OpenMP, one frame per thread.
+ */
+struct t_xtc_readahead;
+
+struct t_xtc_readahead *xtc_readahead_init(int natoms, int nframes);
+/* Return a buffer for reading ahead nframes frames of natoms atoms,
+ * decompressing with up to nframes OpenMP threads
+ */
+
+void xtc_readahead_done(struct t_xtc_readahead *ra);
+/* Free the buffer, ra can be NULL */
+
+int read_next_xtc_readahead(struct t_fileio *fio, struct t_xtc_readahead *ra,
+                            int *step, real *time, matrix box, rvec *x,
+                            real *prec, gmx_bool *bOK, gmx_off_t *offset);
+/* Read the next frame like read_next_xtc(), through the buffer.
+ * offset is set to the file offset of the frame header.
+ */
+
+void xtc_readahead_discard(struct t_fileio *fio, struct t_xtc_readahead *ra);
+/* Discard the buffered frames, positioning fio at the first frame that
+ * has not been returned yet. Should be called before seeking in fio.
+ */
+
+/* An xtc frame with its coordinates kept compressed, so frames can be
+ * copied between files without decompressing and recompressing them.
+ */
+struct t_xtc_raw_frame;
+
+struct t_xtc_raw_frame *xtc_raw_frame_init(void);
+/* Return an empty frame, which can be reused for reading several frames */
+
+void xtc_raw_frame_done(struct t_xtc_raw_frame *frame);
+/* Free the frame, frame can be NULL */
+
+int read_next_xtc_raw(struct t_fileio *fio, struct t_xtc_raw_frame *frame,
+                      int *natoms, int *step, real *time, gmx_bool *bOK);
+/* Read the next frame into frame, without decompressing the coordinates */
+
+int write_xtc_raw(struct t_fileio *fio, const struct t_xtc_raw_frame *frame,
+                  int step, real time);
+/* Write a frame read with read_next_xtc_raw() with a new step and time */
+
+/* Sidecar frame index for xtc files.
+ *
+ * The index is stored next to the trajectory in a file with ".idx"
+ * appended to the trajectory name. For each frame it records the step,
+ * the time and the byte offset of the frame header, so that a frame can
+ * be located with a single seek instead of the bisection search done by
+ * xtc_seek_time(). Index files are only written when the environment
+ * variable GMX_XTC_INDEX is set, but a matching index is used whenever
+ * one is present on reading.
+ */
+struct t_xtc_index;
+
+struct t_xtc_index *xtc_index_init(void);
+/* Return an empty index */
+
+void xtc_index_done(struct t_xtc_index *index);
+/* Free the index, index can be NULL */
+
+void xtc_index_add_frame(struct t_xtc_index *index, gmx_off_t offset,
+                         int natoms, int step, real time);
+/* Add a frame whose header starts at offset to the index */
+
+int xtc_index_nframes(const struct t_xtc_index *index);
+/* Return the number of frames in the index */
+
+struct t_xtc_index *xtc_index_read(const char *xtcfn);
+/* Read the index belonging to xtc file xtcfn,
+ * returns NULL when there is no (readable) index file.
+ */
+
+int xtc_index_write(const struct t_xtc_index *index, const char *xtcfn);
+/* Write the index belonging to xtc file xtcfn */
+
+struct t_xtc_index *xtc_index_complete(struct t_xtc_index *index,
+                                       const char *xtcfn, gmx_off_t end);
+/* Return index with the frames before offset end in xtc file xtcfn,
+ * dropping indexed frames beyond end and adding the missing frames by
+ * reading them without decompression. index can be NULL, then the whole
+ * file is scanned; this also happens when index does not match the file.
+ */
+
+struct t_xtc_index *xtc_index_open_for_writing(struct t_fileio *fio,
+                                               gmx_bool          bAppend);
+/* Return an index to fill while writing frames to fio, or NULL when
+ * GMX_XTC_INDEX is not set. When appending, the existing index is
+ * brought up to date with xtc_index_complete() for the current end of
+ * the file. Frames should be added with their offset taken with
+ * gmx_fio_ftell() just before calling write_xtc().
+ */
+
+int xtc_index_seek_time(struct t_fileio *fio, const struct t_xtc_index *index,
+                        real time, int natoms);
+/* Position fio at the first frame with time >= time.
+ * Frames beyond the last indexed frame are searched for with
+ * xtc_seek_time(), starting from the last indexed frame.
+ * Returns 0 on success, the return value of xtc_seek_time() when that
+ * failed, and 1 when the index does not match the file, in which case
+ * the file position is not changed and the index should not be used.
+ */
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,8 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/cmat.h"
 #include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxana/rmsdmatrix.h"
+#include "gromacs/legacyheaders/copyrite.h"
 #include "gromacs/legacyheaders/typedefs.h"
 #include "gromacs/linearalgebra/eigensolver.h"
 #include "gromacs/math/do_fit.h"
@@ -62,6 +64,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 /* print to two file pointers at once (i.e. stderr and log) */
@@ -1334,7 +1337,10 @@ int gmx_cluster(int argc, char *argv[])
         "Distances between structures can be determined from a trajectory",
         "or read from an [REF].xpm[ref] matrix file with the [TT]-dm[tt] option.",
         "RMS deviation after fitting or RMS deviation of atom-pair distances",
-        "can be used to define the distance between structures.[PAR]",
+        "can be used to define the distance between structures.",
+        "The RMS deviations after fitting are computed with the quaternion",
+        "characteristic polynomial method, which does not need the rotation",
+        "matrix, and the pairs of structures are divided over [TT]-nt[tt] threads.[PAR]",
 
         "single linkage: add a structure to a cluster when its distance to any",
         "element of the cluster is less than [TT]cutoff[tt].[PAR]",
@@ -1409,7 +1415,7 @@ int gmx_cluster(int argc, char *argv[])
     gmx_int64_t        nrms = 0;
 
     matrix             box;
-    rvec              *xtps, *usextps, *x1, **xx = NULL;
+    rvec              *xtps, *usextps, **xx = NULL;
     const char        *fn, *trx_out_fn;
     t_clusters         clust;
     t_mat             *rms, *orig = NULL;
@@ -1423,7 +1429,7 @@ int gmx_cluster(int argc, char *argv[])
     int                isize = 0, ifsize = 0, iosize = 0;
     atom_id           *index = NULL, *fitidx = NULL, *outidx = NULL;
     char              *grpname;
-    real               rmsd, **d1, **d2, *time = NULL, time_invfac, *mass = NULL;
+    real              **d1, **d2, *time = NULL, time_invfac, *mass = NULL;
     char               buf[STRLEN], buf1[80], title[STRLEN];
     gmx_bool           bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bPBC = TRUE;
 
@@ -1447,6 +1453,7 @@ int gmx_cluster(int argc, char *argv[])
     static int        niter    = 10000, nrandom = 0, seed = 1993, write_ncl = 0, write_nst = 1, minstruct = 1;
     static real       kT       = 1e-3;
     static int        M        = 10, P = 3;
+    static int        nthreads = -1;
     gmx_output_env_t *oenv;
     gmx_rmpbc_t       gpbc = NULL;
 
@@ -1493,7 +1500,12 @@ int gmx_cluster(int argc, char *argv[])
           "Boltzmann weighting factor for Monte Carlo optimization "
           "(zero turns off uphill steps)" },
         { "-pbc", FALSE, etBOOL,
-          { &bPBC }, "PBC check" }
+          { &bPBC }, "PBC check" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT, {&nthreads},
+          "Number of threads to compute the RMSD matrix with (if -1, all threads will "
+          "be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
     t_filenm          fnm[] = {
         { efTRX, "-f",     NULL,        ffOPTRD },
@@ -1522,6 +1534,15 @@ int gmx_cluster(int argc, char *argv[])
         return 0;
     }
 
+    if (nthreads > 0)
+    {
+        gmx_omp_set_num_threads(nthreads);
+    }
+    else
+    {
+        nthreads = gmx_omp_get_max_threads();
+    }
+
     /* parse options */
     bReadMat   = opt2bSet("-dm", NFILE, fnm);
     bReadTraj  = opt2bSet("-f", NFILE, fnm) || !bReadMat;
@@ -1744,28 +1765,18 @@ int gmx_cluster(int argc, char *argv[])
         nrms = (static_cast<gmx_int64_t>(nf)*static_cast<gmx_int64_t>(nf-1))/2;
         if (!bRMSdist)
         {
+            double sumrms;
+
             fprintf(stderr, "Computing %dx%d RMS deviation matrix\n", nf, nf);
-            /* Initialize work array */
-            snew(x1, isize);
-            for (i1 = 0; i1 < nf; i1++)
+            /* The frames have been centered above, as needed for the fit */
+            calc_rmsd_matrix(nf, isize, mass, xx, bFit, nthreads, rms->mat,
+                             &rms->minrms, &rms->maxrms, &sumrms);
+            rms->sumrms = sumrms;
+            rms->nn     = nf;
+            if (bFit)
             {
-                for (i2 = i1+1; i2 < nf; i2++)
-                {
-                    for (i = 0; i < isize; i++)
-                    {
-                        copy_rvec(xx[i1][i], x1[i]);
-                    }
-                    if (bFit)
-                    {
-                        do_fit(isize, mass, xx[i2], x1);
-                    }
-                    rmsd = rmsdev(isize, mass, xx[i2], x1);
-                    set_mat_entry(rms, i1, i2, rmsd);
-                }
-                nrms -= nf-i1-1;
-                fprintf(stderr, "\r# RMSD calculations left: " "%" GMX_PRId64 "   ", nrms);
+                please_cite(stdout, "Theobald2005");
             }
-            sfree(x1);
         }
         else /* bRMSdist */
         {
@@ -49,6 +49,7 @@
 #include "gromacs/legacyheaders/txtdump.h"
 #include "gromacs/legacyheaders/typedefs.h"
 #include "gromacs/linearalgebra/eigensolver.h"
+#include "gromacs/linearalgebra/matrix.h"
 #include "gromacs/math/do_fit.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/rmpbc.h"
@@ -57,9 +58,13 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
+/* Number of frames added to the covariance matrix in one update */
+#define COVAR_BATCHSIZE 32
+
 int gmx_covar(int argc, char *argv[])
 {
     const char       *desc[] = {
@@ -93,10 +98,19 @@ int gmx_covar(int argc, char *argv[])
         "of atoms involved. It is easy to run out of memory, in which",
         "case this tool will probably exit with a 'Segmentation fault'. You",
         "should consider carefully whether a reduced set of atoms will meet",
-        "your needs for lower costs."
+        "your needs for lower costs.",
+        "With [TT]-partial[tt] only the eigenvectors 1 to [TT]-last[tt]",
+        "are computed with Lanczos iterations, which is much faster",
+        "than the full diagonalization when only a few eigenvectors are needed.",
+        "Then only the sum of these eigenvalues is known, not the sum",
+        "of all eigenvalues.",
+        "The covariance matrix is accumulated and the Lanczos iterations",
+        "are performed with [TT]-nt[tt] threads."
     };
-    static gmx_bool   bFit = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
-    static int        end  = -1;
+    static gmx_bool   bFit     = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
+    static gmx_bool   bPartial = FALSE;
+    static int        end      = -1;
+    static int        nthreads = -1;
     t_pargs           pa[] = {
         { "-fit",  FALSE, etBOOL, {&bFit},
           "Fit to a reference structure"},
@@ -107,7 +121,13 @@ int gmx_covar(int argc, char *argv[])
         { "-last",  FALSE, etINT, {&end},
           "Last eigenvector to write away (-1 is till the last)" },
         { "-pbc",  FALSE,  etBOOL, {&bPBC},
-          "Apply corrections for periodic boundary conditions" }
+          "Apply corrections for periodic boundary conditions" },
+        { "-partial", FALSE, etBOOL, {&bPartial},
+          "Only compute the eigenvectors up to [TT]-last[tt] with Lanczos iterations" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT, {&nthreads},
+          "Number of threads to compute with (if -1, all threads will be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
     FILE             *out = NULL; /* initialization makes all compilers happy */
     t_trxstatus      *status;
@@ -118,16 +138,16 @@ int gmx_covar(int argc, char *argv[])
     matrix            box, zerobox;
     real             *sqrtm, *mat, *eigenvalues, sum, trace, inv_nframes;
     real              t, tstart, tend, **mat2;
-    real              xj, *w_rls = NULL;
+    real             *xbatch, *w_rls = NULL;
     real              min, max, *axis;
-    int               natoms, nat, nframes0, nframes, nlevels;
-    gmx_int64_t       ndim, i, j, k, l;
+    int               natoms, nat, nframes0, nframes, nlevels, nbatch;
+    gmx_int64_t       ndim, i, j, k;
     int               WriteXref;
     const char       *fitfile, *trxfile, *ndxfile;
     const char       *eigvalfile, *eigvecfile, *averfile, *logfile;
     const char       *asciifile, *xpmfile, *xpmafile;
     char              str[STRLEN], *fitname, *ananame;
-    int               d, dj, nfit;
+    int               d, dj, nfit, neig;
     atom_id          *index, *ifit;
     gmx_bool          bDiffMass1, bDiffMass2;
     char              timebuf[STRLEN];
@@ -156,6 +176,15 @@ int gmx_covar(int argc, char *argv[])
         return 0;
     }
 
+    if (nthreads > 0)
+    {
+        gmx_omp_set_num_threads(nthreads);
+    }
+    else
+    {
+        nthreads = gmx_omp_get_max_threads();
+    }
+
     clear_mat(zerobox);
 
     fitfile    = ftp2fn(efTPS, NFILE, fnm);
@@ -301,6 +330,13 @@ int gmx_covar(int argc, char *argv[])
     sfree(xread);
 
     fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim), static_cast<int>(ndim));
+    /* The deviations of a batch of frames are stored consecutively and
+     * added to the matrix with one symmetric rank-k update, which has a much
+     * better ratio of floating point operations to memory access than
+     * adding the frames one by one.
+     */
+    snew(xbatch, ndim*COVAR_BATCHSIZE);
+    nbatch  = 0;
     nframes = 0;
     nat     = read_first_x(oenv, &status, trxfile, &t, &xread, box);
     tstart  = t;
@@ -333,26 +369,19 @@ int gmx_covar(int argc, char *argv[])
             }
         }
 
-        for (j = 0; j < natoms; j++)
+        std::memcpy(xbatch + ndim*nbatch, x[0], ndim*sizeof(real));
+        nbatch++;
+        if (nbatch == COVAR_BATCHSIZE)
         {
-            for (dj = 0; dj < DIM; dj++)
-            {
-                k  = ndim*(DIM*j+dj);
-                xj = x[j][dj];
-                for (i = j; i < natoms; i++)
-                {
-                    l = k+DIM*i;
-                    for (d = 0; d < DIM; d++)
-                    {
-                        mat[l+d] += x[i][d]*xj;
-                    }
-                }
-            }
+            symmetric_rank_k_update(ndim, nbatch, xbatch, mat, nthreads);
+            nbatch = 0;
         }
     }
     while (read_next_x(oenv, status, &t, xread, box) &&
            (bRef || nframes < nframes0));
     close_trj(status);
+    symmetric_rank_k_update(ndim, nbatch, xbatch, mat, nthreads);
+    sfree(xbatch);
     gmx_rmpbc_done(gpbc);
 
     fprintf(stderr, "Read %d frames\n", nframes);
@@ -509,44 +538,76 @@ int gmx_covar(int argc, char *argv[])
     }
 
 
+    /* Set 'end', the maximum eigenvector and -value index used for output */
+    if (end == -1)
+    {
+        if (nframes-1 < ndim)
+        {
+            end = nframes-1;
+            fprintf(stderr, "\nWARNING: there are fewer frames in your trajectory than there are\n");
+            fprintf(stderr, "degrees of freedom in your system. Only generating the first\n");
+            fprintf(stderr, "%d out of %d eigenvectors and eigenvalues.\n", end, static_cast<int>(ndim));
+        }
+        else
+        {
+            end = ndim;
+        }
+    }
+
+    if (bPartial && end >= ndim)
+    {
+        fprintf(stderr, "\nNote: all eigenvectors are requested, ignoring -partial\n");
+        bPartial = FALSE;
+    }
+
     /* call diagonalization routine */
 
     snew(eigenvalues, ndim);
-    snew(eigenvectors, ndim*ndim);
+    if (bPartial)
+    {
+        /* Only the eigenvectors that are written are computed. We store
+         * them at the end of the arrays, as for the full diagonalization.
+         */
+        neig = end;
+        snew(eigenvectors, neig*ndim);
+        fprintf(stderr, "\nComputing the %d largest eigenvalues ...\n", neig);
+        fflush(stderr);
+        dense_partial_eigensolver(mat, ndim, neig, eigenvalues+ndim-neig, eigenvectors,
+                                  100000, nthreads);
+        std::memcpy(mat+(ndim-neig)*ndim, eigenvectors, neig*ndim*sizeof(real));
+        sfree(eigenvectors);
+    }
+    else
+    {
+        neig = ndim;
+        snew(eigenvectors, ndim*ndim);
 
-    std::memcpy(eigenvectors, mat, ndim*ndim*sizeof(real));
-    fprintf(stderr, "\nDiagonalizing ...\n");
-    fflush(stderr);
-    eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
-    sfree(eigenvectors);
+        std::memcpy(eigenvectors, mat, ndim*ndim*sizeof(real));
+        fprintf(stderr, "\nDiagonalizing ...\n");
+        fflush(stderr);
+        eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
+        sfree(eigenvectors);
+    }
 
     /* now write the output */
 
     sum = 0;
-    for (i = 0; i < ndim; i++)
+    for (i = ndim-neig; i < ndim; i++)
     {
         sum += eigenvalues[i];
     }
-    fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n",
-            sum, bM ? "u " : "");
-    if (std::abs(trace-sum) > 0.01*trace)
+    if (bPartial)
     {
-        fprintf(stderr, "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
+        fprintf(stderr, "\nSum of the %d largest eigenvalues: %g (%snm^2)\n",
+                neig, sum, bM ? "u " : "");
     }
-
-    /* Set 'end', the maximum eigenvector and -value index used for output */
-    if (end == -1)
+    else
     {
-        if (nframes-1 < ndim)
+        fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n",
+                sum, bM ? "u " : "");
+        if (std::abs(trace-sum) > 0.01*trace)
         {
-            end = nframes-1;
-            fprintf(stderr, "\nWARNING: there are fewer frames in your trajectory than there are\n");
-            fprintf(stderr, "degrees of freedom in your system. Only generating the first\n");
-            fprintf(stderr, "%d out of %d eigenvectors and eigenvalues.\n", end, static_cast<int>(ndim));
-        }
-        else
-        {
-            end = ndim;
+            fprintf(stderr, "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
         }
     }
 
@@ -623,11 +684,21 @@ int gmx_covar(int argc, char *argv[])
     {
         fprintf(out, "Fit is %smass weighted\n", bDiffMass1 ? "" : "non-");
     }
-    fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim), static_cast<int>(ndim));
-    fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n",
-            trace);
-    fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n",
-            sum);
+    if (bPartial)
+    {
+        fprintf(out, "Computed the %d largest eigenvalues of the %dx%d covariance matrix\n",
+                neig, static_cast<int>(ndim), static_cast<int>(ndim));
+        fprintf(out, "Trace of the covariance matrix: %g\n", trace);
+        fprintf(out, "Sum of the computed eigenvalues: %g\n\n", sum);
+    }
+    else
+    {
+        fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim), static_cast<int>(ndim));
+        fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n",
+                trace);
+        fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n",
+                sum);
+    }
 
     fprintf(out, "Wrote %d eigenvalues to %s\n", static_cast<int>(end), eigvalfile);
     if (WriteXref == eWXR_YES)
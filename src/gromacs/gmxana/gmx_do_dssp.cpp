@@ -455,6 +455,10 @@ int gmx_do_dssp(int argc, char *argv[])
         "By default, do_dssp uses the syntax introduced with version 2.0.0.",
         "Even newer versions (which at the time of writing are not yet released)",
         "are assumed to have the same syntax as 2.0.0.[PAR]",
+        "[gmx-dssp] assigns the secondary structure with the same algorithm",
+        "without calling an external program, and is much faster for",
+        "trajectories; use [THISMODULE] only for the solvent accessible",
+        "surface output.[PAR]",
         "The structure assignment for each residue and time is written to an",
         "[REF].xpm[ref] matrix file. This file can be visualized with for instance",
         "[TT]xv[tt] and can be converted to postscript with [TT]xpm2ps[tt].",
@@ -129,18 +129,33 @@ typedef struct {
 typedef int     t_icell[grNR];
 typedef atom_id h_id[MAXHYDRO];
 
+/* Frames in which a hydrogen bond exists, stored as sorted,
+ * non-overlapping half-open intervals [begin, end) of frame numbers.
+ * Frames are added in increasing order, so a hydrogen bond that persists
+ * only extends its last interval and the memory needed is set by the
+ * number of times it forms, not by the number of frames.
+ */
+typedef struct {
+    int  begin, end;
+} t_hbinterval;
+
+typedef struct {
+    int           nr, max_nr;
+    t_hbinterval *iv;
+} t_hbexist;
+
 typedef struct {
     int      history[MAXHYDRO];
     /* Has this hbond existed ever? If so as hbDist or hbHB or both.
      * Result is stored as a bitmap (1 = hbDist) || (2 = hbHB)
      */
-    /* Bitmask array which tells whether a hbond is present
-     * at a given time. Either of these may be NULL
+    /* Frames in which the hbond is present, one entry per hydrogen.
+     * Either of these may be empty.
      */
     int            n0;                 /* First frame a HB was found     */
-    int            nframes, maxframes; /* Amount of frames in this hbond */
-    unsigned int **h;
-    unsigned int **g;
+    int            nframes;            /* Amount of frames in this hbond */
+    t_hbexist     *h;
+    t_hbexist     *g;
     /* See Xu and Berne, JPCB 105 (2001), p. 11929. We define the
      * function g(t) = [1-h(t)] H(t) where H(t) is one when the donor-
      * acceptor distance is less than the user-specified distance (typically
@@ -148,6 +163,11 @@ typedef struct {
      */
 } t_hbond;
 
+/* A hydrogen bond or distance found by one thread in the current frame */
+typedef struct {
+    int      d, a, h, grpd, grpa, ihb;
+} t_hbfound;
+
 typedef struct {
     int      nra, max_nra;
     atom_id *acc;             /* Atom numbers of the acceptors     */
@@ -167,7 +187,6 @@ typedef struct {
 
 typedef struct {
     gmx_bool        bHBmap, bDAnr;
-    int             wordlen;
     /* The following arrays are nframes long */
     int             nframes, max_frames, maxhydro;
     int            *nhb, *ndist;
@@ -181,6 +200,10 @@ typedef struct {
     /* This holds a matrix with all possible hydrogen bonds */
     int             nrhb, nrdist;
     t_hbond      ***hbmap;
+    /* Hydrogen bonds found in the current frame, before they are added
+     * to hbmap; used by the threads of the frame loop */
+    int             nfound, max_found;
+    t_hbfound      *found;
 } t_hbdata;
 
 /* Changed argument 'bMerge' into 'oneHB' below,
@@ -194,7 +217,6 @@ static t_hbdata *mk_hbdata(gmx_bool bHBmap, gmx_bool bDAnr, gmx_bool oneHB)
     t_hbdata *hb;
 
     snew(hb, 1);
-    hb->wordlen = 8*sizeof(unsigned int);
     hb->bHBmap  = bHBmap;
     hb->bDAnr   = bDAnr;
     if (oneHB)
@@ -245,92 +267,126 @@ static void add_frames(t_hbdata *hb, int nframes)
     hb->nframes = nframes;
 }
 
-#define OFFSET(frame) (frame / 32)
-#define MASK(frame)   (1 << (frame % 32))
-
-static void _set_hb(unsigned int hbexist[], unsigned int frame, gmx_bool bValue)
+static void add_hbexist(t_hbexist *e, int frame)
 {
-    if (bValue)
+    if (e->nr > 0 && e->iv[e->nr-1].end >= frame)
     {
-        hbexist[OFFSET(frame)] |= MASK(frame);
+        /* Extend the last interval, or nothing to do when the frame
+         * was already added (e.g. with donor and acceptor swapped). */
+        e->iv[e->nr-1].end = std::max(e->iv[e->nr-1].end, frame+1);
+        return;
     }
-    else
+    if (e->nr >= e->max_nr)
     {
-        hbexist[OFFSET(frame)] &= ~MASK(frame);
+        e->max_nr = std::max(4, 2*e->max_nr);
+        srenew(e->iv, e->max_nr);
     }
+    e->iv[e->nr].begin = frame;
+    e->iv[e->nr].end   = frame+1;
+    e->nr++;
 }
 
-static gmx_bool is_hb(unsigned int hbexist[], int frame)
+static gmx_bool is_hb(const t_hbexist *e, int frame)
 {
-    return ((hbexist[OFFSET(frame)] & MASK(frame)) != 0) ? 1 : 0;
+    int lo, hi, mid;
+
+    /* Binary search for the last interval starting at or before frame */
+    lo = 0;
+    hi = e->nr;
+    while (lo < hi)
+    {
+        mid = (lo + hi)/2;
+        if (e->iv[mid].begin <= frame)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return (lo > 0 && frame < e->iv[lo-1].end) ? 1 : 0;
 }
 
-static void set_hb(t_hbdata *hb, int id, int ih, int ia, int frame, int ihb)
+/* Sets x[f-offset] = value for all frames f in e with 0 <= f-offset < n */
+static void fill_hbexist(const t_hbexist *e, int offset, int n, real x[], real value)
 {
-    unsigned int *ghptr = NULL;
+    int i, f, f0, f1;
 
-    if (ihb == hbHB)
+    for (i = 0; (i < e->nr); i++)
     {
-        ghptr = hb->hbmap[id][ia]->h[ih];
-    }
-    else if (ihb == hbDist)
-    {
-        ghptr = hb->hbmap[id][ia]->g[ih];
+        f0 = std::max(e->iv[i].begin - offset, 0);
+        f1 = std::min(e->iv[i].end - offset, n);
+        for (f = f0; (f < f1); f++)
+        {
+            x[f] = value;
+        }
     }
-    else
+}
+
+/* Replaces dest by the union of the frames in dest and src */
+static void merge_hbexist(t_hbexist *dest, const t_hbexist *src)
+{
+    t_hbexist     res;
+    t_hbinterval *next;
+    int           i, j;
+
+    res.nr     = 0;
+    res.max_nr = dest->nr + src->nr;
+    snew(res.iv, std::max(res.max_nr, 1));
+    i = j = 0;
+    while (i < dest->nr || j < src->nr)
     {
-        gmx_fatal(FARGS, "Incomprehensible iValue %d in set_hb", ihb);
+        if (j == src->nr || (i < dest->nr && dest->iv[i].begin <= src->iv[j].begin))
+        {
+            next = &dest->iv[i++];
+        }
+        else
+        {
+            next = &src->iv[j++];
+        }
+        if (res.nr > 0 && res.iv[res.nr-1].end >= next->begin)
+        {
+            res.iv[res.nr-1].end = std::max(res.iv[res.nr-1].end, next->end);
+        }
+        else
+        {
+            res.iv[res.nr++] = *next;
+        }
     }
+    sfree(dest->iv);
+    *dest = res;
+}
 
-    _set_hb(ghptr, frame-hb->hbmap[id][ia]->n0, TRUE);
+static void free_hbexist(t_hbexist *e)
+{
+    sfree(e->iv);
+    e->iv     = NULL;
+    e->nr     = 0;
+    e->max_nr = 0;
 }
 
 static void add_ff(t_hbdata *hbd, int id, int h, int ia, int frame, int ihb)
 {
-    int         i, j, n;
     t_hbond    *hb       = hbd->hbmap[id][ia];
-    int         maxhydro = std::min(hbd->maxhydro, hbd->d.nhydro[id]);
-    int         wlen     = hbd->wordlen;
-    int         delta    = 32*wlen;
 
-    if (!hb->h[0])
+    if (hb->n0 == NOTSET)
     {
-        hb->n0        = frame;
-        hb->maxframes = delta;
-        for (i = 0; (i < maxhydro); i++)
-        {
-            snew(hb->h[i], hb->maxframes/wlen);
-            snew(hb->g[i], hb->maxframes/wlen);
-        }
+        hb->n0 = frame;
     }
-    else
+    hb->nframes = frame-hb->n0;
+    if (ihb == hbHB)
     {
-        hb->nframes = frame-hb->n0;
-        /* We need a while loop here because hbonds may be returning
-         * after a long time.
-         */
-        while (hb->nframes >= hb->maxframes)
-        {
-            n = hb->maxframes + delta;
-            for (i = 0; (i < maxhydro); i++)
-            {
-                srenew(hb->h[i], n/wlen);
-                srenew(hb->g[i], n/wlen);
-                for (j = hb->maxframes/wlen; (j < n/wlen); j++)
-                {
-                    hb->h[i][j] = 0;
-                    hb->g[i][j] = 0;
-                }
-            }
-
-            hb->maxframes = n;
-        }
+        add_hbexist(&hb->h[h], frame);
     }
-    if (frame >= 0)
+    else if (ihb == hbDist)
     {
-        set_hb(hbd, id, h, ia, frame, ihb);
+        add_hbexist(&hb->g[h], frame);
+    }
+    else
+    {
+        gmx_fatal(FARGS, "Incomprehensible iValue %d in add_ff", ihb);
     }
-
 }
 
 static void inc_nhbonds(t_donors *ddd, int d, int h)
@@ -497,21 +553,14 @@ static void add_hbond(t_hbdata *hb, int d, int a, int h, int grpd, int grpa,
 
         if (hb->bHBmap)
         {
-
-#pragma omp critical
+            if (hb->hbmap[id][ia] == NULL)
             {
-                try
-                {
-                    if (hb->hbmap[id][ia] == NULL)
-                    {
-                        snew(hb->hbmap[id][ia], 1);
-                        snew(hb->hbmap[id][ia]->h, hb->maxhydro);
-                        snew(hb->hbmap[id][ia]->g, hb->maxhydro);
-                    }
-                    add_ff(hb, id, k, ia, frame, ihb);
-                }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                snew(hb->hbmap[id][ia], 1);
+                snew(hb->hbmap[id][ia]->h, hb->maxhydro);
+                snew(hb->hbmap[id][ia]->g, hb->maxhydro);
+                hb->hbmap[id][ia]->n0 = NOTSET;
             }
+            add_ff(hb, id, k, ia, frame, ihb);
         }
 
         /* Strange construction with frame >=0 is a relic from old code
@@ -572,6 +621,44 @@ static void add_hbond(t_hbdata *hb, int d, int a, int h, int grpd, int grpa,
     }
 }
 
+/* Stores a hydrogen bond found in the current frame, to be added with
+ * add_found_hbonds() once all threads have finished the frame.
+ * Only touches data of hb itself, so each thread can use its own hb.
+ */
+static void store_hbond(t_hbdata *hb, int d, int a, int h, int grpd, int grpa, int ihb)
+{
+    t_hbfound *found;
+
+    if (hb->nfound >= hb->max_found)
+    {
+        hb->max_found = over_alloc_large(hb->nfound+1);
+        srenew(hb->found, hb->max_found);
+    }
+    found       = &hb->found[hb->nfound++];
+    found->d    = d;
+    found->a    = a;
+    found->h    = h;
+    found->grpd = grpd;
+    found->grpa = grpa;
+    found->ihb  = ihb;
+}
+
+/* Adds the hydrogen bonds stored in p_hb to hb and clears them from p_hb */
+static void add_found_hbonds(t_hbdata *hb, t_hbdata *p_hb, int frame,
+                             gmx_bool bMerge, gmx_bool bContact)
+{
+    int        i;
+    t_hbfound *found;
+
+    for (i = 0; (i < p_hb->nfound); i++)
+    {
+        found = &p_hb->found[i];
+        add_hbond(hb, found->d, found->a, found->h, found->grpd, found->grpa,
+                  frame, bMerge, found->ihb, bContact);
+    }
+    p_hb->nfound = 0;
+}
+
 static char *mkatomname(t_atoms *atoms, int i)
 {
     static char buf[32];
@@ -1358,71 +1445,28 @@ static int is_hbond(t_hbdata *hb, int grpd, int grpa, int d, int a,
 /* Merging is now done on the fly, so do_merge is most likely obsolete now.
  * Will do some more testing before removing the function entirely.
  * - Erik Marklund, MAY 10 2010 */
-static void do_merge(t_hbdata *hb, int ntmp,
-                     unsigned int htmp[], unsigned int gtmp[],
-                     t_hbond *hb0, t_hbond *hb1)
+static void do_merge(t_hbond *hb0, t_hbond *hb1)
 {
     /* Here we need to make sure we're treating periodicity in
      * the right way for the geminate recombination kinetics. */
 
-    int       m, mm, n00, n01, nn0, nnframes;
+    int       nn0, nnframes;
 
     /* Decide where to start from when merging */
-    n00      = hb0->n0;
-    n01      = hb1->n0;
-    nn0      = std::min(n00, n01);
-    nnframes = std::max(n00 + hb0->nframes, n01 + hb1->nframes) - nn0;
-    /* Initiate tmp arrays */
-    for (m = 0; (m < ntmp); m++)
-    {
-        htmp[m] = 0;
-        gtmp[m] = 0;
-    }
-    /* Fill tmp arrays with values due to first HB */
-    /* Once again '<' had to be replaced with '<='
-       to catch the last frame in which the hbond
-       appears.
-       - Erik Marklund, June 1, 2006 */
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m+n00-nn0;
-        htmp[mm] = is_hb(hb0->h[0], m);
-    }
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m+n00-nn0;
-        gtmp[mm] = is_hb(hb0->g[0], m);
-    }
-    /* Next HB */
-    for (m = 0; (m <= hb1->nframes); m++)
-    {
-        mm       = m+n01-nn0;
-        htmp[mm] = htmp[mm] || is_hb(hb1->h[0], m);
-        gtmp[mm] = gtmp[mm] || is_hb(hb1->g[0], m);
-    }
-    /* Reallocate target array */
-    if (nnframes > hb0->maxframes)
-    {
-        srenew(hb0->h[0], 4+nnframes/hb->wordlen);
-        srenew(hb0->g[0], 4+nnframes/hb->wordlen);
-    }
+    nn0      = std::min(hb0->n0, hb1->n0);
+    nnframes = std::max(hb0->n0 + hb0->nframes, hb1->n0 + hb1->nframes) - nn0;
 
-    /* Copy temp array to target array */
-    for (m = 0; (m <= nnframes); m++)
-    {
-        _set_hb(hb0->h[0], m, htmp[m]);
-        _set_hb(hb0->g[0], m, gtmp[m]);
-    }
+    merge_hbexist(&hb0->h[0], &hb1->h[0]);
+    merge_hbexist(&hb0->g[0], &hb1->g[0]);
 
     /* Set scalar variables */
     hb0->n0        = nn0;
-    hb0->maxframes = nnframes;
+    hb0->nframes   = nnframes;
 }
 
 static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
 {
-    int           i, inrnew, indnew, j, ii, jj, id, ia, ntmp;
-    unsigned int *htmp, *gtmp;
+    int           i, inrnew, indnew, j, ii, jj, id, ia;
     t_hbond      *hb0, *hb1;
 
     inrnew = hb->nrhb;
@@ -1431,9 +1475,6 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
     /* Check whether donors are also acceptors */
     printf("Merging hbonds with Acceptor and Donor swapped\n");
 
-    ntmp = 2*hb->max_frames;
-    snew(gtmp, ntmp);
-    snew(htmp, ntmp);
     for (i = 0; (i < hb->d.nrd); i++)
     {
         fprintf(stderr, "\r%d/%d", i+1, hb->d.nrd);
@@ -1450,7 +1491,7 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
                 hb1 = hb->hbmap[jj][ii];
                 if (hb0 && hb1 && ISHB(hb0->history[0]) && ISHB(hb1->history[0]))
                 {
-                    do_merge(hb, ntmp, htmp, gtmp, hb0, hb1);
+                    do_merge(hb0, hb1);
                     if (ISHB(hb1->history[0]))
                     {
                         inrnew--;
@@ -1468,10 +1509,8 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
                     {
                         gmx_incons("Neither hydrogen bond nor distance");
                     }
-                    sfree(hb1->h[0]);
-                    sfree(hb1->g[0]);
-                    hb1->h[0]       = NULL;
-                    hb1->g[0]       = NULL;
+                    free_hbexist(&hb1->h[0]);
+                    free_hbexist(&hb1->g[0]);
                     hb1->history[0] = hbNo;
                 }
             }
@@ -1482,8 +1521,6 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
     printf("- Reduced number of distances from %d to %d\n", hb->nrdist, indnew);
     hb->nrhb   = inrnew;
     hb->nrdist = indnew;
-    sfree(gtmp);
-    sfree(htmp);
 }
 
 static void do_nhb_dist(FILE *fp, t_hbdata *hb, real t)
@@ -1516,15 +1553,16 @@ static void do_nhb_dist(FILE *fp, t_hbdata *hb, real t)
 static void do_hblife(const char *fn, t_hbdata *hb, gmx_bool bMerge, gmx_bool bContact,
                       const gmx_output_env_t *oenv)
 {
-    FILE          *fp;
-    const char    *leg[] = { "p(t)", "t p(t)" };
-    int           *histo;
-    int            i, j, j0, k, m, nh, ihb, ohb, nhydro, ndump = 0;
-    int            nframes = hb->nframes;
-    unsigned int **h;
-    real           t, x1, dt;
-    double         sum, integral;
-    t_hbond       *hbh;
+    FILE             *fp;
+    const char       *leg[] = { "p(t)", "t p(t)" };
+    int              *histo;
+    int               i, j0, k, m, nh, nhydro, last, ndump = 0;
+    int               nframes = hb->nframes;
+    const t_hbexist **h;
+    const t_hbexist  *e;
+    real              t, x1, dt;
+    double            sum, integral;
+    t_hbond          *hbh;
 
     snew(h, hb->maxhydro);
     snew(histo, nframes+1);
@@ -1538,50 +1576,32 @@ static void do_hblife(const char *fn, t_hbdata *hb, gmx_bool bMerge, gmx_bool bC
             {
                 if (bMerge)
                 {
-                    if (hbh->h[0])
-                    {
-                        h[0]   = hbh->h[0];
-                        nhydro = 1;
-                    }
-                    else
-                    {
-                        nhydro = 0;
-                    }
+                    h[0]   = &hbh->h[0];
+                    nhydro = 1;
                 }
                 else
                 {
                     nhydro = 0;
                     for (m = 0; (m < hb->maxhydro); m++)
                     {
-                        if (hbh->h[m])
-                        {
-                            h[nhydro++] = bContact ? hbh->g[m] : hbh->h[m];
-                        }
+                        h[nhydro++] = bContact ? &hbh->g[m] : &hbh->h[m];
                     }
                 }
+                /* Only periods that end within the frames in which
+                 * this pair was seen count as a complete lifetime. */
+                last = hbh->n0 + hbh->nframes;
                 for (nh = 0; (nh < nhydro); nh++)
                 {
-                    ohb = 0;
-                    j0  = 0;
-
-                    for (j = 0; (j <= hbh->nframes); j++)
+                    e = h[nh];
+                    for (m = 0; (m < e->nr); m++)
                     {
-                        ihb      = is_hb(h[nh], j);
                         if (debug && (ndump < 10))
                         {
-                            fprintf(debug, "%5d  %5d\n", j, ihb);
+                            fprintf(debug, "%5d  %5d\n", e->iv[m].begin, e->iv[m].end);
                         }
-                        if (ihb != ohb)
+                        if (e->iv[m].end <= last)
                         {
-                            if (ihb)
-                            {
-                                j0 = j;
-                            }
-                            else
-                            {
-                                histo[j-j0]++;
-                            }
-                            ohb = ihb;
+                            histo[e->iv[m].end - e->iv[m].begin]++;
                         }
                     }
                     ndump++;
@@ -1654,21 +1674,22 @@ static void dump_ac(t_hbdata *hb, gmx_bool oneHB, int nDump)
                 bPrint = FALSE;
                 ihb    = idist = 0;
                 hbh    = hb->hbmap[i][k];
+                if (!hbh)
+                {
+                    continue;
+                }
                 if (oneHB)
                 {
-                    if (hbh->h[0])
-                    {
-                        ihb    = is_hb(hbh->h[0], j);
-                        idist  = is_hb(hbh->g[0], j);
-                        bPrint = TRUE;
-                    }
+                    ihb    = is_hb(&hbh->h[0], j);
+                    idist  = is_hb(&hbh->g[0], j);
+                    bPrint = TRUE;
                 }
                 else
                 {
                     for (m = 0; (m < hb->maxhydro) && !ihb; m++)
                     {
-                        ihb   = ihb   || ((hbh->h[m]) && is_hb(hbh->h[m], j));
-                        idist = idist || ((hbh->g[m]) && is_hb(hbh->g[m], j));
+                        ihb   = ihb   || is_hb(&hbh->h[m], j);
+                        idist = idist || is_hb(&hbh->g[m], j);
                     }
                     /* This is not correct! */
                     /* What isn't correct? -Erik M */
@@ -1926,7 +1947,7 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                     int nThreads)
 {
     FILE          *fp;
-    int            i, j, k, m, ihb, idist, n2, nn;
+    int            i, j, k, m, n2, nn, nf;
 
     const char    *legLuzar[] = {
         "Ac\\sfin sys\\v{}\\z{}(t)",
@@ -1940,7 +1961,7 @@ static void do_hbac(const char *fn, t_hbdata *hb,
     real          *ct, tail, tail2, dtail, *cct;
     const real     tol     = 1e-3;
     int            nframes = hb->nframes;
-    unsigned int **h       = NULL, **g = NULL;
+    const t_hbexist **h    = NULL, **g = NULL;
     int            nh, nhbonds, nhydro;
     t_hbond       *hbh;
     int            acType;
@@ -2034,8 +2055,8 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                 {
                     if (ISHB(hbh->history[0]))
                     {
-                        h[0]   = hbh->h[0];
-                        g[0]   = hbh->g[0];
+                        h[0]   = &hbh->h[0];
+                        g[0]   = &hbh->g[0];
                         nhydro = 1;
                     }
                 }
@@ -2045,14 +2066,15 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                     {
                         if (bContact ? ISDIST(hbh->history[m]) : ISHB(hbh->history[m]))
                         {
-                            g[nhydro] = hbh->g[m];
-                            h[nhydro] = hbh->h[m];
+                            g[nhydro] = &hbh->g[m];
+                            h[nhydro] = &hbh->h[m];
                             nhydro++;
                         }
                     }
                 }
 
-                int nf = hbh->nframes;
+                /* The time series start at the first frame of this pair */
+                nf = std::min(hbh->nframes+1, nframes);
                 for (nh = 0; (nh < nhydro); nh++)
                 {
                     int nrint = bContact ? hb->nrdist : hb->nrhb;
@@ -2063,28 +2085,28 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                     nhbonds++;
                     for (j = 0; (j < nframes); j++)
                     {
-                        if (j <= nf)
-                        {
-                            ihb   = is_hb(h[nh], j);
-                            idist = is_hb(g[nh], j);
-                        }
-                        else
-                        {
-                            ihb = idist = 0;
-                        }
-                        rhbex[j] = ihb;
-                        /* For contacts: if a second cut-off is provided, use it,
-                         * otherwise use g(t) = 1-h(t) */
-                        if (!R2 && bContact)
-                        {
-                            gt[j]  = 1-ihb;
-                        }
-                        else
+                        ht[j] = 0;
+                        gt[j] = 0;
+                    }
+                    fill_hbexist(h[nh], hbh->n0, nf, ht, 1);
+                    /* For contacts: if a second cut-off is provided, use it,
+                     * otherwise use g(t) = 1-h(t) */
+                    if (R2 || !bContact)
+                    {
+                        fill_hbexist(g[nh], hbh->n0, nf, gt, 1);
+                    }
+                    else
+                    {
+                        for (j = 0; (j < nframes); j++)
                         {
-                            gt[j]  = idist*(1-ihb);
+                            gt[j] = 1;
                         }
-                        ht[j]    = rhbex[j];
-                        nhb     += ihb;
+                    }
+                    for (j = 0; (j < nframes); j++)
+                    {
+                        gt[j]   *= 1-ht[j];
+                        rhbex[j] = ht[j];
+                        nhb     += ht[j];
                     }
 
                     /* The autocorrelation function is normalized after summation only */
@@ -2228,8 +2250,8 @@ static void analyse_donor_properties(FILE *fp, t_hbdata *hb, int nframes, real t
             nhtot++;
             for (j = 0; (j < hb->a.nra) && (nb == 0); j++)
             {
-                if (hb->hbmap[i][j] && hb->hbmap[i][j]->h[k] &&
-                    is_hb(hb->hbmap[i][j]->h[k], nframes))
+                if (hb->hbmap[i][j] && k < hb->maxhydro &&
+                    is_hb(&hb->hbmap[i][j]->h[k], nframes))
                 {
                     nb = 1;
                 }
@@ -2357,19 +2379,7 @@ static void sync_hbdata(t_hbdata *p_hb, int nframes)
     if (nframes >= p_hb->max_frames)
     {
         p_hb->max_frames += 4096;
-        srenew(p_hb->nhb,   p_hb->max_frames);
-        srenew(p_hb->ndist, p_hb->max_frames);
-        srenew(p_hb->n_bound, p_hb->max_frames);
         srenew(p_hb->nhx, p_hb->max_frames);
-        if (p_hb->bDAnr)
-        {
-            srenew(p_hb->danr, p_hb->max_frames);
-        }
-        std::memset(&(p_hb->nhb[nframes]),   0, sizeof(int) * (p_hb->max_frames-nframes));
-        std::memset(&(p_hb->ndist[nframes]), 0, sizeof(int) * (p_hb->max_frames-nframes));
-        p_hb->nhb[nframes]   = 0;
-        p_hb->ndist[nframes] = 0;
-
     }
     p_hb->nframes = nframes;
 
@@ -2836,26 +2846,17 @@ int gmx_hbond(int argc, char *argv[])
             snew(p_adist[i], nabin+1);
             snew(p_rdist[i], nrbin+1);
 
+            /* The threads only read the donors and acceptors and
+             * count helices; hydrogen bonds are stored per thread
+             * and added to hb after each frame. */
             p_hb[i]->max_frames = 0;
-            p_hb[i]->nhb        = NULL;
-            p_hb[i]->ndist      = NULL;
-            p_hb[i]->n_bound    = NULL;
-            p_hb[i]->time       = NULL;
             p_hb[i]->nhx        = NULL;
 
             p_hb[i]->bHBmap     = hb->bHBmap;
-            p_hb[i]->bDAnr      = hb->bDAnr;
-            p_hb[i]->wordlen    = hb->wordlen;
             p_hb[i]->nframes    = hb->nframes;
             p_hb[i]->maxhydro   = hb->maxhydro;
-            p_hb[i]->danr       = hb->danr;
             p_hb[i]->d          = hb->d;
             p_hb[i]->a          = hb->a;
-            p_hb[i]->hbmap      = hb->hbmap;
-            p_hb[i]->time       = hb->time; /* This may need re-syncing at every frame. */
-
-            p_hb[i]->nrhb   = 0;
-            p_hb[i]->nrdist = 0;
         }
     }
 
@@ -2912,11 +2913,6 @@ int gmx_hbond(int argc, char *argv[])
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
             } /* omp single */
 
-            if (bOMP)
-            {
-                p_hb[threadNr]->time = hb->time; /* This pointer may have changed. */
-            }
-
             if (bSelected)
             {
 
@@ -3013,9 +3009,8 @@ int gmx_hbond(int argc, char *argv[])
 
                                                         if (ihb)
                                                         {
-                                                            /* add to index if not already there */
-                                                            /* Add a hbond */
-                                                            add_hbond(__HBDATA, i, j, h, grp, ogrp, nframes, bMerge, ihb, bContact);
+                                                            /* Store the hbond, it is added to hb after this frame */
+                                                            store_hbond(__HBDATA, i, j, h, grp, ogrp, ihb);
 
                                                             /* make angle and distance distributions */
                                                             if (ihb == hbHB && !bContact)
@@ -3064,20 +3059,27 @@ int gmx_hbond(int argc, char *argv[])
             /* Better wait for all threads to finnish using x[] before updating it. */
             k = nframes;
 #pragma omp barrier
-#pragma omp critical
+#pragma omp single
             {
                 try
                 {
-                    /* Sum up histograms and counts from p_hb[] into hb */
+                    /* Add the hbonds and counts from p_hb[] to hb,
+                     * in thread order so the result is reproducible */
                     if (bOMP)
                     {
-                        hb->nhb[k]   += p_hb[threadNr]->nhb[k];
-                        hb->ndist[k] += p_hb[threadNr]->ndist[k];
-                        for (j = 0; j < max_hx; j++)
+                        for (ii = 0; ii < actual_nThreads; ii++)
                         {
-                            hb->nhx[k][j]  += p_hb[threadNr]->nhx[k][j];
+                            add_found_hbonds(hb, p_hb[ii], k, bMerge, bContact);
+                            for (j = 0; j < max_hx; j++)
+                            {
+                                hb->nhx[k][j]  += p_hb[ii]->nhx[k][j];
+                            }
                         }
                     }
+                    else
+                    {
+                        add_found_hbonds(hb, hb, k, bMerge, bContact);
+                    }
                 }
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
             }
@@ -3125,16 +3127,9 @@ int gmx_hbond(int argc, char *argv[])
 
         if (bOMP)
         {
-#pragma omp critical
-            {
-                hb->nrhb   += p_hb[threadNr]->nrhb;
-                hb->nrdist += p_hb[threadNr]->nrdist;
-            }
-
             /* Free parallel datastructures */
-            sfree(p_hb[threadNr]->nhb);
-            sfree(p_hb[threadNr]->ndist);
             sfree(p_hb[threadNr]->nhx);
+            sfree(p_hb[threadNr]->found);
 
 #pragma omp for
             for (i = 0; i < nabin; i++)
@@ -3366,11 +3361,14 @@ int gmx_hbond(int argc, char *argv[])
                             {
                                 if (ISHB(hb->hbmap[id][ia]->history[hh]))
                                 {
-                                    for (x = 0; (x <= hb->hbmap[id][ia]->nframes); x++)
+                                    const t_hbexist *e = &hb->hbmap[id][ia]->h[hh];
+                                    range_check(y, 0, mat.ny);
+                                    for (i = 0; (i < e->nr); i++)
                                     {
-                                        int nn0 = hb->hbmap[id][ia]->n0;
-                                        range_check(y, 0, mat.ny);
-                                        mat.matrix[x+nn0][y] = is_hb(hb->hbmap[id][ia]->h[hh], x);
+                                        for (x = e->iv[i].begin; (x < e->iv[i].end); x++)
+                                        {
+                                            mat.matrix[x][y] = 1;
+                                        }
                                     }
                                     y++;
                                 }
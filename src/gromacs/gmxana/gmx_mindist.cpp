@@ -41,6 +41,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -53,23 +54,111 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pbcutil/rmpbc.h"
+#include "gromacs/selection/nbsearch.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 
+/* Closest or farthest pair found in a loop over pairs. The loop positions
+ * j (outer) and i (inner) are kept to select the pair that comes first in
+ * the serial loop order among pairs with equal distances, so that the
+ * result does not depend on how the loop is divided over threads.
+ */
+typedef struct {
+    real r2;
+    int  j, i;
+} t_dist_pair;
+
+static void init_dist_pair(t_dist_pair *p, real r2)
+{
+    p->r2 = r2;
+    p->j  = -1;
+    p->i  = -1;
+}
+
+/* Returns whether the pair at loop position (j, i) with squared distance
+ * r2 should replace p, i.e., is closer (bMin) or farther (!bMin), or
+ * equally far but earlier in the loop order.
+ */
+static gmx_bool replaces_dist_pair(const t_dist_pair *p, gmx_bool bMin,
+                                   real r2, int j, int i)
+{
+    if (r2 != p->r2)
+    {
+        return bMin ? (r2 < p->r2) : (r2 > p->r2);
+    }
+    return p->j >= 0 && (j < p->j || (j == p->j && i < p->i));
+}
+
+static void update_dist_pair(t_dist_pair *p, gmx_bool bMin, real r2, int j, int i)
+{
+    if (replaces_dist_pair(p, bMin, r2, j, i))
+    {
+        p->r2 = r2;
+        p->j  = j;
+        p->i  = i;
+    }
+}
+
+/* Divides the outer loop of a double loop over n elements into nthreads
+ * contiguous blocks, with block t covering [start[t], start[t+1]).
+ * With bTriangular, the inner loop only covers the elements after the
+ * outer one, and the blocks are chosen to have similar numbers of pairs.
+ */
+static void loop_blocks(int n, gmx_bool bTriangular, int nthreads, int start[])
+{
+    int t;
+
+    start[0] = 0;
+    if (bTriangular)
+    {
+        const double total = 0.5*n*(n - 1.0);
+        double       sum   = 0;
+        int          i;
+
+        t = 1;
+        for (i = 0; i < n && t < nthreads; i++)
+        {
+            sum += n - 1 - i;
+            while (t < nthreads && sum >= total*t/nthreads)
+            {
+                start[t++] = i + 1;
+            }
+        }
+        for (; t < nthreads; t++)
+        {
+            start[t] = n;
+        }
+    }
+    else
+    {
+        for (t = 1; t < nthreads; t++)
+        {
+            start[t] = static_cast<int>((static_cast<gmx_int64_t>(n)*t)/nthreads);
+        }
+    }
+    start[nthreads] = n;
+}
+
 static void periodic_dist(int ePBC,
                           matrix box, rvec x[], int n, atom_id index[],
-                          real *rmin, real *rmax, int *min_ind)
+                          real *rmin, real *rmax, int *min_ind, int nthreads)
 {
 #define NSHIFT_MAX 26
-    int  nsz, nshift, sx, sy, sz, i, j, s;
-    real sqr_box, r2min, r2max, r2;
-    rvec shift[NSHIFT_MAX], d0, d;
+    int          nsz, nshift, sx, sy, sz, i, t;
+    real         sqr_box, r2max;
+    rvec         shift[NSHIFT_MAX];
+    int         *start;
+    t_dist_pair *thread_min;
+    real        *thread_r2max;
 
     sqr_box = std::min(norm2(box[XX]), norm2(box[YY]));
     if (ePBC == epbcXYZ)
@@ -108,41 +197,72 @@ static void periodic_dist(int ePBC,
         }
     }
 
-    r2min = sqr_box;
-    r2max = 0;
-
-    for (i = 0; i < n; i++)
+    /* The pairs are divided over the threads in contiguous blocks of i */
+    snew(start, nthreads + 1);
+    snew(thread_min, nthreads);
+    snew(thread_r2max, nthreads);
+    loop_blocks(n, TRUE, nthreads, start);
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+    for (t = 0; t < nthreads; t++)
     {
-        for (j = i+1; j < n; j++)
+        t_dist_pair pmin;
+        real        r2, r2max_t;
+        rvec        d0, d;
+        int         ii, j, s;
+
+        init_dist_pair(&pmin, sqr_box);
+        r2max_t = 0;
+        for (ii = start[t]; ii < start[t+1]; ii++)
         {
-            rvec_sub(x[index[i]], x[index[j]], d0);
-            r2 = norm2(d0);
-            if (r2 > r2max)
-            {
-                r2max = r2;
-            }
-            for (s = 0; s < nshift; s++)
+            for (j = ii+1; j < n; j++)
             {
-                rvec_add(d0, shift[s], d);
-                r2 = norm2(d);
-                if (r2 < r2min)
+                rvec_sub(x[index[ii]], x[index[j]], d0);
+                r2 = norm2(d0);
+                if (r2 > r2max_t)
                 {
-                    r2min      = r2;
-                    min_ind[0] = i;
-                    min_ind[1] = j;
+                    r2max_t = r2;
+                }
+                for (s = 0; s < nshift; s++)
+                {
+                    rvec_add(d0, shift[s], d);
+                    r2 = norm2(d);
+                    if (r2 < pmin.r2)
+                    {
+                        pmin.r2 = r2;
+                        pmin.j  = ii;
+                        pmin.i  = j;
+                    }
                 }
             }
         }
+        thread_min[t]   = pmin;
+        thread_r2max[t] = r2max_t;
     }
 
-    *rmin = std::sqrt(r2min);
+    /* Reduce in block order, which gives the same pair as a serial loop */
+    r2max = 0;
+    for (t = 0; t < nthreads; t++)
+    {
+        if (thread_min[t].j >= 0 && thread_min[t].r2 < sqr_box)
+        {
+            sqr_box    = thread_min[t].r2;
+            min_ind[0] = thread_min[t].j;
+            min_ind[1] = thread_min[t].i;
+        }
+        r2max = std::max(r2max, thread_r2max[t]);
+    }
+    sfree(start);
+    sfree(thread_min);
+    sfree(thread_r2max);
+
+    *rmin = std::sqrt(sqr_box);
     *rmax = std::sqrt(r2max);
 }
 
 static void periodic_mindist_plot(const char *trxfn, const char *outfn,
                                   t_topology *top, int ePBC,
                                   int n, atom_id index[], gmx_bool bSplit,
-                                  const gmx_output_env_t *oenv)
+                                  int nthreads, const gmx_output_env_t *oenv)
 {
     FILE        *out;
     const char  *leg[5] = { "min per.", "max int.", "box1", "box2", "box3" };
@@ -183,7 +303,7 @@ static void periodic_mindist_plot(const char *trxfn, const char *outfn,
             gmx_rmpbc(gpbc, natoms, box, x);
         }
 
-        periodic_dist(ePBC, box, x, n, index, &rmin, &rmax, ind_min);
+        periodic_dist(ePBC, box, x, n, index, &rmin, &rmax, ind_min, nthreads);
         if (rmin < rmint)
         {
             rmint    = rmin;
@@ -215,53 +335,33 @@ static void periodic_mindist_plot(const char *trxfn, const char *outfn,
             index[ind_mini]+1, index[ind_minj]+1);
 }
 
-static void calc_dist(real rcut, gmx_bool bPBC, int ePBC, matrix box, rvec x[],
-                      int nx1, int nx2, atom_id index1[], atom_id index2[],
-                      gmx_bool bGroup,
-                      real *rmin, real *rmax, int *nmin, int *nmax,
-                      int *ixmin, int *jxmin, int *ixmax, int *jxmax)
-{
-    int      i, j, i0 = 0, j1;
-    int      ix, jx;
-    atom_id *index3;
-    rvec     dx;
-    real     r2, rmin2, rmax2, rcut2;
-    t_pbc    pbc;
-    int      nmin_j, nmax_j;
+/* Distance extremes and contact counts for a block of a calc_dist() loop */
+typedef struct {
+    t_dist_pair min, max;
+    int         nmin, nmax;
+} t_dist_result;
 
-    *ixmin = -1;
-    *jxmin = -1;
-    *ixmax = -1;
-    *jxmax = -1;
-    *nmin  = 0;
-    *nmax  = 0;
-
-    rcut2 = sqr(rcut);
-
-    /* Must init pbc every step because of pressure coupling */
-    if (bPBC)
-    {
-        set_pbc(&pbc, ePBC, box);
-    }
-    if (index2)
-    {
-        i0     = 0;
-        j1     = nx2;
-        index3 = index2;
-    }
-    else
-    {
-        j1     = nx1;
-        index3 = index1;
-    }
+/* Loops over outer positions j0 <= j < j1 of calc_dist() */
+static void calc_dist_block(int j0, int j1, real rcut2, const t_pbc *pbc,
+                            rvec x[], int nx1, atom_id index1[],
+                            atom_id index3[], gmx_bool bInternal,
+                            gmx_bool bGroup, t_dist_result *res)
+{
+    int  i, j, i0 = 0;
+    int  ix, jx;
+    rvec dx;
+    real r2;
+    int  nmin_j, nmax_j;
 
-    rmin2 = 1e12;
-    rmax2 = -1e12;
+    init_dist_pair(&res->min, 1e12);
+    init_dist_pair(&res->max, -1e12);
+    res->nmin = 0;
+    res->nmax = 0;
 
-    for (j = 0; (j < j1); j++)
+    for (j = j0; (j < j1); j++)
     {
         jx = index3[j];
-        if (index2 == NULL)
+        if (bInternal)
         {
             i0 = j + 1;
         }
@@ -272,26 +372,26 @@ static void calc_dist(real rcut, gmx_bool bPBC, int ePBC, matrix box, rvec x[],
             ix = index1[i];
             if (ix != jx)
             {
-                if (bPBC)
+                if (pbc)
                 {
-                    pbc_dx(&pbc, x[ix], x[jx], dx);
+                    pbc_dx(pbc, x[ix], x[jx], dx);
                 }
                 else
                 {
                     rvec_sub(x[ix], x[jx], dx);
                 }
                 r2 = iprod(dx, dx);
-                if (r2 < rmin2)
+                if (r2 < res->min.r2)
                 {
-                    rmin2  = r2;
-                    *ixmin = ix;
-                    *jxmin = jx;
+                    res->min.r2 = r2;
+                    res->min.j  = j;
+                    res->min.i  = i;
                 }
-                if (r2 > rmax2)
+                if (r2 > res->max.r2)
                 {
-                    rmax2  = r2;
-                    *ixmax = ix;
-                    *jxmax = jx;
+                    res->max.r2 = r2;
+                    res->max.j  = j;
+                    res->max.i  = i;
                 }
                 if (r2 <= rcut2)
                 {
@@ -307,21 +407,260 @@ static void calc_dist(real rcut, gmx_bool bPBC, int ePBC, matrix box, rvec x[],
         {
             if (nmin_j > 0)
             {
-                (*nmin)++;
+                res->nmin++;
             }
             if (nmax_j > 0)
             {
-                (*nmax)++;
+                res->nmax++;
             }
         }
         else
         {
-            *nmin += nmin_j;
-            *nmax += nmax_j;
+            res->nmin += nmin_j;
+            res->nmax += nmax_j;
         }
     }
-    *rmin = std::sqrt(rmin2);
-    *rmax = std::sqrt(rmax2);
+}
+
+/* Groups with fewer pairs than this are searched with a simple loop */
+static const double c_mindistGridMinPairs  = 10000;
+/* Cutoff to start the minimum distance search with if rcut is not positive */
+static const real   c_mindistGridCutoff    = 0.5;
+/* Number of times the search cutoff is doubled before giving up */
+static const int    c_mindistGridMaxDouble = 4;
+
+/* Grid-based minimum distance and contact count for calc_dist().
+ *
+ * The pairs are searched with gmx::AnalysisNeighborhood, using a cutoff that
+ * starts from rcut and is doubled until the closest pair is found. Each
+ * found pair is checked with the same distance computation as in the
+ * all-pairs loop, and ties are resolved in the loop order, so the results
+ * are identical to calc_dist_block(). The test positions are divided over
+ * nthreads threads.
+ *
+ * Returns FALSE if the all-pairs loop should be used instead, because the
+ * groups are small, the cutoff would become too long for the box or, for
+ * a group with itself, the group contains an atom more than once.
+ */
+static gmx_bool calc_mindist_grid(real rcut, const t_pbc *pbc, rvec x[],
+                                  int nx1, atom_id index1[],
+                                  int nx3, atom_id index3[], gmx_bool bInternal,
+                                  gmx_bool bGroup, int nthreads,
+                                  real *rmin, int *nmin, int *ixmin, int *jxmin)
+{
+    const real  rcut2 = sqr(rcut);
+    real        cutoff, searchCutoff, maxcutoff2;
+    int         ndouble, t;
+
+    if (static_cast<double>(nx1)*nx3 < c_mindistGridMinPairs)
+    {
+        return FALSE;
+    }
+    if (bInternal)
+    {
+        std::vector<atom_id> sorted(index1, index1 + nx1);
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        {
+            return FALSE;
+        }
+    }
+    maxcutoff2 = (pbc != NULL && pbc->ePBC != epbcNONE)
+        ? max_cutoff2(pbc->ePBC, const_cast<rvec *>(pbc->box)) : GMX_REAL_MAX;
+
+    cutoff = (rcut > 0) ? rcut : c_mindistGridCutoff;
+    for (ndouble = 0; ndouble <= c_mindistGridMaxDouble; ndouble++, cutoff *= 2)
+    {
+        /* A small margin makes sure that the search finds all pairs that
+         * the exact distance computation puts within the cutoff.
+         */
+        searchCutoff = cutoff*(1 + 1e-4);
+        if (sqr(searchCutoff) >= maxcutoff2)
+        {
+            return FALSE;
+        }
+
+        gmx::AnalysisNeighborhood          nb;
+        nb.setCutoff(searchCutoff);
+        gmx::AnalysisNeighborhoodPositions refPos(x, nx1);
+        refPos.indexed(gmx::constArrayRefFromArray(index1, nx1));
+        gmx::AnalysisNeighborhoodPositions testPos(x, nx3);
+        testPos.indexed(gmx::constArrayRefFromArray(index3, nx3));
+        gmx::AnalysisNeighborhoodSearch    search = nb.initSearch(pbc, refPos);
+
+        std::vector<t_dist_pair>           thread_min(nthreads);
+        std::vector<int>                   thread_nmin(nthreads);
+#pragma omp parallel num_threads(nthreads)
+        {
+            const int thread = gmx_omp_get_thread_num();
+            try
+            {
+                gmx::AnalysisNeighborhoodPairSearch pairSearch =
+                    search.startPairSearch(testPos, thread, nthreads);
+                gmx::AnalysisNeighborhoodPair       pair;
+                t_dist_pair                         pmin;
+                int                                 ncontact = 0, jlast = -1;
+                rvec                                dx;
+
+                init_dist_pair(&pmin, 1e12);
+                /* Pairs are returned grouped by test position */
+                while (pairSearch.findNextPair(&pair))
+                {
+                    const int i  = pair.refIndex();
+                    const int j  = pair.testIndex();
+                    const int ix = index1[i];
+                    const int jx = index3[j];
+                    if ((bInternal && i <= j) || ix == jx)
+                    {
+                        continue;
+                    }
+                    if (pbc)
+                    {
+                        pbc_dx(pbc, x[ix], x[jx], dx);
+                    }
+                    else
+                    {
+                        rvec_sub(x[ix], x[jx], dx);
+                    }
+                    const real r2 = iprod(dx, dx);
+                    update_dist_pair(&pmin, TRUE, r2, j, i);
+                    if (r2 <= rcut2 && (!bGroup || j != jlast))
+                    {
+                        ncontact++;
+                        jlast = j;
+                    }
+                }
+                thread_min[thread]  = pmin;
+                thread_nmin[thread] = ncontact;
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        t_dist_pair pmin;
+        int         ncontact = 0;
+        init_dist_pair(&pmin, 1e12);
+        for (t = 0; t < nthreads; t++)
+        {
+            if (thread_min[t].j >= 0)
+            {
+                update_dist_pair(&pmin, TRUE, thread_min[t].r2,
+                                 thread_min[t].j, thread_min[t].i);
+            }
+            ncontact += thread_nmin[t];
+        }
+        /* Only pairs within cutoff are guaranteed to all be found, so a
+         * closest pair beyond it may not be the closest of all pairs.
+         */
+        if (pmin.j >= 0 && pmin.r2 <= sqr(cutoff))
+        {
+            *rmin  = std::sqrt(pmin.r2);
+            *nmin  = ncontact;
+            *ixmin = index1[pmin.i];
+            *jxmin = index3[pmin.j];
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Computes the minimum and maximum distance between two groups, or within
+ * a group if index2 is NULL, and the numbers of pairs within and beyond
+ * rcut. With bMin, only the minimum distance and the contacts within rcut
+ * are needed, and these are computed with a grid search if possible.
+ * The work is divided over nthreads threads.
+ */
+static void calc_dist(real rcut, gmx_bool bPBC, int ePBC, matrix box, rvec x[],
+                      int nx1, int nx2, atom_id index1[], atom_id index2[],
+                      gmx_bool bGroup, gmx_bool bMin, int nthreads,
+                      real *rmin, real *rmax, int *nmin, int *nmax,
+                      int *ixmin, int *jxmin, int *ixmax, int *jxmax)
+{
+    int            j1, t;
+    atom_id       *index3;
+    real           rcut2;
+    t_pbc          pbc;
+    gmx_bool       bInternal;
+    int           *start;
+    t_dist_result *res;
+    t_dist_pair    pmin, pmax;
+
+    *ixmin = -1;
+    *jxmin = -1;
+    *ixmax = -1;
+    *jxmax = -1;
+    *nmin  = 0;
+    *nmax  = 0;
+
+    rcut2 = sqr(rcut);
+
+    /* Must init pbc every step because of pressure coupling */
+    if (bPBC)
+    {
+        set_pbc(&pbc, ePBC, box);
+    }
+    bInternal = (index2 == NULL);
+    if (index2)
+    {
+        j1     = nx2;
+        index3 = index2;
+    }
+    else
+    {
+        j1     = nx1;
+        index3 = index1;
+    }
+
+    if (bMin && calc_mindist_grid(rcut, bPBC ? &pbc : NULL, x, nx1, index1,
+                                  j1, index3, bInternal, bGroup, nthreads,
+                                  rmin, nmin, ixmin, jxmin))
+    {
+        /* The maximum distance is not needed for minimum distance output */
+        *rmax = 0;
+        return;
+    }
+
+    nthreads = std::max(1, std::min(nthreads, j1));
+    snew(start, nthreads + 1);
+    snew(res, nthreads);
+    loop_blocks(j1, bInternal, nthreads, start);
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+    for (t = 0; t < nthreads; t++)
+    {
+        calc_dist_block(start[t], start[t+1], rcut2, bPBC ? &pbc : NULL,
+                        x, nx1, index1, index3, bInternal, bGroup, &res[t]);
+    }
+
+    /* Reduce in block order, which gives the same pairs as a serial loop */
+    init_dist_pair(&pmin, 1e12);
+    init_dist_pair(&pmax, -1e12);
+    for (t = 0; t < nthreads; t++)
+    {
+        if (res[t].min.j >= 0 && res[t].min.r2 < pmin.r2)
+        {
+            pmin = res[t].min;
+        }
+        if (res[t].max.j >= 0 && res[t].max.r2 > pmax.r2)
+        {
+            pmax = res[t].max;
+        }
+        *nmin += res[t].nmin;
+        *nmax += res[t].nmax;
+    }
+    sfree(start);
+    sfree(res);
+
+    if (pmin.j >= 0)
+    {
+        *ixmin = index1[pmin.i];
+        *jxmin = index3[pmin.j];
+    }
+    if (pmax.j >= 0)
+    {
+        *ixmax = index1[pmax.i];
+        *jxmax = index3[pmax.j];
+    }
+    *rmin = std::sqrt(pmin.r2);
+    *rmax = std::sqrt(pmax.r2);
 }
 
 void dist_plot(const char *fn, const char *afile, const char *dfile,
@@ -330,7 +669,7 @@ void dist_plot(const char *fn, const char *afile, const char *dfile,
                int ng, atom_id *index[], int gnx[], char *grpn[], gmx_bool bSplit,
                gmx_bool bMin, int nres, atom_id *residue, gmx_bool bPBC, int ePBC,
                gmx_bool bGroup, gmx_bool bEachResEachTime, gmx_bool bPrintResName,
-               const gmx_output_env_t *oenv)
+               int nthreads, const gmx_output_env_t *oenv)
 {
     FILE            *atm, *dist, *num;
     t_trxstatus     *trxout;
@@ -464,7 +803,7 @@ void dist_plot(const char *fn, const char *afile, const char *dfile,
         {
             if (ng == 1)
             {
-                calc_dist(rcut, bPBC, ePBC, box, x0, gnx[0], gnx[0], index[0], index[0], bGroup,
+                calc_dist(rcut, bPBC, ePBC, box, x0, gnx[0], gnx[0], index[0], index[0], bGroup, bMin, nthreads,
                           &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
                 fprintf(dist, "  %12e", bMin ? dmin : dmax);
                 if (num)
@@ -479,7 +818,7 @@ void dist_plot(const char *fn, const char *afile, const char *dfile,
                     for (k = i+1; (k < ng); k++)
                     {
                         calc_dist(rcut, bPBC, ePBC, box, x0, gnx[i], gnx[k], index[i], index[k],
-                                  bGroup, &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
+                                  bGroup, bMin, nthreads, &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
                         fprintf(dist, "  %12e", bMin ? dmin : dmax);
                         if (num)
                         {
@@ -493,7 +832,7 @@ void dist_plot(const char *fn, const char *afile, const char *dfile,
         {
             for (i = 1; (i < ng); i++)
             {
-                calc_dist(rcut, bPBC, ePBC, box, x0, gnx[0], gnx[i], index[0], index[i], bGroup,
+                calc_dist(rcut, bPBC, ePBC, box, x0, gnx[0], gnx[i], index[0], index[i], bGroup, bMin, nthreads,
                           &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
                 fprintf(dist, "  %12e", bMin ? dmin : dmax);
                 if (num)
@@ -505,7 +844,7 @@ void dist_plot(const char *fn, const char *afile, const char *dfile,
                     for (j = 0; j < nres; j++)
                     {
                         calc_dist(rcut, bPBC, ePBC, box, x0, residue[j+1]-residue[j], gnx[i],
-                                  &(index[0][residue[j]]), index[i], bGroup,
+                                  &(index[0][residue[j]]), index[i], bGroup, bMin, nthreads,
                                   &dmin, &dmax, &nmin, &nmax, &min1r, &min2r, &max1r, &max2r);
                         mindres[i-1][j] = std::min(mindres[i-1][j], dmin);
                         maxdres[i-1][j] = std::max(maxdres[i-1][j], dmax);
@@ -660,6 +999,9 @@ int gmx_mindist(int argc, char *argv[])
         "each direction is considered, giving a total of 26 shifts.",
         "It also plots the maximum distance within the group and the lengths",
         "of the three box vectors.[PAR]",
+        "Minimum distances and contacts are found with a grid search for",
+        "large groups, and the pairs are divided over [TT]-nt[tt] threads;",
+        "the output is the same as with a loop over all atom pairs.[PAR]",
         "Also [gmx-distance] and [gmx-pairdist] calculate distances."
     };
 
@@ -668,6 +1010,7 @@ int gmx_mindist(int argc, char *argv[])
     static real       rcutoff          = 0.6;
     static int        ng               = 1;
     static gmx_bool   bEachResEachTime = FALSE, bPrintResName = FALSE;
+    static int        nthreads         = -1;
     t_pargs           pa[]             = {
         { "-matrix", FALSE, etBOOL, {&bMat},
           "Calculate half a matrix of group-group distances" },
@@ -688,7 +1031,12 @@ int gmx_mindist(int argc, char *argv[])
         { "-respertime",  FALSE, etBOOL, {&bEachResEachTime},
           "When writing per-residue distances, write distance for each time point" },
         { "-printresname",  FALSE, etBOOL, {&bPrintResName},
-          "Write residue names" }
+          "Write residue names" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT, {&nthreads},
+          "Number of threads to compute distances with (if -1, all threads will "
+          "be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
     gmx_output_env_t *oenv;
     t_topology       *top  = NULL;
@@ -743,6 +1091,15 @@ int gmx_mindist(int argc, char *argv[])
         gmx_fatal(FARGS, "You have to specify either the index file or a tpr file");
     }
 
+    if (nthreads > 0)
+    {
+        gmx_omp_set_num_threads(nthreads);
+    }
+    else
+    {
+        nthreads = gmx_omp_get_max_threads();
+    }
+
     if (bPI)
     {
         ng = 1;
@@ -799,14 +1156,15 @@ int gmx_mindist(int argc, char *argv[])
 
     if (bPI)
     {
-        periodic_mindist_plot(trxfnm, distfnm, top, ePBC, gnx[0], index[0], bSplit, oenv);
+        periodic_mindist_plot(trxfnm, distfnm, top, ePBC, gnx[0], index[0], bSplit,
+                              nthreads, oenv);
     }
     else
     {
         dist_plot(trxfnm, atmfnm, distfnm, numfnm, resfnm, oxfnm,
                   rcutoff, bMat, top ? &(top->atoms) : NULL,
                   ng, index, gnx, grpname, bSplit, !bMax, nres, residues, bPBC, ePBC,
-                  bGroup, bEachResEachTime, bPrintResName, oenv);
+                  bGroup, bEachResEachTime, bPrintResName, nthreads, oenv);
     }
 
     do_view(oenv, distfnm, "-nxy");
@@ -36,11 +36,13 @@
  */
 #include "gmxpre.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
+#include "gromacs/correlationfunctions/meansquaredisplacement.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
@@ -53,9 +55,11 @@
 #include "gromacs/statistics/statistics.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 #define FACTOR  1000.0  /* Convert nm^2/ps to 10e-5 cm^2/s */
@@ -93,6 +97,9 @@ typedef struct {
     int          *n_offs;
     int         **ndata;      /* the number of msds (particles/mols) per data
                                  point. */
+    gmx_bool      bFFT;       /* use all time origins, computed with FFTs */
+    rvec        **xfft;       /* for bFFT, the positions of each group for
+                                 all frames, frame-major */
 } t_corr;
 
 typedef real t_calc_func (t_corr *curr, int nx, atom_id index[], int nx0, rvec xc[],
@@ -110,7 +117,7 @@ static gmx_bool in_data(t_corr *curr, int nx00)
 
 t_corr *init_corr(int nrgrp, int type, int axis, real dim_factor,
                   int nmol, gmx_bool bTen, gmx_bool bMass, real dt, t_topology *top,
-                  real beginfit, real endfit)
+                  real beginfit, real endfit, gmx_bool bFFT)
 {
     t_corr  *curr;
     t_atoms *atoms;
@@ -129,6 +136,8 @@ t_corr *init_corr(int nrgrp, int type, int axis, real dim_factor,
     curr->nframes    = 0;
     curr->nlast      = 0;
     curr->dim_factor = dim_factor;
+    curr->bFFT       = bFFT;
+    curr->xfft       = NULL;
 
     snew(curr->ndata, nrgrp);
     snew(curr->data, nrgrp);
@@ -136,6 +145,10 @@ t_corr *init_corr(int nrgrp, int type, int axis, real dim_factor,
     {
         snew(curr->datam, nrgrp);
     }
+    if (bFFT)
+    {
+        snew(curr->xfft, nrgrp);
+    }
     for (i = 0; (i < nrgrp); i++)
     {
         curr->ndata[i] = NULL;
@@ -184,8 +197,16 @@ static void corr_print(t_corr *curr, gmx_bool bTen, const char *fn, const char *
     out = xvgropen(fn, title, output_env_get_xvgr_tlabel(oenv), yaxis, oenv);
     if (DD)
     {
-        fprintf(out, "# MSD gathered over %g %s with %d restarts\n",
-                msdtime, output_env_get_time_unit(oenv), curr->nrestart);
+        if (curr->bFFT)
+        {
+            fprintf(out, "# MSD gathered over %g %s using all %d time origins\n",
+                    msdtime, output_env_get_time_unit(oenv), curr->nframes);
+        }
+        else
+        {
+            fprintf(out, "# MSD gathered over %g %s with %d restarts\n",
+                    msdtime, output_env_get_time_unit(oenv), curr->nrestart);
+        }
         fprintf(out, "# Diffusion constants fitted from time %g to %g %s\n",
                 beginfit, endfit, output_env_get_time_unit(oenv));
         for (i = 0; i < curr->ngrp; i++)
@@ -544,6 +565,197 @@ static real calc1_mol(t_corr *curr, int nx, atom_id gmx_unused index[], int nx0,
     return gtot/nx;
 }
 
+/* Store the positions of group nr for the current frame for the FFT
+ * calculation. With COM removal, the COM of each frame is subtracted,
+ * which gives the same displacements as subtracting dcom.
+ */
+static void store_fft_frame(t_corr *curr, int nr, int nx, atom_id index[],
+                            gmx_bool bMol, rvec xc[], gmx_bool bRmCOMM, rvec com)
+{
+    rvec *xs;
+    int   i;
+
+    xs = curr->xfft[nr] + curr->nframes*nx;
+    for (i = 0; i < nx; i++)
+    {
+        copy_rvec(xc[bMol ? i : index[i]], xs[i]);
+        if (bRmCOMM)
+        {
+            rvec_dec(xs[i], com);
+        }
+    }
+}
+
+/* Compute the MSD of group nr over all time origins from the positions
+ * stored with store_fft_frame(). Each atom or molecule is correlated with
+ * FFTs in O(nframes log nframes). The particles are divided over nthreads
+ * threads, which accumulate into their own buffers. These are summed in
+ * thread order, so the result does not depend on the scheduling.
+ */
+static void calc_corr_fft(t_corr *curr, int nr, int nx, atom_id index[],
+                          gmx_bool bMol, gmx_bool bMW, gmx_bool bTen, int nthreads)
+{
+    const int   nframes = curr->nframes;
+    int         dims[DIM], ncomp, i, k, m, m2, t;
+    real       *w;
+    double      wtot;
+    double    **acc, **accm = NULL;
+
+    ncomp = 0;
+    switch (curr->type)
+    {
+        case NORMAL:
+            for (m = 0; m < DIM; m++)
+            {
+                dims[ncomp++] = m;
+            }
+            break;
+        case X:
+        case Y:
+        case Z:
+            dims[ncomp++] = curr->type - X;
+            break;
+        case LATERAL:
+            for (m = 0; m < DIM; m++)
+            {
+                if (m != curr->axis)
+                {
+                    dims[ncomp++] = m;
+                }
+            }
+            break;
+        default:
+            gmx_fatal(FARGS, "Error: did not expect option value %d", curr->type);
+    }
+
+    /* Same weights as in calc1_norm, calc1_mw and calc1_mol */
+    snew(w, nx);
+    wtot = 0;
+    for (i = 0; i < nx; i++)
+    {
+        w[i]  = (bMW && !bMol) ? curr->mass[index[i]] : 1;
+        wtot += w[i];
+    }
+
+    nthreads = std::max(1, std::min(nthreads, nx));
+    snew(acc, nthreads);
+    if (bTen)
+    {
+        snew(accm, nthreads);
+    }
+#pragma omp parallel num_threads(nthreads)
+    {
+        int            thread = gmx_omp_get_thread_num();
+        gmx_msd_fft_t  msd;
+        real          *r2, *res;
+        int            ii, kk, c, c2, status;
+
+        if ((status = gmx_msd_fft_init(&msd, nframes, ncomp)) != 0)
+        {
+            gmx_fatal(FARGS, "Invalid fft return status %d", status);
+        }
+        snew(r2, nframes);
+        snew(res, nframes);
+        snew(acc[thread], nframes);
+        if (bTen)
+        {
+            snew(accm[thread], nframes*DIM*DIM);
+        }
+#pragma omp for schedule(static)
+        for (ii = 0; ii < nx; ii++)
+        {
+            try
+            {
+                if (w[ii] == 0)
+                {
+                    continue;
+                }
+                for (c = 0; c < ncomp; c++)
+                {
+                    gmx_msd_fft_set_component(msd, c, &curr->xfft[nr][ii][dims[c]],
+                                              nx*DIM);
+                }
+                for (kk = 0; kk < nframes; kk++)
+                {
+                    r2[kk] = 0;
+                }
+                for (c = 0; c < ncomp; c++)
+                {
+                    gmx_msd_fft_correlate(msd, c, c, res);
+                    for (kk = 0; kk < nframes; kk++)
+                    {
+                        r2[kk] += w[ii]*res[kk];
+                    }
+                }
+                for (kk = 0; kk < nframes; kk++)
+                {
+                    acc[thread][kk] += r2[kk];
+                }
+                if (bTen)
+                {
+                    /* The tensor is only allowed with NORMAL, so c == dim */
+                    for (c = 0; c < DIM; c++)
+                    {
+                        for (c2 = 0; c2 <= c; c2++)
+                        {
+                            gmx_msd_fft_correlate(msd, c, c2, res);
+                            for (kk = 0; kk < nframes; kk++)
+                            {
+                                accm[thread][(kk*DIM + c)*DIM + c2] += w[ii]*res[kk];
+                            }
+                        }
+                    }
+                }
+                if (bMol)
+                {
+                    for (kk = 0; kk < nframes; kk++)
+                    {
+                        real tt = curr->time[kk];
+                        if (tt >= curr->beginfit && (curr->endfit < 0 || tt <= curr->endfit))
+                        {
+                            gmx_stats_add_point(curr->lsq[0][ii], tt, r2[kk], 0, 0);
+                        }
+                    }
+                }
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+        gmx_msd_fft_destroy(msd);
+        sfree(r2);
+        sfree(res);
+    }
+
+    for (t = 0; t < nthreads; t++)
+    {
+        for (k = 0; k < nframes; k++)
+        {
+            curr->data[nr][k] += acc[t][k]/wtot;
+            if (bTen)
+            {
+                for (m = 0; m < DIM; m++)
+                {
+                    for (m2 = 0; m2 <= m; m2++)
+                    {
+                        curr->datam[nr][k][m][m2] += accm[t][(k*DIM + m)*DIM + m2]/wtot;
+                    }
+                }
+            }
+        }
+        sfree(acc[t]);
+        if (bTen)
+        {
+            sfree(accm[t]);
+        }
+    }
+    for (k = 0; k < nframes; k++)
+    {
+        curr->ndata[nr][k] = 1;
+    }
+    sfree(acc);
+    sfree(accm);
+    sfree(w);
+}
+
 void printmol(t_corr *curr, const char *fn,
               const char *fn_pdb, int *molindex, t_topology *top,
               rvec *x, int ePBC, matrix box, const gmx_output_env_t *oenv)
@@ -551,7 +763,7 @@ void printmol(t_corr *curr, const char *fn,
 #define NDIST 100
     FILE       *out;
     gmx_stats_t lsq1;
-    int         i, j;
+    int         i, j, nlsq;
     real        a, b, D, Dav, D2av, VarD, sqrtD, sqrtD_max, scale;
     t_pdbinfo  *pdbinfo = NULL;
     int        *mol2a   = NULL;
@@ -570,10 +782,12 @@ void printmol(t_corr *curr, const char *fn,
 
     Dav       = D2av = 0;
     sqrtD_max = 0;
+    /* With FFT all time origins are collected in a single set of fits */
+    nlsq      = curr->bFFT ? 1 : curr->nrestart;
     for (i = 0; (i < curr->nmol); i++)
     {
         lsq1 = gmx_stats_init();
-        for (j = 0; (j < curr->nrestart); j++)
+        for (j = 0; (j < nlsq); j++)
         {
             real xx, yy, dx, dy;
 
@@ -641,8 +855,9 @@ void printmol(t_corr *curr, const char *fn,
  */
 int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
               gmx_bool bMol, int gnx[], atom_id *index[],
-              t_calc_func *calc1, gmx_bool bTen, int *gnx_com, atom_id *index_com[],
-              real dt, real t_pdb, rvec **x_pdb, matrix box_pdb,
+              t_calc_func *calc1, gmx_bool bTen, gmx_bool bMW,
+              int *gnx_com, atom_id *index_com[],
+              real dt, real t_pdb, rvec **x_pdb, matrix box_pdb, int nthreads,
               const gmx_output_env_t *oenv)
 {
     rvec            *x[2];  /* the coordinates to read */
@@ -692,6 +907,16 @@ int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
         gpbc = gmx_rmpbc_init(&top->idef, ePBC, natoms);
     }
 
+    if (curr->bFFT && bMol)
+    {
+        snew(curr->lsq, 1);
+        snew(curr->lsq[0], curr->nmol);
+        for (i = 0; i < curr->nmol; i++)
+        {
+            curr->lsq[0][i] = gmx_stats_init();
+        }
+    }
+
     /* the loop over all frames */
     do
     {
@@ -713,7 +938,7 @@ int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
 
 
         /* check whether we've reached a restart point */
-        if (bRmod(t, curr->t0, dt))
+        if (!curr->bFFT && bRmod(t, curr->t0, dt))
         {
             curr->nrestart++;
 
@@ -759,6 +984,10 @@ int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
                 {
                     srenew(curr->datam[i], maxframes);
                 }
+                if (curr->bFFT)
+                {
+                    srenew(curr->xfft[i], maxframes*gnx[i]);
+                }
                 for (j = maxframes-10; j < maxframes; j++)
                 {
                     curr->ndata[i][j] = 0;
@@ -811,9 +1040,17 @@ int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
         /* loop over all groups in index file */
         for (i = 0; (i < curr->ngrp); i++)
         {
-            /* calculate something useful, like mean square displacements */
-            calc_corr(curr, i, gnx[i], index[i], xa[cur], (gnx_com != NULL), com,
-                      calc1, bTen);
+            if (curr->bFFT)
+            {
+                store_fft_frame(curr, i, gnx[i], index[i], bMol, xa[cur],
+                                (gnx_com != NULL), com);
+            }
+            else
+            {
+                /* calculate something useful, like mean square displacements */
+                calc_corr(curr, i, gnx[i], index[i], xa[cur], (gnx_com != NULL), com,
+                          calc1, bTen);
+            }
         }
         cur    = prev;
         t_prev = t;
@@ -821,11 +1058,27 @@ int corr_loop(t_corr *curr, const char *fn, t_topology *top, int ePBC,
         curr->nframes++;
     }
     while (read_next_x(oenv, status, &t, x[cur], box));
-    fprintf(stderr, "\nUsed %d restart points spaced %g %s over %g %s\n\n",
-            curr->nrestart,
-            output_env_conv_time(oenv, dt), output_env_get_time_unit(oenv),
-            output_env_conv_time(oenv, curr->time[curr->nframes-1]),
-            output_env_get_time_unit(oenv) );
+    if (curr->bFFT)
+    {
+        fprintf(stderr, "\nUsing all %d frames over %g %s as time origins\n\n",
+                curr->nframes,
+                output_env_conv_time(oenv, curr->time[curr->nframes-1]),
+                output_env_get_time_unit(oenv));
+        for (i = 0; i < curr->ngrp; i++)
+        {
+            calc_corr_fft(curr, i, gnx[i], index[i], bMol, bMW, bTen, nthreads);
+            sfree(curr->xfft[i]);
+            curr->xfft[i] = NULL;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "\nUsed %d restart points spaced %g %s over %g %s\n\n",
+                curr->nrestart,
+                output_env_conv_time(oenv, dt), output_env_get_time_unit(oenv),
+                output_env_conv_time(oenv, curr->time[curr->nframes-1]),
+                output_env_get_time_unit(oenv) );
+    }
 
     if (bMol)
     {
@@ -876,7 +1129,8 @@ void do_corr(const char *trx_file, const char *ndx_file, const char *msd_file,
              int nrgrp, t_topology *top, int ePBC,
              gmx_bool bTen, gmx_bool bMW, gmx_bool bRmCOMM,
              int type, real dim_factor, int axis,
-             real dt, real beginfit, real endfit, const gmx_output_env_t *oenv)
+             real dt, real beginfit, real endfit, gmx_bool bFFT, int nthreads,
+             const gmx_output_env_t *oenv)
 {
     t_corr        *msd;
     int           *gnx;   /* the selected groups' sizes */
@@ -914,13 +1168,13 @@ void do_corr(const char *trx_file, const char *ndx_file, const char *msd_file,
 
     msd = init_corr(nrgrp, type, axis, dim_factor,
                     mol_file == NULL ? 0 : gnx[0], bTen, bMW, dt, top,
-                    beginfit, endfit);
+                    beginfit, endfit, bFFT);
 
     nat_trx =
         corr_loop(msd, trx_file, top, ePBC, mol_file ? gnx[0] : 0, gnx, index,
                   (mol_file != NULL) ? calc1_mol : (bMW ? calc1_mw : calc1_norm),
-                  bTen, gnx_com, index_com, dt, t_pdb,
-                  pdb_file ? &x : NULL, box, oenv);
+                  bTen, bMW, gnx_com, index_com, dt, t_pdb,
+                  pdb_file ? &x : NULL, box, nthreads, oenv);
 
     /* Correct for the number of points */
     for (j = 0; (j < msd->ngrp); j++)
@@ -1031,6 +1285,13 @@ int gmx_msd(int argc, char *argv[])
         "the diffusion constant using the Einstein relation.",
         "The time between the reference points for the MSD calculation",
         "is set with [TT]-trestart[tt].",
+        "With [TT]-fft[tt], every frame is used as a reference point and the",
+        "MSD is computed exactly for all time differences with FFT-based",
+        "correlations, which costs O(T log T) per atom for T frames instead",
+        "of O(T^2) for restarts at every frame. This requires storing the",
+        "positions of the selected atoms for all frames, and the frames",
+        "should be evenly spaced in time. The work is divided over",
+        "[TT]-nt[tt] threads.",
         "The diffusion constant is calculated by least squares fitting a",
         "straight line (D*t + c) through the MSD(t) from [TT]-beginfit[tt] to",
         "[TT]-endfit[tt] (note that t is time from the reference positions,",
@@ -1079,6 +1340,8 @@ int gmx_msd(int argc, char *argv[])
     static gmx_bool    bTen       = FALSE;
     static gmx_bool    bMW        = TRUE;
     static gmx_bool    bRmCOMM    = FALSE;
+    static gmx_bool    bFFT       = FALSE;
+    static int         nthreads   = -1;
     t_pargs            pa[]       = {
         { "-type",    FALSE, etENUM, {normtype},
           "Compute diffusion coefficient in one direction" },
@@ -1096,10 +1359,17 @@ int gmx_msd(int argc, char *argv[])
           "The frame to use for option [TT]-pdb[tt] (%t)" },
         { "-trestart", FALSE, etTIME, {&dt},
           "Time between restarting points in trajectory (%t)" },
+        { "-fft", FALSE, etBOOL, {&bFFT},
+          "Use all frames as restarting points and compute the MSD with FFTs" },
         { "-beginfit", FALSE, etTIME, {&beginfit},
           "Start time for fitting the MSD (%t), -1 is 10%" },
         { "-endfit", FALSE, etTIME, {&endfit},
-          "End time for fitting the MSD (%t), -1 is 90%" }
+          "End time for fitting the MSD (%t), -1 is 90%" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT, {&nthreads},
+          "Number of threads for the FFT calculation (if -1, all threads will "
+          "be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
 
     t_filenm           fnm[] = {
@@ -1187,6 +1457,14 @@ int gmx_msd(int argc, char *argv[])
     {
         gmx_fatal(FARGS, "Can only calculate the full tensor for 3D msd");
     }
+    if (nthreads > 0)
+    {
+        gmx_omp_set_num_threads(nthreads);
+    }
+    else
+    {
+        nthreads = gmx_omp_get_max_threads();
+    }
 
     bTop = read_tps_conf(tps_file, &top, &ePBC, &xdum, NULL, box, bMW || bRmCOMM);
     if (mol_file && !bTop)
@@ -1198,7 +1476,7 @@ int gmx_msd(int argc, char *argv[])
 
     do_corr(trx_file, ndx_file, msd_file, mol_file, pdb_file, t_pdb, ngroup,
             &top, ePBC, bTen, bMW, bRmCOMM, type, dim_factor, axis, dt, beginfit, endfit,
-            oenv);
+            bFFT, nthreads, oenv);
 
     view_all(oenv, NFILE, fnm);
 
@@ -50,6 +50,7 @@
 #include "gromacs/gmxana/cmat.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/gmxana/princ.h"
+#include "gromacs/gmxana/rmsdmatrix.h"
 #include "gromacs/legacyheaders/copyrite.h"
 #include "gromacs/legacyheaders/typedefs.h"
 #include "gromacs/legacyheaders/types/ifunc.h"
@@ -60,6 +61,7 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static void norm_princ(t_atoms *atoms, int isize, atom_id *index, int natoms,
@@ -120,7 +122,11 @@ int gmx_rms(int argc, char *argv[])
         "Option [TT]-m[tt] produces a matrix in [REF].xpm[ref] format of",
         "comparison values of each structure in the trajectory with respect to",
         "each other structure. This file can be visualized with for instance",
-        "[TT]xv[tt] and can be converted to postscript with [gmx-xpm2ps].[PAR]",
+        "[TT]xv[tt] and can be converted to postscript with [gmx-xpm2ps].",
+        "When the RMSD is computed over the fit group with the fit weights",
+        "and without [TT]-f2[tt] or [TT]-bm[tt], the matrix is computed",
+        "with the quaternion characteristic polynomial method, using",
+        "[TT]-nt[tt] threads.[PAR]",
 
         "Option [TT]-fit[tt] controls the least-squares fitting of",
         "the structures on top of each other: complete fit (rotation and",
@@ -148,6 +154,7 @@ int gmx_rms(int argc, char *argv[])
     static gmx_bool bPBC              = TRUE, bFitAll = TRUE, bSplit = FALSE;
     static gmx_bool bDeltaLog         = FALSE;
     static int      prev              = 0, freq = 1, freq2 = 1, nlevels = 80, avl = 0;
+    static int      nthreads          = -1;
     static real     rmsd_user_max     = -1, rmsd_user_min = -1, bond_user_max = -1,
                     bond_user_min     = -1, delta_maxy = 0.0;
     /* strings and things for selecting difference method */
@@ -217,7 +224,13 @@ int gmx_rms(int argc, char *argv[])
           { &delta_maxy }, "HIDDENMaximum level in delta matrix" },
         { "-aver", FALSE, etINT,
           { &avl },
-          "HIDDENAverage over this distance in the RMSD matrix" }
+          "HIDDENAverage over this distance in the RMSD matrix" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT,
+          { &nthreads },
+          "Number of threads to compute the RMSD matrix with (if -1, all threads will "
+          "be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
     int             natoms_trx, natoms_trx2, natoms;
     int             i, j, k, m, teller, teller2, tel_mat, tel_mat2;
@@ -225,7 +238,7 @@ int gmx_rms(int argc, char *argv[])
     int             maxframe = NFRAME, maxframe2 = NFRAME;
     real            t, *w_rls, *w_rms, *w_rls_m = NULL, *w_rms_m = NULL;
     gmx_bool        bNorm, bAv, bFreq2, bFile2, bMat, bBond, bDelta, bMirror, bMass;
-    gmx_bool        bFit, bReset;
+    gmx_bool        bFit, bReset, bMatQCP;
     t_topology      top;
     int             ePBC;
     t_iatom        *iatom = NULL;
@@ -276,6 +289,16 @@ int gmx_rms(int argc, char *argv[])
     {
         return 0;
     }
+
+    if (nthreads > 0)
+    {
+        gmx_omp_set_num_threads(nthreads);
+    }
+    else
+    {
+        nthreads = gmx_omp_get_max_threads();
+    }
+
     /* parse enumerated options: */
     ewhat = nenum(what);
     if (ewhat == ewRho || ewhat == ewRhoSc)
@@ -808,6 +831,10 @@ int gmx_rms(int argc, char *argv[])
             fprintf(stderr, "Building %s matrix, %dx%d elements\n",
                     whatname[ewhat], tel_mat, tel_mat2);
             snew(rmsd_mat, tel_mat);
+            for (i = 0; i < tel_mat; i++)
+            {
+                snew(rmsd_mat[i], tel_mat2);
+            }
         }
         if (bBond)
         {
@@ -860,7 +887,28 @@ int gmx_rms(int argc, char *argv[])
             }
         }
 
-        if (bFitAll)
+        /* When all pairs of frames of one trajectory are fitted with the
+         * same weights as used for the RMSD, we can compute the RMSDs
+         * without explicit rotation, in parallel.
+         */
+        bMatQCP = (bMat && !bBond && !bFile2 && bFitAll && ewhat == ewRMSD &&
+                   irms[0] == n_ind_m);
+        for (k = 0; k < n_ind_m && bMatQCP; k++)
+        {
+            bMatQCP = (w_rms_m[k] == w_rls_m[k]);
+        }
+        if (bMatQCP)
+        {
+            real   qcp_min, qcp_max;
+            double qcp_sum;
+
+            please_cite(stdout, "Theobald2005");
+            calc_rmsd_matrix(tel_mat, n_ind_m, w_rms_m, mat_x, TRUE, nthreads,
+                             rmsd_mat, &qcp_min, &qcp_max, &qcp_sum);
+            rmsd_max = std::max(rmsd_max, qcp_max);
+            rmsd_avg = qcp_sum;
+        }
+        else if (bFitAll)
         {
             snew(mat_x2_j, natoms);
         }
@@ -868,9 +916,10 @@ int gmx_rms(int argc, char *argv[])
         {
             axis[i] = time[freq*i];
             fprintf(stderr, "\r element %5d; time %5.2f  ", i, axis[i]);
-            if (bMat)
+            if (bMatQCP)
             {
-                snew(rmsd_mat[i], tel_mat2);
+                /* The matrix was computed above, there are no bond angles */
+                continue;
             }
             if (bBond)
             {
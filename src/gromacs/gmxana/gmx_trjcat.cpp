@@ -420,6 +420,10 @@ int gmx_trjcat(int argc, char *argv[])
         "such that a command like [TT]gmx trjcat -f *.trr -o fixed.trr[tt] should do ",
         "the trick. Using [TT]-cat[tt], you can simply paste several files ",
         "together without removal of frames with identical time stamps.[PAR]",
+        "When the input and output files are all [REF].xtc[ref] or all ",
+        "[REF].trr[ref] files and no index group is selected, frames are ",
+        "copied as they are stored, without decoding and re-encoding the ",
+        "coordinates, only the step and time are rewritten.[PAR]",
         "One important option is inferred when the output file is amongst the",
         "input files. In that case that particular file will be appended to",
         "which implies you do not need to store double the amount of data.",
@@ -480,7 +484,8 @@ int gmx_trjcat(int argc, char *argv[])
     t_trxframe        fr, frout;
     char            **fnms, **fnms_out, *out_file;
     int               n_append;
-    gmx_bool          bNewFile, bIndex, bWrite;
+    gmx_bool          bNewFile, bIndex, bWrite, bRaw;
+    t_trxframe_raw   *raw = NULL;
     int               nfile_in, nfile_out, *cont_type;
     real             *readtime, *timest, *settime;
     real              first_time = 0, lasttime = NOTSET, last_ok_t = -1, timestep;
@@ -632,6 +637,17 @@ int gmx_trjcat(int argc, char *argv[])
                       fnms[0], out_file);
         }
 
+        /* Copy frames without decoding them when the formats match.
+         * Raw trr frames contain the velocities, so with -novel
+         * the frames have to be decoded to drop them.
+         */
+        bRaw = (!bIndex && ftpin == ftpout && trx_format_supports_raw(ftpin) &&
+                (bVels || ftpin == efXTC));
+        if (bRaw)
+        {
+            raw = trxframe_raw_init();
+        }
+
         /* Not checking input format, could be dangerous :-) */
         /* Not checking output format, equally dangerous :-) */
 
@@ -805,7 +821,15 @@ int gmx_trjcat(int argc, char *argv[])
             {
                 timestep = timest[i];
             }
-            read_first_frame(oenv, &status, fnms[i], &fr, FLAGS);
+            if (bRaw)
+            {
+                read_first_frame_raw(&status, fnms[i], &fr, raw);
+            }
+            else
+            {
+                read_first_frame(oenv, &status, fnms[i], &fr,
+                                 bVels ? FLAGS : (FLAGS & ~TRX_READ_V));
+            }
             if (!fr.bTime)
             {
                 fr.time = 0;
@@ -892,6 +916,10 @@ int gmx_trjcat(int argc, char *argv[])
                             write_trxframe_indexed(trxout, &frout, isize, index,
                                                    NULL);
                         }
+                        else if (bRaw)
+                        {
+                            write_trxframe_raw(trxout, &frout, raw);
+                        }
                         else
                         {
                             write_trxframe(trxout, &frout, NULL);
@@ -904,7 +932,8 @@ int gmx_trjcat(int argc, char *argv[])
                     }
                 }
             }
-            while (read_next_frame(oenv, status, &fr));
+            while (bRaw ? read_next_frame_raw(status, &fr, raw) :
+                   read_next_frame(oenv, status, &fr));
 
             close_trj(status);
         }
@@ -912,6 +941,7 @@ int gmx_trjcat(int argc, char *argv[])
         {
             close_trx(trxout);
         }
+        trxframe_raw_done(raw);
         fprintf(stderr, "\nLast frame written was %d, time %f %s\n",
                 frame, output_env_conv_time(oenv, last_ok_t), output_env_get_time_unit(oenv));
     }
@@ -67,8 +67,10 @@
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 enum {
@@ -76,8 +78,13 @@ enum {
 };
 
 
+/* Makes the molecules in index whole and clusters them in the unit cell.
+ * Progress is only printed with bVerbose, which should not be set when
+ * several frames are clustered concurrently.
+ */
 static void calc_pbc_cluster(int ecenter, int nrefat, t_topology *top, int ePBC,
-                             rvec x[], atom_id index[], matrix box)
+                             rvec x[], atom_id index[], matrix box,
+                             gmx_bool bVerbose)
 {
     int       m, i, j, j0, j1, jj, ai, aj;
     int       imin, jmin;
@@ -251,8 +258,11 @@ static void calc_pbc_cluster(int ecenter, int nrefat, t_topology *top, int ePBC,
         {
             rvec_inc(x[j], m_shift[jmin]);
         }
-        fprintf(stdout, "\rClustering iteration %d of %d...", nadded, ncluster);
-        fflush(stdout);
+        if (bVerbose)
+        {
+            fprintf(stdout, "\rClustering iteration %d of %d...", nadded, ncluster);
+            fflush(stdout);
+        }
     }
 
     sfree(added);
@@ -261,7 +271,10 @@ static void calc_pbc_cluster(int ecenter, int nrefat, t_topology *top, int ePBC,
     sfree(m_com);
     sfree(m_shift);
 
-    fprintf(stdout, "\n");
+    if (bVerbose)
+    {
+        fprintf(stdout, "\n");
+    }
 }
 
 static void put_molecule_com_in_box(int unitcell_enum, int ecenter,
@@ -440,6 +453,221 @@ static void center_x(int ecenter, rvec x[], matrix box, int n, int nc, atom_id c
     }
 }
 
+/* The coordinate operations on a frame that do not depend on other frames,
+ * so they can be applied to several frames at once.
+ */
+typedef struct {
+    gmx_bool    bSetBox, bTrans; /* set the box, translate the coordinates */
+    rvec        newbox, trans;
+    gmx_bool    bCluster;        /* make the fit group a cluster */
+    gmx_bool    bPFit;           /* progressive fit, done outside these operations */
+    gmx_bool    bRmPBC, bReset, bFit, bCenter;
+    gmx_bool    bPBCcomAtom, bPBCcomRes, bPBCcomMol;
+    int         ePBC, ecenter, unitcell_enum;
+    int         natoms;
+    t_topology *top;
+    t_atoms    *atoms;
+    int         nfitdim, ifit;
+    atom_id    *ind_fit;
+    real       *w_rls;
+    rvec       *xp;              /* the fit reference */
+    rvec        x_shift;
+    int         ncent;
+    atom_id    *cindex;
+} t_frame_ops;
+
+/* Applies the operations for every input frame that precede the choice
+ * of the output frames.
+ */
+static void prepare_frame(const t_frame_ops *ops, t_trxframe *fr)
+{
+    int i, m;
+
+    if (ops->bSetBox)
+    {
+        /* generate new box */
+        if (fr->bBox == FALSE)
+        {
+            clear_mat(fr->box);
+        }
+        for (m = 0; m < DIM; m++)
+        {
+            if (ops->newbox[m] >= 0)
+            {
+                fr->box[m][m] = ops->newbox[m];
+            }
+            else
+            {
+                if (fr->bBox == FALSE)
+                {
+                    gmx_fatal(FARGS, "Cannot preserve a box that does not exist.\n");
+                }
+            }
+        }
+    }
+
+    if (ops->bTrans)
+    {
+        for (i = 0; i < fr->natoms; i++)
+        {
+            rvec_inc(fr->x[i], ops->trans);
+        }
+    }
+}
+
+/* Modifies the coordinates of a frame that will be written according
+ * to the PBC, fit and centering flags.
+ */
+static void transform_output_frame(const t_frame_ops *ops, gmx_rmpbc_t gpbc,
+                                   t_trxframe *fr)
+{
+    int i;
+
+    if (!ops->bPFit)
+    {
+        /* Now modify the coords according to the flags,
+           for PFit we did this already! */
+
+        if (ops->bRmPBC)
+        {
+            gmx_rmpbc_trxfr(gpbc, fr);
+        }
+
+        if (ops->bReset)
+        {
+            reset_x_ndim(ops->nfitdim, ops->ifit, ops->ind_fit, ops->natoms, NULL,
+                         fr->x, ops->w_rls);
+            if (ops->bFit)
+            {
+                do_fit_ndim(ops->nfitdim, ops->natoms, ops->w_rls, ops->xp, fr->x);
+            }
+            if (!ops->bCenter)
+            {
+                for (i = 0; i < ops->natoms; i++)
+                {
+                    rvec_inc(fr->x[i], ops->x_shift);
+                }
+            }
+        }
+
+        if (ops->bCenter)
+        {
+            center_x(ops->ecenter, fr->x, fr->box, ops->natoms, ops->ncent, ops->cindex);
+        }
+    }
+
+    if (ops->bPBCcomAtom)
+    {
+        switch (ops->unitcell_enum)
+        {
+            case euRect:
+                put_atoms_in_box(ops->ePBC, fr->box, ops->natoms, fr->x);
+                break;
+            case euTric:
+                put_atoms_in_triclinic_unitcell(ops->ecenter, fr->box, ops->natoms, fr->x);
+                break;
+            case euCompact:
+                put_atoms_in_compact_unitcell(ops->ePBC, ops->ecenter, fr->box,
+                                              ops->natoms, fr->x);
+                break;
+        }
+    }
+    if (ops->bPBCcomRes)
+    {
+        put_residue_com_in_box(ops->unitcell_enum, ops->ecenter,
+                               ops->natoms, ops->atoms->atom, ops->ePBC, fr->box, fr->x);
+    }
+    if (ops->bPBCcomMol)
+    {
+        put_molecule_com_in_box(ops->unitcell_enum, ops->ecenter,
+                                &ops->top->mols,
+                                ops->natoms, ops->atoms->atom, ops->ePBC, fr->box, fr->x);
+    }
+}
+
+/* Copies the contents of src into dest, which keeps its own coordinate,
+ * velocity and force arrays.
+ */
+static void copy_batch_frame(const t_trxframe *src, t_trxframe *dest)
+{
+    rvec *x = dest->x, *v = dest->v, *f = dest->f;
+
+    *dest = *src;
+    if (src->bX)
+    {
+        srenew(x, src->natoms);
+        std::memcpy(x, src->x, src->natoms*sizeof(*x));
+    }
+    if (src->bV)
+    {
+        srenew(v, src->natoms);
+        std::memcpy(v, src->v, src->natoms*sizeof(*v));
+    }
+    if (src->bF)
+    {
+        srenew(f, src->natoms);
+        std::memcpy(f, src->f, src->natoms*sizeof(*f));
+    }
+    dest->x = x;
+    dest->v = v;
+    dest->f = f;
+}
+
+/* Reads up to nmax frames into batch, starting with the frame in fr
+ * when bFirst is set, and applies the frame operations to all of them
+ * using nthreads threads. The first frame has number frame, only the
+ * frames with a number that is a multiple of skip can be written and get
+ * the output operations. Returns the number of frames read, sets *bEnd
+ * when the end of the trajectory was reached.
+ */
+static int read_frame_batch(const gmx_output_env_t *oenv, t_trxstatus *status,
+                            t_trxframe *fr, gmx_bool bFirst, gmx_bool *bEnd,
+                            int nmax, t_trxframe batch[], int frame, int skip,
+                            const t_frame_ops *ops, gmx_rmpbc_t gpbc[], int nthreads)
+{
+    int n = 0;
+
+    if (bFirst)
+    {
+        copy_batch_frame(fr, &batch[n++]);
+    }
+    while (n < nmax && !*bEnd)
+    {
+        if (read_next_frame(oenv, status, fr))
+        {
+            copy_batch_frame(fr, &batch[n++]);
+        }
+        else
+        {
+            *bEnd = TRUE;
+        }
+    }
+
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+    for (int i = 0; i < n; i++)
+    {
+        try
+        {
+            int thread = gmx_omp_get_thread_num();
+
+            prepare_frame(ops, &batch[i]);
+            if (ops->bCluster)
+            {
+                calc_pbc_cluster(ops->ecenter, ops->ifit, ops->top, ops->ePBC,
+                                 batch[i].x, ops->ind_fit, batch[i].box,
+                                 nthreads == 1);
+            }
+            if ((frame + i) % skip == 0)
+            {
+                transform_output_frame(ops, gpbc[thread], &batch[i]);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    return n;
+}
+
 static void mk_filenm(char *base, const char *ext, int ndigit, int file_nr,
                       char out_file[])
 {
@@ -725,7 +953,13 @@ int gmx_trjconv(int argc, char *argv[])
         "Option [TT]-drop[tt] reads an [REF].xvg[ref] file with times and values.",
         "When options [TT]-dropunder[tt] and/or [TT]-dropover[tt] are set,",
         "frames with a value below and above the value of the respective options",
-        "will not be written."
+        "will not be written.[PAR]",
+
+        "With [TT]-nt[tt], the PBC treatment, fitting and centering of",
+        "batches of frames is distributed over multiple threads. The frames",
+        "are still written in their original order. This is not done with",
+        "[TT]-pbc nojump[tt], [TT]-fit progressive[tt] and [TT]-dump[tt],",
+        "which process each frame based on the previous one."
     };
 
     int         pbc_enum;
@@ -778,6 +1012,7 @@ int gmx_trjconv(int argc, char *argv[])
     static char     *exec_command  = NULL;
     static real      dropunder     = 0, dropover = 0;
     static gmx_bool  bRound        = FALSE;
+    static int       nthreads      = -1;
 
     t_pargs
         pa[] =
@@ -855,7 +1090,13 @@ int gmx_trjconv(int argc, char *argv[])
           { &bCONECT },
           "Add conect records when writing [REF].pdb[ref] files. Useful "
           "for visualization of non-standard molecules, e.g. "
-          "coarse grained ones" }
+          "coarse grained ones" },
+#ifdef GMX_OPENMP
+        { "-nt", FALSE, etINT,
+          { &nthreads },
+          "Number of threads to process frames with (if -1, all threads will "
+          "be used or what is specified by the environment variable OMP_NUM_THREADS)" }
+#endif
     };
 #define NPA asize(pa)
 
@@ -863,7 +1104,12 @@ int gmx_trjconv(int argc, char *argv[])
     t_trxstatus      *trxout = NULL;
     t_trxstatus      *trxin;
     int               ftp, ftpin = 0, file_nr;
-    t_trxframe        fr, frout;
+    t_trxframe        fr, frout, frin;
+    t_trxframe       *frbatch      = NULL;
+    int               nbatch       = 0, ibatch = 0, batchsize = 0;
+    gmx_bool          bBatch       = FALSE, bBatchEnd = FALSE;
+    t_frame_ops       ops;
+    gmx_rmpbc_t      *gpbc_thread  = NULL;
     int               flags;
     rvec             *xmem  = NULL, *vmem = NULL, *fmem = NULL;
     rvec             *xp    = NULL, x_shift, hbox;
@@ -1376,6 +1622,72 @@ int gmx_trjconv(int argc, char *argv[])
                 }
             }
 
+            /* Set up the frame operations that do not depend on other frames */
+            ops.bSetBox       = bSetBox;
+            copy_rvec(newbox, ops.newbox);
+            ops.bTrans        = bTrans;
+            copy_rvec(trans, ops.trans);
+            ops.bCluster      = bCluster;
+            ops.bPFit         = bPFit;
+            ops.bRmPBC        = bRmPBC;
+            ops.bReset        = bReset;
+            ops.bFit          = bFit;
+            ops.bCenter       = bCenter;
+            ops.bPBCcomAtom   = bPBCcomAtom;
+            ops.bPBCcomRes    = bPBCcomRes;
+            ops.bPBCcomMol    = bPBCcomMol;
+            ops.ePBC          = ePBC;
+            ops.ecenter       = ecenter;
+            ops.unitcell_enum = unitcell_enum;
+            ops.natoms        = natoms;
+            ops.top           = &top;
+            ops.atoms         = atoms;
+            ops.nfitdim       = nfitdim;
+            ops.ifit          = ifit;
+            ops.ind_fit       = ind_fit;
+            ops.w_rls         = w_rls;
+            ops.xp            = xp;
+            copy_rvec(x_shift, ops.x_shift);
+            ops.ncent         = ncent;
+            ops.cindex        = cindex;
+
+            /* With multiple threads, process batches of frames in parallel,
+             * unless a frame depends on the previous one.
+             */
+            if (nthreads > 0)
+            {
+                gmx_omp_set_num_threads(nthreads);
+            }
+            else
+            {
+                nthreads = gmx_omp_get_max_threads();
+            }
+            bBatch = (nthreads > 1 && !bNoJump && !bPFit && !bTDump);
+            if (bBatch)
+            {
+                batchsize = 4*nthreads;
+                snew(frbatch, batchsize);
+                snew(gpbc_thread, nthreads);
+                gpbc_thread[0] = gpbc;
+                for (i = 1; i < nthreads; i++)
+                {
+                    if (bRmPBC)
+                    {
+                        gpbc_thread[i] = gmx_rmpbc_init(&top.idef, ePBC, top.atoms.nr);
+                    }
+                }
+                fprintf(stderr, "\nProcessing batches of %d frames using %d threads\n",
+                        batchsize, nthreads);
+
+                /* The trajectory is read into frin, fr is a frame of the batch */
+                frin   = fr;
+                nbatch = read_frame_batch(oenv, trxin, &frin, TRUE, &bBatchEnd,
+                                          batchsize, frbatch, 0, frindex ? 1 : skip_nr,
+                                          &ops, gpbc_thread, nthreads);
+                ibatch = 0;
+                fr     = frbatch[ibatch++];
+            }
+
             /* Start the big loop over frames */
             file_nr  =  0;
             frame    =  0;
@@ -1411,35 +1723,9 @@ int gmx_trjconv(int argc, char *argv[])
                     }
                 }
 
-                if (bSetBox)
+                if (!bBatch)
                 {
-                    /* generate new box */
-                    if (fr.bBox == FALSE)
-                    {
-                        clear_mat(fr.box);
-                    }
-                    for (m = 0; m < DIM; m++)
-                    {
-                        if (newbox[m] >= 0)
-                        {
-                            fr.box[m][m] = newbox[m];
-                        }
-                        else
-                        {
-                            if (fr.bBox == FALSE)
-                            {
-                                gmx_fatal(FARGS, "Cannot preserve a box that does not exist.\n");
-                            }
-                        }
-                    }
-                }
-
-                if (bTrans)
-                {
-                    for (i = 0; i < natoms; i++)
-                    {
-                        rvec_inc(fr.x[i], trans);
-                    }
+                    prepare_frame(&ops, &fr);
                 }
 
                 if (bTDump)
@@ -1501,9 +1787,10 @@ int gmx_trjconv(int argc, char *argv[])
                         }
                     }
                 }
-                else if (bCluster)
+                else if (bCluster && !bBatch)
                 {
-                    calc_pbc_cluster(ecenter, ifit, &top, ePBC, fr.x, ind_fit, fr.box);
+                    calc_pbc_cluster(ecenter, ifit, &top, ePBC, fr.x, ind_fit, fr.box,
+                                     TRUE);
                 }
 
                 if (bPFit)
@@ -1624,64 +1911,9 @@ int gmx_trjconv(int argc, char *argv[])
                                     outframe, output_env_conv_time(oenv, frout_time));
                         }
 
-                        if (!bPFit)
-                        {
-                            /* Now modify the coords according to the flags,
-                               for PFit we did this already! */
-
-                            if (bRmPBC)
-                            {
-                                gmx_rmpbc_trxfr(gpbc, &fr);
-                            }
-
-                            if (bReset)
-                            {
-                                reset_x_ndim(nfitdim, ifit, ind_fit, natoms, NULL, fr.x, w_rls);
-                                if (bFit)
-                                {
-                                    do_fit_ndim(nfitdim, natoms, w_rls, xp, fr.x);
-                                }
-                                if (!bCenter)
-                                {
-                                    for (i = 0; i < natoms; i++)
-                                    {
-                                        rvec_inc(fr.x[i], x_shift);
-                                    }
-                                }
-                            }
-
-                            if (bCenter)
-                            {
-                                center_x(ecenter, fr.x, fr.box, natoms, ncent, cindex);
-                            }
-                        }
-
-                        if (bPBCcomAtom)
-                        {
-                            switch (unitcell_enum)
-                            {
-                                case euRect:
-                                    put_atoms_in_box(ePBC, fr.box, natoms, fr.x);
-                                    break;
-                                case euTric:
-                                    put_atoms_in_triclinic_unitcell(ecenter, fr.box, natoms, fr.x);
-                                    break;
-                                case euCompact:
-                                    put_atoms_in_compact_unitcell(ePBC, ecenter, fr.box,
-                                                                  natoms, fr.x);
-                                    break;
-                            }
-                        }
-                        if (bPBCcomRes)
-                        {
-                            put_residue_com_in_box(unitcell_enum, ecenter,
-                                                   natoms, atoms->atom, ePBC, fr.box, fr.x);
-                        }
-                        if (bPBCcomMol)
+                        if (!bBatch)
                         {
-                            put_molecule_com_in_box(unitcell_enum, ecenter,
-                                                    &top.mols,
-                                                    natoms, atoms->atom, ePBC, fr.box, fr.x);
+                            transform_output_frame(&ops, gpbc, &fr);
                         }
                         /* Copy the input trxframe struct to the output trxframe struct */
                         frout        = fr;
@@ -1885,9 +2117,46 @@ int gmx_trjconv(int argc, char *argv[])
                     }
                 }
                 frame++;
-                bHaveNextFrame = read_next_frame(oenv, trxin, &fr);
+                if (bBatch)
+                {
+                    if (ibatch == nbatch)
+                    {
+                        nbatch = read_frame_batch(oenv, trxin, &frin, FALSE, &bBatchEnd,
+                                                  batchsize, frbatch, frame, frindex ? 1 : skip_nr,
+                                                  &ops, gpbc_thread, nthreads);
+                        ibatch = 0;
+                    }
+                    bHaveNextFrame = (ibatch < nbatch);
+                    if (bHaveNextFrame)
+                    {
+                        fr = frbatch[ibatch++];
+                    }
+                }
+                else
+                {
+                    bHaveNextFrame = read_next_frame(oenv, trxin, &fr);
+                }
             }
             while (!(bTDump && bDumpFrame) && bHaveNextFrame);
+
+            if (bBatch)
+            {
+                for (i = 0; i < batchsize; i++)
+                {
+                    sfree(frbatch[i].x);
+                    sfree(frbatch[i].v);
+                    sfree(frbatch[i].f);
+                }
+                sfree(frbatch);
+                for (i = 1; i < nthreads; i++)
+                {
+                    if (bRmPBC)
+                    {
+                        gmx_rmpbc_done(gpbc_thread[i]);
+                    }
+                }
+                sfree(gpbc_thread);
+            }
         }
 
         if (!bHaveFirstFrame || (bTDump && !bDumpFrame))
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx msd
+ */
+
+#include "gmxpre.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/utility/filestream.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/integrationtests.h"
+#include "testutils/refdata.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+class GmxMsd : public gmx::test::IntegrationTestFixture
+{
+    public:
+        //! Runs gmx msd on 216 water molecules with \p option added.
+        void runTest(const char *option)
+        {
+            std::string xvgFileName = fileManager_.getTemporaryFilePath("msd.xvg");
+
+            gmx::test::CommandLine caller;
+            caller.append("msd");
+            caller.addOption("-s", fileManager_.getInputFilePath("../../../programs/mdrun/tests/spc216.gro"));
+            caller.addOption("-f", fileManager_.getInputFilePath("spc216-traj.xtc"));
+            caller.addOption("-o", xvgFileName);
+            caller.append(option);
+
+            redirectStringToStdin("System\n");
+
+            ASSERT_EQ(0, gmx_msd(caller.argc(), caller.argv()));
+
+            gmx::test::TestReferenceData    data;
+            gmx::test::TestReferenceChecker checker(data.rootChecker());
+            gmx::TextInputFile              xvgFile(xvgFileName);
+            gmx::test::checkXvgFile(&xvgFile, &checker, gmx::test::XvgMatchSettings());
+        }
+};
+
+TEST_F(GmxMsd, ComputesAllTimeOriginsWithFft)
+{
+    runTest("-fft");
+}
+
+} // namespace
@@ -43,8 +43,13 @@
 
 #include "config.h"
 
+#include <fstream>
+#include <iterator>
+#include <string>
+
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/textreader.h"
 
 #include "testutils/cmdlinetest.h"
 #include "testutils/integrationtests.h"
@@ -135,6 +140,72 @@ TEST_P(TrjconvWithIndexGroupSubset, WithDifferentInputFormats)
 
 // ==
 
+#ifdef GMX_OPENMP
+class TrjconvWithThreads : public gmx::test::IntegrationTestFixture,
+                           public ::testing::WithParamInterface<const char *>
+{
+    public:
+        std::string runTest(const char *fileName, const char *numThreads)
+        {
+            gmx::test::CommandLine caller;
+            caller.append("trjconv");
+
+            caller.addOption("-s", fileManager_.getInputFilePath("spc2.gro"));
+            caller.addOption("-f", fileManager_.getInputFilePath(fileName));
+            caller.addOption("-pbc", "atom");
+            caller.addOption("-ur", "compact");
+            caller.append("-center");
+            caller.addOption("-nt", numThreads);
+
+            std::string outputFileName
+                = fileManager_.getTemporaryFilePath(std::string("out-") + numThreads + ".gro");
+            caller.addOption("-o", outputFileName);
+
+            redirectStringToStdin("System\nSystem\n");
+
+            EXPECT_EQ(0, gmx_trjconv(caller.argc(), caller.argv()));
+            return gmx::TextReader::readFileToString(outputFileName);
+        }
+};
+
+TEST_P(TrjconvWithThreads, WritesSameFramesAsSingleThread)
+{
+    std::string serial   = runTest(GetParam(), "1");
+    std::string parallel = runTest(GetParam(), "3");
+    EXPECT_EQ(serial, parallel);
+}
+#endif
+
+// ==
+
+class TrjcatWithMatchingFormats : public gmx::test::IntegrationTestFixture,
+                                  public ::testing::WithParamInterface<const char *>
+{
+    public:
+        static std::string readBinaryFile(const std::string &fileName)
+        {
+            std::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(stream),
+                               std::istreambuf_iterator<char>());
+        }
+};
+
+TEST_P(TrjcatWithMatchingFormats, CopiesFramesUnchanged)
+{
+    std::string inputFileName  = fileManager_.getInputFilePath(GetParam());
+    std::string outputFileName = fileManager_.getTemporaryFilePath(GetParam());
+
+    gmx::test::CommandLine caller;
+    caller.append("trjcat");
+    caller.addOption("-f", inputFileName);
+    caller.addOption("-o", outputFileName);
+
+    EXPECT_EQ(0, gmx_trjcat(caller.argc(), caller.argv()));
+    EXPECT_EQ(readBinaryFile(inputFileName), readBinaryFile(outputFileName));
+}
+
+// ==
+
 /*! \brief Helper array of input files present in the source repo
  * database. These all have two identical frames of two SPC water
  * molecules, which were generated via trjconv from the .gro
@@ -150,6 +221,13 @@ const char *trajectoryFileNames[] = {
     "spc2-traj.g96"
 };
 
+/*! \brief Helper array of input files that gmx trjcat copies without
+ * decoding. */
+const char *rawTrajectoryFileNames[] = {
+    "spc2-traj.trr",
+    "spc2-traj.xtc"
+};
+
 #ifdef __INTEL_COMPILER
 #pragma warning( disable : 177 )
 #endif
@@ -162,4 +240,14 @@ INSTANTIATE_TEST_CASE_P(NoFatalErrorWhenWritingFrom,
                         TrjconvWithIndexGroupSubset,
                             ::testing::ValuesIn(gmx::ArrayRef<const char*>(trajectoryFileNames)));
 
+INSTANTIATE_TEST_CASE_P(ForInputFormats,
+                        TrjcatWithMatchingFormats,
+                            ::testing::ValuesIn(gmx::ArrayRef<const char*>(rawTrajectoryFileNames)));
+
+#ifdef GMX_OPENMP
+INSTANTIATE_TEST_CASE_P(ForInputFormats,
+                        TrjconvWithThreads,
+                            ::testing::ValuesIn(gmx::ArrayRef<const char*>(trajectoryFileNames)));
+#endif
+
 } // namespace
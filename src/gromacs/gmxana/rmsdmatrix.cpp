@@ -0,0 +1,288 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include "rmsdmatrix.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/smalloc.h"
+
+/* Number of frames along each side of a block of pairs; the coordinates
+ * of two such blocks are reused for all pairs between them. */
+#define RMSD_BLOCKSIZE 32
+
+/* Returns the determinant of the symmetric 4x4 matrix k */
+static double det4(double k[4][4])
+{
+    double a, b, c, d, e, f;
+
+    /* Laplace expansion in the 2x2 minors of the first two rows */
+    a = k[0][0]*k[1][1] - k[0][1]*k[1][0];
+    b = k[0][0]*k[1][2] - k[0][2]*k[1][0];
+    c = k[0][0]*k[1][3] - k[0][3]*k[1][0];
+    d = k[0][1]*k[1][2] - k[0][2]*k[1][1];
+    e = k[0][1]*k[1][3] - k[0][3]*k[1][1];
+    f = k[0][2]*k[1][3] - k[0][3]*k[1][2];
+
+    return (a*(k[2][2]*k[3][3] - k[2][3]*k[3][2])
+            - b*(k[2][1]*k[3][3] - k[2][3]*k[3][1])
+            + c*(k[2][1]*k[3][2] - k[2][2]*k[3][1])
+            + d*(k[2][0]*k[3][3] - k[2][3]*k[3][0])
+            - e*(k[2][0]*k[3][2] - k[2][2]*k[3][0])
+            + f*(k[2][0]*k[3][1] - k[2][1]*k[3][0]));
+}
+
+/* Returns the RMSD after least-squares superposition of the centered
+ * structures x1 and x2 with inner products g1 and g2 and total weight wtot.
+ *
+ * The largest eigenvalue of the 4x4 key matrix of the quaternion
+ * formulation, which gives the optimal overlap, is found with Newton
+ * iterations on its characteristic polynomial, starting from the upper
+ * bound (g1+g2)/2 (Theobald, Acta Cryst. A 61, 478 (2005)).
+ */
+static real qcp_rmsd(int natoms, const real w[], const rvec x1[], const rvec x2[],
+                     double g1, double g2, double wtot)
+{
+    double s[DIM][DIM], k[4][4];
+    double c0, c1, c2, e0, lambda, lambda_old, x2l, b, a;
+    int    i, d, e, iter;
+
+    for (d = 0; d < DIM; d++)
+    {
+        for (e = 0; e < DIM; e++)
+        {
+            s[d][e] = 0;
+        }
+    }
+    for (i = 0; i < natoms; i++)
+    {
+        for (d = 0; d < DIM; d++)
+        {
+            for (e = 0; e < DIM; e++)
+            {
+                s[d][e] += w[i]*x1[i][d]*x2[i][e];
+            }
+        }
+    }
+
+    k[0][0] =  s[XX][XX] + s[YY][YY] + s[ZZ][ZZ];
+    k[1][1] =  s[XX][XX] - s[YY][YY] - s[ZZ][ZZ];
+    k[2][2] = -s[XX][XX] + s[YY][YY] - s[ZZ][ZZ];
+    k[3][3] = -s[XX][XX] - s[YY][YY] + s[ZZ][ZZ];
+    k[0][1] = k[1][0] = s[YY][ZZ] - s[ZZ][YY];
+    k[0][2] = k[2][0] = s[ZZ][XX] - s[XX][ZZ];
+    k[0][3] = k[3][0] = s[XX][YY] - s[YY][XX];
+    k[1][2] = k[2][1] = s[XX][YY] + s[YY][XX];
+    k[1][3] = k[3][1] = s[ZZ][XX] + s[XX][ZZ];
+    k[2][3] = k[3][2] = s[YY][ZZ] + s[ZZ][YY];
+
+    /* The key matrix is traceless, so its characteristic polynomial is
+     * lambda^4 + c2 lambda^2 + c1 lambda + c0.
+     */
+    c2 = 0;
+    for (d = 0; d < DIM; d++)
+    {
+        for (e = 0; e < DIM; e++)
+        {
+            c2 += s[d][e]*s[d][e];
+        }
+    }
+    c2 *= -2;
+    c1  = -8*(s[XX][XX]*(s[YY][YY]*s[ZZ][ZZ] - s[YY][ZZ]*s[ZZ][YY])
+              - s[XX][YY]*(s[YY][XX]*s[ZZ][ZZ] - s[YY][ZZ]*s[ZZ][XX])
+              + s[XX][ZZ]*(s[YY][XX]*s[ZZ][YY] - s[YY][YY]*s[ZZ][XX]));
+    c0  = det4(k);
+
+    e0     = 0.5*(g1 + g2);
+    lambda = e0;
+    for (iter = 0; iter < 50; iter++)
+    {
+        lambda_old = lambda;
+        x2l        = lambda*lambda;
+        b          = (x2l + c2)*lambda;
+        a          = b + c1;
+        lambda    -= (a*lambda + c0)/(2*x2l*lambda + b + a);
+        if (std::abs(lambda - lambda_old) < std::abs(1e-11*lambda))
+        {
+            break;
+        }
+    }
+
+    return std::sqrt(std::max(0.0, 2*(e0 - lambda)/wtot));
+}
+
+/* Returns the weighted RMSD of x1 and x2 without superposition */
+static real plain_rmsd(int natoms, const real w[], const rvec x1[], const rvec x2[],
+                       double wtot)
+{
+    rvec   dx;
+    double sum = 0;
+    int    i;
+
+    for (i = 0; i < natoms; i++)
+    {
+        rvec_sub(x1[i], x2[i], dx);
+        sum += w[i]*iprod(dx, dx);
+    }
+
+    return std::sqrt(sum/wtot);
+}
+
+void calc_rmsd_matrix(int n, int natoms, const real w[], rvec *x[],
+                      gmx_bool bFit, int nthreads, real **mat,
+                      real *minrms, real *maxrms, double *sumrms)
+{
+    const int nblock = (n + RMSD_BLOCKSIZE - 1)/RMSD_BLOCKSIZE;
+    int       ntile, t, bi, bj;
+    int      *tile_i, *tile_j;
+    double   *g, wtot;
+    real     *thread_min, *thread_max;
+    double   *thread_sum;
+
+    wtot = 0;
+    for (int i = 0; i < natoms; i++)
+    {
+        wtot += w[i];
+    }
+    if (wtot <= 0)
+    {
+        gmx_fatal(FARGS, "The total weight for the RMSD calculation is zero");
+    }
+
+    /* Inner products of all frames, needed for the superposition */
+    snew(g, n);
+    if (bFit)
+    {
+        for (int f = 0; f < n; f++)
+        {
+            for (int i = 0; i < natoms; i++)
+            {
+                g[f] += w[i]*iprod(x[f][i], x[f][i]);
+            }
+        }
+    }
+
+    /* List the blocks of pairs in the upper triangle, which we divide
+     * dynamically over the threads, since they are not all equal in size */
+    ntile = nblock*(nblock + 1)/2;
+    snew(tile_i, ntile);
+    snew(tile_j, ntile);
+    t = 0;
+    for (bi = 0; bi < nblock; bi++)
+    {
+        for (bj = bi; bj < nblock; bj++)
+        {
+            tile_i[t] = bi;
+            tile_j[t] = bj;
+            t++;
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        mat[i][i] = 0;
+    }
+
+    nthreads = std::max(1, nthreads);
+    snew(thread_min, nthreads);
+    snew(thread_max, nthreads);
+    snew(thread_sum, nthreads);
+    for (t = 0; t < nthreads; t++)
+    {
+        thread_min[t] = 1e20;
+        thread_max[t] = 0;
+    }
+
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+    for (t = 0; t < ntile; t++)
+    {
+        try
+        {
+            int  thread = gmx_omp_get_thread_num();
+            int  i0     = tile_i[t]*RMSD_BLOCKSIZE;
+            int  i1     = std::min(i0 + RMSD_BLOCKSIZE, n);
+            int  j0     = tile_j[t]*RMSD_BLOCKSIZE;
+            int  j1     = std::min(j0 + RMSD_BLOCKSIZE, n);
+            real rmsd;
+
+            for (int i = i0; i < i1; i++)
+            {
+                for (int j = std::max(j0, i + 1); j < j1; j++)
+                {
+                    if (bFit)
+                    {
+                        rmsd = qcp_rmsd(natoms, w, x[i], x[j], g[i], g[j], wtot);
+                    }
+                    else
+                    {
+                        rmsd = plain_rmsd(natoms, w, x[i], x[j], wtot);
+                    }
+                    /* Each pair is only in one tile, so no two threads
+                     * write the same element */
+                    mat[i][j]           = rmsd;
+                    mat[j][i]           = rmsd;
+                    thread_min[thread]  = std::min(thread_min[thread], rmsd);
+                    thread_max[thread]  = std::max(thread_max[thread], rmsd);
+                    thread_sum[thread] += rmsd;
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    *minrms = 1e20;
+    *maxrms = 0;
+    *sumrms = 0;
+    for (t = 0; t < nthreads; t++)
+    {
+        *minrms  = std::min(*minrms, thread_min[t]);
+        *maxrms  = std::max(*maxrms, thread_max[t]);
+        *sumrms += thread_sum[t];
+    }
+
+    sfree(thread_min);
+    sfree(thread_max);
+    sfree(thread_sum);
+    sfree(tile_i);
+    sfree(tile_j);
+    sfree(g);
+}
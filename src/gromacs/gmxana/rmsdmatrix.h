@@ -0,0 +1,68 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#ifndef _rmsdmatrix_h
+#define _rmsdmatrix_h
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/real.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Computes the RMSD between all pairs of the n frames x[0..n-1], with
+ * natoms atoms each, using weights w, and stores them in the symmetric
+ * matrix mat, which should have n rows of at least n elements.
+ * With bFit, the RMSD after least-squares superposition is computed with
+ * the quaternion characteristic polynomial (QCP) method of Theobald,
+ * which needs no rotation matrix; all frames should then be centered on
+ * their weighted center. Without bFit the plain weighted RMSD is used.
+ * The pairs are computed in blocks of frames, which are divided over
+ * nthreads OpenMP threads. Returns the smallest and largest RMSD between
+ * different frames and the sum over all pairs i < j in minrms, maxrms
+ * and sumrms.
+ */
+extern void calc_rmsd_matrix(int n, int natoms, const real w[], rvec *x[],
+                             gmx_bool bFit, int nthreads, real **mat,
+                             real *minrms, real *maxrms, double *sumrms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the RMSD matrix computation with QCP superposition.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/rmsdmatrix.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/do_fit.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/random/random.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! Number of atoms in the test structures
+const int c_numAtoms  = 23;
+//! Number of frames in the test structures
+const int c_numFrames = 7;
+
+/*! \brief
+ * Test fixture with random structures, which are randomly rotated
+ * and perturbed copies of one structure, centered on the weighted center.
+ */
+class RmsdMatrixTest : public ::testing::Test
+{
+    public:
+        RmsdMatrixTest() : x_(c_numFrames)
+        {
+            rng_ = gmx_rng_init(1234);
+            std::vector<gmx::RVec> base(c_numAtoms);
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    base[i][d] = 2*gmx_rng_uniform_real(rng_) - 1;
+                }
+            }
+            for (int f = 0; f < c_numFrames; f++)
+            {
+                matrix R;
+                randomRotation(R);
+                x_[f].resize(c_numAtoms);
+                for (int i = 0; i < c_numAtoms; i++)
+                {
+                    mvmul(R, base[i], x_[f][i]);
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        x_[f][i][d] += 0.1*f*gmx_rng_gaussian_real(rng_);
+                    }
+                }
+            }
+        }
+        ~RmsdMatrixTest()
+        {
+            gmx_rng_destroy(rng_);
+        }
+
+        //! Generates a rotation around a random axis by a random angle.
+        void randomRotation(matrix R)
+        {
+            rvec axis;
+            for (int d = 0; d < DIM; d++)
+            {
+                axis[d] = gmx_rng_gaussian_real(rng_);
+            }
+            unitv(axis, axis);
+            real angle = 2*M_PI*gmx_rng_uniform_real(rng_);
+            real c     = std::cos(angle);
+            real s     = std::sin(angle);
+            for (int d = 0; d < DIM; d++)
+            {
+                for (int e = 0; e < DIM; e++)
+                {
+                    R[d][e] = (1 - c)*axis[d]*axis[e] + (d == e ? c : 0);
+                }
+            }
+            R[XX][YY] -= s*axis[ZZ];
+            R[XX][ZZ] += s*axis[YY];
+            R[YY][XX] += s*axis[ZZ];
+            R[YY][ZZ] -= s*axis[XX];
+            R[ZZ][XX] -= s*axis[YY];
+            R[ZZ][YY] += s*axis[XX];
+        }
+
+        /*! \brief
+         * Checks calc_rmsd_matrix() against the RMSD after do_fit() for all
+         * pairs of frames, with weights \p w.
+         */
+        void checkAgainstDoFit(std::vector<real> w, int nthreads)
+        {
+            std::vector<rvec *> xptr(c_numFrames);
+            for (int f = 0; f < c_numFrames; f++)
+            {
+                reset_x(c_numAtoms, NULL, c_numAtoms, NULL, as_rvec_array(&x_[f][0]), &w[0]);
+                xptr[f] = as_rvec_array(&x_[f][0]);
+            }
+
+            /* Start from a value that is not a valid RMSD, to check
+             * that all elements are set */
+            std::vector<std::vector<real> > mat(c_numFrames, std::vector<real>(c_numFrames, -1));
+            std::vector<real *>             matptr(c_numFrames);
+            for (int f = 0; f < c_numFrames; f++)
+            {
+                matptr[f] = &mat[f][0];
+            }
+            real   minrms, maxrms;
+            double sumrms;
+            calc_rmsd_matrix(c_numFrames, c_numAtoms, &w[0], &xptr[0], TRUE, nthreads,
+                             &matptr[0], &minrms, &maxrms, &sumrms);
+
+            double sumReference = 0;
+            for (int i = 0; i < c_numFrames; i++)
+            {
+                for (int j = i + 1; j < c_numFrames; j++)
+                {
+                    std::vector<gmx::RVec> xfit(x_[j]);
+                    do_fit(c_numAtoms, &w[0], xptr[i], as_rvec_array(&xfit[0]));
+                    real                   reference = rmsdev(c_numAtoms, &w[0], xptr[i], as_rvec_array(&xfit[0]));
+
+                    SCOPED_TRACE(testing::Message() << "Frames " << i << " and " << j);
+                    EXPECT_REAL_EQ_TOL(reference, mat[i][j],
+                                       gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4));
+                    EXPECT_EQ(mat[i][j], mat[j][i]);
+                    EXPECT_LE(minrms, mat[i][j]);
+                    EXPECT_GE(maxrms, mat[i][j]);
+                    sumReference += mat[i][j];
+                }
+                EXPECT_EQ(0, mat[i][i]);
+            }
+            EXPECT_REAL_EQ_TOL(sumReference, sumrms,
+                               gmx::test::relativeToleranceAsFloatingPoint(sumReference, 1e-5));
+        }
+
+        gmx_rng_t                           rng_;
+        std::vector<std::vector<gmx::RVec> > x_;
+};
+
+TEST_F(RmsdMatrixTest, MatchesDoFitWithEqualWeights)
+{
+    checkAgainstDoFit(std::vector<real>(c_numAtoms, 1.0), 1);
+}
+
+TEST_F(RmsdMatrixTest, MatchesDoFitWithMassWeights)
+{
+    std::vector<real> mass(c_numAtoms);
+    for (int i = 0; i < c_numAtoms; i++)
+    {
+        mass[i] = 1 + 15*gmx_rng_uniform_real(rng_);
+    }
+    checkAgainstDoFit(mass, 1);
+}
+
+TEST_F(RmsdMatrixTest, MatchesDoFitWithThreads)
+{
+    std::vector<real> mass(c_numAtoms);
+    for (int i = 0; i < c_numAtoms; i++)
+    {
+        mass[i] = 1 + 15*gmx_rng_uniform_real(rng_);
+    }
+    checkAgainstDoFit(mass, 3);
+}
+
+} // namespace
@@ -69,6 +69,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
@@ -92,9 +93,14 @@
  * But old code can not read a new entry that is present in the file
  * (but can read a new format when new entries are not present).
  */
-static const int cpt_version = 16;
+static const int cpt_version = 17;
 
 
+/* The state entries with one value per atom, which are written in atom
+ * blocks after the footer with distributed checkpointing.
+ */
+static const int cpt_atom_flags = ((1<<estX) | (1<<estV) | (1<<estSDX));
+
 const char *est_names[estNR] =
 {
     "FE-lambda",
@@ -758,7 +764,7 @@ static void do_cpt_header(XDR *xd, gmx_bool bRead, int *file_version,
                           int *natoms, int *ngtc, int *nnhpres, int *nhchainlength,
                           int *nlambda, int *flags_state,
                           int *flags_eks, int *flags_enh, int *flags_dfh,
-                          int *nED, int *eSwapCoords,
+                          int *nED, int *eSwapCoords, int *nAtomBlocks,
                           FILE *list)
 {
     bool_t res = 0;
@@ -904,6 +910,14 @@ static void do_cpt_header(XDR *xd, gmx_bool bRead, int *file_version,
     {
         do_cpt_int_err(xd, "swap", eSwapCoords, list);
     }
+    if (*file_version >= 17)
+    {
+        do_cpt_int_err(xd, "#atom blocks", nAtomBlocks, list);
+    }
+    else
+    {
+        *nAtomBlocks = 0;
+    }
 }
 
 static int do_cpt_footer(XDR *xd, int file_version)
@@ -928,6 +942,254 @@ static int do_cpt_footer(XDR *xd, int file_version)
     return 0;
 }
 
+/* Returns the size in bytes of an atom block with nhome atoms */
+static gmx_off_t cpt_atom_block_size(int nhome, int fflags)
+{
+    gmx_off_t size;
+    int       i;
+
+    size = (1 + nhome)*sizeof(int);
+    for (i = 0; i < estNR; i++)
+    {
+        if ((cpt_atom_flags & fflags) & (1<<i))
+        {
+            size += static_cast<gmx_off_t>(nhome)*DIM*sizeof(real);
+        }
+    }
+
+    return size;
+}
+
+/* Returns the per-atom array of state for entry est */
+static rvec **cpt_atom_array(t_state *state, int est)
+{
+    switch (est)
+    {
+        case estX:   return &state->x;
+        case estV:   return &state->v;
+        case estSDX: return &state->sd_X;
+        default:
+            gmx_incons("Unknown per-atom state entry");
+    }
+
+    return NULL;
+}
+
+/* Writes the home atoms of this rank, with their global indices, as one
+ * block to the checkpoint file fn. The blocks of all PP ranks are placed
+ * after the footer in DD rank order, each rank computes its own offset
+ * from the home atom counts. On the master rank fp is the open checkpoint
+ * file with all other data written. Must be called on all PP ranks.
+ */
+static void write_cpt_atom_blocks(t_fileio *fp, const char *fn, t_commrec *cr,
+                                  t_state *state_local)
+{
+    gmx_domdec_t *dd = cr->dd;
+    int          *nhome;
+    gmx_off_t     offset;
+    int           fnlen;
+    char         *fnbuf;
+    FILE         *fpb = NULL;
+    XDR           xdrb;
+    XDR          *xd;
+    int           n, i, r;
+    bool_t        res;
+
+    snew(nhome, dd->nnodes);
+    nhome[dd->rank] = dd->nat_home;
+    gmx_sumi(dd->nnodes, nhome, cr);
+
+    /* Let the other ranks know where the blocks start and in which file */
+    offset = 0;
+    fnlen  = 0;
+    if (MASTER(cr))
+    {
+        offset = gmx_fio_ftell(fp);
+        fnlen  = std::strlen(fn) + 1;
+    }
+    gmx_bcast(sizeof(offset), &offset, cr);
+    gmx_bcast(sizeof(fnlen), &fnlen, cr);
+    snew(fnbuf, fnlen);
+    if (MASTER(cr))
+    {
+        std::strcpy(fnbuf, fn);
+    }
+    gmx_bcast(fnlen, fnbuf, cr);
+
+    for (r = 0; r < dd->rank; r++)
+    {
+        offset += cpt_atom_block_size(nhome[r], state_local->flags);
+    }
+
+    if (MASTER(cr))
+    {
+        if (gmx_fio_seek(fp, offset) != 0)
+        {
+            gmx_file("Cannot write checkpoint; maybe you are out of disk space?");
+        }
+        xd = gmx_fio_getxdr(fp);
+    }
+    else
+    {
+        fpb = std::fopen(fnbuf, "r+b");
+        if (fpb == NULL || gmx_fseek(fpb, offset, SEEK_SET) != 0)
+        {
+            gmx_file("Cannot write checkpoint; maybe you are out of disk space?");
+        }
+        xdrstdio_create(&xdrb, fpb, XDR_ENCODE);
+        xd = &xdrb;
+    }
+
+    n   = dd->nat_home;
+    res = xdr_int(xd, &n);
+    for (i = 0; i < n && res; i++)
+    {
+        res = xdr_int(xd, &dd->gatindex[i]);
+    }
+    for (i = 0; i < estNR && res; i++)
+    {
+        if ((cpt_atom_flags & state_local->flags) & (1<<i))
+        {
+            do_cpt_n_rvecs_err(xd, NULL, n, *cpt_atom_array(state_local, i), NULL);
+        }
+    }
+
+    if (!MASTER(cr))
+    {
+        xdr_destroy(&xdrb);
+        /* The master rank fsyncs its file together with all output files */
+        if (std::fflush(fpb) != 0 || gmx_fsync(fpb) != 0)
+        {
+            if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == NULL)
+            {
+                res = 0;
+            }
+        }
+        if (std::fclose(fpb) != 0)
+        {
+            res = 0;
+        }
+    }
+    if (res == 0)
+    {
+        gmx_file("Cannot write checkpoint; maybe you are out of disk space?");
+    }
+
+    /* Make sure all blocks are complete before the file is renamed */
+    gmx_barrier(cr);
+
+    sfree(fnbuf);
+    sfree(nhome);
+}
+
+static void do_cpt_block_real_err(XDR *xd, int double_prec, real *f)
+{
+    bool_t res;
+
+    if (double_prec)
+    {
+        double d = *f;
+        res = xdr_double(xd, &d);
+        *f  = d;
+    }
+    else
+    {
+        float  fl = *f;
+        res = xdr_float(xd, &fl);
+        *f  = fl;
+    }
+    if (res == 0)
+    {
+        cp_error();
+    }
+}
+
+/* Reads the atom blocks of a distributed checkpoint into the per-atom
+ * arrays of the global state, which are allocated when NULL.
+ */
+static int do_cpt_atom_blocks_read(XDR *xd, int nblocks, int fflags,
+                                   int double_prec, t_state *state, FILE *list)
+{
+    int   *index = NULL;
+    int    nalloc, ntot, nhome;
+    int    b, i, est, d;
+    int    ret;
+    rvec  *v;
+
+    if (double_prec < 0)
+    {
+        double_prec = GMX_CPT_BUILD_DP;
+    }
+    for (est = 0; est < estNR; est++)
+    {
+        if (((cpt_atom_flags & fflags) & (1<<est)) &&
+            *cpt_atom_array(state, est) == NULL)
+        {
+            snew(*cpt_atom_array(state, est), state->natoms);
+        }
+    }
+
+    ret    = 0;
+    nalloc = 0;
+    ntot   = 0;
+    for (b = 0; b < nblocks && ret == 0; b++)
+    {
+        if (xdr_int(xd, &nhome) == 0 || nhome < 0 || ntot + nhome > state->natoms)
+        {
+            ret = -1;
+            break;
+        }
+        if (nhome > nalloc)
+        {
+            nalloc = nhome;
+            srenew(index, nalloc);
+        }
+        for (i = 0; i < nhome && ret == 0; i++)
+        {
+            if (xdr_int(xd, &index[i]) == 0 ||
+                index[i] < 0 || index[i] >= state->natoms)
+            {
+                ret = -1;
+            }
+        }
+        for (est = 0; est < estNR && ret == 0; est++)
+        {
+            if ((cpt_atom_flags & fflags) & (1<<est))
+            {
+                v = *cpt_atom_array(state, est);
+                for (i = 0; i < nhome; i++)
+                {
+                    for (d = 0; d < DIM; d++)
+                    {
+                        do_cpt_block_real_err(xd, double_prec, &v[index[i]][d]);
+                    }
+                }
+            }
+        }
+        ntot += nhome;
+    }
+    sfree(index);
+
+    if (ret == 0 && ntot != state->natoms)
+    {
+        ret = -1;
+    }
+
+    if (ret == 0 && list)
+    {
+        fprintf(list, "#atom blocks = %d\n", nblocks);
+        for (est = 0; est < estNR; est++)
+        {
+            if ((cpt_atom_flags & fflags) & (1<<est))
+            {
+                pr_rvecs(list, 0, est_names[est], *cpt_atom_array(state, est), state->natoms);
+            }
+        }
+    }
+
+    return ret;
+}
+
 static int do_cpt_state(XDR *xd, gmx_bool bRead,
                         int fflags, t_state *state,
                         FILE *list)
@@ -1437,11 +1699,16 @@ static int do_cpt_files(XDR *xd, gmx_bool bRead,
 }
 
 
-void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
-                      FILE *fplog, t_commrec *cr,
-                      int eIntegrator, int simulation_part,
-                      gmx_bool bExpanded, int elamstats,
-                      gmx_int64_t step, double t, t_state *state)
+/* Writes the checkpoint on the master rank. With state_local != NULL
+ * the per-atom data is not taken from state, but written by all PP ranks
+ * from their local states.
+ */
+static void write_checkpoint_low(const char *fn, gmx_bool bNumberAndKeep,
+                                 FILE *fplog, t_commrec *cr,
+                                 int eIntegrator, int simulation_part,
+                                 gmx_bool bExpanded, int elamstats,
+                                 gmx_int64_t step, double t, t_state *state,
+                                 t_state *state_local)
 {
     t_fileio            *fp;
     int                  file_version;
@@ -1459,8 +1726,15 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
     int                  noutputfiles;
     char                *ftime;
     int                  flags_eks, flags_enh, flags_dfh;
+    int                  flags_main, nAtomBlocks;
     t_fileio            *ret;
 
+    if (state_local != NULL && !MASTER(cr))
+    {
+        write_cpt_atom_blocks(NULL, NULL, cr, state_local);
+        return;
+    }
+
     if (DOMAINDECOMP(cr))
     {
         nppnodes  = cr->dd->nnodes;
@@ -1553,6 +1827,17 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
         flags_dfh = 0;
     }
 
+    /* With distributed writing, the per-atom entries are written
+     * as atom blocks after the footer.
+     */
+    flags_main  = state->flags;
+    nAtomBlocks = 0;
+    if (state_local != NULL)
+    {
+        flags_main  = state->flags & ~cpt_atom_flags;
+        nAtomBlocks = nppnodes;
+    }
+
     /* We can check many more things now (CPU, acceleration, etc), but
      * it is highly unlikely to have two separate builds with exactly
      * the same version, user, time, and build host!
@@ -1575,7 +1860,7 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
                   &state->natoms, &state->ngtc, &state->nnhpres,
                   &state->nhchainlength, &(state->dfhist.nlambda), &state->flags, &flags_eks, &flags_enh, &flags_dfh,
                   &state->edsamstate.nED, &state->swapstate.eSwapCoords,
-                  NULL);
+                  &nAtomBlocks, NULL);
 
     sfree(version);
     sfree(btime);
@@ -1583,7 +1868,7 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
     sfree(bhost);
     sfree(fprog);
 
-    if ((do_cpt_state(gmx_fio_getxdr(fp), FALSE, state->flags, state, NULL) < 0)        ||
+    if ((do_cpt_state(gmx_fio_getxdr(fp), FALSE, flags_main, state, NULL) < 0)          ||
         (do_cpt_ekinstate(gmx_fio_getxdr(fp), flags_eks, &state->ekinstate, NULL) < 0) ||
         (do_cpt_enerhist(gmx_fio_getxdr(fp), FALSE, flags_enh, &state->enerhist, NULL) < 0)  ||
         (do_cpt_df_hist(gmx_fio_getxdr(fp), flags_dfh, &state->dfhist, NULL) < 0)  ||
@@ -1597,6 +1882,11 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
 
     do_cpt_footer(gmx_fio_getxdr(fp), file_version);
 
+    if (state_local != NULL)
+    {
+        write_cpt_atom_blocks(fp, fntemp, cr, state_local);
+    }
+
     /* we really, REALLY, want to make sure to physically write the checkpoint,
        and all the files it depends on, out to disk. Because we've
        opened the checkpoint with gmx_fio_open(), it's in our list
@@ -1672,6 +1962,31 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
 #endif /* end GMX_FAHCORE block */
 }
 
+void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
+                      FILE *fplog, t_commrec *cr,
+                      int eIntegrator, int simulation_part,
+                      gmx_bool bExpanded, int elamstats,
+                      gmx_int64_t step, double t, t_state *state)
+{
+    write_checkpoint_low(fn, bNumberAndKeep, fplog, cr,
+                         eIntegrator, simulation_part, bExpanded, elamstats,
+                         step, t, state, NULL);
+}
+
+void write_checkpoint_distributed(const char *fn, gmx_bool bNumberAndKeep,
+                                  FILE *fplog, t_commrec *cr,
+                                  int eIntegrator, int simulation_part,
+                                  gmx_bool bExpanded, int elamstats,
+                                  gmx_int64_t step, double t,
+                                  t_state *state_local, t_state *state_global)
+{
+    GMX_RELEASE_ASSERT(DOMAINDECOMP(cr), "Distributed checkpointing requires domain decomposition");
+
+    write_checkpoint_low(fn, bNumberAndKeep, fplog, cr,
+                         eIntegrator, simulation_part, bExpanded, elamstats,
+                         step, t, state_global, state_local);
+}
+
 static void print_flag_mismatch(FILE *fplog, int sflags, int fflags)
 {
     int i;
@@ -1828,6 +2143,7 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
     int                  eIntegrator_f, nppnodes_f, npmenodes_f;
     ivec                 dd_nc_f;
     int                  natoms, ngtc, nnhpres, nhchainlength, nlambda, fflags, flags_eks, flags_enh, flags_dfh;
+    int                  nAtomBlocks;
     int                  d;
     int                  ret;
     gmx_file_position_t *outputfiles;
@@ -1859,7 +2175,8 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
                   &nppnodes_f, dd_nc_f, &npmenodes_f,
                   &natoms, &ngtc, &nnhpres, &nhchainlength, &nlambda,
                   &fflags, &flags_eks, &flags_enh, &flags_dfh,
-                  &state->edsamstate.nED, &state->swapstate.eSwapCoords, NULL);
+                  &state->edsamstate.nED, &state->swapstate.eSwapCoords,
+                  &nAtomBlocks, NULL);
 
     if (bAppendOutputFiles &&
         file_version >= 13 && double_prec != GMX_CPT_BUILD_DP)
@@ -1991,7 +2308,9 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
                         cr, nppnodes_f, npmenodes_f, dd_nc, dd_nc_f);
         }
     }
-    ret             = do_cpt_state(gmx_fio_getxdr(fp), TRUE, fflags, state, NULL);
+    ret             = do_cpt_state(gmx_fio_getxdr(fp), TRUE,
+                                   nAtomBlocks > 0 ? fflags & ~cpt_atom_flags : fflags,
+                                   state, NULL);
     *init_fep_state = state->fep_state;  /* there should be a better way to do this than setting it here.
                                             Investigate for 5.0. */
     if (ret)
@@ -2055,6 +2374,12 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
     {
         cp_error();
     }
+    if (nAtomBlocks > 0 &&
+        do_cpt_atom_blocks_read(gmx_fio_getxdr(fp), nAtomBlocks, fflags,
+                                double_prec, state, NULL) != 0)
+    {
+        cp_error();
+    }
     if (gmx_fio_close(fp) != 0)
     {
         gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
@@ -2254,6 +2579,7 @@ void read_checkpoint_part_and_step(const char  *filename,
     int       nppnodes, npme;
     ivec      dd_nc;
     int       flags_eks, flags_enh, flags_dfh;
+    int       nAtomBlocks;
     double    t;
     t_state   state;
     t_fileio *fp;
@@ -2276,7 +2602,7 @@ void read_checkpoint_part_and_step(const char  *filename,
                   &eIntegrator, simulation_part, step, &t, &nppnodes, dd_nc, &npme,
                   &state.natoms, &state.ngtc, &state.nnhpres, &state.nhchainlength,
                   &(state.dfhist.nlambda), &state.flags, &flags_eks, &flags_enh, &flags_dfh,
-                  &state.edsamstate.nED, &state.swapstate.eSwapCoords, NULL);
+                  &state.edsamstate.nED, &state.swapstate.eSwapCoords, &nAtomBlocks, NULL);
 
     gmx_fio_close(fp);
 }
@@ -2292,6 +2618,7 @@ static void read_checkpoint_data(t_fileio *fp, int *simulation_part,
     int                  nppnodes, npme;
     ivec                 dd_nc;
     int                  flags_eks, flags_enh, flags_dfh;
+    int                  nAtomBlocks;
     int                  nfiles_loc;
     gmx_file_position_t *files_loc = NULL;
     int                  ret;
@@ -2301,9 +2628,11 @@ static void read_checkpoint_data(t_fileio *fp, int *simulation_part,
                   &eIntegrator, simulation_part, step, t, &nppnodes, dd_nc, &npme,
                   &state->natoms, &state->ngtc, &state->nnhpres, &state->nhchainlength,
                   &(state->dfhist.nlambda), &state->flags, &flags_eks, &flags_enh, &flags_dfh,
-                  &state->edsamstate.nED, &state->swapstate.eSwapCoords, NULL);
+                  &state->edsamstate.nED, &state->swapstate.eSwapCoords, &nAtomBlocks, NULL);
     ret =
-        do_cpt_state(gmx_fio_getxdr(fp), TRUE, state->flags, state, NULL);
+        do_cpt_state(gmx_fio_getxdr(fp), TRUE,
+                     nAtomBlocks > 0 ? state->flags & ~cpt_atom_flags : state->flags,
+                     state, NULL);
     if (ret)
     {
         cp_error();
@@ -2357,6 +2686,13 @@ static void read_checkpoint_data(t_fileio *fp, int *simulation_part,
         cp_error();
     }
 
+    if (nAtomBlocks > 0 &&
+        do_cpt_atom_blocks_read(gmx_fio_getxdr(fp), nAtomBlocks, state->flags,
+                                double_prec, state, NULL) != 0)
+    {
+        cp_error();
+    }
+
     sfree(fprog);
     sfree(ftime);
     sfree(btime);
@@ -2437,6 +2773,7 @@ void list_checkpoint(const char *fn, FILE *out)
     ivec                 dd_nc;
     t_state              state;
     int                  flags_eks, flags_enh, flags_dfh;
+    int                  nAtomBlocks;
     int                  ret;
     gmx_file_position_t *outputfiles;
     int                  nfiles;
@@ -2450,8 +2787,10 @@ void list_checkpoint(const char *fn, FILE *out)
                   &state.natoms, &state.ngtc, &state.nnhpres, &state.nhchainlength,
                   &(state.dfhist.nlambda), &state.flags,
                   &flags_eks, &flags_enh, &flags_dfh, &state.edsamstate.nED,
-                  &state.swapstate.eSwapCoords, out);
-    ret = do_cpt_state(gmx_fio_getxdr(fp), TRUE, state.flags, &state, out);
+                  &state.swapstate.eSwapCoords, &nAtomBlocks, out);
+    ret = do_cpt_state(gmx_fio_getxdr(fp), TRUE,
+                       nAtomBlocks > 0 ? state.flags & ~cpt_atom_flags : state.flags,
+                       &state, out);
     if (ret)
     {
         cp_error();
@@ -2490,6 +2829,12 @@ void list_checkpoint(const char *fn, FILE *out)
         ret = do_cpt_footer(gmx_fio_getxdr(fp), file_version);
     }
 
+    if (ret == 0 && nAtomBlocks > 0)
+    {
+        ret = do_cpt_atom_blocks_read(gmx_fio_getxdr(fp), nAtomBlocks, state.flags,
+                                      double_prec, &state, out);
+    }
+
     if (ret)
     {
         cp_warning(out);
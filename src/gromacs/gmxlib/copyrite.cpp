@@ -616,6 +616,16 @@ void please_cite(FILE *fp, const char *key)
           "GROMACS: High performance molecular simulations through multi-level parallelism from laptops to supercomputers",
           "SoftwareX",
           1, 2015, "19-25" },
+        { "Kabsch83",
+          "W. Kabsch and C. Sander",
+          "Dictionary of protein secondary structure: pattern recognition of hydrogen-bonded and geometrical features",
+          "Biopolymers",
+          22, 1983, "2577-2637" },
+        { "Theobald2005",
+          "D. L. Theobald",
+          "Rapid calculation of RMSDs using a quaternion-based characteristic polynomial",
+          "Acta Cryst. A",
+          61, 2005, "478-480" },
     };
 #define NSTR (int)asize(citedb)
 
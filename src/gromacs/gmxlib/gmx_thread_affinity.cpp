@@ -64,6 +64,14 @@
 #include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
+/* Set when gmx_set_thread_affinity() pinned threads in this process */
+static gmx_bool bThreadsPinned = FALSE;
+/* The core of each OpenMP thread pinned by gmx_set_thread_affinity(),
+ * only stored with a single rank, since all thread-MPI ranks share these
+ */
+static int     *pinnedCores  = NULL;
+static int      nPinnedCores = 0;
+
 static int
 get_thread_affinity_layout(FILE *fplog,
                            const t_commrec *cr,
@@ -294,6 +302,11 @@ gmx_set_thread_affinity(FILE                *fplog,
     // to zero outside the OpenMP block, and then add to it inside the block.
     // The value will still always be 0 or 1 from each thread.
     nth_affinity_set = 0;
+    if (!PAR(cr) && !MULTISIM(cr))
+    {
+        srenew(pinnedCores, nthread_local);
+        nPinnedCores = nthread_local;
+    }
 #pragma omp parallel num_threads(nthread_local) reduction(+:nth_affinity_set)
     {
         try
@@ -319,6 +332,11 @@ gmx_set_thread_affinity(FILE                *fplog,
             /* store the per-thread success-values of the setaffinity */
             nth_affinity_set += (setaffinity_ret == 0);
 
+            if (thread_id < nPinnedCores)
+            {
+                pinnedCores[thread_id] = (setaffinity_ret == 0 ? core : -1);
+            }
+
             if (debug)
             {
                 fprintf(debug, "On rank %2d, thread %2d, index %2d, core %2d the affinity setting returned %d\n",
@@ -328,6 +346,11 @@ gmx_set_thread_affinity(FILE                *fplog,
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
 
+    if (nth_affinity_set > 0)
+    {
+        bThreadsPinned = TRUE;
+    }
+
     if (nth_affinity_set > nthread_local)
     {
         char msg[STRLEN];
@@ -510,3 +533,82 @@ gmx_check_thread_affinity_set(FILE            *fplog,
     }
 #endif /* HAVE_SCHED_AFFINITY */
 }
+
+void gmx_unpin_thread()
+{
+#ifdef HAVE_SCHED_AFFINITY
+    cpu_set_t mask;
+    int       ret;
+
+    if (!bThreadsPinned)
+    {
+        /* The affinity was set outside of mdrun or not at all, keep it */
+        return;
+    }
+
+    /* We only pin when the process was allowed to run on all cores,
+     * so allowing all cores restores the original affinity.
+     */
+    CPU_ZERO(&mask);
+    for (int i = 0; i < CPU_SETSIZE; i++)
+    {
+        CPU_SET(i, &mask);
+    }
+    if ((ret = sched_setaffinity(0, sizeof(cpu_set_t), &mask)) != 0)
+    {
+        if (debug)
+        {
+            fprintf(debug, "Failed to reset the thread affinity mask (error %d)\n", errno);
+        }
+    }
+#endif /* HAVE_SCHED_AFFINITY */
+}
+
+void gmx_extend_thread_affinity(int thread_begin, int thread_end)
+{
+#ifdef HAVE_SCHED_AFFINITY
+    cpu_set_t mask;
+
+    if (!bThreadsPinned || thread_end > nPinnedCores ||
+        sched_getaffinity(0, sizeof(cpu_set_t), &mask) != 0)
+    {
+        return;
+    }
+    for (int t = thread_begin; t < thread_end; t++)
+    {
+        if (pinnedCores[t] >= 0 && pinnedCores[t] < CPU_SETSIZE)
+        {
+            CPU_SET(pinnedCores[t], &mask);
+        }
+    }
+    sched_setaffinity(0, sizeof(cpu_set_t), &mask);
+#else
+    GMX_UNUSED_VALUE(thread_begin);
+    GMX_UNUSED_VALUE(thread_end);
+#endif /* HAVE_SCHED_AFFINITY */
+}
+
+void gmx_pin_thread_to_assigned_core(int thread)
+{
+    if (bThreadsPinned && thread < nPinnedCores && pinnedCores[thread] >= 0)
+    {
+        tMPI_Thread_setaffinity_single(tMPI_Thread_self(), pinnedCores[thread]);
+    }
+}
+
+gmx_bool gmx_thread_affinity_is_pinned(void)
+{
+    return bThreadsPinned;
+}
+
+gmx_bool gmx_thread_runs_on_single_core(void)
+{
+#if defined HAVE_SCHED_AFFINITY && defined CPU_COUNT
+    cpu_set_t mask;
+
+    return (sched_getaffinity(0, sizeof(cpu_set_t), &mask) == 0 &&
+            CPU_COUNT(&mask) == 1);
+#else
+    return FALSE;
+#endif
+}
@@ -238,6 +238,10 @@ const char *eSwapTypes_names[eSwapTypesNR+1] = {
     "no", "X", "Y", "Z", NULL
 };
 
+const char *emts_names[emtsNR+1] = {
+    "none", "longrange-nonbonded", NULL
+};
+
 const char *eQMmethod_names[eQMmethodNR+1] = {
     "AM1", "PM3", "RHF",
     "UHF", "DFT", "B3LYP", "MP2", "CASSCF", "B3LYPLAN",
@@ -889,6 +889,8 @@ void pr_inputrec(FILE *fp, int indent, const char *title, t_inputrec *ir,
         PI("simulation-part", ir->simulation_part);
         PS("comm-mode", ECOM(ir->comm_mode));
         PI("nstcomm", ir->nstcomm);
+        PS("mts-level2-forces", EMTS(ir->mts_level2_forces));
+        PI("mts-level2-factor", ir->mts_level2_factor);
 
         /* Langevin dynamics */
         PR("bd-fric", ir->bd_fric);
@@ -576,6 +576,33 @@ void check_ir(const char *mdparin, t_inputrec *ir, t_gromppopts *opts,
         }
     }
 
+    /* MULTIPLE TIME STEPPING */
+    if (IR_MTS(*ir))
+    {
+        sprintf(err_buf, "Multiple time stepping is only supported with integrator %s",
+                ei_names[eiMD]);
+        CHECK(ir->eI != eiMD);
+        sprintf(err_buf, "Multiple time stepping is only supported with cutoff-scheme = %s",
+                ecutscheme_names[ecutsVERLET]);
+        CHECK(ir->cutoff_scheme != ecutsVERLET);
+        sprintf(err_buf, "With mts-level2-forces = %s, coulombtype and/or vdwtype should be PME",
+                emts_names[emtsLONGRANGE_NONBONDED]);
+        CHECK(!(EEL_PME(ir->coulombtype) || EVDW_PME(ir->vdwtype)));
+        sprintf(err_buf, "mts-level2-factor should be 1 or larger");
+        CHECK(ir->mts_level2_factor < 1);
+
+        if (ir->mts_level2_factor > 1 && ir->nstcalcenergy > 0 &&
+            ir->nstcalcenergy % ir->mts_level2_factor != 0)
+        {
+            /* The mesh is evaluated at all energy steps, so this is correct,
+             * but it costs extra mesh evaluations.
+             */
+            sprintf(warn_buf, "nstcalcenergy (%d) is not a multiple of mts-level2-factor (%d), this requires extra PME mesh evaluations",
+                    ir->nstcalcenergy, ir->mts_level2_factor);
+            warning_note(wi, warn_buf);
+        }
+    }
+
     if (ir->nsteps == 0 && !ir->bContinuation)
     {
         warning_note(wi, "For a correct single-point energy evaluation with nsteps = 0, use continuation = yes to avoid constraining the input coordinates.");
@@ -1907,6 +1934,9 @@ void get_ir(const char *mdparin, const char *mdparout,
     ITYPE ("nstcomm", ir->nstcomm,    100);
     CTYPE ("group(s) for center of mass motion removal");
     STYPE ("comm-grps",   is->vcm,            NULL);
+    CTYPE ("Multiple time stepping: forces computed every mts-level2-factor steps");
+    EETYPE("mts-level2-forces", ir->mts_level2_forces, emts_names);
+    ITYPE ("mts-level2-factor", ir->mts_level2_factor, 2);
 
     CCTYPE ("LANGEVIN DYNAMICS OPTIONS");
     CTYPE ("Friction coefficient (amu/ps) and random seed");
@@ -63,11 +63,29 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
                       gmx_int64_t step, double t,
                       t_state *state);
 
+/* Write a checkpoint as write_checkpoint, but without collecting
+ * the coordinates, velocities and SD positions on the master rank.
+ * Each PP rank writes its home atoms with their global indices as
+ * a block at the end of the checkpoint file, at an offset computed
+ * from the home atom counts of all ranks.
+ * Must be called on all PP ranks and requires domain decomposition.
+ * state_global is only used on the master rank and only needs
+ * the entries that are not distributed over the ranks.
+ */
+void write_checkpoint_distributed(const char *fn, gmx_bool bNumberAndKeep,
+                                  FILE *fplog, t_commrec *cr,
+                                  int eIntegrator, int simulation_part,
+                                  gmx_bool bExpanded, int elamstats,
+                                  gmx_int64_t step, double t,
+                                  t_state *state_local, t_state *state_global);
+
 /* Loads a checkpoint from fn for run continuation.
  * Generates a fatal error on system size mismatch.
  * The master node reads the file
  * and communicates all the modified number of steps and the parallel setup,
  * but not the state itself.
+ * The atom blocks of a distributed checkpoint are gathered into state,
+ * from which domain decomposition distributes the atoms as usual.
  * When bAppend is set, lock the log file and truncate the existing output
  * files so they can be appended.
  * With bAppend and bForceAppend: truncate anyhow if the system does not
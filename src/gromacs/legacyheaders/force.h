@@ -221,6 +221,24 @@ extern void do_force_lowlevel(t_forcerec   *fr,
                               float        *cycles_pme);
 /* Call all the force routines */
 
+void init_pme_mesh_task(t_forcerec *fr);
+/* Sets up the output storage for do_force_pme_mesh_task */
+
+gmx_bool pme_mesh_is_needed(const t_forcerec *fr, const struct t_commrec *cr,
+                            int flags);
+/* Returns whether the PME mesh part is computed on this rank with \p flags */
+
+void do_force_pme_mesh_task(t_forcerec *fr, struct t_commrec *cr,
+                            gmx_wallcycle_t wcycle,
+                            struct t_mdatoms *md, rvec x[], rvec f_mesh[],
+                            matrix box, real *lambda, int flags);
+/* Computes the PME mesh forces, adding them to f_mesh, and stores
+ * the energies and virial for use by the next do_force_lowlevel call.
+ * Only touches the PME data and f_mesh, so this can run as an OpenMP
+ * task concurrently with the non-bonded and listed force calculation.
+ * The PME threads then run as a nested team inside the task.
+ */
+
 void free_gpu_resources(const t_forcerec                   *fr,
                         const struct t_commrec             *cr,
                         const struct gmx_gpu_info_t        *gpu_info,
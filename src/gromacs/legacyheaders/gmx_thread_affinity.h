@@ -75,6 +75,40 @@ gmx_check_thread_affinity_set(FILE *fplog, const struct t_commrec *cr,
                               gmx_hw_opt_t *hw_opt, int ncpus,
                               gmx_bool bAfterOpenmpInit);
 
+/* Lets the calling thread run on all cores again when it inherited
+ * the core pinning set by gmx_set_thread_affinity() from the thread that
+ * created it. Should be called at the start of helper threads that do not
+ * do compute work, such as I/O threads, so they do not compete with
+ * the compute thread on its core. Does nothing when mdrun did not pin.
+ */
+void
+gmx_unpin_thread(void);
+
+/* Lets the calling thread also run on the cores that
+ * gmx_set_thread_affinity() assigned to OpenMP threads thread_begin
+ * to thread_end-1. Threads created afterwards by the calling thread,
+ * such as those of a nested OpenMP team, inherit this affinity instead
+ * of the single core of the calling thread. Does nothing when mdrun
+ * did not pin, or pinned with multiple ranks.
+ */
+void
+gmx_extend_thread_affinity(int thread_begin, int thread_end);
+
+/* Pins the calling thread to the core that gmx_set_thread_affinity()
+ * assigned to OpenMP thread thread, e.g. to undo
+ * gmx_extend_thread_affinity(). Does nothing when mdrun did not pin.
+ */
+void
+gmx_pin_thread_to_assigned_core(int thread);
+
+/* Returns whether gmx_set_thread_affinity() pinned threads */
+gmx_bool
+gmx_thread_affinity_is_pinned(void);
+
+/* Returns whether the calling thread is bound to a single core */
+gmx_bool
+gmx_thread_runs_on_single_core(void);
+
 #ifdef __cplusplus
 }
 #endif
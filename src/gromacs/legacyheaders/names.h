@@ -97,6 +97,7 @@ extern const char *erotg_names[erotgNR+1];
 extern const char *erotg_originnames[erotgNR+1];
 extern const char *erotg_fitnames[erotgFitNR+1];
 extern const char *eSwapTypes_names[eSwapTypesNR+1];
+extern const char *emts_names[emtsNR+1];
 extern const char *eQMmethod_names[eQMmethodNR+1];
 extern const char *eQMbasis_names[eQMbasisNR+1];
 extern const char *eQMMMscheme_names[eQMMMschemeNR+1];
@@ -150,6 +151,7 @@ extern const char *gmx_nbkernel_vdw_names[GMX_NBKERNEL_VDW_NR+1];
 #define EROTORIGIN(e)  ENUM_NAME(e, erotgOriginNR, erotg_originnames)
 #define EROTFIT(e)     ENUM_NAME(e, erotgFitNR, erotg_fitnames)
 #define ESWAPTYPE(e)   ENUM_NAME(e, eSwapTypesNR, eSwapTypes_names)
+#define EMTS(e)        ENUM_NAME(e, emtsNR, emts_names)
 #define EQMMETHOD(e)   ENUM_NAME(e, eQMmethodNR, eQMmethod_names)
 #define EQMBASIS(e)    ENUM_NAME(e, eQMbasisNR, eQMbasis_names)
 #define EQMMMSCHEME(e) ENUM_NAME(e, eQMMMschemeNR, eQMMMscheme_names)
@@ -319,6 +319,11 @@ enum eSwaptype {
     eswapNO, eswapX, eswapY, eswapZ, eSwapTypesNR
 };
 
+/* Forces which are integrated with a multiple time step */
+enum {
+    emtsNONE, emtsLONGRANGE_NONBONDED, emtsNR
+};
+
 /* QMMM */
 enum {
     eQMmethodAM1, eQMmethodPM3, eQMmethodRHF,
@@ -188,6 +188,8 @@ struct gmx_ewald_tab_t;
 
 typedef struct ewald_corr_thread_t ewald_corr_thread_t;
 
+typedef struct pme_mesh_task_t pme_mesh_task_t;
+
 typedef struct t_forcerec {
     interaction_const_t *ic;
 
@@ -330,8 +332,12 @@ typedef struct t_forcerec {
     /* The allocation size of vectors of size natoms_force */
     int nalloc_force;
 
-    /* Twin Range stuff, f_twin has size natoms_force */
+    /* Twin Range stuff, f_twin has size natoms_force.
+     * With multiple time stepping of the long-range nonbonded forces,
+     * f_twin stores the PME mesh forces.
+     */
     gmx_bool bTwinRange;
+    gmx_bool bMtsLongRange;
     int      nlr;
     rvec    *f_twin;
     /* Constraint virial correction for multiple time stepping */
@@ -477,6 +483,18 @@ typedef struct t_forcerec {
     ewald_corr_thread_t *ewc_t;
     /* Ewald charge correction load distribution over the threads */
     int                 *excl_load;
+
+    /* Compute the CPU non-bonded, listed and PME mesh forces as OpenMP
+     * tasks that run concurrently on the thread team (GMX_FORCE_TASKS)
+     */
+    gmx_bool             bForceTasks;
+    /* The size of the team running the tasks and of the nested team of
+     * the PME mesh task, which together use the non-bonded thread count
+     */
+    int                  nthread_force_tasks;
+    int                  nthread_pme_task;
+    /* Output of the PME mesh task, consumed by do_force_lowlevel */
+    pme_mesh_task_t     *pme_task;
 } t_forcerec;
 
 /* Important: Starting with Gromacs-4.6, the values of c6 and c12 in the nbfp array have
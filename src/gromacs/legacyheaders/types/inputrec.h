@@ -357,6 +357,8 @@ typedef struct t_inputrec {
     real            rlist;                   /* short range pairlist cut-off (nm)		*/
     real            rlistlong;               /* long range pairlist cut-off (nm)		*/
     int             nstcalclr;               /* Frequency of evaluating direct space long-range interactions */
+    int             mts_level2_forces;       /* Forces integrated with a multiple time step  */
+    int             mts_level2_factor;       /* The multiple time step in units of dt        */
     real            rtpi;                    /* Radius for test particle insertion           */
     int             coulombtype;             /* Type of electrostatics treatment             */
     int             coulomb_modifier;        /* Modify the Coulomb interaction              */
@@ -461,6 +463,8 @@ typedef struct t_inputrec {
 
 #define NEED_MUTOT(ir) (((ir).coulombtype == eelEWALD || EEL_PME((ir).coulombtype)) && ((ir).ewald_geometry == eewg3DC || (ir).epsilon_surface != 0))
 
+#define IR_MTS(ir) ((ir).mts_level2_forces != emtsNONE)
+
 #define IR_TWINRANGE(ir) ((ir).rlist > 0 && ((ir).rlistlong == 0 || (ir).rlistlong > (ir).rlist))
 
 #define IR_ELEC_FIELD(ir) ((ir).ex[XX].n > 0 || (ir).ex[YY].n > 0 || (ir).ex[ZZ].n > 0)
@@ -59,7 +59,13 @@ typedef struct t_mdatoms {
     int                    nChargePerturbed;
     int                    nTypePerturbed;
     gmx_bool               bOrires;
+    /* Are there virtual sites or shells among the home atoms? */
+    gmx_bool               bHaveVsitesOrShells;
     real                  *massA, *massB, *massT, *invmass;
+    /* The inverse mass repeated for each dimension,
+     * stored as rvec so the update can use flat SIMD loops
+     */
+    rvec                  *invMassPerDim;
     real                  *chargeA, *chargeB;
     real                  *sqrt_c6A, *sqrt_c6B;
     real                  *sigmaA, *sigmaB, *sigma3A, *sigma3B;
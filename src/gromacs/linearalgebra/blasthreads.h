@@ -0,0 +1,100 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Helpers for calling an external BLAS from our own OpenMP threads.
+ *
+ * A multi-threaded external BLAS would start its own threads in each
+ * call from one of our threads, which oversubscribes the cores. When the
+ * library provides a function to set its number of threads, it is set to
+ * one for the duration of our threaded loops. These settings are global
+ * in the libraries, so the helpers should be called outside parallel
+ * regions. With the bundled BLAS they do nothing.
+ */
+#ifndef GMX_LINEARALGEBRA_BLASTHREADS_H
+#define GMX_LINEARALGEBRA_BLASTHREADS_H
+
+#include "config.h"
+
+#include "gromacs/utility/basedefinitions.h"
+
+#ifdef HAVE_OPENBLAS_SET_NUM_THREADS
+extern "C" void openblas_set_num_threads(int nthreads);
+extern "C" int openblas_get_num_threads(void);
+#endif
+#ifdef HAVE_MKL_SET_NUM_THREADS
+extern "C" void mkl_set_num_threads(int nthreads);
+extern "C" int mkl_get_max_threads(void);
+#endif
+
+/*! \brief
+ * Lets the BLAS use a single thread when we use \p nthreads threads.
+ *
+ * Returns the previous number of BLAS threads, which should be passed
+ * to restore_blas_threads().
+ */
+static inline int limit_blas_threads(int nthreads)
+{
+    int nthreadsBlas = 0;
+
+    if (nthreads > 1)
+    {
+#if defined HAVE_OPENBLAS_SET_NUM_THREADS
+        nthreadsBlas = openblas_get_num_threads();
+        openblas_set_num_threads(1);
+#elif defined HAVE_MKL_SET_NUM_THREADS
+        nthreadsBlas = mkl_get_max_threads();
+        mkl_set_num_threads(1);
+#endif
+    }
+
+    return nthreadsBlas;
+}
+
+//! Restores the setting changed by limit_blas_threads().
+static inline void restore_blas_threads(int nthreads, int nthreadsBlas)
+{
+    if (nthreads > 1)
+    {
+#if defined HAVE_OPENBLAS_SET_NUM_THREADS
+        openblas_set_num_threads(nthreadsBlas);
+#elif defined HAVE_MKL_SET_NUM_THREADS
+        mkl_set_num_threads(nthreadsBlas);
+#endif
+    }
+    GMX_UNUSED_VALUE(nthreadsBlas);
+}
+
+#endif
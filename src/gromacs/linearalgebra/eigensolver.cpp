@@ -38,14 +38,21 @@
 
 #include "eigensolver.h"
 
+#include <algorithm>
+
 #include "gromacs/linearalgebra/sparsematrix.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 
+#include "blasthreads.h"
 #include "gmx_arpack.h"
+#include "gmx_blas.h"
 #include "gmx_lapack.h"
 
+/*! \brief Number of rows of a dense matrix handled as one block by a thread */
+#define DENSE_BLOCKSIZE 64
+
 void
 eigensolver(real *   a,
             int      n,
@@ -263,12 +270,26 @@ sparse_parallel_eigensolver(gmx_sparsematrix_t *    A,
 #endif
 
 
-void
-sparse_eigensolver(gmx_sparsematrix_t *    A,
-                   int                     neig,
-                   real *                  eigenvalues,
-                   real *                  eigenvectors,
-                   int                     maxiter)
+/*! \brief Function type for multiplying a vector with a matrix, y = A x */
+typedef void (*matrix_vector_multiply_t)(void *data, real *x, real *y);
+
+/*! \brief Determines neig eigenvalues and -vectors of the symmetric n*n
+ * matrix that is multiplied with by \p multiply, using the implicitly
+ * restarted Lanczos method in ARPACK.
+ *
+ * \p which selects the eigenvalues in ARPACK notation, e.g. "SA" for the
+ * smallest and "LA" for the largest algebraic eigenvalues. The eigenvalues
+ * are returned in ascending order.
+ */
+static void
+arpack_eigensolver(int                      n,
+                   matrix_vector_multiply_t multiply,
+                   void                    *data,
+                   const char              *which,
+                   int                      neig,
+                   real *                   eigenvalues,
+                   real *                   eigenvectors,
+                   int                      maxiter)
 {
     int      iwork[80];
     int      iparam[11];
@@ -277,21 +298,11 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
     real *   workd;
     real *   workl;
     real *   v;
-    int      n;
     int      ido, info, lworkl, i, ncv, dovec;
     real     abstol;
     int *    select;
     int      iter;
 
-#ifdef GMX_MPI_NOT
-    MPI_Comm_size( MPI_COMM_WORLD, &n );
-    if (n > 1)
-    {
-        sparse_parallel_eigensolver(A, neig, eigenvalues, eigenvectors, maxiter);
-        return;
-    }
-#endif
-
     if (eigenvectors != NULL)
     {
         dovec = 1;
@@ -301,7 +312,6 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
         dovec = 0;
     }
 
-    n   = A->nrow;
     ncv = 2*neig;
 
     if (ncv > n)
@@ -335,17 +345,17 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
     do
     {
 #ifdef GMX_DOUBLE
-        F77_FUNC(dsaupd, DSAUPD) (&ido, "I", &n, "SA", &neig, &abstol,
+        F77_FUNC(dsaupd, DSAUPD) (&ido, "I", &n, which, &neig, &abstol,
                                   resid, &ncv, v, &n, iparam, ipntr,
                                   workd, iwork, workl, &lworkl, &info);
 #else
-        F77_FUNC(ssaupd, SSAUPD) (&ido, "I", &n, "SA", &neig, &abstol,
+        F77_FUNC(ssaupd, SSAUPD) (&ido, "I", &n, which, &neig, &abstol,
                                   resid, &ncv, v, &n, iparam, ipntr,
                                   workd, iwork, workl, &lworkl, &info);
 #endif
         if (ido == -1 || ido == 1)
         {
-            gmx_sparsematrix_vector_multiply(A, workd+ipntr[0]-1, workd+ipntr[1]-1);
+            multiply(data, workd+ipntr[0]-1, workd+ipntr[1]-1);
         }
 
         fprintf(stderr, "\rIteration %4d: %3d out of %3d Ritz values converged.", iter++, iparam[4], neig);
@@ -371,12 +381,12 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
 
 #ifdef GMX_DOUBLE
     F77_FUNC(dseupd, DSEUPD) (&dovec, "A", select, eigenvalues, eigenvectors,
-                              &n, NULL, "I", &n, "SA", &neig, &abstol,
+                              &n, NULL, "I", &n, which, &neig, &abstol,
                               resid, &ncv, v, &n, iparam, ipntr,
                               workd, workl, &lworkl, &info);
 #else
     F77_FUNC(sseupd, SSEUPD) (&dovec, "A", select, eigenvalues, eigenvectors,
-                              &n, NULL, "I", &n, "SA", &neig, &abstol,
+                              &n, NULL, "I", &n, which, &neig, &abstol,
                               resid, &ncv, v, &n, iparam, ipntr,
                               workd, workl, &lworkl, &info);
 #endif
@@ -387,3 +397,108 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
     sfree(workl);
     sfree(select);
 }
+
+static void sparse_multiply(void *data, real *x, real *y)
+{
+    gmx_sparsematrix_vector_multiply(static_cast<gmx_sparsematrix_t *>(data), x, y);
+}
+
+void
+sparse_eigensolver(gmx_sparsematrix_t *    A,
+                   int                     neig,
+                   real *                  eigenvalues,
+                   real *                  eigenvectors,
+                   int                     maxiter)
+{
+#ifdef GMX_MPI_NOT
+    int n;
+
+    MPI_Comm_size( MPI_COMM_WORLD, &n );
+    if (n > 1)
+    {
+        sparse_parallel_eigensolver(A, neig, eigenvalues, eigenvectors, maxiter);
+        return;
+    }
+#endif
+
+    arpack_eigensolver(A->nrow, sparse_multiply, A, "SA",
+                       neig, eigenvalues, eigenvectors, maxiter);
+}
+
+/*! \brief Data for multiplying with a dense symmetric matrix */
+typedef struct
+{
+    const real *a;        /* The n*n matrix                   */
+    int         n;        /* Size of the matrix               */
+    int         nthreads; /* Number of OpenMP threads to use  */
+} dense_multiply_data_t;
+
+/* Multiplies x with minus the dense matrix, see dense_partial_eigensolver;
+ * each thread computes a block of y
+ */
+static void dense_multiply(void *data, real *x, real *y)
+{
+    const dense_multiply_data_t *d      = static_cast<dense_multiply_data_t *>(data);
+    const int                    n      = d->n;
+    const int                    nblock = (n + DENSE_BLOCKSIZE - 1)/DENSE_BLOCKSIZE;
+    int                          b;
+
+#pragma omp parallel for num_threads(d->nthreads) schedule(static)
+    for (b = 0; b < nblock; b++)
+    {
+        int   i0    = b*DENSE_BLOCKSIZE;
+        int   ni    = std::min(DENSE_BLOCKSIZE, n - i0);
+        int   nn    = n;
+        int   one   = 1;
+        real  alpha = -1;
+        real  beta  = 0;
+        real *ai    = const_cast<real *>(d->a) + static_cast<gmx_int64_t>(i0)*n;
+
+        /* Row i of the row-major matrix is column i in Fortran order */
+#ifdef GMX_DOUBLE
+        F77_FUNC(dgemv, DGEMV) ("T", &nn, &ni, &alpha, ai, &nn, x, &one, &beta, y + i0, &one);
+#else
+        F77_FUNC(sgemv, SGEMV) ("T", &nn, &ni, &alpha, ai, &nn, x, &one, &beta, y + i0, &one);
+#endif
+    }
+}
+
+void
+dense_partial_eigensolver(const real *   a,
+                          int            n,
+                          int            neig,
+                          real *         eigenvalues,
+                          real *         eigenvectors,
+                          int            maxiter,
+                          int            nthreads)
+{
+    dense_multiply_data_t data;
+
+    data.a        = a;
+    data.n        = n;
+    data.nthreads = std::max(1, nthreads);
+
+    /* The "LA" mode of our ARPACK translation can miss eigenvalues,
+     * so we use the well-tested "SA" mode on -a, as for sparse matrices.
+     */
+    const int nthreadsBlas = limit_blas_threads(data.nthreads);
+    arpack_eigensolver(n, dense_multiply, &data, "SA",
+                       neig, eigenvalues, eigenvectors, maxiter);
+    restore_blas_threads(data.nthreads, nthreadsBlas);
+
+    /* Convert the ascending eigenvalues of -a to ascending ones of a */
+    for (int i = 0; i < neig/2; i++)
+    {
+        std::swap(eigenvalues[i], eigenvalues[neig - 1 - i]);
+        if (eigenvectors != NULL)
+        {
+            std::swap_ranges(eigenvectors + static_cast<gmx_int64_t>(i)*n,
+                             eigenvectors + static_cast<gmx_int64_t>(i + 1)*n,
+                             eigenvectors + static_cast<gmx_int64_t>(neig - 1 - i)*n);
+        }
+    }
+    for (int i = 0; i < neig; i++)
+    {
+        eigenvalues[i] = -eigenvalues[i];
+    }
+}
@@ -91,6 +91,28 @@ sparse_eigensolver(gmx_sparsematrix_t *    A,
                    real *                  eigenvectors,
                    int                     maxiter);
 
+/*! \brief Dense matrix eigensolver for the largest eigenvalues.
+ *
+ *  Determines the neig largest eigenvalues of the symmetric n*n matrix a,
+ *  and if the eigenvectors pointer is non-NULL also the corresponding
+ *  eigenvectors, with the Lanczos method of ARPACK. Only matrix-vector
+ *  products with a are needed, which are divided over nthreads OpenMP
+ *  threads, so this is much faster than eigensolver() when neig is much
+ *  smaller than n. The matrix is not changed.
+ *
+ *  The eigenvalues are returned in ascending order in the first neig
+ *  elements of eigenvalues, the eigenvectors as rows of eigenvectors,
+ *  which should have size neig*n.
+ */
+void
+dense_partial_eigensolver(const real *   a,
+                          int            n,
+                          int            neig,
+                          real *         eigenvalues,
+                          real *         eigenvectors,
+                          int            maxiter,
+                          int            nthreads);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,11 +42,18 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
+#include "blasthreads.h"
+#include "gmx_blas.h"
 #include "gmx_lapack.h"
 
+/*! \brief Number of columns of the matrix updated as one block by a thread */
+#define SYRK_BLOCKSIZE 64
+
 double **alloc_matrix(int n, int m)
 {
     double **ptr;
@@ -245,3 +252,50 @@ double multi_regression(FILE *fp, int nrow, double *y, int ncol,
 
     return chi2;
 }
+
+void
+symmetric_rank_k_update(int            n,
+                        int            k,
+                        const real *   x,
+                        real *         c,
+                        int            nthreads)
+{
+    const int nblock = (n + SYRK_BLOCKSIZE - 1)/SYRK_BLOCKSIZE;
+    int       b;
+
+    if (k <= 0)
+    {
+        return;
+    }
+
+    /* In Fortran order x is an n*k matrix and the update of the lower
+     * triangle of c, which is the upper triangle in row-major order,
+     * is a syrk. We compute it as a gemm per block of columns of c,
+     * including only the rows on and below the diagonal block. The blocks
+     * do not overlap, so they can be divided over the threads.
+     * The first blocks have the most rows, so we use dynamic scheduling.
+     */
+    nthreads = std::max(1, nthreads);
+    const int nthreadsBlas = limit_blas_threads(nthreads);
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+    for (b = 0; b < nblock; b++)
+    {
+        int   i0    = b*SYRK_BLOCKSIZE;
+        int   ni    = std::min(SYRK_BLOCKSIZE, n - i0);
+        int   m     = n - i0;
+        int   nn    = n;
+        int   kk    = k;
+        real  alpha = 1;
+        real  beta  = 1;
+        real *xi    = const_cast<real *>(x) + i0;
+
+#ifdef GMX_DOUBLE
+        F77_FUNC(dgemm, DGEMM) ("N", "T", &m, &ni, &kk, &alpha, xi, &nn, xi, &nn,
+                                &beta, c + static_cast<gmx_int64_t>(i0)*n + i0, &nn);
+#else
+        F77_FUNC(sgemm, SGEMM) ("N", "T", &m, &ni, &kk, &alpha, xi, &nn, xi, &nn,
+                                &beta, c + static_cast<gmx_int64_t>(i0)*n + i0, &nn);
+#endif
+    }
+    restore_blas_threads(nthreads, nthreadsBlas);
+}
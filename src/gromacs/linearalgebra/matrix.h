@@ -39,6 +39,8 @@
 
 #include <stdio.h>
 
+#include "gromacs/utility/real.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -64,6 +66,14 @@ double multi_regression(FILE *fp, int ny, double *y,
  * If fp is not NULL debug information will be written to it.
  */
 
+void symmetric_rank_k_update(int n, int k, const real *x, real *c, int nthreads);
+/* Add the outer products of k vectors of length n, stored consecutively
+ * in x, to the n*n matrix c: c[i*n+j] += sum_f x[f*n+i]*x[f*n+j].
+ * Only the elements with j >= i are guaranteed to be updated; the others
+ * can be partly updated. The work is done with BLAS gemm calls on blocks
+ * of the matrix, which are divided over nthreads OpenMP threads.
+ */
+
 #ifdef __cplusplus
 }
 #endif
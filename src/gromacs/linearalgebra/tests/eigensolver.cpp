@@ -0,0 +1,139 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the dense matrix eigensolvers.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/linearalgebra/eigensolver.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/random.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief
+ * Returns a symmetric n*n covariance matrix of random data with
+ * variances that decrease along the dimensions, so the largest
+ * eigenvalues are well separated.
+ */
+std::vector<real> randomCovarianceMatrix(int n)
+{
+    const int         nframes = 4*n;
+    gmx_rng_t         rng     = gmx_rng_init(2468);
+    std::vector<real> x(nframes*n);
+    for (int f = 0; f < nframes; f++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            x[f*n + i] = std::exp(-0.2*i)*gmx_rng_gaussian_real(rng);
+        }
+    }
+    gmx_rng_destroy(rng);
+
+    std::vector<real> a(n*n);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            double sum = 0;
+            for (int f = 0; f < nframes; f++)
+            {
+                sum += x[f*n + i]*x[f*n + j];
+            }
+            a[i*n + j] = sum/nframes;
+        }
+    }
+    return a;
+}
+
+/*! \brief
+ * Checks dense_partial_eigensolver() against the full diagonalization
+ * with eigensolver().
+ */
+void checkPartialAgainstFull(int n, int neig, int nthreads)
+{
+    const std::vector<real> a = randomCovarianceMatrix(n);
+
+    std::vector<real>       afull(a);
+    std::vector<real>       eigenvaluesFull(n);
+    std::vector<real>       eigenvectorsFull(n*n);
+    eigensolver(&afull[0], n, 0, n, &eigenvaluesFull[0], &eigenvectorsFull[0]);
+
+    std::vector<real>       eigenvalues(n);
+    std::vector<real>       eigenvectors(neig*n);
+    dense_partial_eigensolver(&a[0], n, neig, &eigenvalues[0], &eigenvectors[0],
+                              100000, nthreads);
+
+    /* Both return the eigenvalues in ascending order */
+    for (int e = 0; e < neig; e++)
+    {
+        const int eFull = n - neig + e;
+
+        SCOPED_TRACE(testing::Message() << "Eigenvalue " << e);
+        EXPECT_REAL_EQ_TOL(eigenvaluesFull[eFull], eigenvalues[e],
+                           gmx::test::relativeToleranceAsFloatingPoint(eigenvaluesFull[n - 1], 1e-4));
+
+        /* The eigenvectors are normalized and can differ in sign */
+        double dot = 0;
+        for (int i = 0; i < n; i++)
+        {
+            dot += eigenvectorsFull[eFull*n + i]*eigenvectors[e*n + i];
+        }
+        EXPECT_REAL_EQ_TOL(1, std::fabs(dot),
+                           gmx::test::relativeToleranceAsFloatingPoint(1, 1e-3));
+    }
+}
+
+TEST(DensePartialEigensolverTest, MatchesFullEigensolver)
+{
+    checkPartialAgainstFull(60, 5, 1);
+}
+
+TEST(DensePartialEigensolverTest, MatchesFullEigensolverWithThreads)
+{
+    checkPartialAgainstFull(150, 8, 3);
+}
+
+} // namespace
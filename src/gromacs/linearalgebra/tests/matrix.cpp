@@ -0,0 +1,127 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the dense matrix routines.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/linearalgebra/matrix.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/random.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief
+ * Checks symmetric_rank_k_update() against a naive sum of outer products.
+ *
+ * The matrix size is not a multiple of the block size, so that also
+ * partial blocks are covered. The update is added to a non-zero matrix.
+ */
+void checkRankKUpdate(int n, int k, int nthreads)
+{
+    gmx_rng_t         rng = gmx_rng_init(4321);
+    std::vector<real> x(k*n);
+    std::vector<real> c(n*n);
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = gmx_rng_gaussian_real(rng);
+    }
+    for (size_t i = 0; i < c.size(); i++)
+    {
+        c[i] = gmx_rng_uniform_real(rng);
+    }
+    gmx_rng_destroy(rng);
+
+    std::vector<real> reference(c);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            double sum = 0;
+            for (int f = 0; f < k; f++)
+            {
+                sum += x[f*n + i]*x[f*n + j];
+            }
+            reference[i*n + j] += sum;
+        }
+    }
+
+    symmetric_rank_k_update(n, k, &x[0], &c[0], nthreads);
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = i; j < n; j++)
+        {
+            SCOPED_TRACE(testing::Message() << "Element " << i << " " << j);
+            EXPECT_REAL_EQ_TOL(reference[i*n + j], c[i*n + j],
+                               gmx::test::relativeToleranceAsFloatingPoint(k, 1e-5));
+        }
+    }
+}
+
+TEST(SymmetricRankKUpdateTest, MatchesNaiveSum)
+{
+    checkRankKUpdate(150, 7, 1);
+}
+
+TEST(SymmetricRankKUpdateTest, MatchesNaiveSumForSmallMatrix)
+{
+    checkRankKUpdate(5, 3, 1);
+}
+
+TEST(SymmetricRankKUpdateTest, MatchesNaiveSumWithThreads)
+{
+    checkRankKUpdate(150, 32, 3);
+}
+
+TEST(SymmetricRankKUpdateTest, DoesNothingWithoutVectors)
+{
+    std::vector<real> c(9, 1);
+    symmetric_rank_k_update(3, 0, NULL, &c[0], 1);
+    for (size_t i = 0; i < c.size(); i++)
+    {
+        EXPECT_EQ(1, c[i]);
+    }
+}
+
+} // namespace
@@ -460,12 +460,15 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                 {
                     try
                     {
-                        int start_th, end_th;
+                        int  start_th, end_th;
+                        int *settle_error_th;
 
                         if (th > 0)
                         {
                             clear_mat(constr->vir_r_m_dr_th[th]);
                         }
+                        settle_error_th  = (th == 0 ? &settle_error : &constr->settle_error[th]);
+                        *settle_error_th = -1;
 
                         start_th = (nsettle* th   )/nth;
                         end_th   = (nsettle*(th+1))/nth;
@@ -478,7 +481,12 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                                     x[0], xprime[0],
                                     invdt, v ? v[0] : NULL, calcvir_atom_end,
                                     th == 0 ? vir_r_m_dr : constr->vir_r_m_dr_th[th],
-                                    th == 0 ? &settle_error : &constr->settle_error[th]);
+                                    settle_error_th);
+                            /* Convert to an index in the full settle list */
+                            if (*settle_error_th >= 0)
+                            {
+                                *settle_error_th += start_th;
+                            }
                         }
                     }
                     GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
@@ -541,7 +549,10 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
         /* Combine virial and error info of the other threads */
         for (i = 1; i < nth; i++)
         {
-            settle_error = constr->settle_error[i];
+            if (constr->settle_error[i] >= 0)
+            {
+                settle_error = constr->settle_error[i];
+            }
         }
         if (vir != NULL)
         {
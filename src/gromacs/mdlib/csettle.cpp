@@ -43,9 +43,17 @@
 #include "gromacs/mdlib/constr.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/pbcutil/pbc-simd.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
+#if defined GMX_SIMD_HAVE_REAL
+/* We can process GMX_SIMD_REAL_WIDTH settles at once with SIMD */
+#define SETTLE_SIMD
+#endif
+
 typedef struct
 {
     real   mO;
@@ -167,34 +175,23 @@ static void check_cons(FILE *fp, char *title, real x[], int OW1, int HW2, int HW
 #endif
 
 
-void settle_proj(gmx_settledata_t settled, int econq,
-                 int nsettle, t_iatom iatoms[],
-                 const t_pbc *pbc,
-                 rvec x[],
-                 rvec *der, rvec *derp,
-                 int calcvir_atom_end, tensor vir_r_m_dder)
+static void settle_proj_scalar(const settleparam_t *p,
+                               int start, int end, const t_iatom iatoms[],
+                               const t_pbc *pbc,
+                               rvec x[],
+                               rvec *der, rvec *derp,
+                               int calcvir_atom_end, tensor vir_r_m_dder)
 {
     /* Settle for projection out constraint components
      * of derivatives of the coordinates.
      * Berk Hess 2008-1-10
      */
 
-    settleparam_t *p;
     real           imO, imH, dOH, dHH, invdOH, invdHH;
     matrix         invmat;
     int            i, m, m2, ow1, hw2, hw3;
     rvec           roh2, roh3, rhh, dc, fc;
 
-    calcvir_atom_end *= DIM;
-
-    if (econq == econqForce)
-    {
-        p = &settled->mass1;
-    }
-    else
-    {
-        p = &settled->massw;
-    }
     imO    = p->imO;
     imH    = p->imH;
     copy_mat(p->invmat, invmat);
@@ -207,7 +204,7 @@ void settle_proj(gmx_settledata_t settled, int econq,
 #pragma ivdep
 #endif
 
-    for (i = 0; i < nsettle; i++)
+    for (i = start; i < end; i++)
     {
         ow1 = iatoms[i*4+1];
         hw2 = iatoms[i*4+2];
@@ -275,13 +272,13 @@ void settle_proj(gmx_settledata_t settled, int econq,
 }
 
 
-void csettle(gmx_settledata_t settled,
-             int nsettle, t_iatom iatoms[],
-             const t_pbc *pbc,
-             real b4[], real after[],
-             real invdt, real *v, int CalcVirAtomEnd,
-             tensor vir_r_m_dr,
-             int *error)
+static void csettle_scalar(const settleparam_t *p,
+                           int start, int end, const t_iatom iatoms[],
+                           const t_pbc *pbc,
+                           real b4[], real after[],
+                           real invdt, real *v, int CalcVirAtomEnd,
+                           tensor vir_r_m_dr,
+                           int *error)
 {
     /* ***************************************************************** */
     /*                                                               ** */
@@ -295,7 +292,6 @@ void csettle(gmx_settledata_t settled,
     /* ***************************************************************** */
 
     /* Initialized data */
-    settleparam_t *p;
     real           wh, ra, rb, rc, irc2;
     real           mO, mH;
 
@@ -322,11 +318,6 @@ void csettle(gmx_settledata_t settled,
     rvec     doh2, doh3;
     int      is;
 
-    *error = -1;
-
-    CalcVirAtomEnd *= 3;
-
-    p     = &settled->massw;
     wh    = p->wh;
     rc    = p->rc;
     ra    = p->ra;
@@ -338,7 +329,7 @@ void csettle(gmx_settledata_t settled,
 #ifdef PRAGMAS
 #pragma ivdep
 #endif
-    for (i = 0; i < nsettle; ++i)
+    for (i = start; i < end; ++i)
     {
         bOK = TRUE;
         /*    --- Step1  A1' ---      */
@@ -606,3 +597,544 @@ void csettle(gmx_settledata_t settled,
 #endif
     }
 }
+
+#ifdef SETTLE_SIMD
+/* Gathers the coordinates of atoms at real offsets index[]
+ * for GMX_SIMD_REAL_WIDTH settles into SIMD registers.
+ */
+static gmx_inline void gmx_simdcall
+gather_rvec_settle(const real *x, const int *index, real *buf,
+                   gmx_simd_real_t *x_S, gmx_simd_real_t *y_S, gmx_simd_real_t *z_S)
+{
+    int i, m;
+
+    for (i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+    {
+        for (m = 0; m < DIM; m++)
+        {
+            buf[m*GMX_SIMD_REAL_WIDTH + i] = x[index[i] + m];
+        }
+    }
+    *x_S = gmx_simd_load_r(buf + 0*GMX_SIMD_REAL_WIDTH);
+    *y_S = gmx_simd_load_r(buf + 1*GMX_SIMD_REAL_WIDTH);
+    *z_S = gmx_simd_load_r(buf + 2*GMX_SIMD_REAL_WIDTH);
+}
+
+/* Adds the SIMD registers to the coordinates of atoms at real offsets
+ * index[] for GMX_SIMD_REAL_WIDTH settles. All indices should differ.
+ */
+static gmx_inline void gmx_simdcall
+scatter_add_rvec_settle(real *x, const int *index, real *buf,
+                        gmx_simd_real_t x_S, gmx_simd_real_t y_S, gmx_simd_real_t z_S)
+{
+    int i, m;
+
+    gmx_simd_store_r(buf + 0*GMX_SIMD_REAL_WIDTH, x_S);
+    gmx_simd_store_r(buf + 1*GMX_SIMD_REAL_WIDTH, y_S);
+    gmx_simd_store_r(buf + 2*GMX_SIMD_REAL_WIDTH, z_S);
+    for (i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+    {
+        for (m = 0; m < DIM; m++)
+        {
+            x[index[i] + m] += buf[m*GMX_SIMD_REAL_WIDTH + i];
+        }
+    }
+}
+
+/* Sets the real atom offsets of the atoms for GMX_SIMD_REAL_WIDTH settles
+ * starting at settle i and a mask which is 1 for settles that contribute
+ * to the virial and 0 otherwise.
+ */
+static gmx_inline void
+settle_simd_indices(const t_iatom iatoms[], int i, int calcvir_atom_end,
+                    int *ow1, int *hw2, int *hw3, real *vir_mask)
+{
+    int j;
+
+    for (j = 0; j < GMX_SIMD_REAL_WIDTH; j++)
+    {
+        ow1[j]      = iatoms[(i + j)*4 + 1]*DIM;
+        hw2[j]      = iatoms[(i + j)*4 + 2]*DIM;
+        hw3[j]      = iatoms[(i + j)*4 + 3]*DIM;
+        vir_mask[j] = (ow1[j] < calcvir_atom_end ? 1 : 0);
+    }
+}
+
+/* SIMD version of settle_proj_scalar for settles start to end,
+ * end - start should be a multiple of GMX_SIMD_REAL_WIDTH.
+ */
+static void settle_proj_simd(const settleparam_t *p,
+                             int start, int end, const t_iatom iatoms[],
+                             const t_pbc *pbc,
+                             rvec x[],
+                             rvec *der, rvec *derp,
+                             int calcvir_atom_end, tensor vir_r_m_dder)
+{
+    real            buf_unaligned[5*GMX_SIMD_REAL_WIDTH];
+    real           *buf, *vir_mask;
+    int             ow1[GMX_SIMD_REAL_WIDTH];
+    int             hw2[GMX_SIMD_REAL_WIDTH];
+    int             hw3[GMX_SIMD_REAL_WIDTH];
+    pbc_simd_t      pbc_simd;
+    gmx_simd_real_t vir_S[DIM][DIM];
+    int             i, m, m2;
+
+    /* Aligned buffers for gather/scatter and the virial mask */
+    buf      = gmx_simd_align_r(buf_unaligned);
+    vir_mask = buf + 3*GMX_SIMD_REAL_WIDTH;
+
+    set_pbc_simd(pbc, &pbc_simd);
+
+    for (m = 0; m < DIM; m++)
+    {
+        for (m2 = 0; m2 < DIM; m2++)
+        {
+            vir_S[m][m2] = gmx_simd_setzero_r();
+        }
+    }
+
+    for (i = start; i < end; i += GMX_SIMD_REAL_WIDTH)
+    {
+        gmx_simd_real_t xO, yO, zO, xH2, yH2, zH2, xH3, yH3, zH3;
+        gmx_simd_real_t roh2[DIM], roh3[DIM], rhh[DIM];
+        gmx_simd_real_t dc0, dc1, dc2, fc0, fc1, fc2, mask_S;
+
+        settle_simd_indices(iatoms, i, calcvir_atom_end, ow1, hw2, hw3, vir_mask);
+
+        gather_rvec_settle(x[0], ow1, buf, &xO, &yO, &zO);
+        gather_rvec_settle(x[0], hw2, buf, &xH2, &yH2, &zH2);
+        gather_rvec_settle(x[0], hw3, buf, &xH3, &yH3, &zH3);
+
+        roh2[XX] = gmx_simd_sub_r(xO, xH2);
+        roh2[YY] = gmx_simd_sub_r(yO, yH2);
+        roh2[ZZ] = gmx_simd_sub_r(zO, zH2);
+        pbc_correct_dx_simd(&roh2[XX], &roh2[YY], &roh2[ZZ], &pbc_simd);
+        roh3[XX] = gmx_simd_sub_r(xO, xH3);
+        roh3[YY] = gmx_simd_sub_r(yO, yH3);
+        roh3[ZZ] = gmx_simd_sub_r(zO, zH3);
+        pbc_correct_dx_simd(&roh3[XX], &roh3[YY], &roh3[ZZ], &pbc_simd);
+        rhh[XX]  = gmx_simd_sub_r(xH2, xH3);
+        rhh[YY]  = gmx_simd_sub_r(yH2, yH3);
+        rhh[ZZ]  = gmx_simd_sub_r(zH2, zH3);
+        pbc_correct_dx_simd(&rhh[XX], &rhh[YY], &rhh[ZZ], &pbc_simd);
+        for (m = 0; m < DIM; m++)
+        {
+            roh2[m] = gmx_simd_mul_r(roh2[m], gmx_simd_set1_r(p->invdOH));
+            roh3[m] = gmx_simd_mul_r(roh3[m], gmx_simd_set1_r(p->invdOH));
+            rhh[m]  = gmx_simd_mul_r(rhh[m], gmx_simd_set1_r(p->invdHH));
+        }
+
+        /* Determine the projections of der on the bonds */
+        gather_rvec_settle(der[0], ow1, buf, &xO, &yO, &zO);
+        gather_rvec_settle(der[0], hw2, buf, &xH2, &yH2, &zH2);
+        gather_rvec_settle(der[0], hw3, buf, &xH3, &yH3, &zH3);
+
+        dc0 = gmx_simd_mul_r(gmx_simd_sub_r(xO, xH2), roh2[XX]);
+        dc0 = gmx_simd_fmadd_r(gmx_simd_sub_r(yO, yH2), roh2[YY], dc0);
+        dc0 = gmx_simd_fmadd_r(gmx_simd_sub_r(zO, zH2), roh2[ZZ], dc0);
+        dc1 = gmx_simd_mul_r(gmx_simd_sub_r(xO, xH3), roh3[XX]);
+        dc1 = gmx_simd_fmadd_r(gmx_simd_sub_r(yO, yH3), roh3[YY], dc1);
+        dc1 = gmx_simd_fmadd_r(gmx_simd_sub_r(zO, zH3), roh3[ZZ], dc1);
+        dc2 = gmx_simd_mul_r(gmx_simd_sub_r(xH2, xH3), rhh[XX]);
+        dc2 = gmx_simd_fmadd_r(gmx_simd_sub_r(yH2, yH3), rhh[YY], dc2);
+        dc2 = gmx_simd_fmadd_r(gmx_simd_sub_r(zH2, zH3), rhh[ZZ], dc2);
+
+        /* Determine the correction for the three bonds */
+        fc0 = gmx_simd_mul_r(gmx_simd_set1_r(p->invmat[0][0]), dc0);
+        fc0 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[0][1]), dc1, fc0);
+        fc0 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[0][2]), dc2, fc0);
+        fc1 = gmx_simd_mul_r(gmx_simd_set1_r(p->invmat[1][0]), dc0);
+        fc1 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[1][1]), dc1, fc1);
+        fc1 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[1][2]), dc2, fc1);
+        fc2 = gmx_simd_mul_r(gmx_simd_set1_r(p->invmat[2][0]), dc0);
+        fc2 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[2][1]), dc1, fc2);
+        fc2 = gmx_simd_fmadd_r(gmx_simd_set1_r(p->invmat[2][2]), dc2, fc2);
+
+        /* Subtract the corrections from derp */
+        {
+            gmx_simd_real_t mimO = gmx_simd_set1_r(-p->imO);
+            gmx_simd_real_t mimH = gmx_simd_set1_r(-p->imH);
+            gmx_simd_real_t dO[DIM], dH2[DIM], dH3[DIM];
+
+            for (m = 0; m < DIM; m++)
+            {
+                dO[m]  = gmx_simd_mul_r(mimO, gmx_simd_fmadd_r(fc0, roh2[m], gmx_simd_mul_r(fc1, roh3[m])));
+                dH2[m] = gmx_simd_mul_r(mimH, gmx_simd_fmsub_r(fc2, rhh[m], gmx_simd_mul_r(fc0, roh2[m])));
+                dH3[m] = gmx_simd_mul_r(mimH, gmx_simd_fnmadd_r(fc2, rhh[m], gmx_simd_fnmadd_r(fc1, roh3[m], gmx_simd_setzero_r())));
+            }
+            scatter_add_rvec_settle(derp[0], ow1, buf, dO[XX], dO[YY], dO[ZZ]);
+            scatter_add_rvec_settle(derp[0], hw2, buf, dH2[XX], dH2[YY], dH2[ZZ]);
+            scatter_add_rvec_settle(derp[0], hw3, buf, dH3[XX], dH3[YY], dH3[ZZ]);
+        }
+
+        /* The virial contribution, fc contains the mass weighted corrections */
+        mask_S = gmx_simd_load_r(vir_mask);
+        fc0    = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, gmx_simd_set1_r(p->dOH)), fc0);
+        fc1    = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, gmx_simd_set1_r(p->dOH)), fc1);
+        fc2    = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, gmx_simd_set1_r(p->dHH)), fc2);
+        for (m = 0; m < DIM; m++)
+        {
+            for (m2 = m; m2 < DIM; m2++)
+            {
+                vir_S[m][m2] = gmx_simd_fmadd_r(gmx_simd_mul_r(roh2[m], roh2[m2]), fc0, vir_S[m][m2]);
+                vir_S[m][m2] = gmx_simd_fmadd_r(gmx_simd_mul_r(roh3[m], roh3[m2]), fc1, vir_S[m][m2]);
+                vir_S[m][m2] = gmx_simd_fmadd_r(gmx_simd_mul_r(rhh[m], rhh[m2]), fc2, vir_S[m][m2]);
+            }
+        }
+    }
+
+    for (m = 0; m < DIM; m++)
+    {
+        for (m2 = m; m2 < DIM; m2++)
+        {
+            real sum = gmx_simd_reduce_r(vir_S[m][m2]);
+
+            vir_r_m_dder[m][m2] += sum;
+            if (m2 > m)
+            {
+                vir_r_m_dder[m2][m] += sum;
+            }
+        }
+    }
+}
+
+/* SIMD version of csettle_scalar for settles start to end,
+ * end - start should be a multiple of GMX_SIMD_REAL_WIDTH.
+ * Blocks of settles containing one or more settles that can not
+ * be settled are passed to csettle_scalar, which flags the error.
+ */
+static void csettle_simd(const settleparam_t *p,
+                         int start, int end, const t_iatom iatoms[],
+                         const t_pbc *pbc,
+                         real b4[], real after[],
+                         real invdt, real *v, int calcvir_atom_end,
+                         tensor vir_r_m_dr,
+                         int *error)
+{
+    real            buf_unaligned[5*GMX_SIMD_REAL_WIDTH];
+    real           *buf, *vir_mask;
+    int             ow1[GMX_SIMD_REAL_WIDTH];
+    int             hw2[GMX_SIMD_REAL_WIDTH];
+    int             hw3[GMX_SIMD_REAL_WIDTH];
+    pbc_simd_t      pbc_simd;
+    gmx_simd_real_t vir_S[DIM][DIM];
+    gmx_simd_real_t zero_S, one_S;
+    gmx_simd_real_t wh_S, ra_S, rb_S, rc_S, irc2_S, invra_S, mO_S, mH_S;
+    int             i, m, m2;
+
+    /* Aligned buffers for gather/scatter and the virial mask */
+    buf      = gmx_simd_align_r(buf_unaligned);
+    vir_mask = buf + 3*GMX_SIMD_REAL_WIDTH;
+
+    set_pbc_simd(pbc, &pbc_simd);
+
+    zero_S  = gmx_simd_setzero_r();
+    one_S   = gmx_simd_set1_r(1.0);
+    wh_S    = gmx_simd_set1_r(p->wh);
+    ra_S    = gmx_simd_set1_r(p->ra);
+    rb_S    = gmx_simd_set1_r(p->rb);
+    rc_S    = gmx_simd_set1_r(p->rc);
+    irc2_S  = gmx_simd_set1_r(p->irc2);
+    invra_S = gmx_simd_set1_r(gmx_invsqrt(p->ra*p->ra));
+    mO_S    = gmx_simd_set1_r(p->mO);
+    mH_S    = gmx_simd_set1_r(p->mH);
+
+    for (m = 0; m < DIM; m++)
+    {
+        for (m2 = 0; m2 < DIM; m2++)
+        {
+            vir_S[m][m2] = zero_S;
+        }
+    }
+
+    for (i = start; i < end; i += GMX_SIMD_REAL_WIDTH)
+    {
+        gmx_simd_real_t xO, yO, zO, xH2, yH2, zH2, xH3, yH3, zH3;
+        gmx_simd_real_t xb0, yb0, zb0, xc0, yc0, zc0;
+        gmx_simd_real_t xa1, ya1, za1, xb1, yb1, zb1, xc1, yc1, zc1;
+        gmx_simd_real_t xakszd, yakszd, zakszd, xaksxd, yaksxd, zaksxd;
+        gmx_simd_real_t xaksyd, yaksyd, zaksyd, axlng, aylng, azlng;
+        gmx_simd_real_t trns11, trns21, trns31, trns12, trns22, trns32;
+        gmx_simd_real_t trns13, trns23, trns33;
+        gmx_simd_real_t xb0d, yb0d, xc0d, yc0d, za1d, xb1d, yb1d, zb1d;
+        gmx_simd_real_t xc1d, yc1d, zc1d;
+        gmx_simd_real_t sinphi, cosphi, sinpsi, cospsi, tmp, tmp2;
+        gmx_simd_real_t ya2d, xb2d, yb2d, yc2d, t1, t2;
+        gmx_simd_real_t alpa, beta, gama, al2be2, sinthe, costhe;
+        gmx_simd_real_t xa3d, ya3d, xb3d, yb3d, xc3d, yc3d;
+        gmx_simd_real_t da[DIM], db[DIM], dc[DIM], mask_S;
+        gmx_simd_bool_t bBad;
+
+        settle_simd_indices(iatoms, i, calcvir_atom_end, ow1, hw2, hw3, vir_mask);
+
+        /*    --- Step1  A1' ---      */
+        gather_rvec_settle(b4, ow1, buf, &xO, &yO, &zO);
+        gather_rvec_settle(b4, hw2, buf, &xH2, &yH2, &zH2);
+        gather_rvec_settle(b4, hw3, buf, &xH3, &yH3, &zH3);
+        xb0 = gmx_simd_sub_r(xH2, xO);
+        yb0 = gmx_simd_sub_r(yH2, yO);
+        zb0 = gmx_simd_sub_r(zH2, zO);
+        pbc_correct_dx_simd(&xb0, &yb0, &zb0, &pbc_simd);
+        xc0 = gmx_simd_sub_r(xH3, xO);
+        yc0 = gmx_simd_sub_r(yH3, yO);
+        zc0 = gmx_simd_sub_r(zH3, zO);
+        pbc_correct_dx_simd(&xc0, &yc0, &zc0, &pbc_simd);
+
+        /* Keep the old oxygen position for the virial */
+        gather_rvec_settle(after, hw2, buf, &xH2, &yH2, &zH2);
+        gather_rvec_settle(after, hw3, buf, &xH3, &yH3, &zH3);
+        gather_rvec_settle(after, ow1, buf, &xb1, &yb1, &zb1);
+        xH2 = gmx_simd_sub_r(xH2, xb1);
+        yH2 = gmx_simd_sub_r(yH2, yb1);
+        zH2 = gmx_simd_sub_r(zH2, zb1);
+        pbc_correct_dx_simd(&xH2, &yH2, &zH2, &pbc_simd);
+        xH3 = gmx_simd_sub_r(xH3, xb1);
+        yH3 = gmx_simd_sub_r(yH3, yb1);
+        zH3 = gmx_simd_sub_r(zH3, zb1);
+        pbc_correct_dx_simd(&xH3, &yH3, &zH3, &pbc_simd);
+
+        /* As in the scalar code, we compute the center of mass
+         * from the O-H distances. We only need the positions
+         * relative to the center of mass, since we update
+         * the positions with the displacements below.
+         */
+        xa1 = gmx_simd_mul_r(gmx_simd_add_r(xH2, xH3), gmx_simd_sub_r(zero_S, wh_S));
+        ya1 = gmx_simd_mul_r(gmx_simd_add_r(yH2, yH3), gmx_simd_sub_r(zero_S, wh_S));
+        za1 = gmx_simd_mul_r(gmx_simd_add_r(zH2, zH3), gmx_simd_sub_r(zero_S, wh_S));
+
+        xb1 = gmx_simd_add_r(xH2, xa1);
+        yb1 = gmx_simd_add_r(yH2, ya1);
+        zb1 = gmx_simd_add_r(zH2, za1);
+        xc1 = gmx_simd_add_r(xH3, xa1);
+        yc1 = gmx_simd_add_r(yH3, ya1);
+        zc1 = gmx_simd_add_r(zH3, za1);
+
+        xakszd = gmx_simd_fmsub_r(yb0, zc0, gmx_simd_mul_r(zb0, yc0));
+        yakszd = gmx_simd_fmsub_r(zb0, xc0, gmx_simd_mul_r(xb0, zc0));
+        zakszd = gmx_simd_fmsub_r(xb0, yc0, gmx_simd_mul_r(yb0, xc0));
+        xaksxd = gmx_simd_fmsub_r(ya1, zakszd, gmx_simd_mul_r(za1, yakszd));
+        yaksxd = gmx_simd_fmsub_r(za1, xakszd, gmx_simd_mul_r(xa1, zakszd));
+        zaksxd = gmx_simd_fmsub_r(xa1, yakszd, gmx_simd_mul_r(ya1, xakszd));
+        xaksyd = gmx_simd_fmsub_r(yakszd, zaksxd, gmx_simd_mul_r(zakszd, yaksxd));
+        yaksyd = gmx_simd_fmsub_r(zakszd, xaksxd, gmx_simd_mul_r(xakszd, zaksxd));
+        zaksyd = gmx_simd_fmsub_r(xakszd, yaksxd, gmx_simd_mul_r(yakszd, xaksxd));
+
+        axlng = gmx_simd_invsqrt_r(gmx_simd_fmadd_r(xaksxd, xaksxd, gmx_simd_fmadd_r(yaksxd, yaksxd, gmx_simd_mul_r(zaksxd, zaksxd))));
+        aylng = gmx_simd_invsqrt_r(gmx_simd_fmadd_r(xaksyd, xaksyd, gmx_simd_fmadd_r(yaksyd, yaksyd, gmx_simd_mul_r(zaksyd, zaksyd))));
+        azlng = gmx_simd_invsqrt_r(gmx_simd_fmadd_r(xakszd, xakszd, gmx_simd_fmadd_r(yakszd, yakszd, gmx_simd_mul_r(zakszd, zakszd))));
+
+        trns11 = gmx_simd_mul_r(xaksxd, axlng);
+        trns21 = gmx_simd_mul_r(yaksxd, axlng);
+        trns31 = gmx_simd_mul_r(zaksxd, axlng);
+        trns12 = gmx_simd_mul_r(xaksyd, aylng);
+        trns22 = gmx_simd_mul_r(yaksyd, aylng);
+        trns32 = gmx_simd_mul_r(zaksyd, aylng);
+        trns13 = gmx_simd_mul_r(xakszd, azlng);
+        trns23 = gmx_simd_mul_r(yakszd, azlng);
+        trns33 = gmx_simd_mul_r(zakszd, azlng);
+
+        xb0d = gmx_simd_fmadd_r(trns11, xb0, gmx_simd_fmadd_r(trns21, yb0, gmx_simd_mul_r(trns31, zb0)));
+        yb0d = gmx_simd_fmadd_r(trns12, xb0, gmx_simd_fmadd_r(trns22, yb0, gmx_simd_mul_r(trns32, zb0)));
+        xc0d = gmx_simd_fmadd_r(trns11, xc0, gmx_simd_fmadd_r(trns21, yc0, gmx_simd_mul_r(trns31, zc0)));
+        yc0d = gmx_simd_fmadd_r(trns12, xc0, gmx_simd_fmadd_r(trns22, yc0, gmx_simd_mul_r(trns32, zc0)));
+        za1d = gmx_simd_fmadd_r(trns13, xa1, gmx_simd_fmadd_r(trns23, ya1, gmx_simd_mul_r(trns33, za1)));
+        xb1d = gmx_simd_fmadd_r(trns11, xb1, gmx_simd_fmadd_r(trns21, yb1, gmx_simd_mul_r(trns31, zb1)));
+        yb1d = gmx_simd_fmadd_r(trns12, xb1, gmx_simd_fmadd_r(trns22, yb1, gmx_simd_mul_r(trns32, zb1)));
+        zb1d = gmx_simd_fmadd_r(trns13, xb1, gmx_simd_fmadd_r(trns23, yb1, gmx_simd_mul_r(trns33, zb1)));
+        xc1d = gmx_simd_fmadd_r(trns11, xc1, gmx_simd_fmadd_r(trns21, yc1, gmx_simd_mul_r(trns31, zc1)));
+        yc1d = gmx_simd_fmadd_r(trns12, xc1, gmx_simd_fmadd_r(trns22, yc1, gmx_simd_mul_r(trns32, zc1)));
+        zc1d = gmx_simd_fmadd_r(trns13, xc1, gmx_simd_fmadd_r(trns23, yc1, gmx_simd_mul_r(trns33, zc1)));
+
+        sinphi = gmx_simd_mul_r(za1d, invra_S);
+        tmp    = gmx_simd_fnmadd_r(sinphi, sinphi, one_S);
+        bBad   = gmx_simd_cmple_r(tmp, zero_S);
+        /* Avoid invalid operations for lanes we will not use */
+        tmp2   = gmx_simd_invsqrt_r(gmx_simd_blendv_r(tmp, one_S, bBad));
+        cosphi = gmx_simd_mul_r(tmp, tmp2);
+        sinpsi = gmx_simd_mul_r(gmx_simd_mul_r(gmx_simd_sub_r(zb1d, zc1d), irc2_S), tmp2);
+        tmp2   = gmx_simd_fnmadd_r(sinpsi, sinpsi, one_S);
+        bBad   = gmx_simd_or_b(bBad, gmx_simd_cmple_r(tmp2, zero_S));
+
+        if (gmx_simd_anytrue_b(bBad))
+        {
+            /* Let the scalar code handle (and report) this block */
+            csettle_scalar(p, i, i + GMX_SIMD_REAL_WIDTH, iatoms, pbc,
+                           b4, after, invdt, v, calcvir_atom_end,
+                           vir_r_m_dr, error);
+            continue;
+        }
+        cospsi = gmx_simd_mul_r(tmp2, gmx_simd_invsqrt_r(tmp2));
+
+        ya2d = gmx_simd_mul_r(ra_S, cosphi);
+        xb2d = gmx_simd_mul_r(gmx_simd_sub_r(zero_S, rc_S), cospsi);
+        t1   = gmx_simd_mul_r(gmx_simd_sub_r(zero_S, rb_S), cosphi);
+        t2   = gmx_simd_mul_r(gmx_simd_mul_r(rc_S, sinpsi), sinphi);
+        yb2d = gmx_simd_sub_r(t1, t2);
+        yc2d = gmx_simd_add_r(t1, t2);
+
+        /*     --- Step3  al,be,ga            --- */
+        alpa   = gmx_simd_fmadd_r(xb2d, gmx_simd_sub_r(xb0d, xc0d),
+                                  gmx_simd_fmadd_r(yb0d, yb2d, gmx_simd_mul_r(yc0d, yc2d)));
+        beta   = gmx_simd_fmadd_r(xb2d, gmx_simd_sub_r(yc0d, yb0d),
+                                  gmx_simd_fmadd_r(xb0d, yb2d, gmx_simd_mul_r(xc0d, yc2d)));
+        gama   = gmx_simd_fmsub_r(xb0d, yb1d, gmx_simd_mul_r(xb1d, yb0d));
+        gama   = gmx_simd_add_r(gama, gmx_simd_fmsub_r(xc0d, yc1d, gmx_simd_mul_r(xc1d, yc0d)));
+        al2be2 = gmx_simd_fmadd_r(alpa, alpa, gmx_simd_mul_r(beta, beta));
+        tmp2   = gmx_simd_fnmadd_r(gama, gama, al2be2);
+        sinthe = gmx_simd_fmsub_r(alpa, gama,
+                                  gmx_simd_mul_r(beta, gmx_simd_mul_r(tmp2, gmx_simd_invsqrt_r(tmp2))));
+        sinthe = gmx_simd_mul_r(sinthe, gmx_simd_invsqrt_r(gmx_simd_mul_r(al2be2, al2be2)));
+
+        /*  --- Step4  A3' --- */
+        tmp2   = gmx_simd_fnmadd_r(sinthe, sinthe, one_S);
+        costhe = gmx_simd_mul_r(tmp2, gmx_simd_invsqrt_r(tmp2));
+        xa3d   = gmx_simd_mul_r(gmx_simd_sub_r(zero_S, ya2d), sinthe);
+        ya3d   = gmx_simd_mul_r(ya2d, costhe);
+        xb3d   = gmx_simd_fmsub_r(xb2d, costhe, gmx_simd_mul_r(yb2d, sinthe));
+        yb3d   = gmx_simd_fmadd_r(xb2d, sinthe, gmx_simd_mul_r(yb2d, costhe));
+        xc3d   = gmx_simd_fnmadd_r(xb2d, costhe, gmx_simd_mul_r(gmx_simd_sub_r(zero_S, yc2d), sinthe));
+        yc3d   = gmx_simd_fnmadd_r(xb2d, sinthe, gmx_simd_mul_r(yc2d, costhe));
+
+        /*    --- Step5  A3 --- */
+        /* The z-components in the rotated frame do not change */
+        da[XX] = gmx_simd_fmadd_r(trns11, xa3d, gmx_simd_fmadd_r(trns12, ya3d, gmx_simd_mul_r(trns13, za1d)));
+        da[YY] = gmx_simd_fmadd_r(trns21, xa3d, gmx_simd_fmadd_r(trns22, ya3d, gmx_simd_mul_r(trns23, za1d)));
+        da[ZZ] = gmx_simd_fmadd_r(trns31, xa3d, gmx_simd_fmadd_r(trns32, ya3d, gmx_simd_mul_r(trns33, za1d)));
+        db[XX] = gmx_simd_fmadd_r(trns11, xb3d, gmx_simd_fmadd_r(trns12, yb3d, gmx_simd_mul_r(trns13, zb1d)));
+        db[YY] = gmx_simd_fmadd_r(trns21, xb3d, gmx_simd_fmadd_r(trns22, yb3d, gmx_simd_mul_r(trns23, zb1d)));
+        db[ZZ] = gmx_simd_fmadd_r(trns31, xb3d, gmx_simd_fmadd_r(trns32, yb3d, gmx_simd_mul_r(trns33, zb1d)));
+        dc[XX] = gmx_simd_fmadd_r(trns11, xc3d, gmx_simd_fmadd_r(trns12, yc3d, gmx_simd_mul_r(trns13, zc1d)));
+        dc[YY] = gmx_simd_fmadd_r(trns21, xc3d, gmx_simd_fmadd_r(trns22, yc3d, gmx_simd_mul_r(trns23, zc1d)));
+        dc[ZZ] = gmx_simd_fmadd_r(trns31, xc3d, gmx_simd_fmadd_r(trns32, yc3d, gmx_simd_mul_r(trns33, zc1d)));
+
+        /* The displacements */
+        da[XX] = gmx_simd_sub_r(da[XX], xa1);
+        da[YY] = gmx_simd_sub_r(da[YY], ya1);
+        da[ZZ] = gmx_simd_sub_r(da[ZZ], za1);
+        db[XX] = gmx_simd_sub_r(db[XX], xb1);
+        db[YY] = gmx_simd_sub_r(db[YY], yb1);
+        db[ZZ] = gmx_simd_sub_r(db[ZZ], zb1);
+        dc[XX] = gmx_simd_sub_r(dc[XX], xc1);
+        dc[YY] = gmx_simd_sub_r(dc[YY], yc1);
+        dc[ZZ] = gmx_simd_sub_r(dc[ZZ], zc1);
+
+        scatter_add_rvec_settle(after, ow1, buf, da[XX], da[YY], da[ZZ]);
+        scatter_add_rvec_settle(after, hw2, buf, db[XX], db[YY], db[ZZ]);
+        scatter_add_rvec_settle(after, hw3, buf, dc[XX], dc[YY], dc[ZZ]);
+
+        if (v != NULL)
+        {
+            gmx_simd_real_t invdt_S = gmx_simd_set1_r(invdt);
+
+            scatter_add_rvec_settle(v, ow1, buf,
+                                    gmx_simd_mul_r(da[XX], invdt_S),
+                                    gmx_simd_mul_r(da[YY], invdt_S),
+                                    gmx_simd_mul_r(da[ZZ], invdt_S));
+            scatter_add_rvec_settle(v, hw2, buf,
+                                    gmx_simd_mul_r(db[XX], invdt_S),
+                                    gmx_simd_mul_r(db[YY], invdt_S),
+                                    gmx_simd_mul_r(db[ZZ], invdt_S));
+            scatter_add_rvec_settle(v, hw3, buf,
+                                    gmx_simd_mul_r(dc[XX], invdt_S),
+                                    gmx_simd_mul_r(dc[YY], invdt_S),
+                                    gmx_simd_mul_r(dc[ZZ], invdt_S));
+        }
+
+        /* The virial contribution, using the old oxygen position */
+        {
+            gmx_simd_real_t rO[DIM], rb[DIM], rc[DIM];
+
+            gather_rvec_settle(b4, ow1, buf, &rO[XX], &rO[YY], &rO[ZZ]);
+            rb[XX] = gmx_simd_add_r(rO[XX], xb0);
+            rb[YY] = gmx_simd_add_r(rO[YY], yb0);
+            rb[ZZ] = gmx_simd_add_r(rO[ZZ], zb0);
+            rc[XX] = gmx_simd_add_r(rO[XX], xc0);
+            rc[YY] = gmx_simd_add_r(rO[YY], yc0);
+            rc[ZZ] = gmx_simd_add_r(rO[ZZ], zc0);
+
+            mask_S = gmx_simd_load_r(vir_mask);
+            for (m2 = 0; m2 < DIM; m2++)
+            {
+                da[m2] = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, mO_S), da[m2]);
+                db[m2] = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, mH_S), db[m2]);
+                dc[m2] = gmx_simd_mul_r(gmx_simd_mul_r(mask_S, mH_S), dc[m2]);
+            }
+            for (m = 0; m < DIM; m++)
+            {
+                for (m2 = 0; m2 < DIM; m2++)
+                {
+                    vir_S[m][m2] = gmx_simd_fmadd_r(rO[m], da[m2], vir_S[m][m2]);
+                    vir_S[m][m2] = gmx_simd_fmadd_r(rb[m], db[m2], vir_S[m][m2]);
+                    vir_S[m][m2] = gmx_simd_fmadd_r(rc[m], dc[m2], vir_S[m][m2]);
+                }
+            }
+        }
+    }
+
+    for (m = 0; m < DIM; m++)
+    {
+        for (m2 = 0; m2 < DIM; m2++)
+        {
+            vir_r_m_dr[m][m2] -= gmx_simd_reduce_r(vir_S[m][m2]);
+        }
+    }
+}
+#endif /* SETTLE_SIMD */
+
+
+void settle_proj(gmx_settledata_t settled, int econq,
+                 int nsettle, t_iatom iatoms[],
+                 const t_pbc *pbc,
+                 rvec x[],
+                 rvec *der, rvec *derp,
+                 int calcvir_atom_end, tensor vir_r_m_dder)
+{
+    const settleparam_t *p;
+    int                  nsettle_simd;
+
+    calcvir_atom_end *= DIM;
+
+    if (econq == econqForce)
+    {
+        p = &settled->mass1;
+    }
+    else
+    {
+        p = &settled->massw;
+    }
+
+#ifdef SETTLE_SIMD
+    nsettle_simd = (nsettle/GMX_SIMD_REAL_WIDTH)*GMX_SIMD_REAL_WIDTH;
+    settle_proj_simd(p, 0, nsettle_simd, iatoms, pbc, x, der, derp,
+                     calcvir_atom_end, vir_r_m_dder);
+#else
+    nsettle_simd = 0;
+#endif
+    settle_proj_scalar(p, nsettle_simd, nsettle, iatoms, pbc, x, der, derp,
+                       calcvir_atom_end, vir_r_m_dder);
+}
+
+void csettle(gmx_settledata_t settled,
+             int nsettle, t_iatom iatoms[],
+             const t_pbc *pbc,
+             real b4[], real after[],
+             real invdt, real *v, int CalcVirAtomEnd,
+             tensor vir_r_m_dr,
+             int *error)
+{
+    int nsettle_simd;
+
+    *error = -1;
+
+    CalcVirAtomEnd *= DIM;
+
+#ifdef SETTLE_SIMD
+    nsettle_simd = (nsettle/GMX_SIMD_REAL_WIDTH)*GMX_SIMD_REAL_WIDTH;
+    csettle_simd(&settled->massw, 0, nsettle_simd, iatoms, pbc,
+                 b4, after, invdt, v, CalcVirAtomEnd, vir_r_m_dr, error);
+#else
+    nsettle_simd = 0;
+#endif
+    csettle_scalar(&settled->massw, nsettle_simd, nsettle, iatoms, pbc,
+                   b4, after, invdt, v, CalcVirAtomEnd, vir_r_m_dr, error);
+}
@@ -114,6 +114,107 @@ void ns(FILE              *fp,
     }
 }
 
+/* Output of the PME mesh part when computed as a separate task */
+struct pme_mesh_task_t
+{
+    gmx_bool bDone;   /* The mesh part of this step has been computed */
+    real     Vlr_q;   /* Coulomb mesh energy */
+    real     Vlr_lj;  /* LJ mesh energy */
+    real     dvdl_q;  /* Coulomb mesh dV/dlambda */
+    real     dvdl_lj; /* LJ mesh dV/dlambda */
+    matrix   vir_q;   /* Coulomb mesh virial */
+    matrix   vir_lj;  /* LJ mesh virial */
+    float    cycles;  /* Cycles spent in the mesh task */
+    t_nrnb   nrnb;    /* Flop counts of the mesh task, added afterwards */
+};
+
+/* Returns the gmx_pme_do flags for force flags \p flags */
+static int pme_mesh_flags(const t_forcerec *fr, int flags)
+{
+    int pme_flags = GMX_PME_SPREAD | GMX_PME_SOLVE;
+
+    if (EEL_PME(fr->eeltype))
+    {
+        pme_flags |= GMX_PME_DO_COULOMB;
+    }
+    if (EVDW_PME(fr->vdwtype))
+    {
+        pme_flags |= GMX_PME_DO_LJ;
+    }
+    if (flags & GMX_FORCE_FORCES)
+    {
+        pme_flags |= GMX_PME_CALC_F;
+    }
+    if (flags & GMX_FORCE_VIRIAL)
+    {
+        pme_flags |= GMX_PME_CALC_ENER_VIR;
+    }
+    if (fr->n_tpi > 0)
+    {
+        /* We don't calculate f, but we do want the potential */
+        pme_flags |= GMX_PME_CALC_POT;
+    }
+
+    return pme_flags;
+}
+
+void init_pme_mesh_task(t_forcerec *fr)
+{
+    snew(fr->pme_task, 1);
+}
+
+gmx_bool pme_mesh_is_needed(const t_forcerec *fr, const t_commrec *cr,
+                            int flags)
+{
+    gmx_bool bMtsSep = (fr->bMtsLongRange && (flags & GMX_FORCE_SEPLRF));
+
+    return ((EEL_PME(fr->eeltype) || EVDW_PME(fr->vdwtype)) &&
+            (cr->duty & DUTY_PME) &&
+            (!bMtsSep || (flags & GMX_FORCE_DO_LR)));
+}
+
+void do_force_pme_mesh_task(t_forcerec *fr, t_commrec *cr,
+                            gmx_wallcycle_t wcycle,
+                            t_mdatoms *md, rvec x[], rvec f_mesh[],
+                            matrix box, real *lambda, int flags)
+{
+    pme_mesh_task_t *pt;
+    int              status;
+
+    pt = fr->pme_task;
+
+    pt->Vlr_q   = 0;
+    pt->Vlr_lj  = 0;
+    pt->dvdl_q  = 0;
+    pt->dvdl_lj = 0;
+    clear_mat(pt->vir_q);
+    clear_mat(pt->vir_lj);
+    init_nrnb(&pt->nrnb);
+
+    wallcycle_start(wcycle, ewcPMEMESH_TASK);
+    status = gmx_pme_do(fr->pmedata,
+                        0, md->homenr,
+                        x, f_mesh,
+                        md->chargeA, md->chargeB,
+                        md->sqrt_c6A, md->sqrt_c6B,
+                        md->sigmaA, md->sigmaB,
+                        box, cr, 0, 0,
+                        &pt->nrnb, wcycle,
+                        pt->vir_q, fr->ewaldcoeff_q,
+                        pt->vir_lj, fr->ewaldcoeff_lj,
+                        &pt->Vlr_q, &pt->Vlr_lj,
+                        lambda[efptCOUL], lambda[efptVDW],
+                        &pt->dvdl_q, &pt->dvdl_lj,
+                        pme_mesh_flags(fr, flags));
+    pt->cycles = wallcycle_stop(wcycle, ewcPMEMESH_TASK);
+    if (status != 0)
+    {
+        gmx_fatal(FARGS, "Error %d in reciprocal PME routine", status);
+    }
+
+    pt->bDone = TRUE;
+}
+
 static void reduce_thread_energies(tensor vir_q, tensor vir_lj,
                                    real *Vcorr_q, real *Vcorr_lj,
                                    real *dvdl_q, real *dvdl_lj,
@@ -396,6 +497,18 @@ void do_force_lowlevel(t_forcerec *fr,      t_inputrec *ir,
         real Vlr_q             = 0, Vlr_lj = 0, Vcorr_q = 0, Vcorr_lj = 0;
         real dvdl_long_range_q = 0, dvdl_long_range_lj = 0;
 
+        gmx_bool bMtsSep, bDoMesh;
+        rvec    *f_mesh;
+
+        /* With multiple time stepping the mesh part is only computed when
+         * the long-range forces are requested and its forces are stored
+         * separately in f_longrange. Callers that do not separate
+         * the long-range forces get the mesh part at every call.
+         */
+        bMtsSep = (fr->bMtsLongRange && (flags & GMX_FORCE_SEPLRF));
+        bDoMesh = (!bMtsSep || (flags & GMX_FORCE_DO_LR));
+        f_mesh  = (bMtsSep ? f_longrange : fr->f_novirsum);
+
         bSB = (ir->nwall == 2);
         if (bSB)
         {
@@ -506,38 +619,35 @@ void do_force_lowlevel(t_forcerec *fr,      t_inputrec *ir,
             enerd->dvdl_lin[efptCOUL] += dvdl_long_range_correction_q;
             enerd->dvdl_lin[efptVDW]  += dvdl_long_range_correction_lj;
 
-            if ((EEL_PME(fr->eeltype) || EVDW_PME(fr->vdwtype)) && (cr->duty & DUTY_PME))
+            if ((EEL_PME(fr->eeltype) || EVDW_PME(fr->vdwtype)) && (cr->duty & DUTY_PME) &&
+                bDoMesh)
             {
                 /* Do reciprocal PME for Coulomb and/or LJ. */
                 assert(fr->n_tpi >= 0);
-                if (fr->n_tpi == 0 || (flags & GMX_FORCE_STATECHANGED))
+                if (fr->pme_task != NULL && fr->pme_task->bDone)
                 {
-                    pme_flags = GMX_PME_SPREAD | GMX_PME_SOLVE;
-                    if (EEL_PME(fr->eeltype))
-                    {
-                        pme_flags     |= GMX_PME_DO_COULOMB;
-                    }
-                    if (EVDW_PME(fr->vdwtype))
-                    {
-                        pme_flags |= GMX_PME_DO_LJ;
-                    }
-                    if (flags & GMX_FORCE_FORCES)
-                    {
-                        pme_flags |= GMX_PME_CALC_F;
-                    }
-                    if (flags & GMX_FORCE_VIRIAL)
-                    {
-                        pme_flags |= GMX_PME_CALC_ENER_VIR;
-                    }
-                    if (fr->n_tpi > 0)
-                    {
-                        /* We don't calculate f, but we do want the potential */
-                        pme_flags |= GMX_PME_CALC_POT;
-                    }
+                    /* The mesh part was computed by do_force_pme_mesh_task,
+                     * concurrently with the other forces.
+                     */
+                    pme_mesh_task_t *pt = fr->pme_task;
+
+                    Vlr_q              = pt->Vlr_q;
+                    Vlr_lj             = pt->Vlr_lj;
+                    dvdl_long_range_q  = pt->dvdl_q;
+                    dvdl_long_range_lj = pt->dvdl_lj;
+                    m_add(fr->vir_el_recip, pt->vir_q, fr->vir_el_recip);
+                    m_add(fr->vir_lj_recip, pt->vir_lj, fr->vir_lj_recip);
+                    *cycles_pme        = pt->cycles;
+                    add_nrnb(nrnb, nrnb, &pt->nrnb);
+                    pt->bDone          = FALSE;
+                }
+                else if (fr->n_tpi == 0 || (flags & GMX_FORCE_STATECHANGED))
+                {
+                    pme_flags = pme_mesh_flags(fr, flags);
                     wallcycle_start(wcycle, ewcPMEMESH);
                     status = gmx_pme_do(fr->pmedata,
                                         0, md->homenr - fr->n_tpi,
-                                        x, fr->f_novirsum,
+                                        x, f_mesh,
                                         md->chargeA, md->chargeB,
                                         md->sqrt_c6A, md->sqrt_c6B,
                                         md->sigmaA, md->sigmaB,
@@ -57,6 +57,7 @@
 #include "gromacs/legacyheaders/force.h"
 #include "gromacs/legacyheaders/gmx_detect_hardware.h"
 #include "gromacs/legacyheaders/gmx_omp_nthreads.h"
+#include "gromacs/legacyheaders/gmx_thread_affinity.h"
 #include "gromacs/legacyheaders/inputrec.h"
 #include "gromacs/legacyheaders/names.h"
 #include "gromacs/legacyheaders/network.h"
@@ -72,6 +73,7 @@
 #include "gromacs/math/units.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/calc_verletbuf.h"
 #include "gromacs/mdlib/forcerec-threading.h"
 #include "gromacs/mdlib/md_support.h"
 #include "gromacs/mdlib/nb_verlet.h"
@@ -1435,7 +1437,7 @@ void forcerec_set_ranges(t_forcerec *fr,
     {
         fr->nalloc_force = over_alloc_dd(fr->natoms_force_constr);
 
-        if (fr->bTwinRange)
+        if (fr->bTwinRange || fr->bMtsLongRange)
         {
             srenew(fr->f_twin, fr->nalloc_force);
         }
@@ -2108,10 +2110,95 @@ init_interaction_const(FILE                       *fp,
     *interaction_const = ic;
 }
 
+/* The default interval for pruning the inner pair list with dynamic pruning */
+static const int nbnxnDynamicPruneNstlist = 4;
+
+/* Sets up dynamic pruning of the pair list, when supported and useful.
+ * The list is then searched every nstlist steps with rlist and pruned
+ * every nbv->nstlist_prune steps to an inner list with a buffer set
+ * for that interval by the Verlet buffer tolerance.
+ */
+static void init_dynamic_pruning(FILE                *fp,
+                                 nonbonded_verlet_t  *nbv,
+                                 const t_inputrec    *ir,
+                                 const gmx_mtop_t    *mtop,
+                                 matrix               box,
+                                 const t_forcerec    *fr)
+{
+    const interaction_const_t *ic = fr->ic;
+    verletbuf_list_setup_t     ls;
+    t_inputrec                 ir_prune;
+    real                       rlist_inner;
+    char                      *env;
+
+    nbv->bDynamicPrune = FALSE;
+    nbv->nstlist_prune = nbnxnDynamicPruneNstlist;
+    nbv->rbuf_inner    = 0;
+    nbv->step_search   = 0;
+
+    /* We need a Verlet buffer tolerance to set the inner list buffer,
+     * which can not be estimated for NVE.
+     */
+    if (nbv->bUseGPU ||
+        !nbnxn_kernel_pairlist_simple(nbv->grp[0].kernel_type) ||
+        !EI_DYNAMICS(ir->eI) ||
+        ir->verletbuf_tol <= 0 ||
+        (EI_MD(ir->eI) && ir->etc == etcNO) ||
+        getenv("GMX_DISABLE_DYNAMICPRUNING") != NULL)
+    {
+        return;
+    }
+
+    if ((env = getenv("GMX_NSTLIST_DYNAMICPRUNING")) != NULL)
+    {
+        char *end;
+
+        nbv->nstlist_prune = strtol(env, &end, 10);
+        if (!end || (*end != 0) || nbv->nstlist_prune <= 0)
+        {
+            gmx_fatal(FARGS, "Invalid value passed in GMX_NSTLIST_DYNAMICPRUNING=%s, positive integer required", env);
+        }
+    }
+
+    if (ir->nstlist <= nbv->nstlist_prune)
+    {
+        return;
+    }
+
+    ls.cluster_size_i = NBNXN_CPU_CLUSTER_I_SIZE;
+    ls.cluster_size_j = nbnxn_kernel_to_cluster_j_size(nbv->grp[0].kernel_type);
+
+    ir_prune         = *ir;
+    ir_prune.nstlist = nbv->nstlist_prune;
+    calc_verlet_buffer_size(mtop, det(box), &ir_prune, -1, &ls, NULL,
+                            &rlist_inner);
+    rlist_inner = std::max(rlist_inner, std::max(ic->rcoulomb, ic->rvdw));
+
+    if (rlist_inner >= ic->rlist)
+    {
+        /* The outer list buffer is not larger, pruning would not help */
+        return;
+    }
+
+    nbv->bDynamicPrune = TRUE;
+    nbv->rbuf_inner    = rlist_inner - std::max(ic->rcoulomb, ic->rvdw);
+
+    if (fp != NULL)
+    {
+        fprintf(fp, "Using a dual pair-list setup updated with dynamic pruning:\n");
+        fprintf(fp, "  outer list: updated every %3d steps, buffer %.3f nm, rlist %.3f nm\n",
+                ir->nstlist, ic->rlist - std::max(ic->rcoulomb, ic->rvdw), ic->rlist);
+        fprintf(fp, "  inner list: updated every %3d steps, buffer %.3f nm, rlist %.3f nm\n",
+                nbv->nstlist_prune, nbv->rbuf_inner, rlist_inner);
+    }
+}
+
 static void init_nb_verlet(FILE                *fp,
                            nonbonded_verlet_t **nb_verlet,
                            gmx_bool             bFEP_NonBonded,
                            const t_inputrec    *ir,
+                           const gmx_mtop_t    *mtop,
+                           matrix               box,
                            const t_forcerec    *fr,
                            const t_commrec     *cr,
                            const char          *nbpu_opt)
@@ -2297,9 +2384,128 @@ static void init_nb_verlet(FILE                *fp,
 
     }
 
+    init_dynamic_pruning(fp, nbv, ir, mtop, box, fr);
+
     *nb_verlet = nbv;
 }
 
+/* Sets up the task-based force scheduling, when requested with
+ * the GMX_FORCE_TASKS environment variable and supported.
+ */
+static void init_force_tasks(FILE                        *fp,
+                             t_forcerec                  *fr,
+                             const t_inputrec gmx_unused *ir,
+                             const gmx_mtop_t gmx_unused *mtop,
+                             const t_commrec             *cr)
+{
+    const char *reason = NULL;
+
+    fr->bForceTasks = FALSE;
+    fr->pme_task    = NULL;
+
+    if (getenv("GMX_FORCE_TASKS") == NULL)
+    {
+        return;
+    }
+
+#if !defined _OPENMP || _OPENMP < 201307
+    reason = "it requires OpenMP 4.0 support";
+#else
+    if (fr->cutoff_scheme != ecutsVERLET ||
+        fr->nbv->bUseGPU ||
+        !nbnxn_kernel_pairlist_simple(fr->nbv->grp[eintLocal].kernel_type))
+    {
+        reason = "it requires the Verlet scheme with CPU non-bonded kernels";
+    }
+    else if (PAR(cr) || cr->ms != NULL)
+    {
+        reason = "it is only supported with a single rank";
+    }
+    else if (gmx_omp_nthreads_get(emntNonbonded) < 2)
+    {
+        reason = "it requires more than one OpenMP thread";
+    }
+    else if (fr->efep != efepNO || ir->nwall > 0 || fr->n_tpi > 0)
+    {
+        reason = "free-energy, walls and test-particle insertion are not supported";
+    }
+    else if (gmx_mtop_ftype_count(mtop, F_POSRES) > 0 ||
+             gmx_mtop_ftype_count(mtop, F_FBPOSRES) > 0)
+    {
+        /* Position restraints add to f_novirsum, as does the PME mesh task */
+        reason = "position restraints are not supported";
+    }
+    else if (fr->nbv->grp[eintLocal].nbat->bUseTreeReduce)
+    {
+        reason = "the tree force-buffer reduction is not supported";
+    }
+    else if (fr->ePBC != epbcNONE && !fr->bMolPBC)
+    {
+        /* The listed forces task can not make molecules whole
+         * with the graph, since that modifies x.
+         */
+        reason = "molecules are made whole with a graph";
+    }
+#endif
+
+    if (reason != NULL)
+    {
+        md_print_warn(cr, fp, "NOTE: GMX_FORCE_TASKS is set, but task-based force computation is disabled, since %s\n", reason);
+        return;
+    }
+
+    fr->bForceTasks = TRUE;
+    init_pme_mesh_task(fr);
+
+    /* The thread running the mesh task is also the first thread of
+     * the nested PME team, the other PME threads are taken out of the
+     * task team, so the total thread count does not change. At most
+     * half of the threads go to PME, so the other forces still run
+     * on at least two threads concurrently with the mesh.
+     */
+    fr->nthread_force_tasks = gmx_omp_nthreads_get(emntNonbonded);
+    fr->nthread_pme_task    = 0;
+    if (EEL_PME(fr->eeltype) || EVDW_PME(fr->vdwtype))
+    {
+        fr->nthread_pme_task     = std::min(gmx_omp_nthreads_get(emntPME),
+                                            fr->nthread_force_tasks/2);
+        fr->nthread_force_tasks -= fr->nthread_pme_task - 1;
+    }
+
+    if (fp != NULL)
+    {
+        fprintf(fp, "Computing the non-bonded, listed and PME mesh forces as concurrent OpenMP tasks\n");
+        if (fr->nthread_pme_task > 0)
+        {
+            fprintf(fp, "The tasks run on %d OpenMP threads, the PME mesh task uses a nested team of %d threads\n",
+                    fr->nthread_force_tasks, fr->nthread_pme_task);
+        }
+    }
+}
+
+void check_force_tasks_affinity(FILE *fp, const t_forcerec *fr,
+                                const t_commrec *cr)
+{
+    if (!fr->bForceTasks || fr->nthread_pme_task <= 1)
+    {
+        return;
+    }
+
+    /* When mdrun pinned the threads, the mesh task extends its affinity
+     * to the cores of the threads taken out of the task team. Otherwise
+     * a binding to single cores set outside mdrun, e.g. by the OpenMP
+     * library, is inherited by the nested team, which then runs
+     * on a single core.
+     */
+    if (gmx_thread_runs_on_single_core() && !gmx_thread_affinity_is_pinned())
+    {
+        md_print_warn(cr, fp, "NOTE: The OpenMP threads are bound to single cores outside of mdrun, so the\n"
+                      "      %d threads of the nested PME mesh team share one core. Let mdrun pin\n"
+                      "      the threads, or use GMX_PME_NUM_THREADS=1.\n",
+                      fr->nthread_pme_task);
+    }
+}
+
 gmx_bool usingGpu(nonbonded_verlet_t *nbv)
 {
     return nbv != NULL && nbv->bUseGPU;
@@ -2682,6 +2888,13 @@ void init_forcerec(FILE              *fp,
     fr->bTwinRange = fr->rlistlong > fr->rlist;
     fr->bEwald     = (EEL_PME(fr->eeltype) || fr->eeltype == eelEWALD);
 
+    fr->bMtsLongRange = (ir->mts_level2_forces == emtsLONGRANGE_NONBONDED);
+    if (fr->bMtsLongRange && fp)
+    {
+        fprintf(fp, "Using multiple time stepping: the PME mesh forces are applied every %d steps\n",
+                ir->mts_level2_factor);
+    }
+
     fr->reppow     = mtop->ffparams.reppow;
 
     if (ir->cutoff_scheme == ecutsGROUP)
@@ -3260,9 +3473,11 @@ void init_forcerec(FILE              *fp,
             gmx_fatal(FARGS, "With Verlet lists rcoulomb and rvdw should be identical");
         }
 
-        init_nb_verlet(fp, &fr->nbv, bFEP_NonBonded, ir, fr, cr, nbpu_opt);
+        init_nb_verlet(fp, &fr->nbv, bFEP_NonBonded, ir, mtop, box, fr, cr, nbpu_opt);
     }
 
+    init_force_tasks(fp, fr, ir, mtop, cr);
+
     if (ir->eDispCorr != edispcNO)
     {
         calc_enervirdiff(fp, ir->eDispCorr, fr);
@@ -120,6 +120,19 @@ void init_forcerec(FILE                   *fplog,
                    gmx_bool                bNoSolvOpt,
                    real                    print_force);
 
+/*! \brief Check the thread affinity for task-based force computation
+ *
+ * Prints a note when the nested team of the PME mesh task would run
+ * on a single core, due to thread binding set outside of mdrun.
+ * Should be called after the thread affinity has been set.
+ * \param[in]  fplog  File for printing
+ * \param[in]  fr     The force record
+ * \param[in]  cr     Communication structures
+ */
+void check_force_tasks_affinity(FILE             *fplog,
+                                const t_forcerec *fr,
+                                const t_commrec  *cr);
+
 /*! \brief Divide exclusions over threads
  *
  * Set the exclusion load for the local exclusions and possibly threads
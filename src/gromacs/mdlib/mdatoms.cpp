@@ -151,6 +151,7 @@ void atoms2md(const gmx_mtop_t *mtop, const t_inputrec *ir,
         }
         srenew(md->massT, md->nalloc);
         srenew(md->invmass, md->nalloc);
+        srenew(md->invMassPerDim, md->nalloc);
         srenew(md->chargeA, md->nalloc);
         srenew(md->typeA, md->nalloc);
         if (md->nPerturbed)
@@ -234,7 +235,7 @@ void atoms2md(const gmx_mtop_t *mtop, const t_inputrec *ir,
     {
         try
         {
-            int      g, ag;
+            int      g, ag, d;
             real     mA, mB, fac;
             real     c6, c12;
             t_atom  *atom;
@@ -319,6 +320,10 @@ void atoms2md(const gmx_mtop_t *mtop, const t_inputrec *ir,
             {
                 md->invmass[i]    = 1.0/mA;
             }
+            for (d = 0; d < DIM; d++)
+            {
+                md->invMassPerDim[i][d] = md->invmass[i];
+            }
             md->chargeA[i]      = atom->q;
             md->typeA[i]        = atom->type;
             if (bLJPME)
@@ -424,13 +429,20 @@ void atoms2md(const gmx_mtop_t *mtop, const t_inputrec *ir,
 
     gmx_mtop_atomlookup_destroy(alook);
 
+    md->bHaveVsitesOrShells = FALSE;
+    for (i = 0; i < homenr && !md->bHaveVsitesOrShells; i++)
+    {
+        md->bHaveVsitesOrShells = (md->ptype[i] == eptVSite ||
+                                   md->ptype[i] == eptShell);
+    }
+
     md->homenr = homenr;
     md->lambda = 0;
 }
 
 void update_mdatoms(t_mdatoms *md, real lambda)
 {
-    int    al, end;
+    int    al, end, d;
     real   L1 = 1.0-lambda;
 
     end = md->nr;
@@ -445,6 +457,10 @@ void update_mdatoms(t_mdatoms *md, real lambda)
                 if (md->invmass[al] > 1.1*ALMOST_ZERO)
                 {
                     md->invmass[al] = 1.0/md->massT[al];
+                    for (d = 0; d < DIM; d++)
+                    {
+                        md->invMassPerDim[al][d] = md->invmass[al];
+                    }
                 }
             }
         }
@@ -36,6 +36,11 @@
 
 #include "mdoutf.h"
 
+#include <cstdlib>
+#include <cstring>
+
+#include "thread_mpi/threads.h"
+
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
@@ -44,6 +49,7 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/legacyheaders/checkpoint.h"
 #include "gromacs/legacyheaders/copyrite.h"
+#include "gromacs/legacyheaders/gmx_thread_affinity.h"
 #include "gromacs/legacyheaders/types/commrec.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/mdrun.h"
@@ -52,27 +58,213 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
+/* Number of frames that can be queued for asynchronous xtc writing */
+#define XTC_ASYNC_NBUF 2
+
+/* A compressed-trajectory frame queued for writing */
+typedef struct {
+    gmx_int64_t step;
+    real        t;
+    matrix      box;
+    rvec       *x;
+} t_xtc_async_frame;
+
+/* Writer thread for xtc output, so that the master rank does not need to
+ * wait for the compression and the write. Frames are copied into a queue
+ * of XTC_ASYNC_NBUF buffers, the master only blocks when the queue is full.
+ */
+typedef struct {
+    t_fileio           *fio;
+    t_xtc_index        *index;
+    int                 natoms;
+    int                 precision;
+    t_xtc_async_frame   frames[XTC_ASYNC_NBUF];
+    int                 first;   /* index of the first queued frame */
+    int                 nqueued; /* number of queued frames */
+    gmx_bool            bStop;   /* tells the thread to exit */
+    gmx_bool            bError;  /* whether a write failed */
+    tMPI_Thread_t       thread;
+    tMPI_Thread_mutex_t mutex;
+    tMPI_Thread_cond_t  cond;    /* signaled on any change of the queue */
+} t_xtc_async_writer;
+
 struct gmx_mdoutf {
-    t_fileio         *fp_trn;
-    t_fileio         *fp_xtc;
-    tng_trajectory_t  tng;
-    tng_trajectory_t  tng_low_prec;
-    int               x_compression_precision; /* only used by XTC output */
-    ener_file_t       fp_ene;
-    const char       *fn_cpt;
-    gmx_bool          bKeepAndNumCPT;
-    int               eIntegrator;
-    gmx_bool          bExpanded;
-    int               elamstats;
-    int               simulation_part;
-    FILE             *fp_dhdl;
-    FILE             *fp_field;
-    int               natoms_global;
-    int               natoms_x_compressed;
-    gmx_groups_t     *groups; /* for compressed position writing */
-    gmx_wallcycle_t   wcycle;
+    t_fileio           *fp_trn;
+    t_fileio           *fp_xtc;
+    t_xtc_index        *xtc_index; /* frame index of fp_xtc, NULL if not written */
+    t_xtc_async_writer *xtc_async; /* writer thread for fp_xtc, or NULL */
+    tng_trajectory_t    tng;
+    tng_trajectory_t    tng_low_prec;
+    int                 x_compression_precision; /* only used by XTC output */
+    ener_file_t         fp_ene;
+    const char         *fn_cpt;
+    gmx_bool            bKeepAndNumCPT;
+    gmx_bool            bDistributedCPT; /* all PP ranks write the atom data */
+    int                 eIntegrator;
+    gmx_bool            bExpanded;
+    int                 elamstats;
+    int                 simulation_part;
+    FILE               *fp_dhdl;
+    FILE               *fp_field;
+    int                 natoms_global;
+    int                 natoms_x_compressed;
+    gmx_groups_t       *groups; /* for compressed position writing */
+    gmx_wallcycle_t     wcycle;
 };
 
+/* Writes the frame index of the xtc file, warns on failure */
+static void write_xtc_index(gmx_mdoutf_t of)
+{
+    if (!xtc_index_write(of->xtc_index, gmx_fio_getname(of->fp_xtc)))
+    {
+        gmx_warning("Could not write the frame index for %s",
+                    gmx_fio_getname(of->fp_xtc));
+    }
+}
+
+/* Writes one frame, with the frame index entry when requested */
+static int write_xtc_frame(t_fileio *fio, t_xtc_index *index, int natoms,
+                           gmx_int64_t step, real t, matrix box, rvec *x,
+                           int precision)
+{
+    if (index)
+    {
+        xtc_index_add_frame(index, gmx_fio_ftell(fio), natoms, step, t);
+    }
+    return write_xtc(fio, natoms, step, t, box, x, precision);
+}
+
+static void *xtc_async_thread(void *arg)
+{
+    t_xtc_async_writer *w = static_cast<t_xtc_async_writer *>(arg);
+
+    /* Don't compete with the force work for the core of the master thread */
+    gmx_unpin_thread();
+
+    tMPI_Thread_mutex_lock(&w->mutex);
+    while (TRUE)
+    {
+        while (w->nqueued == 0 && !w->bStop)
+        {
+            tMPI_Thread_cond_wait(&w->cond, &w->mutex);
+        }
+        if (w->nqueued == 0)
+        {
+            break;
+        }
+        /* The master only fills buffers that are not queued,
+         * so we can write the first frame without holding the lock.
+         */
+        t_xtc_async_frame *frame = &w->frames[w->first];
+        tMPI_Thread_mutex_unlock(&w->mutex);
+
+        int                bOK = write_xtc_frame(w->fio, w->index, w->natoms,
+                                                 frame->step, frame->t, frame->box,
+                                                 frame->x, w->precision);
+
+        tMPI_Thread_mutex_lock(&w->mutex);
+        if (!bOK)
+        {
+            w->bError = TRUE;
+        }
+        w->first   = (w->first + 1) % XTC_ASYNC_NBUF;
+        w->nqueued--;
+        tMPI_Thread_cond_broadcast(&w->cond);
+    }
+    tMPI_Thread_mutex_unlock(&w->mutex);
+
+    return NULL;
+}
+
+static t_xtc_async_writer *xtc_async_init(t_fileio *fio, t_xtc_index *index,
+                                          int natoms, int precision)
+{
+    t_xtc_async_writer *w;
+
+    snew(w, 1);
+    w->fio       = fio;
+    w->index     = index;
+    w->natoms    = natoms;
+    w->precision = precision;
+    for (int i = 0; i < XTC_ASYNC_NBUF; i++)
+    {
+        snew(w->frames[i].x, natoms);
+    }
+    w->first   = 0;
+    w->nqueued = 0;
+    w->bStop   = FALSE;
+    w->bError  = FALSE;
+    tMPI_Thread_mutex_init(&w->mutex);
+    tMPI_Thread_cond_init(&w->cond);
+    if (tMPI_Thread_create(&w->thread, xtc_async_thread, w) != 0)
+    {
+        gmx_fatal(FARGS, "Could not start the thread for asynchronous XTC output");
+    }
+
+    return w;
+}
+
+static void xtc_async_check_error(t_xtc_async_writer *w)
+{
+    if (w->bError)
+    {
+        gmx_fatal(FARGS, "XTC error - maybe you are out of disk space?");
+    }
+}
+
+/* Queues a copy of the frame, waiting while the queue is full */
+static void xtc_async_submit(t_xtc_async_writer *w, gmx_int64_t step, real t,
+                             matrix box, rvec *x)
+{
+    t_xtc_async_frame *frame;
+
+    tMPI_Thread_mutex_lock(&w->mutex);
+    while (w->nqueued == XTC_ASYNC_NBUF)
+    {
+        tMPI_Thread_cond_wait(&w->cond, &w->mutex);
+    }
+    xtc_async_check_error(w);
+    frame       = &w->frames[(w->first + w->nqueued) % XTC_ASYNC_NBUF];
+    frame->step = step;
+    frame->t    = t;
+    copy_mat(box, frame->box);
+    std::memcpy(frame->x, x, w->natoms*sizeof(*x));
+    w->nqueued++;
+    tMPI_Thread_cond_broadcast(&w->cond);
+    tMPI_Thread_mutex_unlock(&w->mutex);
+}
+
+/* Waits until all queued frames have been written */
+static void xtc_async_flush(t_xtc_async_writer *w)
+{
+    tMPI_Thread_mutex_lock(&w->mutex);
+    while (w->nqueued > 0)
+    {
+        tMPI_Thread_cond_wait(&w->cond, &w->mutex);
+    }
+    xtc_async_check_error(w);
+    tMPI_Thread_mutex_unlock(&w->mutex);
+}
+
+/* Writes all queued frames, stops the thread and frees w */
+static void xtc_async_done(t_xtc_async_writer *w)
+{
+    tMPI_Thread_mutex_lock(&w->mutex);
+    w->bStop = TRUE;
+    tMPI_Thread_cond_broadcast(&w->cond);
+    tMPI_Thread_mutex_unlock(&w->mutex);
+    tMPI_Thread_join(w->thread, NULL);
+    xtc_async_check_error(w);
+
+    tMPI_Thread_cond_destroy(&w->cond);
+    tMPI_Thread_mutex_destroy(&w->mutex);
+    for (int i = 0; i < XTC_ASYNC_NBUF; i++)
+    {
+        sfree(w->frames[i].x);
+    }
+    sfree(w);
+}
+
 
 gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                          int mdrun_flags, const t_commrec *cr,
@@ -89,6 +281,8 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
     of->fp_trn       = NULL;
     of->fp_ene       = NULL;
     of->fp_xtc       = NULL;
+    of->xtc_index    = NULL;
+    of->xtc_async    = NULL;
     of->tng          = NULL;
     of->tng_low_prec = NULL;
     of->fp_dhdl      = NULL;
@@ -100,6 +294,7 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
     of->simulation_part         = ir->simulation_part;
     of->x_compression_precision = static_cast<int>(ir->x_compression_precision);
     of->wcycle                  = wcycle;
+    of->bDistributedCPT         = (DOMAINDECOMP(cr) && (mdrun_flags & MD_DISTRIBUTEDCPT));
 
     if (MASTER(cr))
     {
@@ -148,6 +343,7 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
             {
                 case efXTC:
                     of->fp_xtc                  = open_xtc(filename, filemode);
+                    of->xtc_index               = xtc_index_open_for_writing(of->fp_xtc, bAppendFiles);
                     break;
                 case efTNG:
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
@@ -211,6 +407,13 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                 of->natoms_x_compressed++;
             }
         }
+
+        if (of->fp_xtc && getenv("GMX_XTC_ASYNC") != NULL)
+        {
+            of->xtc_async = xtc_async_init(of->fp_xtc, of->xtc_index,
+                                           of->natoms_x_compressed,
+                                           of->x_compression_precision);
+        }
     }
 
     if (bCiteTng)
@@ -260,18 +463,23 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
 
     if (DOMAINDECOMP(cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if ((mdof_flags & MDOF_CPT) && !of->bDistributedCPT)
         {
             dd_collect_state(cr->dd, state_local, state_global);
         }
         else
         {
-            if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED))
+            if (mdof_flags & MDOF_CPT)
+            {
+                /* The atom data is written by each rank */
+                dd_collect_state_nondistributed(cr->dd, state_local, state_global);
+            }
+            if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED | MDOF_COLLECT_X_V))
             {
                 dd_collect_vec(cr->dd, state_local, state_local->x,
                                state_global->x);
             }
-            if (mdof_flags & MDOF_V)
+            if (mdof_flags & (MDOF_V | MDOF_COLLECT_X_V))
             {
                 dd_collect_vec(cr->dd, state_local, local_v,
                                global_v);
@@ -300,12 +508,36 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
         }
     }
 
+    if ((mdof_flags & MDOF_CPT) && MASTER(cr))
+    {
+        /* The checkpoint stores the output file positions */
+        if (of->xtc_async)
+        {
+            xtc_async_flush(of->xtc_async);
+        }
+        /* Keep the index up to date with the frames covered by the
+         * checkpoint, so a killed run can be continued with an index.
+         */
+        if (of->xtc_index)
+        {
+            write_xtc_index(of);
+        }
+        fflush_tng(of->tng);
+        fflush_tng(of->tng_low_prec);
+    }
+
+    if ((mdof_flags & MDOF_CPT) && of->bDistributedCPT)
+    {
+        write_checkpoint_distributed(of->fn_cpt, of->bKeepAndNumCPT,
+                                     fplog, cr, of->eIntegrator, of->simulation_part,
+                                     of->bExpanded, of->elamstats, step, t,
+                                     state_local, state_global);
+    }
+
     if (MASTER(cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if ((mdof_flags & MDOF_CPT) && !of->bDistributedCPT)
         {
-            fflush_tng(of->tng);
-            fflush_tng(of->tng_low_prec);
             write_checkpoint(of->fn_cpt, of->bKeepAndNumCPT,
                              fplog, cr, of->eIntegrator, of->simulation_part,
                              of->bExpanded, of->elamstats, step, t, state_global);
@@ -359,8 +591,13 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                     }
                 }
             }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
-                          state_local->box, xxtc, of->x_compression_precision) == 0)
+            if (of->xtc_async)
+            {
+                xtc_async_submit(of->xtc_async, step, t, state_local->box, xxtc);
+            }
+            else if (write_xtc_frame(of->fp_xtc, of->xtc_index, of->natoms_x_compressed,
+                                     step, t, state_local->box, xxtc,
+                                     of->x_compression_precision) == 0)
             {
                 gmx_fatal(FARGS, "XTC error - maybe you are out of disk space?");
             }
@@ -395,10 +632,19 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    if (of->xtc_async)
+    {
+        xtc_async_done(of->xtc_async);
+    }
     if (of->fp_ene != NULL)
     {
         close_enx(of->fp_ene);
     }
+    if (of->xtc_index)
+    {
+        write_xtc_index(of);
+        xtc_index_done(of->xtc_index);
+    }
     if (of->fp_xtc)
     {
         close_xtc(of->fp_xtc);
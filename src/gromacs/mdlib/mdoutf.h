@@ -111,6 +111,10 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
 #define MDOF_X_COMPRESSED (1<<3)
 #define MDOF_CPT          (1<<4)
 #define MDOF_IMD          (1<<5)
+/* Collect x and v on the master rank also when they are not written,
+ * e.g. for writing the final configuration after a distributed checkpoint.
+ */
+#define MDOF_COLLECT_X_V  (1<<6)
 
 #ifdef __cplusplus
 }
@@ -105,6 +105,12 @@ typedef struct nonbonded_verlet_t {
     gmx_nbnxn_gpu_t         *gpu_nbv;         /* pointer to GPU nb verlet data     */
     int                      min_ci_balanced; /* pair list balancing parameter
                                                  used for the 8x8x8 GPU kernels    */
+
+    gmx_bool                 bDynamicPrune;   /* Prune the outer list built every
+                                                 nstlist steps to an inner list */
+    int                      nstlist_prune;   /* The inner list pruning interval */
+    real                     rbuf_inner;      /* The buffer for the inner list   */
+    gmx_int64_t              step_search;     /* The step of the last search     */
 } nonbonded_verlet_t;
 
 /*! \brief Getter for bUseGPU */
@@ -1539,6 +1539,49 @@ static void nbnxn_atomdata_add_nbat_f_to_f_treereduce(const nbnxn_atomdata_t *nb
 }
 
 
+/* Reduces the force output buffers of nbat over cell blocks b0 to b1 */
+static void nbnxn_atomdata_reduce_f_blocks(const nbnxn_atomdata_t *nbat,
+                                           int b0, int b1)
+{
+    const nbnxn_buffer_flags_t *flags;
+    int   nfptr;
+    real *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
+
+    flags = &nbat->buffer_flags;
+
+    for (int b = b0; b < b1; b++)
+    {
+        int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+        int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+
+        nfptr = 0;
+        for (int out = 1; out < nbat->nout; out++)
+        {
+            if (bitmask_is_set(flags->flag[b], out))
+            {
+                fptr[nfptr++] = nbat->out[out].f;
+            }
+        }
+        if (nfptr > 0)
+        {
+#ifdef GMX_NBNXN_SIMD
+            nbnxn_atomdata_reduce_reals_simd
+#else
+            nbnxn_atomdata_reduce_reals
+#endif
+                (nbat->out[0].f,
+                bitmask_is_set(flags->flag[b], 0),
+                fptr, nfptr,
+                i0, i1);
+        }
+        else if (!bitmask_is_set(flags->flag[b], 0))
+        {
+            nbnxn_atomdata_clear_reals(nbat->out[0].f,
+                                       i0, i1);
+        }
+    }
+}
+
 static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(const nbnxn_atomdata_t *nbat,
                                                      int                     nth)
 {
@@ -1547,47 +1590,12 @@ static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(const nbnxn_atomdata_t *nba
     {
         try
         {
-            const nbnxn_buffer_flags_t *flags;
-            int   nfptr;
-            real *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
-
-            flags = &nbat->buffer_flags;
+            int nflag = nbat->buffer_flags.nflag;
 
             /* Calculate the cell-block range for our thread */
-            int b0 = (flags->nflag* th   )/nth;
-            int b1 = (flags->nflag*(th+1))/nth;
-
-            for (int b = b0; b < b1; b++)
-            {
-                int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
-                int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
-
-                nfptr = 0;
-                for (int out = 1; out < nbat->nout; out++)
-                {
-                    if (bitmask_is_set(flags->flag[b], out))
-                    {
-                        fptr[nfptr++] = nbat->out[out].f;
-                    }
-                }
-                if (nfptr > 0)
-                {
-#ifdef GMX_NBNXN_SIMD
-                    nbnxn_atomdata_reduce_reals_simd
-#else
-                    nbnxn_atomdata_reduce_reals
-#endif
-                        (nbat->out[0].f,
-                        bitmask_is_set(flags->flag[b], 0),
-                        fptr, nfptr,
-                        i0, i1);
-                }
-                else if (!bitmask_is_set(flags->flag[b], 0))
-                {
-                    nbnxn_atomdata_clear_reals(nbat->out[0].f,
-                                               i0, i1);
-                }
-            }
+            nbnxn_atomdata_reduce_f_blocks(nbat,
+                                           (nflag* th   )/nth,
+                                           (nflag*(th+1))/nth);
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
@@ -1658,6 +1666,49 @@ void nbnxn_atomdata_add_nbat_f_to_f(const nbnxn_search_t    nbs,
     nbs_cycle_stop(&nbs->cc[enbsCCreducef]);
 }
 
+void nbnxn_atomdata_add_nbat_f_to_f_tasks(const nbnxn_search_t    nbs,
+                                          const nbnxn_atomdata_t *nbat,
+                                          rvec                   *f)
+{
+    int na, nflag, ntask;
+
+    /* Use more tasks than threads, so the work can be balanced
+     * with the other tasks that might be running.
+     */
+    ntask = 2*gmx_omp_nthreads_get(emntNonbonded);
+    na    = nbs->natoms_nonlocal;
+    nflag = nbat->buffer_flags.nflag;
+
+    if (nbat->nout > 1)
+    {
+        /* Reduce the force thread output buffers into buffer 0 */
+#pragma omp taskgroup
+        {
+            for (int t = 0; t < ntask; t++)
+            {
+#pragma omp task firstprivate(t)
+                nbnxn_atomdata_reduce_f_blocks(nbat,
+                                               (nflag* t   )/ntask,
+                                               (nflag*(t+1))/ntask);
+            }
+        }
+    }
+
+#pragma omp taskgroup
+    {
+        for (int t = 0; t < ntask; t++)
+        {
+#pragma omp task firstprivate(t)
+            nbnxn_atomdata_add_nbat_f_to_f_part(nbs, nbat,
+                                                nbat->out,
+                                                1,
+                                                ((t+0)*na)/ntask,
+                                                ((t+1)*na)/ntask,
+                                                f);
+        }
+    }
+}
+
 /* Adds the shift forces from nbnxn_atomdata_t to fshift */
 void nbnxn_atomdata_add_nbat_fshift_to_fshift(const nbnxn_atomdata_t *nbat,
                                               rvec                   *fshift)
@@ -112,6 +112,14 @@ void nbnxn_atomdata_add_nbat_f_to_f(const nbnxn_search_t    nbs,
                                     const nbnxn_atomdata_t *nbat,
                                     rvec                   *f);
 
+/* As nbnxn_atomdata_add_nbat_f_to_f for all atoms, but should be called
+ * by a single thread of an active OpenMP parallel region and does
+ * the reduction with tasks. Does not support the tree reduction.
+ */
+void nbnxn_atomdata_add_nbat_f_to_f_tasks(const nbnxn_search_t    nbs,
+                                          const nbnxn_atomdata_t *nbat,
+                                          rvec                   *f);
+
 /* Add the fshift force stored in nbat to fshift */
 void nbnxn_atomdata_add_nbat_fshift_to_fshift(const nbnxn_atomdata_t *nbat,
                                               rvec                   *fshift);
@@ -170,6 +170,90 @@ p_nbk_func_ener p_nbk_c_energrp[coultNR][vdwtNR] =
     { nbnxn_kernel_ElecQSTabTwinCut_VdwLJ_VgrpF_ref, nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VgrpF_ref, nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VgrpF_ref, nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_ref, nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VgrpF_ref }
 };
 
+/* Computes the interactions in pair list nb of nbl_list */
+static void
+nbnxn_kernel_ref_list(const nbnxn_pairlist_set_t *nbl_list,
+                      int                         nb,
+                      const nbnxn_atomdata_t     *nbat,
+                      const interaction_const_t  *ic,
+                      rvec                       *shift_vec,
+                      int                         force_flags,
+                      int                         clearF,
+                      real                       *fshift,
+                      int                         coult,
+                      int                         vdwt)
+{
+    nbnxn_atomdata_output_t *out;
+    real                    *fshift_p;
+
+    out = &nbat->out[nb];
+
+    if (clearF == enbvClearFYes)
+    {
+        clear_f(nbat, nb, out->f);
+    }
+
+    if ((force_flags & GMX_FORCE_VIRIAL) && nbl_list->nnbl == 1)
+    {
+        fshift_p = fshift;
+    }
+    else
+    {
+        fshift_p = out->fshift;
+
+        if (clearF == enbvClearFYes)
+        {
+            clear_fshift(fshift_p);
+        }
+    }
+
+    if (!(force_flags & GMX_FORCE_ENERGY))
+    {
+        /* Don't calculate energies */
+        p_nbk_c_noener[coult][vdwt](nbl_list->nbl[nb], nbat,
+                                    ic,
+                                    shift_vec,
+                                    out->f,
+                                    fshift_p);
+    }
+    else if (out->nV == 1)
+    {
+        /* No energy groups */
+        out->Vvdw[0] = 0;
+        out->Vc[0]   = 0;
+
+        p_nbk_c_ener[coult][vdwt](nbl_list->nbl[nb], nbat,
+                                  ic,
+                                  shift_vec,
+                                  out->f,
+                                  fshift_p,
+                                  out->Vvdw,
+                                  out->Vc);
+    }
+    else
+    {
+        /* Calculate energy group contributions */
+        int i;
+
+        for (i = 0; i < out->nV; i++)
+        {
+            out->Vvdw[i] = 0;
+        }
+        for (i = 0; i < out->nV; i++)
+        {
+            out->Vc[i] = 0;
+        }
+
+        p_nbk_c_energrp[coult][vdwt](nbl_list->nbl[nb], nbat,
+                                     ic,
+                                     shift_vec,
+                                     out->f,
+                                     fshift_p,
+                                     out->Vvdw,
+                                     out->Vc);
+    }
+}
+
 void
 nbnxn_kernel_ref(const nbnxn_pairlist_set_t *nbl_list,
                  const nbnxn_atomdata_t     *nbat,
@@ -179,17 +263,16 @@ nbnxn_kernel_ref(const nbnxn_pairlist_set_t *nbl_list,
                  int                         clearF,
                  real                       *fshift,
                  real                       *Vc,
-                 real                       *Vvdw)
+                 real                       *Vvdw,
+                 gmx_bool                    bUseTasks)
 {
     int                nnbl;
-    nbnxn_pairlist_t **nbl;
     int                coult;
     int                vdwt;
     int                nb;
     int                nthreads gmx_unused;
 
     nnbl = nbl_list->nnbl;
-    nbl  = nbl_list->nbl;
 
     if (EEL_RF(ic->eeltype) || ic->eeltype == eelCUT)
     {
@@ -244,81 +327,34 @@ nbnxn_kernel_ref(const nbnxn_pairlist_set_t *nbl_list,
         gmx_incons("Unsupported vdwtype in nbnxn reference kernel");
     }
 
-    // cppcheck-suppress unreadVariable
-    nthreads = gmx_omp_nthreads_get(emntNonbonded);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (nb = 0; nb < nnbl; nb++)
+    if (bUseTasks)
     {
-        // Presently, the kernels do not call C++ code that can throw, so
-        // no need for a try/catch pair in this OpenMP region.
-        nbnxn_atomdata_output_t *out;
-        real                    *fshift_p;
-
-        out = &nbat->out[nb];
-
-        if (clearF == enbvClearFYes)
+        /* We are called by one thread of a parallel region,
+         * compute each list as a task on the thread team.
+         */
+#pragma omp taskgroup
         {
-            clear_f(nbat, nb, out->f);
-        }
-
-        if ((force_flags & GMX_FORCE_VIRIAL) && nnbl == 1)
-        {
-            fshift_p = fshift;
-        }
-        else
-        {
-            fshift_p = out->fshift;
-
-            if (clearF == enbvClearFYes)
+            for (nb = 0; nb < nnbl; nb++)
             {
-                clear_fshift(fshift_p);
+#pragma omp task firstprivate(nb)
+                nbnxn_kernel_ref_list(nbl_list, nb, nbat, ic, shift_vec,
+                                      force_flags, clearF, fshift,
+                                      coult, vdwt);
             }
         }
-
-        if (!(force_flags & GMX_FORCE_ENERGY))
-        {
-            /* Don't calculate energies */
-            p_nbk_c_noener[coult][vdwt](nbl[nb], nbat,
-                                        ic,
-                                        shift_vec,
-                                        out->f,
-                                        fshift_p);
-        }
-        else if (out->nV == 1)
-        {
-            /* No energy groups */
-            out->Vvdw[0] = 0;
-            out->Vc[0]   = 0;
-
-            p_nbk_c_ener[coult][vdwt](nbl[nb], nbat,
-                                      ic,
-                                      shift_vec,
-                                      out->f,
-                                      fshift_p,
-                                      out->Vvdw,
-                                      out->Vc);
-        }
-        else
+    }
+    else
+    {
+        // cppcheck-suppress unreadVariable
+        nthreads = gmx_omp_nthreads_get(emntNonbonded);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (nb = 0; nb < nnbl; nb++)
         {
-            /* Calculate energy group contributions */
-            int i;
-
-            for (i = 0; i < out->nV; i++)
-            {
-                out->Vvdw[i] = 0;
-            }
-            for (i = 0; i < out->nV; i++)
-            {
-                out->Vc[i] = 0;
-            }
-
-            p_nbk_c_energrp[coult][vdwt](nbl[nb], nbat,
-                                         ic,
-                                         shift_vec,
-                                         out->f,
-                                         fshift_p,
-                                         out->Vvdw,
-                                         out->Vc);
+            // Presently, the kernels do not call C++ code that can throw, so
+            // no need for a try/catch pair in this OpenMP region.
+            nbnxn_kernel_ref_list(nbl_list, nb, nbat, ic, shift_vec,
+                                  force_flags, clearF, fshift,
+                                  coult, vdwt);
         }
     }
 
@@ -43,7 +43,10 @@
 extern "C" {
 #endif
 
-/* Wrapper call for the non-bonded n vs n reference kernels */
+/* Wrapper call for the non-bonded n vs n reference kernels.
+ * With bUseTasks, this should be called by a single thread of an active
+ * OpenMP parallel region and the lists are computed as tasks.
+ */
 void
 nbnxn_kernel_ref(const nbnxn_pairlist_set_t *nbl_list,
                  const nbnxn_atomdata_t     *nbat,
@@ -53,7 +56,8 @@ nbnxn_kernel_ref(const nbnxn_pairlist_set_t *nbl_list,
                  int                         clearF,
                  real                       *fshift,
                  real                       *Vc,
-                 real                       *Vvdw);
+                 real                       *Vvdw,
+                 gmx_bool                    bUseTasks);
 
 #ifdef __cplusplus
 }
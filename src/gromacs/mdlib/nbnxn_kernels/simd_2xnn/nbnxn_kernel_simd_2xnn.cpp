@@ -253,6 +253,94 @@ reduce_group_energies(int ng, int ng_2log,
     }
 }
 
+/*! \brief Computes the interactions in pair list \p nb of \p nbl_list */
+static void
+nbnxn_kernel_list(const nbnxn_pairlist_set_t *nbl_list,
+                  int                         nb,
+                  const nbnxn_atomdata_t     *nbat,
+                  const interaction_const_t  *ic,
+                  rvec                       *shift_vec,
+                  int                         force_flags,
+                  int                         clearF,
+                  real                       *fshift,
+                  int                         coulkt,
+                  int                         vdwkt)
+{
+    nbnxn_atomdata_output_t *out;
+    real                    *fshift_p;
+
+    out = &nbat->out[nb];
+
+    if (clearF == enbvClearFYes)
+    {
+        clear_f(nbat, nb, out->f);
+    }
+
+    if ((force_flags & GMX_FORCE_VIRIAL) && nbl_list->nnbl == 1)
+    {
+        fshift_p = fshift;
+    }
+    else
+    {
+        fshift_p = out->fshift;
+
+        if (clearF == enbvClearFYes)
+        {
+            clear_fshift(fshift_p);
+        }
+    }
+
+    if (!(force_flags & GMX_FORCE_ENERGY))
+    {
+        /* Don't calculate energies */
+        p_nbk_noener[coulkt][vdwkt](nbl_list->nbl[nb], nbat,
+                                    ic,
+                                    shift_vec,
+                                    out->f,
+                                    fshift_p);
+    }
+    else if (out->nV == 1)
+    {
+        /* No energy groups */
+        out->Vvdw[0] = 0;
+        out->Vc[0]   = 0;
+
+        p_nbk_ener[coulkt][vdwkt](nbl_list->nbl[nb], nbat,
+                                  ic,
+                                  shift_vec,
+                                  out->f,
+                                  fshift_p,
+                                  out->Vvdw,
+                                  out->Vc);
+    }
+    else
+    {
+        /* Calculate energy group contributions */
+        int i;
+
+        for (i = 0; i < out->nVS; i++)
+        {
+            out->VSvdw[i] = 0;
+        }
+        for (i = 0; i < out->nVS; i++)
+        {
+            out->VSc[i] = 0;
+        }
+
+        p_nbk_energrp[coulkt][vdwkt](nbl_list->nbl[nb], nbat,
+                                     ic,
+                                     shift_vec,
+                                     out->f,
+                                     fshift_p,
+                                     out->VSvdw,
+                                     out->VSc);
+
+        reduce_group_energies(nbat->nenergrp, nbat->neg_2log,
+                              out->VSvdw, out->VSc,
+                              out->Vvdw, out->Vc);
+    }
+}
+
 #else /* GMX_NBNXN_SIMD_2XNN */
 
 #include "gromacs/utility/fatalerror.h"
@@ -269,17 +357,16 @@ nbnxn_kernel_simd_2xnn(nbnxn_pairlist_set_t      gmx_unused *nbl_list,
                        int                       gmx_unused  clearF,
                        real                      gmx_unused *fshift,
                        real                      gmx_unused *Vc,
-                       real                      gmx_unused *Vvdw)
+                       real                      gmx_unused *Vvdw,
+                       gmx_bool                  gmx_unused  bUseTasks)
 #ifdef GMX_NBNXN_SIMD_2XNN
 {
     int                nnbl;
-    nbnxn_pairlist_t **nbl;
     int                coulkt, vdwkt = 0;
     int                nb;
     int                nthreads gmx_unused;
 
     nnbl = nbl_list->nnbl;
-    nbl  = nbl_list->nbl;
 
     if (EEL_RF(ic->eeltype) || ic->eeltype == eelCUT)
     {
@@ -348,84 +435,33 @@ nbnxn_kernel_simd_2xnn(nbnxn_pairlist_set_t      gmx_unused *nbl_list,
         gmx_incons("Unsupported VdW interaction type");
     }
 
-    nthreads = gmx_omp_nthreads_get(emntNonbonded);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (nb = 0; nb < nnbl; nb++)
+    if (bUseTasks)
     {
-        // Presently, the kernels do not call C++ code that can throw, so
-        // no need for a try/catch pair in this OpenMP region.
-        nbnxn_atomdata_output_t *out;
-        real                    *fshift_p;
-
-        out = &nbat->out[nb];
-
-        if (clearF == enbvClearFYes)
+        /* We are called by one thread of a parallel region,
+         * compute each list as a task on the thread team.
+         */
+#pragma omp taskgroup
         {
-            clear_f(nbat, nb, out->f);
-        }
-
-        if ((force_flags & GMX_FORCE_VIRIAL) && nnbl == 1)
-        {
-            fshift_p = fshift;
-        }
-        else
-        {
-            fshift_p = out->fshift;
-
-            if (clearF == enbvClearFYes)
+            for (nb = 0; nb < nnbl; nb++)
             {
-                clear_fshift(fshift_p);
+#pragma omp task firstprivate(nb)
+                nbnxn_kernel_list(nbl_list, nb, nbat, ic, shift_vec,
+                                  force_flags, clearF, fshift,
+                                  coulkt, vdwkt);
             }
         }
-
-        if (!(force_flags & GMX_FORCE_ENERGY))
-        {
-            /* Don't calculate energies */
-            p_nbk_noener[coulkt][vdwkt](nbl[nb], nbat,
-                                        ic,
-                                        shift_vec,
-                                        out->f,
-                                        fshift_p);
-        }
-        else if (out->nV == 1)
-        {
-            /* No energy groups */
-            out->Vvdw[0] = 0;
-            out->Vc[0]   = 0;
-
-            p_nbk_ener[coulkt][vdwkt](nbl[nb], nbat,
-                                      ic,
-                                      shift_vec,
-                                      out->f,
-                                      fshift_p,
-                                      out->Vvdw,
-                                      out->Vc);
-        }
-        else
+    }
+    else
+    {
+        nthreads = gmx_omp_nthreads_get(emntNonbonded);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (nb = 0; nb < nnbl; nb++)
         {
-            /* Calculate energy group contributions */
-            int i;
-
-            for (i = 0; i < out->nVS; i++)
-            {
-                out->VSvdw[i] = 0;
-            }
-            for (i = 0; i < out->nVS; i++)
-            {
-                out->VSc[i] = 0;
-            }
-
-            p_nbk_energrp[coulkt][vdwkt](nbl[nb], nbat,
-                                         ic,
-                                         shift_vec,
-                                         out->f,
-                                         fshift_p,
-                                         out->VSvdw,
-                                         out->VSc);
-
-            reduce_group_energies(nbat->nenergrp, nbat->neg_2log,
-                                  out->VSvdw, out->VSc,
-                                  out->Vvdw, out->Vc);
+            // Presently, the kernels do not call C++ code that can throw, so
+            // no need for a try/catch pair in this OpenMP region.
+            nbnxn_kernel_list(nbl_list, nb, nbat, ic, shift_vec,
+                              force_flags, clearF, fshift,
+                              coulkt, vdwkt);
         }
     }
 
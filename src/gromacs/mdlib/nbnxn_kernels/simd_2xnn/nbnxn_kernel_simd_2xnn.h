@@ -40,7 +40,12 @@
 #include "gromacs/legacyheaders/types/forcerec.h"
 #include "gromacs/mdlib/nbnxn_pairlist.h"
 
-/*! \brief Run-time dispatcher for nbnxn kernel functions. */
+/*! \brief Run-time dispatcher for nbnxn kernel functions.
+ *
+ * With \p bUseTasks, this should be called by a single thread of
+ * an active OpenMP parallel region and the pair lists are computed
+ * as tasks by the thread team.
+ */
 void
 nbnxn_kernel_simd_2xnn(nbnxn_pairlist_set_t       *nbl_list,
                        const nbnxn_atomdata_t     *nbat,
@@ -51,7 +56,8 @@ nbnxn_kernel_simd_2xnn(nbnxn_pairlist_set_t       *nbl_list,
                        int                         clearF,
                        real                       *fshift,
                        real                       *Vc,
-                       real                       *Vvdw);
+                       real                       *Vvdw,
+                       gmx_bool                    bUseTasks);
 
 /* Need an #include guard so that sim_util.c can include all
  * such files. */
@@ -162,6 +162,16 @@ typedef struct nbnxn_pairlist_t {
     int                     excl_nalloc; /* The allocation size for excl             */
     int                     nci_tot;     /* The total number of i clusters           */
 
+    /* With dynamic pruning the list built by the search is stored below
+     * and ci/cj above hold the list pruned from it with a shorter cut-off.
+     */
+    int                     nci_outer;       /* The number of i-clusters in the outer list */
+    nbnxn_ci_t             *ci_outer;        /* The outer i-cluster list                   */
+    int                     ci_outer_nalloc; /* The allocation size of ci_outer            */
+    int                     ncj_outer;       /* The number of j-clusters in the outer list */
+    nbnxn_cj_t             *cj_outer;        /* The outer j-cluster list                   */
+    int                     cj_outer_nalloc; /* The allocation size of cj_outer            */
+
     struct nbnxn_list_work *work;
 
     gmx_cache_protect_t     cp1;
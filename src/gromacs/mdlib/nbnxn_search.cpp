@@ -775,6 +775,13 @@ static void nbnxn_init_pairlist(nbnxn_pairlist_t *nbl,
     nbl->cj4         = NULL;
     nbl->nci_tot     = 0;
 
+    nbl->nci_outer       = 0;
+    nbl->ci_outer        = NULL;
+    nbl->ci_outer_nalloc = 0;
+    nbl->ncj_outer       = 0;
+    nbl->cj_outer        = NULL;
+    nbl->cj_outer_nalloc = 0;
+
     if (!nbl->bSimple)
     {
         nbl->excl        = NULL;
@@ -1204,6 +1211,34 @@ static void make_cluster_list_simple(const nbnxn_grid_t *gridj,
     }
 }
 
+/* Plain C code for checking if any atom pair of the i-cluster, set in work
+ * by icell_set_x_simple, and j-cluster cj is within the cut-off.
+ * Used for pruning a simple list.
+ */
+static gmx_bool cluster_pair_in_range_simple(const nbnxn_list_work_t *work,
+                                             const real *x_j, int cj,
+                                             real rl2)
+{
+    const real *x_ci = work->x_ci;
+
+    for (int i = 0; i < NBNXN_CPU_CLUSTER_I_SIZE; i++)
+    {
+        for (int j = 0; j < NBNXN_CPU_CLUSTER_I_SIZE; j++)
+        {
+            int ja = (cj*NBNXN_CPU_CLUSTER_I_SIZE + j)*STRIDE_XYZ;
+
+            if (sqr(x_ci[i*STRIDE_XYZ+XX] - x_j[ja+XX]) +
+                sqr(x_ci[i*STRIDE_XYZ+YY] - x_j[ja+YY]) +
+                sqr(x_ci[i*STRIDE_XYZ+ZZ] - x_j[ja+ZZ]) < rl2)
+            {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
 #ifdef GMX_NBNXN_SIMD_4XN
 #include "gromacs/mdlib/nbnxn_search_simd_4xn.h"
 #endif
@@ -4147,3 +4182,126 @@ void nbnxn_make_pairlist(const nbnxn_search_t  nbs,
         }
     }
 }
+
+/* Prunes the outer list stored in nbl to the list with cut-off rlist_inner */
+static void prune_pairlist_simple(const nbnxn_search_t     nbs,
+                                  nbnxn_pairlist_t        *nbl,
+                                  const nbnxn_atomdata_t  *nbat,
+                                  real                     rlist_inner,
+                                  int                      nb_kernel_type)
+{
+    const real *x;
+    real        rl2;
+#ifdef GMX_NBNXN_SIMD
+    gmx_simd_real_t rc2_S;
+#endif
+
+    x   = nbat->x;
+    rl2 = rlist_inner*rlist_inner;
+#ifdef GMX_NBNXN_SIMD
+    rc2_S = gmx_simd_set1_r(rl2);
+#endif
+
+    /* The inner list is never longer than the outer list */
+    nbl->nci = 0;
+    nbl->ncj = 0;
+    if (nbl->nci_outer > nbl->ci_nalloc)
+    {
+        nb_realloc_ci(nbl, nbl->nci_outer);
+    }
+    check_subcell_list_space_simple(nbl, nbl->ncj_outer);
+
+    for (int i = 0; i < nbl->nci_outer; i++)
+    {
+        const nbnxn_ci_t *ci_outer = &nbl->ci_outer[i];
+        int               shift    = ci_outer->shift & NBNXN_CI_SHIFT;
+        int               ncj_prev = nbl->ncj;
+
+        nbs->icell_set_x(ci_outer->ci,
+                         nbat->shift_vec[shift][XX],
+                         nbat->shift_vec[shift][YY],
+                         nbat->shift_vec[shift][ZZ],
+                         nbl->na_ci, nbat->xstride, x, nbl->work);
+
+        for (int cjind = ci_outer->cj_ind_start; cjind < ci_outer->cj_ind_end; cjind++)
+        {
+            const nbnxn_cj_t *cj_outer = &nbl->cj_outer[cjind];
+            gmx_bool          InRange  = FALSE;
+
+            switch (nb_kernel_type)
+            {
+                case nbnxnk4x4_PlainC:
+                    InRange = cluster_pair_in_range_simple(nbl->work, x, cj_outer->cj, rl2);
+                    break;
+#ifdef GMX_NBNXN_SIMD_4XN
+                case nbnxnk4xN_SIMD_4xN:
+                    InRange = cluster_pair_in_range_simd_4xn(nbl->work, x, cj_outer->cj, rc2_S);
+                    break;
+#endif
+#ifdef GMX_NBNXN_SIMD_2XNN
+                case nbnxnk4xN_SIMD_2xNN:
+                    InRange = cluster_pair_in_range_simd_2xnn(nbl->work, x, cj_outer->cj, rc2_S);
+                    break;
+#endif
+                default:
+                    gmx_incons("Pair-list pruning is only supported with CPU kernels");
+            }
+
+            /* We keep the order of the j-clusters, since the kernels
+             * expect the ones with exclusions at the start of the list.
+             */
+            if (InRange)
+            {
+                nbl->cj[nbl->ncj++] = *cj_outer;
+            }
+        }
+
+        if (nbl->ncj > ncj_prev)
+        {
+            nbl->ci[nbl->nci]              = *ci_outer;
+            nbl->ci[nbl->nci].cj_ind_start = ncj_prev;
+            nbl->ci[nbl->nci].cj_ind_end   = nbl->ncj;
+            nbl->nci++;
+        }
+    }
+}
+
+void nbnxn_prune_pairlist_set(const nbnxn_search_t    nbs,
+                              nbnxn_pairlist_set_t   *nbl_list,
+                              gmx_bool                bNewOuter,
+                              const nbnxn_atomdata_t *nbat,
+                              real                    rlist_inner,
+                              int                     nb_kernel_type)
+{
+    int nnbl = nbl_list->nnbl;
+
+    if (!nbl_list->bSimple)
+    {
+        gmx_incons("Pair-list pruning is only supported for simple lists");
+    }
+
+#pragma omp parallel for num_threads(nnbl) schedule(static)
+    for (int th = 0; th < nnbl; th++)
+    {
+        try
+        {
+            nbnxn_pairlist_t *nbl = nbl_list->nbl[th];
+
+            if (bNewOuter)
+            {
+                /* Move the list that was just searched to the outer list,
+                 * the old outer list storage is reused for the inner list.
+                 */
+                std::swap(nbl->nci, nbl->nci_outer);
+                std::swap(nbl->ci, nbl->ci_outer);
+                std::swap(nbl->ci_nalloc, nbl->ci_outer_nalloc);
+                std::swap(nbl->ncj, nbl->ncj_outer);
+                std::swap(nbl->cj, nbl->cj_outer);
+                std::swap(nbl->cj_nalloc, nbl->cj_outer_nalloc);
+            }
+
+            prune_pairlist_simple(nbs, nbl, nbat, rlist_inner, nb_kernel_type);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
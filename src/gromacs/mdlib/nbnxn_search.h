@@ -82,4 +82,18 @@ void nbnxn_make_pairlist(const nbnxn_search_t  nbs,
                          int                   nb_kernel_type,
                          t_nrnb               *nrnb);
 
+/* Prunes the lists in nbl_list, made with radius rlist by
+ * nbnxn_make_pairlist, to the shorter radius rlist_inner.
+ * With bNewOuter the lists were just made by nbnxn_make_pairlist and are
+ * stored as outer lists. Otherwise the lists are pruned again from
+ * the stored outer lists, which is cheaper than a search.
+ * Only supported for simple (CPU) lists.
+ */
+void nbnxn_prune_pairlist_set(const nbnxn_search_t    nbs,
+                              nbnxn_pairlist_set_t   *nbl_list,
+                              gmx_bool                bNewOuter,
+                              const nbnxn_atomdata_t *nbat,
+                              real                    rlist_inner,
+                              int                     nb_kernel_type);
+
 #endif
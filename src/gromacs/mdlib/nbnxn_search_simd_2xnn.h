@@ -261,4 +261,57 @@ make_cluster_list_simd_2xnn(const nbnxn_grid_t *gridj,
     }
 }
 
+/* SIMD code for checking if any atom pair of the i-cluster, set in work
+ * by icell_set_x_simd_2xnn, and j-cluster cj is within the cut-off.
+ * This is an accelerated version of cluster_pair_in_range_simple.
+ */
+static gmx_inline gmx_bool
+cluster_pair_in_range_simd_2xnn(const nbnxn_list_work_t *nbl_work,
+                                const real *x_j, int cj,
+                                gmx_simd_real_t rc2_S)
+{
+    const nbnxn_x_ci_simd_2xnn_t *work;
+
+    gmx_simd_real_t                jx_S, jy_S, jz_S;
+
+    gmx_simd_real_t                dx_S0, dy_S0, dz_S0;
+    gmx_simd_real_t                dx_S2, dy_S2, dz_S2;
+
+    gmx_simd_real_t                rsq_S0;
+    gmx_simd_real_t                rsq_S2;
+
+    gmx_simd_bool_t                wco_S0;
+    gmx_simd_bool_t                wco_S2;
+    gmx_simd_bool_t                wco_any_S;
+
+    int                            xind;
+
+    work = nbl_work->x_ci_simd_2xnn;
+
+    xind = X_IND_CJ_SIMD_2XNN(cj);
+
+    jx_S = gmx_load_hpr_hilo_pr(x_j+xind+0*STRIDE_S);
+    jy_S = gmx_load_hpr_hilo_pr(x_j+xind+1*STRIDE_S);
+    jz_S = gmx_load_hpr_hilo_pr(x_j+xind+2*STRIDE_S);
+
+    /* Calculate distance */
+    dx_S0       = gmx_simd_sub_r(work->ix_S0, jx_S);
+    dy_S0       = gmx_simd_sub_r(work->iy_S0, jy_S);
+    dz_S0       = gmx_simd_sub_r(work->iz_S0, jz_S);
+    dx_S2       = gmx_simd_sub_r(work->ix_S2, jx_S);
+    dy_S2       = gmx_simd_sub_r(work->iy_S2, jy_S);
+    dz_S2       = gmx_simd_sub_r(work->iz_S2, jz_S);
+
+    /* rsq = dx*dx+dy*dy+dz*dz */
+    rsq_S0      = gmx_simd_calc_rsq_r(dx_S0, dy_S0, dz_S0);
+    rsq_S2      = gmx_simd_calc_rsq_r(dx_S2, dy_S2, dz_S2);
+
+    wco_S0      = gmx_simd_cmplt_r(rsq_S0, rc2_S);
+    wco_S2      = gmx_simd_cmplt_r(rsq_S2, rc2_S);
+
+    wco_any_S   = gmx_simd_or_b(wco_S0, wco_S2);
+
+    return gmx_simd_anytrue_b(wco_any_S);
+}
+
 #undef STRIDE_S
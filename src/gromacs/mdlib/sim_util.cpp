@@ -45,6 +45,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/essentialdynamics/edsam.h"
 #include "gromacs/ewald/pme.h"
@@ -58,6 +60,7 @@
 #include "gromacs/legacyheaders/force.h"
 #include "gromacs/legacyheaders/genborn.h"
 #include "gromacs/legacyheaders/gmx_omp_nthreads.h"
+#include "gromacs/legacyheaders/gmx_thread_affinity.h"
 #include "gromacs/legacyheaders/names.h"
 #include "gromacs/legacyheaders/network.h"
 #include "gromacs/legacyheaders/nonbonded.h"
@@ -66,6 +69,7 @@
 #include "gromacs/legacyheaders/typedefs.h"
 #include "gromacs/legacyheaders/types/commrec.h"
 #include "gromacs/listed-forces/bonded.h"
+#include "gromacs/listed-forces/listed-forces.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/calcmu.h"
@@ -96,6 +100,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
@@ -345,7 +350,8 @@ static void pull_potential_wrapper(t_commrec *cr,
 static void pme_receive_force_ener(t_commrec      *cr,
                                    gmx_wallcycle_t wcycle,
                                    gmx_enerdata_t *enerd,
-                                   t_forcerec     *fr)
+                                   t_forcerec     *fr,
+                                   rvec            f[])
 {
     real   e_q, e_lj, dvdl_q, dvdl_lj;
     float  cycles_ppdpme, cycles_seppme;
@@ -359,7 +365,7 @@ static void pme_receive_force_ener(t_commrec      *cr,
     wallcycle_start(wcycle, ewcPP_PMEWAITRECVF);
     dvdl_q  = 0;
     dvdl_lj = 0;
-    gmx_pme_receive_f(cr, fr->f_novirsum, fr->vir_el_recip, &e_q,
+    gmx_pme_receive_f(cr, f, fr->vir_el_recip, &e_q,
                       fr->vir_lj_recip, &e_lj, &dvdl_q, &dvdl_lj,
                       &cycles_seppme);
     enerd->term[F_COUL_RECIP] += e_q;
@@ -457,13 +463,53 @@ static void post_process_forces(t_commrec *cr,
     }
 }
 
+/* With dynamic pruning, prunes the outer pair list of the given locality
+ * to the inner list when this is required at this step.
+ */
+static void do_nb_verlet_prune(nonbonded_verlet_t        *nbv,
+                               const interaction_const_t *ic,
+                               int                        ilocality,
+                               gmx_int64_t                step,
+                               gmx_bool                   bNS,
+                               gmx_wallcycle_t            wcycle)
+{
+    nonbonded_verlet_group_t *nbvg = &nbv->grp[ilocality];
+    real                      rlist_inner;
+
+    if (!nbv->bDynamicPrune || !nbvg->nbl_lists.bSimple)
+    {
+        return;
+    }
+
+    if (bNS)
+    {
+        nbv->step_search = step;
+    }
+    else if ((step - nbv->step_search) % nbv->nstlist_prune != 0)
+    {
+        return;
+    }
+
+    /* PME load balancing changes the cut-off, but keeps the buffer */
+    rlist_inner = std::min(ic->rlist,
+                           std::max(ic->rcoulomb, ic->rvdw) + nbv->rbuf_inner);
+
+    wallcycle_start_nocount(wcycle, ewcNS);
+    wallcycle_sub_start(wcycle, ewcsNONBONDED_PRUNING);
+    nbnxn_prune_pairlist_set(nbv->nbs, &nbvg->nbl_lists, bNS,
+                             nbvg->nbat, rlist_inner, nbvg->kernel_type);
+    wallcycle_sub_stop(wcycle, ewcsNONBONDED_PRUNING);
+    wallcycle_stop(wcycle, ewcNS);
+}
+
 static void do_nb_verlet(t_forcerec *fr,
                          interaction_const_t *ic,
                          gmx_enerdata_t *enerd,
                          int flags, int ilocality,
                          int clearF,
                          t_nrnb *nrnb,
-                         gmx_wallcycle_t wcycle)
+                         gmx_wallcycle_t wcycle,
+                         gmx_bool bUseTasks)
 {
     int                        enr_nbnxn_kernel_ljc, enr_nbnxn_kernel_lj;
     nonbonded_verlet_group_t  *nbvg;
@@ -501,7 +547,8 @@ static void do_nb_verlet(t_forcerec *fr,
                              enerd->grpp.ener[egCOULSR],
                              fr->bBHAM ?
                              enerd->grpp.ener[egBHAMSR] :
-                             enerd->grpp.ener[egLJSR]);
+                             enerd->grpp.ener[egLJSR],
+                             bUseTasks);
             break;
 
         case nbnxnk4xN_SIMD_4xN:
@@ -515,7 +562,8 @@ static void do_nb_verlet(t_forcerec *fr,
                                   enerd->grpp.ener[egCOULSR],
                                   fr->bBHAM ?
                                   enerd->grpp.ener[egBHAMSR] :
-                                  enerd->grpp.ener[egLJSR]);
+                                  enerd->grpp.ener[egLJSR],
+                                  bUseTasks);
             break;
         case nbnxnk4xN_SIMD_2xNN:
             nbnxn_kernel_simd_2xnn(&nbvg->nbl_lists,
@@ -528,7 +576,8 @@ static void do_nb_verlet(t_forcerec *fr,
                                    enerd->grpp.ener[egCOULSR],
                                    fr->bBHAM ?
                                    enerd->grpp.ener[egBHAMSR] :
-                                   enerd->grpp.ener[egLJSR]);
+                                   enerd->grpp.ener[egLJSR],
+                                   bUseTasks);
             break;
 
         case nbnxnk8x8x8_GPU:
@@ -723,6 +772,113 @@ static void do_nb_verlet_fep(nbnxn_pairlist_set_t *nbl_lists,
     wallcycle_sub_stop(wcycle, ewcsNONBONDED);
 }
 
+/* Computes the PME mesh, listed and local non-bonded forces as OpenMP
+ * tasks on one thread team, instead of one parallel region per force
+ * type with a (load imbalance) barrier at the end of each.
+ * The mesh forces are added to f_mesh, when not NULL, and its energies
+ * are consumed by the next call to do_force_lowlevel. The reduction
+ * of the non-bonded force buffers into f starts as soon as the listed
+ * and non-bonded tasks are done, while the mesh task can still run.
+ */
+static void do_force_tasks(t_commrec *cr, t_inputrec *ir,
+                           t_nrnb *nrnb, gmx_wallcycle_t wcycle,
+                           gmx_localtop_t *top,
+                           matrix box, rvec x[], history_t *hist,
+                           rvec f[], rvec f_mesh[],
+                           t_mdatoms *md,
+                           gmx_enerdata_t *enerd, t_fcdata *fcd,
+                           real *lambda,
+                           t_forcerec *fr, interaction_const_t *ic,
+                           int flags)
+{
+    nonbonded_verlet_t *nbv;
+    t_pbc               pbc;
+    t_nrnb              nrnb_listed;
+
+    nbv = fr->nbv;
+
+    if (fr->bMolPBC)
+    {
+        set_pbc_dd(&pbc, fr->ePBC, cr->dd, TRUE, box);
+    }
+    /* The listed task counts into a separate buffer to avoid races */
+    init_nrnb(&nrnb_listed);
+
+#pragma omp parallel num_threads(fr->nthread_force_tasks)
+    {
+#pragma omp single
+        {
+            try
+            {
+                if (f_mesh != NULL)
+                {
+#pragma omp task
+                    {
+                        try
+                        {
+                            /* Run the mesh part on a nested team with
+                             * the PME thread count. This only affects
+                             * the parallel regions inside this task.
+                             * With pinning, the nested threads would
+                             * inherit the single core of this thread,
+                             * so we let them use the cores of the
+                             * threads that are not in the task team.
+                             */
+                            int thread = gmx_omp_get_thread_num();
+
+                            gmx_omp_set_nested(TRUE);
+                            gmx_extend_thread_affinity(fr->nthread_force_tasks,
+                                                       gmx_omp_nthreads_get(emntNonbonded));
+                            do_force_pme_mesh_task(fr, cr, wcycle, md,
+                                                   x, f_mesh, box,
+                                                   lambda, flags);
+                            gmx_pin_thread_to_assigned_core(thread);
+                        }
+                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                    }
+                }
+
+#pragma omp taskgroup
+                {
+                    if (flags & GMX_FORCE_LISTED)
+                    {
+#pragma omp task
+                        {
+                            try
+                            {
+                                do_force_listed(wcycle, box, ir->fepvals,
+                                                cr->ms, &top->idef,
+                                                (const rvec *) x, hist,
+                                                f, fr, &pbc, NULL, enerd,
+                                                &nrnb_listed, lambda, md,
+                                                fcd, NULL, flags);
+                            }
+                            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                        }
+                    }
+
+                    do_nb_verlet(fr, ic, enerd, flags, eintLocal,
+                                 enbvClearFYes, nrnb, wcycle, TRUE);
+                }
+
+                nbnxn_atomdata_add_nbat_f_to_f_tasks(nbv->nbs,
+                                                     nbv->grp[eintLocal].nbat,
+                                                     f);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+    }
+
+    add_nrnb(nrnb, nrnb, &nrnb_listed);
+
+    if ((flags & GMX_FORCE_VIRIAL) &&
+        nbv->grp[eintLocal].nbl_lists.nnbl > 1)
+    {
+        nbnxn_atomdata_add_nbat_fshift_to_fshift(nbv->grp[eintLocal].nbat,
+                                                 fr->fshift);
+    }
+}
+
 gmx_bool use_GPU(const nonbonded_verlet_t *nbv)
 {
     return nbv != NULL && nbv->bUseGPU;
@@ -751,7 +907,9 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
     gmx_bool            bStateChanged, bNS, bFillGrid, bCalcCGCM;
     gmx_bool            bDoLongRange, bDoForces, bSepLRF, bUseGPU, bUseOrEmulGPU;
     gmx_bool            bDiffKernels = FALSE;
+    gmx_bool            bForceTasks;
     rvec                vzero, box_diag;
+    rvec               *f_mesh_task = NULL;
     float               cycles_pme, cycles_force, cycles_wait_gpu;
     nonbonded_verlet_t *nbv;
 
@@ -781,11 +939,17 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
     bNS           = (flags & GMX_FORCE_NS) && (fr->bAllvsAll == FALSE);
     bFillGrid     = (bNS && bStateChanged);
     bCalcCGCM     = (bFillGrid && !DOMAINDECOMP(cr));
-    bDoLongRange  = (fr->bTwinRange && bNS && (flags & GMX_FORCE_DO_LR));
     bDoForces     = (flags & GMX_FORCE_FORCES);
-    bSepLRF       = (bDoLongRange && bDoForces && (flags & GMX_FORCE_SEPLRF));
+    /* With multiple time stepping of the long-range forces, the PME mesh
+     * part is only computed at DO_LR steps and stored separately in f_twin.
+     */
+    bDoLongRange  = (!(fr->bMtsLongRange && (flags & GMX_FORCE_SEPLRF)) ||
+                     (flags & GMX_FORCE_DO_LR));
+    bSepLRF       = (fr->bMtsLongRange && bDoLongRange && bDoForces &&
+                     (flags & GMX_FORCE_SEPLRF));
     bUseGPU       = fr->nbv->bUseGPU;
     bUseOrEmulGPU = bUseGPU || (nbv->grp[0].kernel_type == nbnxnk8x8x8_PlainC);
+    bForceTasks   = fr->bForceTasks;
 
     if (bStateChanged)
     {
@@ -827,7 +991,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
                                  fr->shift_vec, nbv->grp[0].nbat);
 
 #ifdef GMX_MPI
-    if (!(cr->duty & DUTY_PME))
+    if (!(cr->duty & DUTY_PME) && bDoLongRange)
     {
         gmx_bool bBS;
         matrix   boxs;
@@ -969,12 +1133,14 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         wallcycle_stop(wcycle, ewcNB_XF_BUF_OPS);
     }
 
+    do_nb_verlet_prune(nbv, ic, eintLocal, step, bNS, wcycle);
+
     if (bUseGPU)
     {
         wallcycle_start(wcycle, ewcLAUNCH_GPU_NB);
         /* launch local nonbonded F on GPU */
         do_nb_verlet(fr, ic, enerd, flags, eintLocal, enbvClearFNo,
-                     nrnb, wcycle);
+                     nrnb, wcycle, FALSE);
         wallcycle_stop(wcycle, ewcLAUNCH_GPU_NB);
     }
 
@@ -1050,12 +1216,14 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
             cycles_force += wallcycle_stop(wcycle, ewcNB_XF_BUF_OPS);
         }
 
+        do_nb_verlet_prune(nbv, ic, eintNonlocal, step, bNS, wcycle);
+
         if (bUseGPU && !bDiffKernels)
         {
             wallcycle_start(wcycle, ewcLAUNCH_GPU_NB);
             /* launch non-local nonbonded F on GPU */
             do_nb_verlet(fr, ic, enerd, flags, eintNonlocal, enbvClearFNo,
-                         nrnb, wcycle);
+                         nrnb, wcycle, FALSE);
             cycles_force += wallcycle_stop(wcycle, ewcLAUNCH_GPU_NB);
         }
     }
@@ -1109,7 +1277,10 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
 
     if (DOMAINDECOMP(cr) && !(cr->duty & DUTY_PME))
     {
-        wallcycle_start(wcycle, ewcPPDURINGPME);
+        if (bDoLongRange)
+        {
+            wallcycle_start(wcycle, ewcPPDURINGPME);
+        }
         dd_force_flop_start(cr->dd, nrnb);
     }
 
@@ -1159,7 +1330,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
 
         /* Clear the short- and long-range forces */
         clear_rvecs(fr->natoms_force_constr, f);
-        if (bSepLRF && do_per_step(step, inputrec->nstcalclr))
+        if (bSepLRF)
         {
             clear_rvecs(fr->natoms_force_constr, fr->f_twin);
         }
@@ -1180,11 +1351,38 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
      * decomposition load balancing.
      */
 
-    if (!bUseOrEmulGPU)
+    if (bForceTasks)
+    {
+        if (bDoForces && pme_mesh_is_needed(fr, cr, flags))
+        {
+            /* The mesh task can not add to f concurrently with the other
+             * tasks, so without virial we use the separate buffer and
+             * add it to f after do_force_lowlevel.
+             */
+            if (bSepLRF)
+            {
+                f_mesh_task = fr->f_twin;
+            }
+            else if (fr->f_novirsum == f)
+            {
+                f_mesh_task = fr->f_novirsum_alloc;
+                clear_rvecs(homenr, f_mesh_task);
+            }
+            else
+            {
+                f_mesh_task = fr->f_novirsum;
+            }
+        }
+
+        do_force_tasks(cr, inputrec, nrnb, wcycle, top, box, x, hist,
+                       f, f_mesh_task, mdatoms, enerd, fcd, lambda,
+                       fr, ic, flags);
+    }
+    else if (!bUseOrEmulGPU)
     {
         /* Maybe we should move this into do_force_lowlevel */
         do_nb_verlet(fr, ic, enerd, flags, eintLocal, enbvClearFYes,
-                     nrnb, wcycle);
+                     nrnb, wcycle, FALSE);
     }
 
     if (fr->efep != efepNO)
@@ -1210,7 +1408,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         }
     }
 
-    if (!bUseOrEmulGPU || bDiffKernels)
+    if (!bForceTasks && (!bUseOrEmulGPU || bDiffKernels))
     {
         int aloc;
 
@@ -1218,7 +1416,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         {
             do_nb_verlet(fr, ic, enerd, flags, eintNonlocal,
                          bDiffKernels ? enbvClearFYes : enbvClearFNo,
-                         nrnb, wcycle);
+                         nrnb, wcycle, FALSE);
         }
 
         if (!bUseOrEmulGPU)
@@ -1259,24 +1457,21 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         update_QMMMrec(cr, fr, x, mdatoms, box, top);
     }
 
-    /* Compute the bonded and non-bonded energies and optionally forces */
+    /* Compute the bonded and non-bonded energies and optionally forces,
+     * the listed forces have already been computed by a task.
+     */
     do_force_lowlevel(fr, inputrec, &(top->idef),
                       cr, nrnb, wcycle, mdatoms,
                       x, hist, f, bSepLRF ? fr->f_twin : f, enerd, fcd, top, fr->born,
                       bBornRadii, box,
                       inputrec->fepvals, lambda, graph, &(top->excls), fr->mu_tot,
-                      flags, &cycles_pme);
+                      bForceTasks ? (flags & ~GMX_FORCE_LISTED) : flags,
+                      &cycles_pme);
 
-    if (bSepLRF)
+    if (f_mesh_task != NULL && f_mesh_task != fr->f_novirsum &&
+        f_mesh_task != fr->f_twin)
     {
-        if (do_per_step(step, inputrec->nstcalclr))
-        {
-            /* Add the long range forces to the short range forces */
-            for (i = 0; i < fr->natoms_force_constr; i++)
-            {
-                rvec_add(fr->f_twin[i], f[i], f[i]);
-            }
-        }
+        sum_forces(0, homenr, f, f_mesh_task);
     }
 
     cycles_force += wallcycle_stop(wcycle, ewcFORCE);
@@ -1308,7 +1503,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
             {
                 wallcycle_start_nocount(wcycle, ewcFORCE);
                 do_nb_verlet(fr, ic, enerd, flags, eintNonlocal, enbvClearFYes,
-                             nrnb, wcycle);
+                             nrnb, wcycle, FALSE);
                 cycles_force += wallcycle_stop(wcycle, ewcFORCE);
             }
             wallcycle_start(wcycle, ewcNB_XF_BUF_OPS);
@@ -1339,13 +1534,6 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         /* Communicate the forces */
         wallcycle_start(wcycle, ewcMOVEF);
         dd_move_f(cr->dd, f, fr->fshift);
-        if (bSepLRF)
-        {
-            /* We should not update the shift forces here,
-             * since f_twin is already included in f.
-             */
-            dd_move_f(cr->dd, fr->f_twin, NULL);
-        }
         wallcycle_stop(wcycle, ewcMOVEF);
     }
 
@@ -1413,7 +1601,7 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
             wallcycle_start_nocount(wcycle, ewcFORCE);
             do_nb_verlet(fr, ic, enerd, flags, eintLocal,
                          DOMAINDECOMP(cr) ? enbvClearFNo : enbvClearFYes,
-                         nrnb, wcycle);
+                         nrnb, wcycle, FALSE);
             wallcycle_stop(wcycle, ewcFORCE);
         }
         wallcycle_start(wcycle, ewcNB_XF_BUF_OPS);
@@ -1456,15 +1644,6 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
             spread_vsite_f(vsite, x, f, fr->fshift, FALSE, NULL, nrnb,
                            &top->idef, fr->ePBC, fr->bMolPBC, graph, box, cr);
             wallcycle_stop(wcycle, ewcVSITESPREAD);
-
-            if (bSepLRF)
-            {
-                wallcycle_start(wcycle, ewcVSITESPREAD);
-                spread_vsite_f(vsite, x, fr->f_twin, NULL, FALSE, NULL,
-                               nrnb,
-                               &top->idef, fr->ePBC, fr->bMolPBC, graph, box, cr);
-                wallcycle_stop(wcycle, ewcVSITESPREAD);
-            }
         }
 
         if (flags & GMX_FORCE_VIRIAL)
@@ -1496,12 +1675,30 @@ void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
     /* Add forces from interactive molecular dynamics (IMD), if bIMD == TRUE. */
     IMD_apply_forces(inputrec->bIMD, inputrec->imd, cr, f, wcycle);
 
-    if (PAR(cr) && !(cr->duty & DUTY_PME))
+    if (PAR(cr) && !(cr->duty & DUTY_PME) && bDoLongRange)
     {
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(cr, wcycle, enerd, fr);
+        pme_receive_force_ener(cr, wcycle, enerd, fr,
+                               bSepLRF ? fr->f_twin : fr->f_novirsum);
+    }
+
+    if (bSepLRF)
+    {
+        /* Add the separately stored mesh forces, so f contains the total
+         * force. The update adds the extra multiple time step contribution.
+         */
+        if (vsite)
+        {
+            wallcycle_start(wcycle, ewcVSITESPREAD);
+            spread_vsite_f(vsite, x, fr->f_twin, NULL,
+                           (flags & GMX_FORCE_VIRIAL), fr->vir_el_recip,
+                           nrnb,
+                           &top->idef, fr->ePBC, fr->bMolPBC, graph, box, cr);
+            wallcycle_stop(wcycle, ewcVSITESPREAD);
+        }
+        sum_forces(0, homenr, f, fr->f_twin);
     }
 
     if (bDoForces)
@@ -1962,7 +2159,7 @@ void do_force_cutsGROUP(FILE *fplog, t_commrec *cr,
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(cr, wcycle, enerd, fr);
+        pme_receive_force_ener(cr, wcycle, enerd, fr, fr->f_novirsum);
     }
 
     if (bDoForces)
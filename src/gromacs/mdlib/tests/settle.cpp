@@ -0,0 +1,331 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include <math.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/constr.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! SPC water O-H distance
+const real dOH = 0.1;
+//! SPC water H-H distance
+const real dHH = 0.1633;
+//! Oxygen mass
+const real mO  = 15.9994;
+//! Hydrogen mass
+const real mH  = 1.008;
+
+/*! \brief Test fixture for testing SETTLE
+ *
+ * Uses more waters than the widest SIMD width, with a remainder,
+ * so both the SIMD and plain-C code paths are exercised. */
+class SettleTest : public ::testing::Test
+{
+    public:
+        //! Set up ideal waters, positions after an unconstrained update and the topology
+        SettleTest() : numSettles_(19)
+        {
+            settled_ = settle_init(mO, mH, 1/mO, 1/mH, dOH, dHH);
+
+            real HH2 = 0.5*dHH;
+            real yH  = sqrt(dOH*dOH - HH2*HH2);
+
+            box_[XX][XX] = 1.9;
+            box_[XX][YY] = 0;
+            box_[XX][ZZ] = 0;
+            box_[YY][XX] = 0;
+            box_[YY][YY] = 2.1;
+            box_[YY][ZZ] = 0;
+            box_[ZZ][XX] = 0.3;
+            box_[ZZ][YY] = 0.2;
+            box_[ZZ][ZZ] = 2.3;
+
+            for (int i = 0; i < numSettles_; i++)
+            {
+                /* A water in the xy-plane, rotated around z and x */
+                real phi   = 0.7*i;
+                real theta = 0.3 + 0.45*i;
+                rvec local[3];
+                rvec com;
+
+                local[0][XX] = 0;
+                local[0][YY] = 0;
+                local[0][ZZ] = 0;
+                local[1][XX] = -HH2;
+                local[1][YY] = yH;
+                local[1][ZZ] = 0;
+                local[2][XX] = HH2;
+                local[2][YY] = yH;
+                local[2][ZZ] = 0;
+
+                com[XX] = 0.1*(i % 7);
+                com[YY] = 0.2*(i % 5);
+                com[ZZ] = 0.15*(i % 3);
+
+                /* The interaction type, followed by the O and the two H */
+                iatom_.push_back(0);
+                for (int a = 0; a < 3; a++)
+                {
+                    real xr = cos(phi)*local[a][XX] - sin(phi)*local[a][YY];
+                    real yr = sin(phi)*local[a][XX] + cos(phi)*local[a][YY];
+                    real zr = local[a][ZZ];
+
+                    iatom_.push_back(3*i + a);
+                    x_.push_back(com[XX] + xr);
+                    x_.push_back(com[YY] + cos(theta)*yr - sin(theta)*zr);
+                    x_.push_back(com[ZZ] + sin(theta)*yr + cos(theta)*zr);
+                }
+            }
+            /* Generate positions after an unconstrained update */
+            for (size_t j = 0; j < x_.size(); j++)
+            {
+                xprime_.push_back(x_[j] + 0.004*sin(1.3*j + 0.1));
+                v_.push_back(0.5*cos(0.9*j));
+            }
+        }
+
+        ~SettleTest()
+        {
+            /* The settle data is opaque, but allocated as plain C struct */
+            sfree(static_cast<void *>(settled_));
+        }
+
+        //! Returns the distance between atoms a and b in \p x
+        real distance(const std::vector<real> &x, int a, int b)
+        {
+            rvec dx;
+
+            rvec_sub(&x[a*DIM], &x[b*DIM], dx);
+
+            return norm(dx);
+        }
+
+        //! Check that water i in \p x satisfies the constraints
+        void checkConstraints(const std::vector<real> &x, int i)
+        {
+            gmx::test::FloatingPointTolerance tolerance =
+                gmx::test::relativeToleranceAsFloatingPoint(dOH, 1e-5);
+
+            EXPECT_REAL_EQ_TOL(dOH, distance(x, 3*i, 3*i + 1), tolerance) << "water " << i;
+            EXPECT_REAL_EQ_TOL(dOH, distance(x, 3*i, 3*i + 2), tolerance) << "water " << i;
+            EXPECT_REAL_EQ_TOL(dHH, distance(x, 3*i + 1, 3*i + 2), tolerance) << "water " << i;
+        }
+
+        //! The SETTLE parameters
+        gmx_settledata_t     settled_;
+        //! The number of waters
+        int                  numSettles_;
+        //! The settle topology
+        std::vector<atom_id> iatom_;
+        //! Constrained positions before the update
+        std::vector<real>    x_;
+        //! Unconstrained positions after the update
+        std::vector<real>    xprime_;
+        //! Velocities
+        std::vector<real>    v_;
+        //! Triclinic box for the PBC test
+        matrix               box_;
+};
+
+TEST_F(SettleTest, SatisfiesConstraintsAndComputesVirial)
+{
+    std::vector<real> xprime  = xprime_;
+    std::vector<real> v       = v_;
+    const real        invdt   = 1/0.002;
+    tensor            vir;
+    int               error;
+
+    clear_mat(vir);
+    csettle(settled_, numSettles_, &iatom_[0], NULL,
+            &x_[0], &xprime[0], invdt, &v[0], 3*numSettles_, vir, &error);
+
+    EXPECT_EQ(-1, error);
+
+    double refVir[DIM][DIM] = { { 0 } };
+    for (int i = 0; i < numSettles_; i++)
+    {
+        checkConstraints(xprime, i);
+
+        for (int a = 3*i; a < 3*i + 3; a++)
+        {
+            real m = (a == 3*i ? mO : mH);
+
+            for (int d = 0; d < DIM; d++)
+            {
+                real dx = xprime[a*DIM + d] - xprime_[a*DIM + d];
+
+                /* The velocity change should match the displacement */
+                EXPECT_REAL_EQ_TOL(v_[a*DIM + d] + dx*invdt, v[a*DIM + d],
+                                   gmx::test::absoluteTolerance(1e-3));
+                for (int d2 = 0; d2 < DIM; d2++)
+                {
+                    refVir[d2][d] -= x_[a*DIM + d2]*m*(xprime[a*DIM + d] - xprime_[a*DIM + d]);
+                }
+            }
+        }
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int d2 = 0; d2 < DIM; d2++)
+        {
+            EXPECT_REAL_EQ_TOL(refVir[d][d2], vir[d][d2],
+                               gmx::test::absoluteTolerance(1e-5));
+        }
+    }
+}
+
+TEST_F(SettleTest, GivesSameResultsWithPbc)
+{
+    std::vector<real> xprimeRef = xprime_;
+    std::vector<real> x         = x_;
+    std::vector<real> xprime    = xprime_;
+    t_pbc             pbc;
+    tensor            vir;
+    int               error;
+
+    /* Shift the hydrogens of every other water by a box vector */
+    for (int i = 0; i < numSettles_; i += 2)
+    {
+        int dim = i % DIM;
+
+        for (int a = 3*i + 1; a < 3*i + 3; a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                x[a*DIM + d]      += box_[dim][d];
+                xprime[a*DIM + d] += box_[dim][d];
+            }
+        }
+    }
+
+    clear_mat(vir);
+    csettle(settled_, numSettles_, &iatom_[0], NULL,
+            &x_[0], &xprimeRef[0], 0, NULL, 0, vir, &error);
+    EXPECT_EQ(-1, error);
+
+    set_pbc(&pbc, epbcXYZ, box_);
+    csettle(settled_, numSettles_, &iatom_[0], &pbc,
+            &x[0], &xprime[0], 0, NULL, 0, vir, &error);
+    EXPECT_EQ(-1, error);
+
+    for (int i = 0; i < numSettles_; i++)
+    {
+        for (int a = 3*i; a < 3*i + 3; a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                real shift = x[a*DIM + d] - x_[a*DIM + d];
+
+                EXPECT_REAL_EQ_TOL(xprimeRef[a*DIM + d], xprime[a*DIM + d] - shift,
+                                   gmx::test::absoluteTolerance(1e-5));
+            }
+        }
+    }
+}
+
+TEST_F(SettleTest, ReportsWaterThatCanNotBeSettled)
+{
+    std::vector<real> xprime  = xprime_;
+    const int         badWater = 10;
+    rvec              normal, dOH2, dOH3;
+    tensor            vir;
+    int               error;
+
+    /* Move the oxygen far out of the plane of the old water */
+    rvec_sub(&x_[(3*badWater + 1)*DIM], &x_[3*badWater*DIM], dOH2);
+    rvec_sub(&x_[(3*badWater + 2)*DIM], &x_[3*badWater*DIM], dOH3);
+    cprod(dOH2, dOH3, normal);
+    unitv(normal, normal);
+    for (int d = 0; d < DIM; d++)
+    {
+        xprime[3*badWater*DIM + d] += 0.2*normal[d];
+    }
+
+    clear_mat(vir);
+    csettle(settled_, numSettles_, &iatom_[0], NULL,
+            &x_[0], &xprime[0], 0, NULL, 0, vir, &error);
+
+    EXPECT_EQ(badWater, error);
+    for (int i = 0; i < numSettles_; i++)
+    {
+        if (i != badWater)
+        {
+            checkConstraints(xprime, i);
+        }
+    }
+}
+
+TEST_F(SettleTest, ProjectsOutConstraintVelocityComponents)
+{
+    std::vector<real> v       = v_;
+    tensor            vir;
+
+    clear_mat(vir);
+    settle_proj(settled_, econqVeloc, numSettles_, &iatom_[0], NULL,
+                reinterpret_cast<rvec *>(&x_[0]),
+                reinterpret_cast<rvec *>(&v[0]), reinterpret_cast<rvec *>(&v[0]),
+                0, vir);
+
+    for (int i = 0; i < numSettles_; i++)
+    {
+        const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+
+        for (int p = 0; p < 3; p++)
+        {
+            int  a = 3*i + pairs[p][0];
+            int  b = 3*i + pairs[p][1];
+            rvec dx, dv;
+
+            rvec_sub(&x_[a*DIM], &x_[b*DIM], dx);
+            rvec_sub(&v[a*DIM], &v[b*DIM], dv);
+            EXPECT_REAL_EQ_TOL(0, iprod(dx, dv), gmx::test::absoluteTolerance(1e-5))
+            << "water " << i << " pair " << p;
+        }
+    }
+}
+
+} // namespace
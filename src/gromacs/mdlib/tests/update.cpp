@@ -0,0 +1,297 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/legacyheaders/gmx_omp_nthreads.h"
+#include "gromacs/legacyheaders/inputrec.h"
+#include "gromacs/legacyheaders/nrnb.h"
+#include "gromacs/legacyheaders/typedefs.h"
+#include "gromacs/legacyheaders/types/commrec.h"
+#include "gromacs/legacyheaders/types/group.h"
+#include "gromacs/legacyheaders/types/mdatom.h"
+#include "gromacs/legacyheaders/types/nrnb.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/update.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief Test fixture for comparing the flat update kernels with the general ones
+ *
+ * update_coords uses the flat kernels when there are no freeze groups.
+ * Setting a freeze group array with all atoms in the non-frozen group 0
+ * gives the same physics, but takes the general per-atom code path.
+ * The atom count is not a multiple of any SIMD width, so both the SIMD
+ * and the plain-C remainder loops are exercised. Two T-coupling groups
+ * with the same coupling factors and friction, but different reference
+ * temperatures, check the per-atom group lookups of the SD noise.
+ */
+class UpdateTest : public ::testing::Test
+{
+    public:
+        //! Set up the atoms, forces and the input record for a leap-frog run
+        UpdateTest() : numAtoms_(23)
+        {
+            init_inputrec(&ir_);
+            ir_.eI            = eiMD;
+            ir_.delta_t       = 0.002;
+            ir_.etc           = etcBERENDSEN;
+            ir_.epc           = epcNO;
+            ir_.ld_seed       = 1993;
+            ir_.opts.ngtc     = 2;
+            snew(ir_.opts.ref_t, ir_.opts.ngtc);
+            snew(ir_.opts.tau_t, ir_.opts.ngtc);
+            snew(ir_.opts.nrdf, ir_.opts.ngtc);
+            ir_.opts.ref_t[0] = 300;
+            ir_.opts.ref_t[1] = 320;
+            for (int g = 0; g < ir_.opts.ngtc; g++)
+            {
+                ir_.opts.tau_t[g] = 0.5;
+                ir_.opts.nrdf[g]  = 3*numAtoms_/2;
+            }
+            ir_.opts.ngacc    = 1;
+            snew(ir_.opts.acc, ir_.opts.ngacc);
+            ir_.opts.ngfrz    = 1;
+            snew(ir_.opts.nFreeze, ir_.opts.ngfrz);
+
+            memset(&ekind_, 0, sizeof(ekind_));
+            snew(ekind_.tcstat, ir_.opts.ngtc);
+            for (int g = 0; g < ir_.opts.ngtc; g++)
+            {
+                ekind_.tcstat[g].lambda = 0.98;
+            }
+            snew(ekind_.grpstat, ir_.opts.ngacc);
+
+            for (int i = 0; i < numAtoms_; i++)
+            {
+                real invmass = 1/(1.0 + 15*(i % 3 == 0));
+
+                invmass_.push_back(invmass);
+                ptype_.push_back(eptAtom);
+                cTC_.push_back(i % 2);
+                cFREEZE_.push_back(0);
+                for (int d = 0; d < DIM; d++)
+                {
+                    int j = i*DIM + d;
+
+                    invMassPerDim_.push_back(invmass);
+                    x_.push_back(0.1*i + 0.3*sin(0.7*j));
+                    v_.push_back(0.5*cos(0.9*j + 0.2));
+                    f_.push_back(200*sin(1.3*j + 0.1));
+                }
+            }
+        }
+
+        ~UpdateTest()
+        {
+            sfree(ir_.opts.ref_t);
+            sfree(ir_.opts.tau_t);
+            sfree(ir_.opts.nrdf);
+            sfree(ir_.opts.acc);
+            sfree(ir_.opts.nFreeze);
+            sfree(ekind_.tcstat);
+            sfree(ekind_.grpstat);
+        }
+
+        /*! \brief Runs the parts \p parts of the update on copies of the atoms
+         *
+         * When \p bGeneral is set, the general kernels are used. The updated
+         * coordinates and velocities are returned in \p x and \p v.
+         */
+        void runUpdate(const std::vector<int> &parts, bool bGeneral, int numThreads,
+                       std::vector<real> *x, std::vector<real> *v)
+        {
+            t_mdatoms     md;
+            t_state       state;
+            t_commrec     cr;
+            t_nrnb        nrnb;
+            gmx_update_t  upd;
+            matrix        M;
+            tensor        vir;
+            real          dvdl = 0;
+            gmx_int64_t   step = 5;
+
+            memset(&md, 0, sizeof(md));
+            md.homenr         = numAtoms_;
+            md.invmass        = &invmass_[0];
+            md.invMassPerDim  = reinterpret_cast<rvec *>(&invMassPerDim_[0]);
+            md.ptype          = &ptype_[0];
+            md.cTC            = &cTC_[0];
+            md.cFREEZE        = bGeneral ? &cFREEZE_[0] : NULL;
+
+            init_state(&state, numAtoms_, ir_.opts.ngtc, 0, 0, 0);
+            state.veta = 0.1;
+            for (int j = 0; j < numAtoms_*DIM; j++)
+            {
+                state.x[0][j] = x_[j];
+                state.v[0][j] = v_[j];
+            }
+
+            memset(&cr, 0, sizeof(cr));
+            init_nrnb(&nrnb);
+            clear_mat(M);
+            upd = init_update(&ir_);
+
+            gmx_omp_nthreads_set(emntUpdate, numThreads);
+
+            for (size_t p = 0; p < parts.size(); p++)
+            {
+                update_coords(NULL, step, &ir_, &md, &state, FALSE,
+                              reinterpret_cast<rvec *>(&f_[0]),
+                              FALSE, NULL, NULL, NULL, &ekind_, M, upd, FALSE,
+                              parts[p], &cr, &nrnb, NULL, NULL);
+            }
+            if (parts.back() == etrtPOSITION)
+            {
+                /* Without constraints, this copies the updated coordinates */
+                update_constraints(NULL, step, &dvdl, &ir_, &md, &state, FALSE,
+                                   NULL, reinterpret_cast<rvec *>(&f_[0]),
+                                   NULL, vir, &cr, &nrnb, NULL, upd, NULL,
+                                   FALSE, FALSE);
+            }
+
+            x->assign(state.x[0], state.x[0] + numAtoms_*DIM);
+            v->assign(state.v[0], state.v[0] + numAtoms_*DIM);
+
+            done_state(&state);
+        }
+
+        //! Checks that the flat kernels give the same results as the general ones
+        void checkFlatKernels(const std::vector<int> &parts)
+        {
+            std::vector<real> xRef, vRef;
+
+            runUpdate(parts, true, 1, &xRef, &vRef);
+
+            /* With multiple threads the atom ranges per thread
+             * do not start at multiples of the SIMD width.
+             */
+            const int threadCounts[] = { 1, 3, 7 };
+            for (size_t t = 0; t < sizeof(threadCounts)/sizeof(threadCounts[0]); t++)
+            {
+                std::vector<real> x, v;
+
+                runUpdate(parts, false, threadCounts[t], &x, &v);
+
+                for (int j = 0; j < numAtoms_*DIM; j++)
+                {
+                    /* The flat kernels can use FMA, so results can differ
+                     * by a few ulp of the largest values.
+                     */
+                    EXPECT_REAL_EQ_TOL(xRef[j], x[j],
+                                       gmx::test::relativeToleranceAsFloatingPoint(10, 1e-6))
+                    << "x element " << j << " with " << threadCounts[t] << " threads";
+                    EXPECT_REAL_EQ_TOL(vRef[j], v[j],
+                                       gmx::test::relativeToleranceAsFloatingPoint(10, 1e-6))
+                    << "v element " << j << " with " << threadCounts[t] << " threads";
+                }
+                /* Check that the update actually changed something */
+                EXPECT_NE(x_[0], x[0]);
+            }
+        }
+
+        //! The number of atoms
+        int                         numAtoms_;
+        //! The input record
+        t_inputrec                  ir_;
+        //! The T-coupling factors and acceleration data
+        gmx_ekindata_t              ekind_;
+        //! Inverse masses
+        std::vector<real>           invmass_;
+        //! Inverse masses for each dimension
+        std::vector<real>           invMassPerDim_;
+        //! Particle types
+        std::vector<unsigned short> ptype_;
+        //! T-coupling group indices
+        std::vector<unsigned short> cTC_;
+        //! Freeze group indices, all in the non-frozen group 0
+        std::vector<unsigned short> cFREEZE_;
+        //! Initial coordinates
+        std::vector<real>           x_;
+        //! Initial velocities
+        std::vector<real>           v_;
+        //! Forces
+        std::vector<real>           f_;
+};
+
+TEST_F(UpdateTest, LeapFrogFlatKernelMatchesGeneralKernel)
+{
+    std::vector<int> parts(1, etrtPOSITION);
+
+    checkFlatKernels(parts);
+}
+
+TEST_F(UpdateTest, StochasticDynamicsFlatKernelMatchesGeneralKernel)
+{
+    std::vector<int> parts(1, etrtPOSITION);
+
+    ir_.eI = eiSD1;
+    checkFlatKernels(parts);
+}
+
+TEST_F(UpdateTest, VelocityVerletFlatKernelsMatchGeneralKernels)
+{
+    std::vector<int> parts;
+
+    parts.push_back(etrtVELOCITY1);
+    parts.push_back(etrtPOSITION);
+
+    ir_.eI = eiVV;
+    checkFlatKernels(parts);
+}
+
+TEST_F(UpdateTest, ExtendedVelocityVerletFlatKernelsMatchGeneralKernels)
+{
+    std::vector<int> parts;
+
+    parts.push_back(etrtVELOCITY1);
+    parts.push_back(etrtPOSITION);
+
+    ir_.eI  = eiVV;
+    ir_.etc = etcNOSEHOOVER;
+    checkFlatKernels(parts);
+}
+
+} // namespace
@@ -95,6 +95,11 @@ do_md_trajectory_writing(FILE           *fplog,
     if (bCPT)
     {
         mdof_flags |= MDOF_CPT;
+        if (bLastStep && step_rel == ir->nsteps && bDoConfOut && !bRerunMD)
+        {
+            /* The final configuration is written from the global state */
+            mdof_flags |= MDOF_COLLECT_X_V;
+        }
     }
     ;
 
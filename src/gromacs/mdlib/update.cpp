@@ -64,6 +64,7 @@
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pulling/pull.h"
 #include "gromacs/random/random.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
@@ -71,6 +72,11 @@
 #include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
+#if defined GMX_SIMD_HAVE_REAL && defined GMX_SIMD_HAVE_LOADU && defined GMX_SIMD_HAVE_STOREU
+/* We can use SIMD for the flat-array update kernels */
+#define UPDATE_SIMD
+#endif
+
 /*For debugging, start at v(-dt/2) for velolcity verlet -- uncomment next line */
 /*#define STARTFROMDT2*/
 
@@ -99,6 +105,9 @@ typedef struct {
     gmx_sd_sigma_t *sdsig;
     rvec           *sd_V;
     int             sd_V_nalloc;
+    /* SD1 noise buffer, filled per step before the flat update loop */
+    rvec           *sd_rnd;
+    int             sd_rnd_nalloc;
     /* andersen temperature control stuff */
     gmx_bool       *randomize_group;
     real           *boltzfac;
@@ -261,6 +270,175 @@ static void do_update_md(int start, int nrend, double dt,
     }
 }
 
+/* The update kernels below are used when all atoms are updated in the same
+ * way and independently for each dimension: no vsites or shells, no freeze
+ * groups and no acceleration groups. Then the rvec arrays can be processed
+ * as flat real arrays, using SIMD when available, without any per-atom
+ * group lookups.
+ */
+static gmx_bool update_is_simple(const t_inputrec *ir, const t_mdatoms *md)
+{
+    const t_grpopts *opts = &ir->opts;
+
+    return (!md->bHaveVsitesOrShells && md->cFREEZE == NULL &&
+            !opts->nFreeze[0][XX] && !opts->nFreeze[0][YY] && !opts->nFreeze[0][ZZ] &&
+            opts->ngacc <= 1 && norm2(opts->acc[0]) == 0);
+}
+
+/* Returns whether all T-coupling groups have the same scaling factor */
+static gmx_bool tcouple_lambda_is_uniform(int ngtc, const t_grp_tcstat *tcstat)
+{
+    int i;
+
+    for (i = 1; i < ngtc; i++)
+    {
+        if (tcstat[i].lambda != tcstat[0].lambda)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Leap-frog update with T-coupling scaling factor lg for all atoms */
+static void do_update_md_simple(int start, int nrend, real dt, real lg,
+                                const rvec invMassPerDim[],
+                                const rvec x[], rvec xprime[], rvec v[],
+                                const rvec f[])
+{
+    const real *im  = invMassPerDim[0];
+    const real *xf  = x[0];
+    const real *ff  = f[0];
+    real       *vf  = v[0];
+    real       *xpf = xprime[0];
+    int         i, iEnd;
+
+    i    = start*DIM;
+    iEnd = nrend*DIM;
+#ifdef UPDATE_SIMD
+    {
+        gmx_simd_real_t dt_S = gmx_simd_set1_r(dt);
+        gmx_simd_real_t lg_S = gmx_simd_set1_r(lg);
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= iEnd; i += GMX_SIMD_REAL_WIDTH)
+        {
+            gmx_simd_real_t v_S, f_S;
+
+            f_S = gmx_simd_mul_r(gmx_simd_loadu_r(ff + i), gmx_simd_loadu_r(im + i));
+            v_S = gmx_simd_fmadd_r(lg_S, gmx_simd_loadu_r(vf + i),
+                                   gmx_simd_mul_r(f_S, dt_S));
+            gmx_simd_storeu_r(vf + i, v_S);
+            gmx_simd_storeu_r(xpf + i, gmx_simd_fmadd_r(v_S, dt_S, gmx_simd_loadu_r(xf + i)));
+        }
+    }
+#endif
+    for (; i < iEnd; i++)
+    {
+        vf[i]  = lg*vf[i] + ff[i]*im[i]*dt;
+        xpf[i] = xf[i] + vf[i]*dt;
+    }
+}
+
+/* Velocity Verlet velocity update without freeze or acceleration groups */
+static void do_update_vv_vel_simple(int start, int nrend, double dt,
+                                    const rvec invMassPerDim[],
+                                    rvec v[], const rvec f[],
+                                    gmx_bool bExtended, real veta, real alpha)
+{
+    const real *im = invMassPerDim[0];
+    const real *ff = f[0];
+    real       *vf = v[0];
+    double      g, mv1, mv2;
+    real        fac_v, fac_f;
+    int         i, iEnd;
+
+    if (bExtended)
+    {
+        g        = 0.25*dt*veta*alpha;
+        mv1      = exp(-g);
+        mv2      = series_sinhx(g);
+    }
+    else
+    {
+        mv1      = 1.0;
+        mv2      = 1.0;
+    }
+    fac_v = mv1*mv1;
+    fac_f = 0.5*dt*mv1*mv2;
+
+    i    = start*DIM;
+    iEnd = nrend*DIM;
+#ifdef UPDATE_SIMD
+    {
+        gmx_simd_real_t fac_v_S = gmx_simd_set1_r(fac_v);
+        gmx_simd_real_t fac_f_S = gmx_simd_set1_r(fac_f);
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= iEnd; i += GMX_SIMD_REAL_WIDTH)
+        {
+            gmx_simd_real_t f_S;
+
+            f_S = gmx_simd_mul_r(gmx_simd_loadu_r(ff + i), gmx_simd_loadu_r(im + i));
+            gmx_simd_storeu_r(vf + i,
+                              gmx_simd_fmadd_r(fac_v_S, gmx_simd_loadu_r(vf + i),
+                                               gmx_simd_mul_r(fac_f_S, f_S)));
+        }
+    }
+#endif
+    for (; i < iEnd; i++)
+    {
+        vf[i] = fac_v*vf[i] + fac_f*im[i]*ff[i];
+    }
+}
+
+/* Velocity Verlet position update without freeze groups */
+static void do_update_vv_pos_simple(int start, int nrend, double dt,
+                                    const rvec x[], rvec xprime[],
+                                    const rvec v[],
+                                    gmx_bool bExtended, real veta)
+{
+    const real *xf  = x[0];
+    const real *vf  = v[0];
+    real       *xpf = xprime[0];
+    double      g, mr1, mr2;
+    real        fac_x, fac_v;
+    int         i, iEnd;
+
+    if (bExtended)
+    {
+        g        = 0.5*dt*veta;
+        mr1      = exp(g);
+        mr2      = series_sinhx(g);
+    }
+    else
+    {
+        mr1      = 1.0;
+        mr2      = 1.0;
+    }
+    fac_x = mr1*mr1;
+    fac_v = mr1*mr2*dt;
+
+    i    = start*DIM;
+    iEnd = nrend*DIM;
+#ifdef UPDATE_SIMD
+    {
+        gmx_simd_real_t fac_x_S = gmx_simd_set1_r(fac_x);
+        gmx_simd_real_t fac_v_S = gmx_simd_set1_r(fac_v);
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= iEnd; i += GMX_SIMD_REAL_WIDTH)
+        {
+            gmx_simd_storeu_r(xpf + i,
+                              gmx_simd_fmadd_r(fac_x_S, gmx_simd_loadu_r(xf + i),
+                                               gmx_simd_mul_r(fac_v_S, gmx_simd_loadu_r(vf + i))));
+        }
+    }
+#endif
+    for (; i < iEnd; i++)
+    {
+        xpf[i] = fac_x*xf[i] + fac_v*vf[i];
+    }
+}
+
 static void do_update_vv_vel(int start, int nrend, double dt,
                              rvec accel[], ivec nFreeze[], real invmass[],
                              unsigned short ptype[], unsigned short cFREEZE[],
@@ -718,6 +896,158 @@ static void do_update_sd1(gmx_stochd_t *sd,
     }
 }
 
+/* Returns whether all T-coupling groups have the same SD friction factor */
+static gmx_bool sd_friction_is_uniform(int ngtc, const gmx_sd_const_t *sdc)
+{
+    int i;
+
+    for (i = 1; i < ngtc; i++)
+    {
+        if (sdc[i].em != sdc[0].em)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* SD1 update for the simple case, see update_is_simple, with the same
+ * friction for all atoms. The random noise, which is drawn per atom from
+ * the counter-based generator and thus independent of the parallel setup,
+ * is generated for the whole atom range first. This leaves a flat loop
+ * without group lookups that can be done with SIMD.
+ * The first part of the update with constraints is a plain leap-frog
+ * update, which is done with do_update_md_simple.
+ */
+static void do_update_sd1_simple(gmx_stochd_t *sd,
+                                 int start, int nrend, double dt,
+                                 const rvec invMassPerDim[], const real invmass[],
+                                 const unsigned short cTC[],
+                                 const rvec x[], rvec xprime[], rvec v[], const rvec f[],
+                                 int ngtc, const real ref_t[],
+                                 gmx_bool bDoConstr,
+                                 gmx_int64_t step, int seed, const int *gatindex)
+{
+    gmx_sd_const_t *sdc;
+    gmx_sd_sigma_t *sig;
+    rvec           *sd_rnd;
+    const real     *im, *xf, *ff, *rf;
+    real           *vf, *xpf;
+    real            em, ism;
+    int             gt = 0;
+    int             n, d, i, iEnd;
+
+    sdc    = sd->sdc;
+    sig    = sd->sdsig;
+    sd_rnd = sd->sd_rnd;
+
+    for (n = 0; n < ngtc; n++)
+    {
+        /* The mass is encounted for later, since this differs per atom */
+        sig[n].V  = sqrt(BOLTZ*ref_t[n]*(1 - sdc[n].em*sdc[n].em));
+    }
+    em = sdc[0].em;
+
+    for (n = start; n < nrend; n++)
+    {
+        real rnd[3];
+        int  ng = gatindex ? gatindex[n] : n;
+
+        ism = sqrt(invmass[n]);
+        if (cTC)
+        {
+            gt  = cTC[n];
+        }
+
+        gmx_rng_cycle_3gaussian_table(step, ng, seed, RND_SEED_UPDATE, rnd);
+
+        for (d = 0; d < DIM; d++)
+        {
+            sd_rnd[n][d] = ism*sig[gt].V*rnd[d];
+        }
+    }
+
+    im   = invMassPerDim[0];
+    xf   = x[0];
+    ff   = f[0];
+    rf   = sd_rnd[0];
+    vf   = v[0];
+    xpf  = xprime[0];
+    i    = start*DIM;
+    iEnd = nrend*DIM;
+    if (!bDoConstr)
+    {
+#ifdef UPDATE_SIMD
+        gmx_simd_real_t dt_S     = gmx_simd_set1_r(dt);
+        gmx_simd_real_t halfdt_S = gmx_simd_set1_r(0.5*dt);
+        gmx_simd_real_t em_S     = gmx_simd_set1_r(em);
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= iEnd; i += GMX_SIMD_REAL_WIDTH)
+        {
+            gmx_simd_real_t f_S, vn_S, v_S;
+
+            f_S  = gmx_simd_mul_r(gmx_simd_loadu_r(ff + i), gmx_simd_loadu_r(im + i));
+            vn_S = gmx_simd_fmadd_r(f_S, dt_S, gmx_simd_loadu_r(vf + i));
+            v_S  = gmx_simd_fmadd_r(vn_S, em_S, gmx_simd_loadu_r(rf + i));
+            gmx_simd_storeu_r(vf + i, v_S);
+            /* Here we include half of the friction+noise
+             * update of v into the integration of x.
+             */
+            gmx_simd_storeu_r(xpf + i,
+                              gmx_simd_fmadd_r(gmx_simd_add_r(vn_S, v_S), halfdt_S,
+                                               gmx_simd_loadu_r(xf + i)));
+        }
+#endif
+        for (; i < iEnd; i++)
+        {
+            real vn;
+
+            vn     = vf[i] + im[i]*ff[i]*dt;
+            vf[i]  = vn*em + rf[i];
+            xpf[i] = xf[i] + 0.5*(vn + vf[i])*dt;
+        }
+    }
+    else
+    {
+        /* Update friction and noise only */
+#ifdef UPDATE_SIMD
+        gmx_simd_real_t halfdt_S = gmx_simd_set1_r(0.5*dt);
+        gmx_simd_real_t em_S     = gmx_simd_set1_r(em);
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= iEnd; i += GMX_SIMD_REAL_WIDTH)
+        {
+            gmx_simd_real_t vn_S, v_S;
+
+            vn_S = gmx_simd_loadu_r(vf + i);
+            v_S  = gmx_simd_fmadd_r(vn_S, em_S, gmx_simd_loadu_r(rf + i));
+            gmx_simd_storeu_r(vf + i, v_S);
+            /* Add the friction and noise contribution only */
+            gmx_simd_storeu_r(xpf + i,
+                              gmx_simd_fmadd_r(gmx_simd_sub_r(v_S, vn_S), halfdt_S,
+                                               gmx_simd_loadu_r(xpf + i)));
+        }
+#endif
+        for (; i < iEnd; i++)
+        {
+            real vn;
+
+            vn     = vf[i];
+            vf[i]  = vn*em + rf[i];
+            xpf[i] = xpf[i] + 0.5*(vf[i] - vn)*dt;
+        }
+    }
+}
+
+static void check_sd1_work_data_allocation(gmx_stochd_t *sd, int nrend)
+{
+    if (nrend > sd->sd_rnd_nalloc)
+    {
+        sd->sd_rnd_nalloc = over_alloc_dd(nrend);
+        srenew(sd->sd_rnd, sd->sd_rnd_nalloc);
+    }
+}
+
 static void check_sd2_work_data_allocation(gmx_stochd_t *sd, int nrend)
 {
     if (nrend > sd->sd_V_nalloc)
@@ -1493,9 +1823,12 @@ static void combine_forces(gmx_update_t upd,
                 }
             }
         }
+        /* xp is the constrained coordinates plus a displacement, so
+         * the constraint virial is obtained by constraining coordinates.
+         */
         constrain(NULL, FALSE, FALSE, constr, idef, ir, cr, step, 0, 1.0, md,
-                  state->x, xp, xp, bMolPBC, state->box, state->lambda[efptBONDED], NULL,
-                  NULL, vir_lr_constr, nrnb, econqForce);
+                  state->x, xp, NULL, bMolPBC, state->box, state->lambda[efptBONDED], NULL,
+                  NULL, vir_lr_constr, nrnb, econqCoord);
     }
 
     /* Add nstcalclr-1 times the LR force to the sum of both forces
@@ -1535,6 +1868,7 @@ void update_constraints(FILE             *fplog,
     tensor               vir_con;
     rvec                *xprime = NULL;
     int                  nth, th;
+    gmx_bool             bSimple;
 
     if (constr)
     {
@@ -1636,6 +1970,13 @@ void update_constraints(FILE             *fplog,
         wallcycle_start(wcycle, ewcUPDATE);
         xprime = get_xprime(state, upd);
 
+        bSimple = (update_is_simple(inputrec, md) &&
+                   sd_friction_is_uniform(inputrec->opts.ngtc, upd->sd->sdc));
+        if (bSimple)
+        {
+            check_sd1_work_data_allocation(upd->sd, nrend);
+        }
+
         nth = gmx_omp_nthreads_get(emntUpdate);
 
 #pragma omp parallel for num_threads(nth) schedule(static)
@@ -1649,16 +1990,30 @@ void update_constraints(FILE             *fplog,
                 end_th   = start + ((nrend-start)*(th+1))/nth;
 
                 /* The second part of the SD integration */
-                do_update_sd1(upd->sd,
-                              start_th, end_th, dt,
-                              inputrec->opts.acc, inputrec->opts.nFreeze,
-                              md->invmass, md->ptype,
-                              md->cFREEZE, md->cACC, md->cTC,
-                              state->x, xprime, state->v, force,
-                              inputrec->opts.ngtc, inputrec->opts.ref_t,
-                              bDoConstr, FALSE,
-                              step, inputrec->ld_seed,
-                              DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                if (bSimple)
+                {
+                    do_update_sd1_simple(upd->sd,
+                                         start_th, end_th, dt,
+                                         md->invMassPerDim, md->invmass, md->cTC,
+                                         state->x, xprime, state->v, force,
+                                         inputrec->opts.ngtc, inputrec->opts.ref_t,
+                                         TRUE,
+                                         step, inputrec->ld_seed,
+                                         DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                }
+                else
+                {
+                    do_update_sd1(upd->sd,
+                                  start_th, end_th, dt,
+                                  inputrec->opts.acc, inputrec->opts.nFreeze,
+                                  md->invmass, md->ptype,
+                                  md->cFREEZE, md->cACC, md->cTC,
+                                  state->x, xprime, state->v, force,
+                                  inputrec->opts.ngtc, inputrec->opts.ref_t,
+                                  bDoConstr, FALSE,
+                                  step, inputrec->ld_seed,
+                                  DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
@@ -1890,10 +2245,10 @@ void update_coords(FILE             *fplog,
                    gmx_constr_t      constr,
                    t_idef           *idef)
 {
-    gmx_bool          bNH, bPR, bDoConstr = FALSE;
+    gmx_bool          bNH, bPR, bDoConstr = FALSE, bSimple;
     double            dt, alpha;
     rvec             *force;
-    int               start, homenr, nrend;
+    int               start, homenr, nrend, nstcalclr;
     rvec             *xprime;
     int               nth, th;
 
@@ -1928,7 +2283,21 @@ void update_coords(FILE             *fplog,
     bNH = inputrec->etc == etcNOSEHOOVER;
     bPR = ((inputrec->epc == epcPARRINELLORAHMAN) || (inputrec->epc == epcMTTK));
 
-    if (bDoLR && inputrec->nstcalclr > 1 && !EI_VV(inputrec->eI))  /* get this working with VV? */
+    if (IR_MTS(*inputrec))
+    {
+        /* The long-range forces are applied as an impulse of mts_level2_factor
+         * times the force every mts_level2_factor steps. At other steps
+         * they are only computed for output and should not be applied.
+         */
+        nstcalclr = (do_per_step(step, inputrec->mts_level2_factor) ?
+                     inputrec->mts_level2_factor : 0);
+    }
+    else
+    {
+        nstcalclr = inputrec->nstcalclr;
+    }
+
+    if (bDoLR && (nstcalclr > 1 || IR_MTS(*inputrec)) && !EI_VV(inputrec->eI))  /* get this working with VV? */
     {
         /* Store the total force + nstcalclr-1 times the LR force
          * in forces_lr, so it can be used in a normal update algorithm
@@ -1936,7 +2305,7 @@ void update_coords(FILE             *fplog,
          */
         /* is this correct in the new construction? MRS */
         combine_forces(upd,
-                       inputrec->nstcalclr, constr, inputrec, md, idef, cr,
+                       nstcalclr, constr, inputrec, md, idef, cr,
                        step, state, bMolPBC,
                        start, nrend, f, f_lr, vir_lr_constr, nrnb);
         force = f_lr;
@@ -1967,6 +2336,23 @@ void update_coords(FILE             *fplog,
                              upd->sd->bd_rf);
     }
 
+    /* Check whether we can use the flat update kernels */
+    bSimple = update_is_simple(inputrec, md);
+    if (inputrec->eI == eiMD)
+    {
+        bSimple = (bSimple && !bNH && !bPR && ekind->cosacc.cos_accel == 0 &&
+                   tcouple_lambda_is_uniform(inputrec->opts.ngtc, ekind->tcstat));
+    }
+    else if (inputrec->eI == eiSD1)
+    {
+        bSimple = (bSimple &&
+                   sd_friction_is_uniform(inputrec->opts.ngtc, upd->sd->sdc));
+        if (bSimple)
+        {
+            check_sd1_work_data_allocation(upd->sd, nrend);
+        }
+    }
+
     nth = gmx_omp_nthreads_get(emntUpdate);
 
 #pragma omp parallel for num_threads(nth) schedule(static) private(alpha)
@@ -1982,7 +2368,14 @@ void update_coords(FILE             *fplog,
             switch (inputrec->eI)
             {
                 case (eiMD):
-                    if (ekind->cosacc.cos_accel == 0)
+                    if (bSimple)
+                    {
+                        do_update_md_simple(start_th, end_th, dt,
+                                            ekind->tcstat[0].lambda,
+                                            md->invMassPerDim,
+                                            state->x, xprime, state->v, force);
+                    }
+                    else if (ekind->cosacc.cos_accel == 0)
                     {
                         do_update_md(start_th, end_th, dt,
                                      ekind->tcstat, state->nosehoover_vxi,
@@ -2007,15 +2400,35 @@ void update_coords(FILE             *fplog,
                     break;
                 case (eiSD1):
                     /* With constraints, the SD1 update is done in 2 parts */
-                    do_update_sd1(upd->sd,
-                                  start_th, end_th, dt,
-                                  inputrec->opts.acc, inputrec->opts.nFreeze,
-                                  md->invmass, md->ptype,
-                                  md->cFREEZE, md->cACC, md->cTC,
-                                  state->x, xprime, state->v, force,
-                                  inputrec->opts.ngtc, inputrec->opts.ref_t,
-                                  bDoConstr, TRUE,
-                                  step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                    if (bSimple && bDoConstr)
+                    {
+                        /* The first part is leap-frog without friction and noise */
+                        do_update_md_simple(start_th, end_th, dt, 1.0,
+                                            md->invMassPerDim,
+                                            state->x, xprime, state->v, force);
+                    }
+                    else if (bSimple)
+                    {
+                        do_update_sd1_simple(upd->sd,
+                                             start_th, end_th, dt,
+                                             md->invMassPerDim, md->invmass, md->cTC,
+                                             state->x, xprime, state->v, force,
+                                             inputrec->opts.ngtc, inputrec->opts.ref_t,
+                                             FALSE,
+                                             step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                    }
+                    else
+                    {
+                        do_update_sd1(upd->sd,
+                                      start_th, end_th, dt,
+                                      inputrec->opts.acc, inputrec->opts.nFreeze,
+                                      md->invmass, md->ptype,
+                                      md->cFREEZE, md->cACC, md->cTC,
+                                      state->x, xprime, state->v, force,
+                                      inputrec->opts.ngtc, inputrec->opts.ref_t,
+                                      bDoConstr, TRUE,
+                                      step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : NULL);
+                    }
                     break;
                 case (eiSD2):
                     /* The SD2 update is always done in 2 parts,
@@ -2047,19 +2460,38 @@ void update_coords(FILE             *fplog,
                     {
                         case etrtVELOCITY1:
                         case etrtVELOCITY2:
-                            do_update_vv_vel(start_th, end_th, dt,
-                                             inputrec->opts.acc, inputrec->opts.nFreeze,
-                                             md->invmass, md->ptype,
-                                             md->cFREEZE, md->cACC,
-                                             state->v, force,
-                                             (bNH || bPR), state->veta, alpha);
+                            if (bSimple)
+                            {
+                                do_update_vv_vel_simple(start_th, end_th, dt,
+                                                        md->invMassPerDim,
+                                                        state->v, force,
+                                                        (bNH || bPR), state->veta, alpha);
+                            }
+                            else
+                            {
+                                do_update_vv_vel(start_th, end_th, dt,
+                                                 inputrec->opts.acc, inputrec->opts.nFreeze,
+                                                 md->invmass, md->ptype,
+                                                 md->cFREEZE, md->cACC,
+                                                 state->v, force,
+                                                 (bNH || bPR), state->veta, alpha);
+                            }
                             break;
                         case etrtPOSITION:
-                            do_update_vv_pos(start_th, end_th, dt,
-                                             inputrec->opts.nFreeze,
-                                             md->ptype, md->cFREEZE,
-                                             state->x, xprime, state->v,
-                                             (bNH || bPR), state->veta);
+                            if (bSimple)
+                            {
+                                do_update_vv_pos_simple(start_th, end_th, dt,
+                                                        state->x, xprime, state->v,
+                                                        (bNH || bPR), state->veta);
+                            }
+                            else
+                            {
+                                do_update_vv_pos(start_th, end_th, dt,
+                                                 inputrec->opts.nFreeze,
+                                                 md->ptype, md->cFREEZE,
+                                                 state->x, xprime, state->v,
+                                                 (bNH || bPR), state->veta);
+                            }
                             break;
                     }
                     break;
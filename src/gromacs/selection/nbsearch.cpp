@@ -40,8 +40,6 @@
  *
  * \todo
  * The grid implementation could still be optimized in several different ways:
- *   - Pruning grid cells from the search list if they are completely outside
- *     the sphere that is being considered.
  *   - A better heuristic could be added for falling back to simple loops for a
  *     small number of reference particles.
  *   - A better heuristic for selecting the grid size.
@@ -66,8 +64,10 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/selection/position.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/topology/block.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/mutex.h"
@@ -137,12 +137,16 @@ class AnalysisNeighborhoodSearchImpl
          * \param[in] excls           Exclusions.
          * \param[in] pbc             PBC information.
          * \param[in] positions       Set of reference positions.
+         * \param[in] gridReuseBuffer Distance that reference positions can
+         *     move out of their grid cells before the grid from the previous
+         *     call is rebuilt (<=0 disables reusing the grid).
          */
         void init(AnalysisNeighborhood::SearchMode     mode,
                   bool                                 bXY,
                   const t_blocka                      *excls,
                   const t_pbc                         *pbc,
-                  const AnalysisNeighborhoodPositions &positions);
+                  const AnalysisNeighborhoodPositions &positions,
+                  real                                 gridReuseBuffer);
         PairSearchImplPointer getPairSearch();
 
         real cutoffSquared() const { return cutoff2_; }
@@ -179,18 +183,56 @@ class AnalysisNeighborhoodSearchImpl
          * \returns   `false` if grid search is not suitable.
          */
         bool initGrid(const t_pbc &pbc, int posCount, const rvec x[], bool bForce);
+        /*! \brief
+         * Sets the cell sizes for a grid with cells already set up.
+         *
+         * \param[in] box  Box vectors for the grid (bounding box in
+         *     non-periodic dimensions).
+         *
+         * Uses \p bSingleCell_ and \p ncelldim_.
+         */
+        void initCellSizes(const matrix box);
+        /*! \brief
+         * Stores the reference positions in each grid cell in batches for
+         * SIMD distance calculations.
+         *
+         * Needs to be called whenever \p xref_ has changed for a grid.
+         * Does nothing if SIMD is not supported.
+         */
+        void initCellBatches();
+        /*! \brief
+         * Updates the grid from the previous call for new reference positions.
+         *
+         * \param[in] pbc      Information about the box.
+         * \param[in] posCount Number of positions in \p x.
+         * \param[in] x        Reference positions.
+         * \param[in] indices  Indices into \p x (NULL if no indices).
+         * \param[in] bForce   If `true`, grid searching will be used if at all
+         *     possible, even if a simple search might give better performance.
+         * \returns   `false` if the grid needs to be rebuilt.
+         *
+         * Keeps each reference position in the grid cell to which it was
+         * assigned when the grid was built, and sets \p cellMargin_ to the
+         * largest distance of a position from its cell.
+         * The grid needs to be rebuilt if this exceeds \p gridReuseBuffer_.
+         */
+        bool reuseGrid(const t_pbc &pbc, int posCount, const rvec x[],
+                       const int *indices, bool bForce);
         /*! \brief
          * Maps a point into a grid cell.
          *
          * \param[in]  x    Point to map.
          * \param[out] cell Fractional cell coordinates of \p x on the grid.
          * \param[out] xout Coordinates to use.
+         * \param[out] imageShift Number of box vectors added to \p x in
+         *     each dimension to get \p xout.
          *
          * \p xout will be within the rectangular unit cell in dimensions where
          * the grid is periodic.  For other dimensions, both \p xout and
          * \p cell can be outside the grid/unit cell.
          */
-        void mapPointToGridCell(const rvec x, rvec cell, rvec xout) const;
+        void mapPointToGridCell(const rvec x, rvec cell, rvec xout,
+                                ivec imageShift) const;
         /*! \brief
          * Calculates linear index of a grid cell.
          *
@@ -204,11 +246,25 @@ class AnalysisNeighborhoodSearchImpl
          * \param[in]  cell Fractional cell coordinates into which \p i should
          *     be added.
          * \param[in]  i    Index to add.
+         * \param[out] icell Cell indices into which \p i was added.
          *
          * \p cell should satisfy the conditions that \p mapPointToGridCell()
          * produces.
          */
-        void addToGridCell(const rvec cell, int i);
+        void addToGridCell(const rvec cell, int i, ivec icell);
+        /*! \brief
+         * Calculates the center of a cell pair loop for a dimension.
+         *
+         * \param[in] centerCell Fractional cell coordiates of the particle
+         *     for which pairs are being searched.
+         * \param[in] cell       Current cell in the loop; only `cell[d]` with
+         *     `d > dim` are used.
+         * \param[in] dim        Dimension to compute the center for.
+         * \returns   `centerCell[dim]`, shifted for triclinic boxes if `cell`
+         *     is outside the grid in a higher dimension.
+         */
+        real getCellRangeCenter(const rvec centerCell, const ivec cell,
+                                int dim) const;
         /*! \brief
          * Initializes a cell pair loop for a dimension.
          *
@@ -225,6 +281,8 @@ class AnalysisNeighborhoodSearchImpl
          * `cell[dim]` until `upperBound[dim]`, inclusive.
          * `cell[d]` with `d < dim` or `upperBound[d]` with `d != dim` are not
          * modified by this function.
+         * Cells that are completely outside the cutoff, given the distance to
+         * the cells `cell[d]` (`d > dim`), are left out of the range.
          *
          * `cell` and `upperBound` may be outside the grid for periodic
          * dimensions and need to be shifted separately: to simplify the
@@ -258,6 +316,12 @@ class AnalysisNeighborhoodSearchImpl
         real                    cutoff_;
         //! The cutoff squared.
         real                    cutoff2_;
+        /*! \brief
+         * Cutoff used for selecting grid cells.
+         *
+         * Equals \p cutoff_ plus \p cellMargin_.
+         */
+        real                    gridCutoff_;
         //! Whether to do searching in XY plane only.
         bool                    bXY_;
 
@@ -305,8 +369,55 @@ class AnalysisNeighborhoodSearchImpl
         real                    cellShiftYX_;
         //! Number of cells along each dimension.
         ivec                    ncelldim_;
+        //! Whether a single cell is used along a dimension.
+        bool                    bSingleCell_[DIM];
         //! Data structure to hold the grid cell contents.
         CellList                cells_;
+        /*! \brief
+         * Index of the first batch of reference positions for each cell in
+         * \p batchCoords_.
+         *
+         * Only used with SIMD.  Each batch contains \c GMX_SIMD_REAL_WIDTH
+         * positions from `cells_[ci]`, in the same order; the last batch of
+         * a cell is padded with unused entries.
+         */
+        std::vector<int>        cellBatchStart_;
+        //! Storage for \p batchCoords_ (with space for alignment).
+        std::vector<real>       batchCoordAlloc_;
+        /*! \brief
+         * Coordinates of the reference positions in each batch.
+         *
+         * For each batch, stores the X coordinates of the positions, followed
+         * by the Y and Z coordinates, each in a SIMD-aligned block.
+         */
+        real                   *batchCoords_;
+        /*! \brief
+         * Squared distance below which SIMD distances are checked exactly.
+         *
+         * Slightly larger than \p cutoff2_ to account for rounding
+         * differences between the SIMD and scalar calculations.
+         */
+        real                    batchCutoff2_;
+
+        //! Buffer for reusing the grid between calls to init() (zero if not).
+        real                    gridReuseBuffer_;
+        //! Whether the current grid can be reused in the next init() call.
+        bool                    bGridReusable_;
+        /*! \brief
+         * Largest distance of a reference position from its grid cell.
+         *
+         * Nonzero only when the grid has been reused.
+         */
+        real                    cellMargin_;
+        //! Box vectors used to set up the grid.
+        matrix                  gridBox_;
+        //! Grid cell indices for each reference position (DIM per position).
+        std::vector<int>        refCells_;
+        /*! \brief
+         * Image shifts (in box vectors) applied to each reference position
+         * when it was put on the grid (DIM per position).
+         */
+        std::vector<int>        refImageShifts_;
 
         Mutex                   createPairSearchMutex_;
         PairSearchList          pairSearchList_;
@@ -332,11 +443,20 @@ class AnalysisNeighborhoodPairSearchImpl
             clear_rvec(testcell_);
             clear_ivec(currCell_);
             clear_ivec(cellBound_);
+#ifdef GMX_SIMD_HAVE_REAL
+            batchR2_ = gmx_simd_align_r(batchR2Alloc_);
+#endif
             reset(-1);
         }
 
         //! Initializes a search to find reference positions neighboring \p x.
         void startSearch(const AnalysisNeighborhoodPositions &positions);
+        /*! \brief
+         * Initializes a search for the block of test positions in
+         * \p positions assigned to thread \p threadIndex.
+         */
+        void startSearch(const AnalysisNeighborhoodPositions &positions,
+                         int threadIndex, int threadCount);
         //! Searches for the next neighbor.
         template <class Action>
         bool searchNext(Action action);
@@ -350,6 +470,16 @@ class AnalysisNeighborhoodPairSearchImpl
         void reset(int testIndex);
         //! Checks whether a reference positiong should be excluded.
         bool isExcluded(int j);
+#ifdef GMX_SIMD_HAVE_REAL
+        /*! \brief
+         * Computes squared distances from the test position to a batch of
+         * reference positions into \p batchR2_.
+         *
+         * \param[in] batch  Index of the batch in the parent search.
+         * \param[in] shift  Shift to apply to get the periodic distances.
+         */
+        void computeBatchDistances(int batch, const rvec shift);
+#endif
 
         //! Parent search object.
         const AnalysisNeighborhoodSearchImpl   &search_;
@@ -385,6 +515,15 @@ class AnalysisNeighborhoodPairSearchImpl
         ivec                                    cellBound_;
         //! Stores the index within the current cell during pair loops.
         int                                     prevcai_;
+#ifdef GMX_SIMD_HAVE_REAL
+        //! Storage for \p batchR2_ (with space for alignment).
+        real                                    batchR2Alloc_[2*GMX_SIMD_REAL_WIDTH];
+        /*! \brief
+         * Squared distances to the reference positions in the current batch
+         * during grid pair loops.
+         */
+        real                                   *batchR2_;
+#endif
 
         GMX_DISALLOW_COPY_AND_ASSIGN(AnalysisNeighborhoodPairSearchImpl);
 };
@@ -406,6 +545,7 @@ AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
     {
         cutoff2_        = sqr(cutoff_);
     }
+    gridCutoff_      = cutoff_;
     bXY_             = false;
     nref_            = 0;
     xref_            = NULL;
@@ -423,6 +563,17 @@ AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
     clear_rvec(cellSize_);
     clear_rvec(invCellSize_);
     clear_ivec(ncelldim_);
+    bSingleCell_[XX] = false;
+    bSingleCell_[YY] = false;
+    bSingleCell_[ZZ] = false;
+
+    gridReuseBuffer_ = 0.0;
+    bGridReusable_   = false;
+    cellMargin_      = 0.0;
+    clear_mat(gridBox_);
+
+    batchCoords_     = NULL;
+    batchCutoff2_    = cutoff2_ * (1 + 10*GMX_REAL_EPS);
 }
 
 AnalysisNeighborhoodSearchImpl::~AnalysisNeighborhoodSearchImpl()
@@ -460,7 +611,7 @@ bool AnalysisNeighborhoodSearchImpl::checkGridSearchEfficiency(bool bForce)
     ivec  range;
     for (int dd = 0; dd < DIM; ++dd)
     {
-        range[dd] = static_cast<int>(ceil(cutoff_ * invCellSize_[dd]));
+        range[dd] = static_cast<int>(ceil(gridCutoff_ * invCellSize_[dd]));
     }
 
     // Calculate the fraction of cell pairs that need to be searched,
@@ -660,11 +811,22 @@ bool AnalysisNeighborhoodSearchImpl::initGrid(
         return false;
     }
 
+    for (int dd = 0; dd < DIM; ++dd)
+    {
+        bSingleCell_[dd] = bSingleCell[dd];
+    }
+    copy_mat(box, gridBox_);
     bTric_ = TRICLINIC(pbc.box);
+    initCellSizes(box);
+    return checkGridSearchEfficiency(bForce);
+}
+
+void AnalysisNeighborhoodSearchImpl::initCellSizes(const matrix box)
+{
     for (int dd = 0; dd < DIM; ++dd)
     {
         cellSize_[dd] = box[dd][dd] / ncelldim_[dd];
-        if (bSingleCell[dd])
+        if (bSingleCell_[dd])
         {
             invCellSize_[dd] = 0.0;
         }
@@ -679,15 +841,128 @@ bool AnalysisNeighborhoodSearchImpl::initGrid(
         cellShiftZX_ = box[ZZ][XX] * invCellSize_[XX];
         cellShiftYX_ = box[YY][XX] * invCellSize_[XX];
     }
+}
+
+void AnalysisNeighborhoodSearchImpl::initCellBatches()
+{
+#ifdef GMX_SIMD_HAVE_REAL
+    const int cellCount  = ncelldim_[XX] * ncelldim_[YY] * ncelldim_[ZZ];
+    int       batchCount = 0;
+    cellBatchStart_.resize(cellCount + 1);
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        cellBatchStart_[ci] = batchCount;
+        const int cellSize = static_cast<int>(cells_[ci].size());
+        batchCount += (cellSize + GMX_SIMD_REAL_WIDTH - 1) / GMX_SIMD_REAL_WIDTH;
+    }
+    cellBatchStart_[cellCount] = batchCount;
+    batchCoordAlloc_.resize((batchCount * DIM + 1) * GMX_SIMD_REAL_WIDTH);
+    batchCoords_ = gmx_simd_align_r(&batchCoordAlloc_[0]);
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        const int cellSize = static_cast<int>(cells_[ci].size());
+        real     *coords   = batchCoords_
+            + cellBatchStart_[ci] * DIM * GMX_SIMD_REAL_WIDTH;
+        for (int cai = 0; cai < cellSize; ++cai)
+        {
+            const int  i     = cells_[ci][cai];
+            const int  lane  = cai % GMX_SIMD_REAL_WIDTH;
+            real      *batch = coords
+                + (cai / GMX_SIMD_REAL_WIDTH) * DIM * GMX_SIMD_REAL_WIDTH;
+            for (int d = 0; d < DIM; ++d)
+            {
+                batch[d * GMX_SIMD_REAL_WIDTH + lane] = xref_[i][d];
+            }
+        }
+    }
+#endif
+}
+
+bool AnalysisNeighborhoodSearchImpl::reuseGrid(
+        const t_pbc &pbc, int posCount, const rvec x[], const int *indices,
+        bool bForce)
+{
+    if (posCount != nref_ || TRICLINIC(pbc.box) != bTric_)
+    {
+        return false;
+    }
+    // Periodic dimensions follow the current box, while the bounding box from
+    // when the grid was built is kept for the other dimensions.  The number
+    // of cells stays the same, so the cell size changes with the box.
+    matrix box;
+    copy_mat(gridBox_, box);
+    for (int dd = 0; dd < DIM; ++dd)
+    {
+        if (bGridPBC_[dd])
+        {
+            copy_rvec(pbc.box[dd], box[dd]);
+        }
+    }
+    initCellSizes(box);
+
+    // Each position is kept in the same periodic image and in the same cell
+    // as when the grid was built; the searches then need to extend the
+    // cutoff by the largest distance of a position from its cell.
+    const real maxDist2 = sqr(gridReuseBuffer_);
+    real       margin2  = 0.0;
+    for (int i = 0; i < posCount; ++i)
+    {
+        const int  ii         = (indices != NULL) ? indices[i] : i;
+        const int *cell       = &refCells_[i*DIM];
+        const int *imageShift = &refImageShifts_[i*DIM];
+        rvec       xi;
+        rvec_sub(x[ii], gridOrigin_, xi);
+        for (int dd = 0; dd < DIM; ++dd)
+        {
+            if (imageShift[dd] != 0)
+            {
+                for (int d = 0; d <= dd; ++d)
+                {
+                    xi[d] += imageShift[dd] * pbc.box[dd][d];
+                }
+            }
+        }
+        real dist2 = 0.0;
+        for (int dd = 0; dd < DIM; ++dd)
+        {
+            if (bSingleCell_[dd])
+            {
+                continue;
+            }
+            const real lowerBound = cell[dd] * cellSize_[dd];
+            const real upperBound = lowerBound + cellSize_[dd];
+            if (xi[dd] < lowerBound)
+            {
+                dist2 += sqr(lowerBound - xi[dd]);
+            }
+            else if (xi[dd] > upperBound)
+            {
+                dist2 += sqr(xi[dd] - upperBound);
+            }
+        }
+        if (dist2 > margin2)
+        {
+            if (dist2 > maxDist2)
+            {
+                return false;
+            }
+            margin2 = dist2;
+        }
+        copy_rvec(xi, xrefAlloc_[i]);
+    }
+    cellMargin_ = std::sqrt(margin2);
+    gridCutoff_ = cutoff_ + cellMargin_;
     return checkGridSearchEfficiency(bForce);
 }
 
 void AnalysisNeighborhoodSearchImpl::mapPointToGridCell(const rvec x,
                                                         rvec       cell,
-                                                        rvec       xout) const
+                                                        rvec       xout,
+                                                        ivec       imageShift) const
 {
     rvec xtmp;
     rvec_sub(x, gridOrigin_, xtmp);
+    clear_ivec(imageShift);
     // The reverse order is necessary for triclinic cells: shifting in Z may
     // modify also X and Y, and shifting in Y may modify X, so the mapping to
     // a rectangular grid needs to be done in this order.
@@ -701,11 +976,13 @@ void AnalysisNeighborhoodSearchImpl::mapPointToGridCell(const rvec x,
             {
                 cellIndex += cellCount;
                 rvec_inc(xtmp, pbc_.box[dd]);
+                ++imageShift[dd];
             }
             while (cellIndex >= cellCount)
             {
                 cellIndex -= cellCount;
                 rvec_dec(xtmp, pbc_.box[dd]);
+                --imageShift[dd];
             }
         }
         cell[dd] = cellIndex;
@@ -725,9 +1002,9 @@ int AnalysisNeighborhoodSearchImpl::getGridCellIndex(const ivec cell) const
            + cell[ZZ] * ncelldim_[XX] * ncelldim_[YY];
 }
 
-void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i)
+void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i,
+                                                   ivec icell)
 {
-    ivec icell;
     for (int dd = 0; dd < DIM; ++dd)
     {
         int cellIndex = static_cast<int>(floor(cell[dd]));
@@ -749,13 +1026,10 @@ void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i)
     cells_[ci].push_back(i);
 }
 
-void AnalysisNeighborhoodSearchImpl::initCellRange(
-        const rvec centerCell, ivec currCell, ivec upperBound, int dim) const
+real AnalysisNeighborhoodSearchImpl::getCellRangeCenter(
+        const rvec centerCell, const ivec cell, int dim) const
 {
-    // TODO: Prune off cells that are completely outside the cutoff.
-    const real range       = cutoff_ * invCellSize_[dim];
-    real       startOffset = centerCell[dim] - range;
-    real       endOffset   = centerCell[dim] + range;
+    real center = centerCell[dim];
     if (bTric_)
     {
         switch (dim)
@@ -763,41 +1037,63 @@ void AnalysisNeighborhoodSearchImpl::initCellRange(
             case ZZ:
                 break;
             case YY:
-                if (currCell[ZZ] < 0)
+                if (cell[ZZ] < 0)
                 {
-                    startOffset += cellShiftZY_;
-                    endOffset   += cellShiftZY_;
+                    center += cellShiftZY_;
                 }
-                else if (currCell[ZZ] >= ncelldim_[ZZ])
+                else if (cell[ZZ] >= ncelldim_[ZZ])
                 {
-                    startOffset -= cellShiftZY_;
-                    endOffset   -= cellShiftZY_;
+                    center -= cellShiftZY_;
                 }
                 break;
             case XX:
-                if (currCell[ZZ] < 0)
+                if (cell[ZZ] < 0)
                 {
-                    startOffset += cellShiftZX_;
-                    endOffset   += cellShiftZX_;
+                    center += cellShiftZX_;
                 }
-                else if (currCell[ZZ] >= ncelldim_[ZZ])
+                else if (cell[ZZ] >= ncelldim_[ZZ])
                 {
-                    startOffset -= cellShiftZX_;
-                    endOffset   -= cellShiftZX_;
+                    center -= cellShiftZX_;
                 }
-                if (currCell[YY] < 0)
+                if (cell[YY] < 0)
                 {
-                    startOffset += cellShiftYX_;
-                    endOffset   += cellShiftYX_;
+                    center += cellShiftYX_;
                 }
-                else if (currCell[YY] >= ncelldim_[YY])
+                else if (cell[YY] >= ncelldim_[YY])
                 {
-                    startOffset -= cellShiftYX_;
-                    endOffset   -= cellShiftYX_;
+                    center -= cellShiftYX_;
                 }
                 break;
         }
     }
+    return center;
+}
+
+void AnalysisNeighborhoodSearchImpl::initCellRange(
+        const rvec centerCell, ivec currCell, ivec upperBound, int dim) const
+{
+    // Only the part of the cutoff sphere that remains after the distance to
+    // the current cells in the higher dimensions needs to be covered.
+    real rangeSquared = sqr(gridCutoff_);
+    for (int d = dim + 1; d < DIM; ++d)
+    {
+        const real center = getCellRangeCenter(centerCell, currCell, d);
+        real       dist   = 0.0;
+        if (currCell[d] > center)
+        {
+            dist = (currCell[d] - center) * cellSize_[d];
+        }
+        else if (currCell[d] + 1 < center)
+        {
+            dist = (center - currCell[d] - 1) * cellSize_[d];
+        }
+        rangeSquared -= dist * dist;
+    }
+    const real range       = std::sqrt(std::max(rangeSquared, static_cast<real>(0.0)))
+        * invCellSize_[dim];
+    const real center      = getCellRangeCenter(centerCell, currCell, dim);
+    real       startOffset = center - range;
+    real       endOffset   = center + range;
     // For non-periodic dimensions, clamp to the actual grid edges.
     if (!bGridPBC_[dim])
     {
@@ -879,11 +1175,18 @@ void AnalysisNeighborhoodSearchImpl::init(
         bool                                 bXY,
         const t_blocka                      *excls,
         const t_pbc                         *pbc,
-        const AnalysisNeighborhoodPositions &positions)
+        const AnalysisNeighborhoodPositions &positions,
+        real                                 gridReuseBuffer)
 {
     GMX_RELEASE_ASSERT(positions.index_ == -1,
                        "Individual indexed positions not supported as reference");
-    bXY_ = bXY;
+    const int prevEPBC = pbc_.ePBC;
+    if (gridReuseBuffer != gridReuseBuffer_ || bXY != bXY_)
+    {
+        bGridReusable_ = false;
+    }
+    gridReuseBuffer_ = std::max(gridReuseBuffer, static_cast<real>(0.0));
+    bXY_             = bXY;
     if (bXY_ && pbc != NULL && pbc->ePBC != epbcNONE)
     {
         if (pbc->ePBC != epbcXY && pbc->ePBC != epbcXYZ)
@@ -914,32 +1217,68 @@ void AnalysisNeighborhoodSearchImpl::init(
         pbc_.ePBC = epbcNONE;
         clear_mat(pbc_.box);
     }
-    nref_ = positions.count_;
+    if (pbc_.ePBC != prevEPBC)
+    {
+        bGridReusable_ = false;
+    }
+    refIndices_ = positions.indices_;
+    bool bGridReused = false;
     if (mode == AnalysisNeighborhood::eSearchMode_Simple)
     {
         bGrid_ = false;
     }
     else if (bTryGrid_)
     {
-        bGrid_ = initGrid(pbc_, positions.count_, positions.x_,
-                          mode == AnalysisNeighborhood::eSearchMode_Grid);
+        const bool bForce = (mode == AnalysisNeighborhood::eSearchMode_Grid);
+        bGridReused = bGridReusable_
+            && reuseGrid(pbc_, positions.count_, positions.x_, refIndices_, bForce);
+        if (!bGridReused)
+        {
+            cellMargin_ = 0.0;
+            gridCutoff_ = cutoff_;
+            bGrid_      = initGrid(pbc_, positions.count_, positions.x_, bForce);
+        }
     }
-    refIndices_ = positions.indices_;
-    if (bGrid_)
+    nref_ = positions.count_;
+    if (bGrid_ && bGridReused)
     {
+        xref_ = as_rvec_array(&xrefAlloc_[0]);
+        initCellBatches();
+    }
+    else if (bGrid_)
+    {
+        const bool bStoreCells = (gridReuseBuffer_ > 0.0);
         xrefAlloc_.resize(nref_);
         xref_ = as_rvec_array(&xrefAlloc_[0]);
+        if (bStoreCells)
+        {
+            refCells_.resize(nref_ * DIM);
+            refImageShifts_.resize(nref_ * DIM);
+        }
 
         for (int i = 0; i < nref_; ++i)
         {
             const int ii = (refIndices_ != NULL) ? refIndices_[i] : i;
             rvec      refcell;
-            mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i]);
-            addToGridCell(refcell, i);
+            ivec      imageShift, icell;
+            mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i],
+                               imageShift);
+            addToGridCell(refcell, i, icell);
+            if (bStoreCells)
+            {
+                for (int d = 0; d < DIM; ++d)
+                {
+                    refCells_[i*DIM + d]       = icell[d];
+                    refImageShifts_[i*DIM + d] = imageShift[d];
+                }
+            }
         }
+        bGridReusable_ = bStoreCells;
+        initCellBatches();
     }
     else if (refIndices_ != NULL)
     {
+        bGridReusable_ = false;
         xrefAlloc_.resize(nref_);
         xref_ = as_rvec_array(&xrefAlloc_[0]);
         for (int i = 0; i < nref_; ++i)
@@ -949,7 +1288,8 @@ void AnalysisNeighborhoodSearchImpl::init(
     }
     else
     {
-        xref_ = positions.x_;
+        bGridReusable_ = false;
+        xref_          = positions.x_;
     }
     excls_           = excls;
     refExclusionIds_ = NULL;
@@ -976,7 +1316,9 @@ void AnalysisNeighborhoodPairSearchImpl::reset(int testIndex)
             (testIndices_ != NULL ? testIndices_[testIndex] : testIndex);
         if (search_.bGrid_)
         {
-            search_.mapPointToGridCell(testPositions_[index], testcell_, xtest_);
+            ivec imageShift;
+            search_.mapPointToGridCell(testPositions_[index], testcell_, xtest_,
+                                       imageShift);
             search_.initCellRange(testcell_, currCell_, cellBound_, ZZ);
             search_.initCellRange(testcell_, currCell_, cellBound_, YY);
             search_.initCellRange(testcell_, currCell_, cellBound_, XX);
@@ -1017,6 +1359,35 @@ void AnalysisNeighborhoodPairSearchImpl::nextTestPosition()
     }
 }
 
+#ifdef GMX_SIMD_HAVE_REAL
+void AnalysisNeighborhoodPairSearchImpl::computeBatchDistances(
+        int batch, const rvec shift)
+{
+    const real     *coords = search_.batchCoords_
+        + batch * DIM * GMX_SIMD_REAL_WIDTH;
+    // The operations are done in the same order as in the scalar code, such
+    // that the results only differ by rounding in the final sum.
+    gmx_simd_real_t dx
+        = gmx_simd_sub_r(gmx_simd_sub_r(gmx_simd_load_r(coords),
+                                        gmx_simd_set1_r(xtest_[XX])),
+                         gmx_simd_set1_r(shift[XX]));
+    gmx_simd_real_t dy
+        = gmx_simd_sub_r(gmx_simd_sub_r(gmx_simd_load_r(coords + GMX_SIMD_REAL_WIDTH),
+                                        gmx_simd_set1_r(xtest_[YY])),
+                         gmx_simd_set1_r(shift[YY]));
+    gmx_simd_real_t r2 = gmx_simd_fmadd_r(dy, dy, gmx_simd_mul_r(dx, dx));
+    if (!search_.bXY_)
+    {
+        gmx_simd_real_t dz
+            = gmx_simd_sub_r(gmx_simd_sub_r(gmx_simd_load_r(coords + 2*GMX_SIMD_REAL_WIDTH),
+                                            gmx_simd_set1_r(xtest_[ZZ])),
+                             gmx_simd_set1_r(shift[ZZ]));
+        r2 = gmx_simd_fmadd_r(dz, dz, r2);
+    }
+    gmx_simd_store_r(batchR2_, r2);
+}
+#endif
+
 bool AnalysisNeighborhoodPairSearchImpl::isExcluded(int j)
 {
     if (exclind_ < nexcl_)
@@ -1037,6 +1408,23 @@ bool AnalysisNeighborhoodPairSearchImpl::isExcluded(int j)
     return false;
 }
 
+void AnalysisNeighborhoodPairSearchImpl::startSearch(
+        const AnalysisNeighborhoodPositions &positions,
+        int threadIndex, int threadCount)
+{
+    GMX_RELEASE_ASSERT(positions.index_ < 0,
+                       "Individual indexed positions not supported for partial searches");
+    GMX_RELEASE_ASSERT(threadIndex >= 0 && threadIndex < threadCount,
+                       "Invalid thread index");
+    // Use 64-bit intermediates to avoid overflow for large position counts.
+    const gmx_int64_t count = positions.count_;
+    const int         begin = static_cast<int>(count * threadIndex / threadCount);
+    const int         end   = static_cast<int>(count * (threadIndex + 1) / threadCount);
+    startSearch(positions);
+    testPosCount_ = end;
+    reset(begin);
+}
+
 void AnalysisNeighborhoodPairSearchImpl::startSearch(
         const AnalysisNeighborhoodPositions &positions)
 {
@@ -1075,6 +1463,24 @@ bool AnalysisNeighborhoodPairSearchImpl::searchNext(Action action)
                 const int cellSize = static_cast<int>(search_.cells_[ci].size());
                 for (; cai < cellSize; ++cai)
                 {
+#ifdef GMX_SIMD_HAVE_REAL
+                    // Distances are computed for a batch of reference
+                    // positions at a time, and only positions that are close
+                    // to the cutoff or within it are checked further.
+                    // When resuming in the middle of a batch, batchR2_ still
+                    // holds the distances for it.
+                    const int lane = cai % GMX_SIMD_REAL_WIDTH;
+                    if (lane == 0)
+                    {
+                        computeBatchDistances(search_.cellBatchStart_[ci]
+                                              + cai / GMX_SIMD_REAL_WIDTH,
+                                              shift);
+                    }
+                    if (batchR2_[lane] > search_.batchCutoff2_)
+                    {
+                        continue;
+                    }
+#endif
                     const int i = search_.cells_[ci][cai];
                     if (isExcluded(i))
                     {
@@ -1236,7 +1642,8 @@ class AnalysisNeighborhood::Impl
         typedef std::vector<SearchImplPointer> SearchList;
 
         Impl()
-            : cutoff_(0), excls_(NULL), mode_(eSearchMode_Automatic), bXY_(false)
+            : cutoff_(0), excls_(NULL), mode_(eSearchMode_Automatic), bXY_(false),
+              gridReuseBuffer_(0)
         {
         }
         ~Impl()
@@ -1257,6 +1664,7 @@ class AnalysisNeighborhood::Impl
         const t_blocka         *excls_;
         SearchMode              mode_;
         bool                    bXY_;
+        real                    gridReuseBuffer_;
 };
 
 AnalysisNeighborhood::Impl::SearchImplPointer
@@ -1310,6 +1718,11 @@ void AnalysisNeighborhood::setTopologyExclusions(const t_blocka *excls)
     impl_->excls_ = excls;
 }
 
+void AnalysisNeighborhood::setGridReuseBuffer(real buffer)
+{
+    impl_->gridReuseBuffer_ = buffer;
+}
+
 void AnalysisNeighborhood::setMode(SearchMode mode)
 {
     impl_->mode_ = mode;
@@ -1326,7 +1739,7 @@ AnalysisNeighborhood::initSearch(const t_pbc                         *pbc,
 {
     Impl::SearchImplPointer search(impl_->getSearch());
     search->init(mode(), impl_->bXY_, impl_->excls_,
-                 pbc, positions);
+                 pbc, positions, impl_->gridReuseBuffer_);
     return AnalysisNeighborhoodSearch(search);
 }
 
@@ -1404,6 +1817,17 @@ AnalysisNeighborhoodSearch::startPairSearch(
     return AnalysisNeighborhoodPairSearch(pairSearch);
 }
 
+AnalysisNeighborhoodPairSearch
+AnalysisNeighborhoodSearch::startPairSearch(
+        const AnalysisNeighborhoodPositions &positions,
+        int threadIndex, int threadCount) const
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid search object");
+    Impl::PairSearchImplPointer pairSearch(impl_->getPairSearch());
+    pairSearch->startSearch(positions, threadIndex, threadCount);
+    return AnalysisNeighborhoodPairSearch(pairSearch);
+}
+
 /********************************************************************
  * AnalysisNeighborhoodPairSearch
  */
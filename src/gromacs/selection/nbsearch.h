@@ -275,6 +275,29 @@ class AnalysisNeighborhood
          * \see AnalysisNeighborhoodPositions::exclusionIds()
          */
         void setTopologyExclusions(const t_blocka *excls);
+        /*! \brief
+         * Sets a buffer for reusing the search grid between searches.
+         *
+         * \param[in] buffer  Distance that a reference position can move out
+         *   of its grid cell before the grid is rebuilt (<=0 disables reuse).
+         *
+         * When this is set, initSearch() keeps the grid from the previous
+         * call if the number of reference positions and the type of the box
+         * are unchanged, and no reference position has moved farther than
+         * \p buffer from the grid cell it was assigned to.  Each reference
+         * position then stays in the same cell and periodic image, and the
+         * cells to search are selected with the cutoff increased by the
+         * largest such distance.  Pairs are still only returned within the
+         * actual cutoff, so the results are the same as with a rebuilt grid.
+         * This avoids assigning the positions to cells again for each frame
+         * when the reference positions move little between frames, at the
+         * cost of searching slightly more cells.
+         *
+         * If this method is not called, the grid is rebuilt in each call.
+         *
+         * Does not throw.
+         */
+        void setGridReuseBuffer(real buffer);
         /*! \brief
          * Sets the algorithm to use for searching.
          *
@@ -510,6 +533,45 @@ class AnalysisNeighborhoodSearch
          */
         AnalysisNeighborhoodPairSearch
         startPairSearch(const AnalysisNeighborhoodPositions &positions) const;
+        /*! \brief
+         * Start a search for the share of test positions of one thread.
+         *
+         * \param[in] positions    Set of test positions to use.
+         * \param[in] threadIndex  Index of the calling thread.
+         * \param[in] threadCount  Number of threads that share the search.
+         * \returns   Initialized search object to loop through all reference
+         *     positions within the configured cutoff from the test positions
+         *     assigned to \p threadIndex.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The test positions are divided into \p threadCount contiguous
+         * blocks, and the returned search only loops over the block for
+         * \p threadIndex.  Test indices in the returned pairs are still
+         * indices into \p positions, so the searches for all thread indices
+         * together find the same pairs as startPairSearch(positions).
+         * The grid of this search is only read by the pair searches, so each
+         * thread of, e.g., an OpenMP parallel region can loop over its own
+         * pair search concurrently with the others:
+         * \code
+           #pragma omp parallel num_threads(nthreads)
+           {
+               gmx::AnalysisNeighborhoodPairSearch pairSearch =
+                   search.startPairSearch(positions, gmx_omp_get_thread_num(),
+                                          nthreads);
+               gmx::AnalysisNeighborhoodPair       pair;
+               while (pairSearch.findNextPair(&pair))
+               {
+                   // <process the pair, accumulating into thread-local data>
+               }
+           }
+         * \endcode
+         *
+         * Currently, the input positions cannot use
+         * AnalysisNeighborhoodPositions::selectSingleFromArray().
+         */
+        AnalysisNeighborhoodPairSearch
+        startPairSearch(const AnalysisNeighborhoodPositions &positions,
+                        int threadIndex, int threadCount) const;
 
     private:
         typedef internal::AnalysisNeighborhoodSearchImpl Impl;
@@ -120,6 +120,21 @@ SelectionData::SelectionData(SelectionTreeElement *elem,
 }
 
 
+SelectionData::SelectionData(const SelectionData *source)
+    : name_(source->name_), selectionText_(source->selectionText_),
+      posMass_(source->posMass_), posCharge_(source->posCharge_),
+      flags_(source->flags_), rootElement_(source->rootElement_),
+      coveredFractionType_(source->coveredFractionType_),
+      coveredFraction_(source->coveredFraction_),
+      averageCoveredFraction_(source->averageCoveredFraction_),
+      bDynamic_(source->bDynamic_),
+      bDynamicCoveredFraction_(source->bDynamicCoveredFraction_)
+{
+    gmx_ana_pos_copy(&rawPositions_,
+                     const_cast<gmx_ana_pos_t *>(&source->rawPositions_), true);
+}
+
+
 SelectionData::~SelectionData()
 {
 }
@@ -254,6 +269,21 @@ SelectionData::restoreOriginalPositions(const t_topology *top)
     }
 }
 
+void
+SelectionData::copyFrameData(const SelectionData &source)
+{
+    GMX_ASSERT(&rootElement_ == &source.rootElement_,
+               "Frame data can only be copied from the original selection");
+    gmx_ana_pos_copy(&rawPositions_,
+                     const_cast<gmx_ana_pos_t *>(&source.rawPositions_), false);
+    if (bDynamic_)
+    {
+        posMass_   = source.posMass_;
+        posCharge_ = source.posCharge_;
+    }
+    coveredFraction_ = source.coveredFraction_;
+}
+
 }   // namespace internal
 
 /********************************************************************
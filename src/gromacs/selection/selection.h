@@ -93,6 +93,21 @@ class SelectionData
          * \throws    std::bad_alloc if out of memory.
          */
         SelectionData(SelectionTreeElement *elem, const char *selstr);
+        /*! \brief
+         * Creates a frame-local copy of another selection.
+         *
+         * \param[in] source  Selection to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The copy shares the evaluation tree with \p source, and can only be
+         * used for accessing the positions; it is not evaluated directly.
+         * Instead, copyFrameData() is used to update it to match \p source
+         * after \p source has been evaluated.
+         *
+         * \p source should not yet have been evaluated for any frame, such
+         * that enough memory is reserved for the maximal set of positions.
+         */
+        explicit SelectionData(const SelectionData *source);
         ~SelectionData();
 
         //! Returns the name for this selection.
@@ -184,6 +199,16 @@ class SelectionData
          * Called by SelectionEvaluator::evaluateFinal().
          */
         void restoreOriginalPositions(const t_topology *top);
+        /*! \brief
+         * Updates a frame-local copy to match the current state of \p source.
+         *
+         * \param[in] source  Selection that this object was copied from.
+         *
+         * Copies the positions, masses, charges and the covered fraction that
+         * resulted from the most recent evaluation of \p source.
+         * Called by SelectionCollection::copyFrameData().
+         */
+        void copyFrameData(const SelectionData &source);
 
     private:
         //! Name of the selection.
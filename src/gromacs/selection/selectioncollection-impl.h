@@ -178,6 +178,14 @@ class SelectionCollection::Impl
         bool                    bExternalGroupsSet_;
         //! External index groups (can be NULL).
         gmx_ana_indexgrps_t    *grps_;
+        /*! \brief
+         * Selections from which \a sc_.sel have been copied.
+         *
+         * Empty unless the collection has been initialized with
+         * SelectionCollection::initFrameLocalCopy(); otherwise, the i'th
+         * element corresponds to the i'th element in \a sc_.sel.
+         */
+        std::vector<Selection>  frameCopySources_;
 };
 
 /*! \internal
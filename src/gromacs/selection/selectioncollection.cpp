@@ -839,6 +839,51 @@ SelectionCollection::evaluateFinal(int nframes)
 }
 
 
+void
+SelectionCollection::initFrameLocalCopy(const SelectionCollection &source)
+{
+    GMX_RELEASE_ASSERT(impl_->sc_.sel.empty() && !impl_->sc_.root,
+                       "Frame-local copy can only be initialized for an empty collection");
+    const SelectionDataList &sourceList = source.impl_->sc_.sel;
+    impl_->sc_.sel.reserve(sourceList.size());
+    impl_->frameCopySources_.reserve(sourceList.size());
+    for (size_t i = 0; i < sourceList.size(); ++i)
+    {
+        SelectionDataPointer copy(new internal::SelectionData(sourceList[i].get()));
+        impl_->sc_.sel.push_back(std::move(copy));
+        impl_->frameCopySources_.push_back(Selection(sourceList[i].get()));
+    }
+}
+
+
+void
+SelectionCollection::copyFrameData(const SelectionCollection &source)
+{
+    const SelectionDataList &sourceList = source.impl_->sc_.sel;
+    GMX_ASSERT(sourceList.size() == impl_->sc_.sel.size(),
+               "Frame data copied from a different collection");
+    for (size_t i = 0; i < sourceList.size(); ++i)
+    {
+        impl_->sc_.sel[i]->copyFrameData(*sourceList[i]);
+    }
+}
+
+
+Selection
+SelectionCollection::frameLocalSelection(const Selection &selection) const
+{
+    const std::vector<Selection> &sources = impl_->frameCopySources_;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (sources[i] == selection)
+        {
+            return Selection(impl_->sc_.sel[i].get());
+        }
+    }
+    return selection;
+}
+
+
 void
 SelectionCollection::printTree(FILE *fp, bool bValues) const
 {
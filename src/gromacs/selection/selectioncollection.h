@@ -386,6 +386,47 @@ class SelectionCollection
          */
         void evaluateFinal(int nframes);
 
+        /*! \brief
+         * Initializes this collection as a frame-local copy of another one.
+         *
+         * \param[in] source  Compiled collection to copy the selections from.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * After the call, this collection contains a copy of each selection
+         * in \p source.  The copies cannot be evaluated; instead,
+         * copyFrameData() is used to make them match the state of \p source
+         * after it has been evaluated for a frame.  This allows evaluating
+         * \p source for several frames in sequence, and then processing the
+         * frames in parallel, each using its own copy.
+         *
+         * This collection must be empty, and \p source must not have been
+         * evaluated for any frame when this method is called.
+         */
+        void initFrameLocalCopy(const SelectionCollection &source);
+        /*! \brief
+         * Updates a frame-local copy to the current state of its source.
+         *
+         * \param[in] source  Collection passed to initFrameLocalCopy().
+         *
+         * Copies the evaluated positions of all selections in \p source,
+         * such that subsequent evaluation of \p source does not affect
+         * the selections in this collection.
+         *
+         * Does not throw.
+         */
+        void copyFrameData(const SelectionCollection &source);
+        /*! \brief
+         * Returns the frame-local copy of a selection.
+         *
+         * \param[in] selection  Selection from the source collection.
+         * \returns   Selection in this collection that corresponds to
+         *      \p selection, or \p selection itself if this collection is not
+         *      a frame-local copy.
+         *
+         * Does not throw.
+         */
+        Selection frameLocalSelection(const Selection &selection) const;
+
         /*! \brief
          * Prints a human-readable version of the internal selection element
          * tree.
@@ -44,6 +44,8 @@
  */
 #include "gmxpre.h"
 
+#include <vector>
+
 #include "gromacs/math/vec.h"
 #include "gromacs/selection/nbsearch.h"
 #include "gromacs/selection/position.h"
@@ -74,8 +76,27 @@ struct t_methoddata_distance
     gmx::AnalysisNeighborhood        nb;
     /** Neighborhood search for an invididual frame. */
     gmx::AnalysisNeighborhoodSearch  nbsearch;
+    /** Whether each evaluated position is within the cutoff (for \p within). */
+    std::vector<char>                bWithin;
 };
 
+/*! \brief
+ * Minimum number of evaluated positions for searching with multiple threads.
+ *
+ * The searches for the positions are independent and only read the grid in
+ * \c t_methoddata_distance::nbsearch, so they are divided over the available
+ * OpenMP threads when there are enough positions to pay off.
+ */
+static const int c_minParallelPositionCount = 1000;
+
+/*! \brief
+ * Buffer (in nm) for reusing the neighborhood search grid between frames.
+ *
+ * Reference positions typically move much less than this between
+ * trajectory frames, so the grid only needs to be rebuilt occasionally.
+ */
+static const real c_gridReuseBuffer = 0.1;
+
 /*! \brief
  * Allocates data for distance-based selection methods.
  *
@@ -243,6 +264,7 @@ init_common(t_topology * /* top */, int /* npar */, gmx_ana_selparam_t *param, v
         GMX_THROW(gmx::InvalidInputError("Distance cutoff should be > 0"));
     }
     d->nb.setCutoff(d->cutoff);
+    d->nb.setGridReuseBuffer(c_gridReuseBuffer);
 }
 
 /*!
@@ -280,8 +302,10 @@ evaluate_distance(t_topology * /* top */, t_trxframe * /* fr */, t_pbc * /* pbc
 {
     t_methoddata_distance *d = static_cast<t_methoddata_distance *>(data);
 
-    out->nr = pos->count();
-    for (int i = 0; i < pos->count(); ++i)
+    const int count = pos->count();
+    out->nr = count;
+#pragma omp parallel for schedule(static) if (count >= c_minParallelPositionCount)
+    for (int i = 0; i < count; ++i)
     {
         out->u.r[i] = d->nbsearch.minimumDistance(pos->x[i]);
     }
@@ -300,10 +324,17 @@ evaluate_within(t_topology * /* top */, t_trxframe * /* fr */, t_pbc * /* pbc */
 {
     t_methoddata_distance *d = static_cast<t_methoddata_distance *>(data);
 
+    const int count = pos->count();
+    d->bWithin.resize(count);
+#pragma omp parallel for schedule(static) if (count >= c_minParallelPositionCount)
+    for (int b = 0; b < count; ++b)
+    {
+        d->bWithin[b] = d->nbsearch.isWithin(pos->x[b]);
+    }
     out->u.g->isize = 0;
-    for (int b = 0; b < pos->count(); ++b)
+    for (int b = 0; b < count; ++b)
     {
-        if (d->nbsearch.isWithin(pos->x[b]))
+        if (d->bWithin[b])
         {
             gmx_ana_pos_add_to_group(out->u.g, pos, b);
         }
@@ -968,6 +968,53 @@ TEST_F(NeighborhoodSearchTest, GridSearchXYBox)
     testPairSearch(&search, data);
 }
 
+TEST_F(NeighborhoodSearchTest, GridSearchWithGridReuse)
+{
+    NeighborhoodSearchTestData data(12345, 1.0);
+    data.box_[XX][XX] = 5.0;
+    data.box_[YY][XX] = 2.5;
+    data.box_[YY][YY] = 2.5*sqrt(3.0);
+    data.box_[ZZ][XX] = 2.5;
+    data.box_[ZZ][YY] = 2.5*sqrt(1.0/3.0);
+    data.box_[ZZ][ZZ] = 5.0*sqrt(2.0/3.0);
+    data.generateRandomRefPositions(1000);
+    data.generateRandomTestPositions(100);
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    nb_.setGridReuseBuffer(0.2);
+    // Move the reference positions and scale the box between the searches,
+    // such that the grid is first reused and then needs to be rebuilt.
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        SCOPED_TRACE(gmx::formatString("Frame %d", frame));
+        if (frame > 0)
+        {
+            const real scale        = (frame % 2 == 0) ? 1.01 : 0.99;
+            const real displacement = (frame == 3) ? 0.5 : 0.1;
+            msmul(data.box_, scale, data.box_);
+            for (int i = 0; i < data.refPosCount_; ++i)
+            {
+                svmul(scale, data.refPos_[i], data.refPos_[i]);
+                for (int d = 0; d < DIM; ++d)
+                {
+                    data.refPos_[i][d] +=
+                        displacement * (gmx_rng_uniform_real(data.rng_) - 0.5);
+                }
+            }
+        }
+        set_pbc(&data.pbc_, epbcXYZ, data.box_);
+        data.computeReferences(&data.pbc_);
+
+        gmx::AnalysisNeighborhoodSearch search =
+            nb_.initSearch(&data.pbc_, data.refPositions());
+        ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+        testIsWithin(&search, data);
+        testPairSearch(&search, data);
+    }
+}
+
 TEST_F(NeighborhoodSearchTest, HandlesConcurrentSearches)
 {
     const NeighborhoodSearchTestData &data = TrivialTestData::get();
@@ -1003,6 +1050,41 @@ TEST_F(NeighborhoodSearchTest, HandlesConcurrentSearches)
     }
 }
 
+TEST_F(NeighborhoodSearchTest, HandlesSearchSplitOverThreads)
+{
+    const NeighborhoodSearchTestData &data = RandomTriclinicFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    gmx::AnalysisNeighborhoodSearch search =
+        nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    size_t expectedPairCount = 0;
+    for (size_t i = 0; i < data.testPositions_.size(); ++i)
+    {
+        expectedPairCount += data.testPositions_[i].refPairs.size();
+    }
+    const int threadCount = 3;
+    const int testCount   = data.testPositions_.size();
+    size_t    pairCount   = 0;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        gmx::AnalysisNeighborhoodPairSearch pairSearch =
+            search.startPairSearch(data.testPositions(), t, threadCount);
+        gmx::AnalysisNeighborhoodPair       pair;
+        while (pairSearch.findNextPair(&pair))
+        {
+            EXPECT_LE(testCount * t / threadCount, pair.testIndex());
+            EXPECT_GT(testCount * (t + 1) / threadCount, pair.testIndex());
+            NeighborhoodSearchTestData::RefPair searchPair(pair.refIndex(), sqrt(pair.distance2()));
+            EXPECT_TRUE(data.containsPair(pair.testIndex(), searchPair));
+            ++pairCount;
+        }
+    }
+    EXPECT_EQ(expectedPairCount, pairCount);
+}
+
 TEST_F(NeighborhoodSearchTest, HandlesNoPBC)
 {
     const NeighborhoodSearchTestData &data = TrivialNoPBCTestData::get();
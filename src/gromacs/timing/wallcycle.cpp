@@ -104,7 +104,7 @@ static const char *wcn[ewcNR] =
 {
     "Run", "Step", "PP during PME", "Domain decomp.", "DD comm. load",
     "DD comm. bounds", "Vsite constr.", "Send X to PME", "Neighbor search", "Launch GPU ops.",
-    "Comm. coord.", "Born radii", "Force", "Wait + Comm. F", "PME mesh",
+    "Comm. coord.", "Born radii", "Force", "Wait + Comm. F", "PME mesh task", "PME mesh",
     "PME redist. X/F", "PME spread/gather", "PME 3D-FFT", "PME 3D-FFT Comm.", "PME solve LJ", "PME solve Elec",
     "PME wait for PP", "Wait + Recv. PME F", "Wait GPU nonlocal", "Wait GPU local", "Wait GPU loc. est.", "NB X/F buffer ops.",
     "Vsite spread", "COM pull force",
@@ -123,6 +123,7 @@ static const char *wcsn[ewcsNR] =
     "Restraints F",
     "Listed buffer ops.",
     "Nonbonded F",
+    "Nonbonded pruning",
     "Ewald F correction",
     "NB X buffer ops.",
     "NB F buffer ops.",
@@ -774,6 +775,17 @@ void wallcycle_print(FILE *fplog, int nnodes, int npme, double realtime,
                          npme, nth_pme,
                          wc->wcc[i].n, cyc_sum[i], tot);
         }
+        else if (i == ewcPMEMESH_TASK)
+        {
+            /* The PME mesh task overlaps with the Force time,
+             * so it should not be counted in the total.
+             */
+            char buffer[STRLEN];
+            snprintf(buffer, STRLEN, "%s **", wcn[i]);
+            print_cycles(fplog, c2t_pp, buffer,
+                         npp, nth_pp,
+                         wc->wcc[i].n, cyc_sum[i], tot);
+        }
         else
         {
             /* Print timing information when it is for a PP or PP+PME
@@ -817,7 +829,15 @@ void wallcycle_print(FILE *fplog, int nnodes, int npme, double realtime,
                 "%s\n", hline);
     }
 
-    if (wc->wcc[ewcPMEMESH].n > 0)
+    if (wc->wcc[ewcPMEMESH_TASK].n > 0)
+    {
+        fprintf(fplog,
+                "(**) The PME mesh task runs concurrently with the other force tasks,\n"
+                "     its time overlaps with Force and is not included in the total.\n"
+                "%s\n", hline);
+    }
+
+    if (wc->wcc[ewcPMEMESH].n > 0 || wc->wcc[ewcPMEMESH_TASK].n > 0)
     {
         fprintf(fplog, " Breakdown of PME mesh computation\n");
         fprintf(fplog, "%s\n", hline);
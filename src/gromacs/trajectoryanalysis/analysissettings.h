@@ -119,6 +119,23 @@ class TrajectoryAnalysisSettings
              * \see setRmPBC()
              */
             efNoUserRmPBC    = 1<<5,
+            /*! \brief
+             * Allows analyzing several frames concurrently.
+             *
+             * If this flag is specified, a command-line option is provided
+             * for the user to set the number of threads, and
+             * TrajectoryAnalysisModule::analyzeFrame() may be called
+             * concurrently for different frames, each with its own
+             * TrajectoryAnalysisModuleData object.
+             * The module should only access frame-local data through
+             * TrajectoryAnalysisModuleData (including
+             * TrajectoryAnalysisModuleData::parallelSelection()), and not
+             * modify any other member variables in analyzeFrame().
+             * The flag can be cleared in
+             * TrajectoryAnalysisModule::optionsFinished() if the selected
+             * options make the analysis depend on earlier frames.
+             */
+            efFrameParallel  = 1<<6,
         };
 
         //! Initializes default settings.
@@ -43,10 +43,15 @@
 
 #include "cmdlinerunner.h"
 
+#include <memory>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
 #include "gromacs/fileio/trx.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -54,6 +59,7 @@
 #include "gromacs/selection/selectionoptionbehavior.h"
 #include "gromacs/trajectoryanalysis/analysismodule.h"
 #include "gromacs/trajectoryanalysis/analysissettings.h"
+#include "gromacs/utility/classhelpers.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/filestream.h"
 #include "gromacs/utility/gmxassert.h"
@@ -66,6 +72,68 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * FrameParallelSlot
+ */
+
+/*! \brief
+ * Frame-local state for analyzing one frame in frame-parallel analysis.
+ *
+ * Holds a copy of the frame and of the evaluated selections, such that the
+ * runner can read and evaluate the next frames while this one is analyzed.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+class FrameParallelSlot
+{
+    public:
+        FrameParallelSlot()
+        {
+            clear_trxframe(&frame_, TRUE);
+        }
+
+        /*! \brief
+         * Copies the given frame into this slot.
+         *
+         * Coordinate arrays are copied, other pointers are shared with
+         * \p source.
+         */
+        void setFrame(const t_trxframe &source)
+        {
+            frame_ = source;
+            frame_.x = copyArray(source.x, source.natoms, &x_);
+            frame_.v = copyArray(source.v, source.natoms, &v_);
+            frame_.f = copyArray(source.f, source.natoms, &f_);
+        }
+
+        //! Frame-local copy of the frame.
+        t_trxframe                          frame_;
+        //! PBC information for \a frame_.
+        t_pbc                               pbc_;
+        //! Frame-local copies of the selections.
+        SelectionCollection                 selections_;
+        //! Thread-local data for the analysis module.
+        TrajectoryAnalysisModuleDataPointer pdata_;
+
+    private:
+        //! Copies an array of \p n vectors (if not NULL) into \p storage.
+        static rvec *copyArray(const rvec *source, int n, std::vector<RVec> *storage)
+        {
+            if (source == NULL)
+            {
+                return NULL;
+            }
+            storage->assign(source, source + n);
+            return as_rvec_array(storage->data());
+        }
+
+        std::vector<RVec>                   x_;
+        std::vector<RVec>                   v_;
+        std::vector<RVec>                   f_;
+
+        GMX_DISALLOW_COPY_AND_ASSIGN(FrameParallelSlot);
+};
+
 /********************************************************************
  * RunnerModule
  */
@@ -84,6 +152,18 @@ class RunnerModule : public ICommandLineOptionsModule
         virtual void optionsFinished();
         virtual int run();
 
+        /*! \brief
+         * Analyzes all frames, \p nthreads frames concurrently.
+         *
+         * \returns  Number of frames analyzed.
+         *
+         * Frames are read and selections evaluated serially, after which up
+         * to \p nthreads frames are passed to analyzeFrame() in parallel,
+         * each with its own copy of the frame, the selections, and the
+         * module data.  finishFrameSerial() is then called in frame order.
+         */
+        int analyzeFramesParallel(int nthreads);
+
         TrajectoryAnalysisModulePointer module_;
         TrajectoryAnalysisSettings      settings_;
         TrajectoryAnalysisRunnerCommon  common_;
@@ -124,35 +204,42 @@ int RunnerModule::run()
     common_.initFirstFrame();
     module_->initAfterFirstFrame(settings_, common_.frame());
 
-    t_pbc  pbc;
-    t_pbc *ppbc = settings_.hasPBC() ? &pbc : NULL;
-
-    int    nframes = 0;
-    AnalysisDataParallelOptions         dataOptions;
-    TrajectoryAnalysisModuleDataPointer pdata(
-            module_->startFrames(dataOptions, selections_));
-    do
+    int nframes = 0;
+    if (common_.frameThreadCount() > 1)
     {
-        common_.initFrame();
-        t_trxframe &frame = common_.frame();
-        if (ppbc != NULL)
+        nframes = analyzeFramesParallel(common_.frameThreadCount());
+    }
+    else
+    {
+        t_pbc  pbc;
+        t_pbc *ppbc = settings_.hasPBC() ? &pbc : NULL;
+
+        AnalysisDataParallelOptions         dataOptions;
+        TrajectoryAnalysisModuleDataPointer pdata(
+                module_->startFrames(dataOptions, selections_));
+        do
         {
-            set_pbc(ppbc, topology.ePBC(), frame.box);
-        }
+            common_.initFrame();
+            t_trxframe &frame = common_.frame();
+            if (ppbc != NULL)
+            {
+                set_pbc(ppbc, topology.ePBC(), frame.box);
+            }
 
-        selections_.evaluate(&frame, ppbc);
-        module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
-        module_->finishFrameSerial(nframes);
+            selections_.evaluate(&frame, ppbc);
+            module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
+            module_->finishFrameSerial(nframes);
 
-        ++nframes;
-    }
-    while (common_.readNextFrame());
-    module_->finishFrames(pdata.get());
-    if (pdata.get() != NULL)
-    {
-        pdata->finish();
+            ++nframes;
+        }
+        while (common_.readNextFrame());
+        module_->finishFrames(pdata.get());
+        if (pdata.get() != NULL)
+        {
+            pdata->finish();
+        }
+        pdata.reset();
     }
-    pdata.reset();
 
     if (common_.hasTrajectory())
     {
@@ -173,6 +260,78 @@ int RunnerModule::run()
     return 0;
 }
 
+int RunnerModule::analyzeFramesParallel(int nthreads)
+{
+    const TopologyInformation &topology = common_.topologyInformation();
+    const bool                 bPBC     = settings_.hasPBC();
+
+    AnalysisDataParallelOptions dataOptions(nthreads);
+    std::vector<std::unique_ptr<FrameParallelSlot> > slots;
+    for (int i = 0; i < nthreads; ++i)
+    {
+        std::unique_ptr<FrameParallelSlot> slot(new FrameParallelSlot);
+        slot->selections_.initFrameLocalCopy(selections_);
+        slot->pdata_ = module_->startFrames(dataOptions, slot->selections_);
+        slots.push_back(std::move(slot));
+    }
+
+    int  nframes = 0;
+    bool bMore   = true;
+    while (bMore)
+    {
+        // Read and evaluate selections for the next batch of frames.
+        // Selection evaluation is not thread-safe, so this is done serially.
+        int batchSize = 0;
+        do
+        {
+            common_.initFrame();
+            FrameParallelSlot &slot = *slots[batchSize];
+            slot.setFrame(common_.frame());
+            t_pbc *ppbc = bPBC ? &slot.pbc_ : NULL;
+            if (ppbc != NULL)
+            {
+                set_pbc(ppbc, topology.ePBC(), slot.frame_.box);
+            }
+            selections_.evaluate(&slot.frame_, ppbc);
+            slot.selections_.copyFrameData(selections_);
+            ++batchSize;
+            bMore = common_.readNextFrame();
+        }
+        while (bMore && batchSize < nthreads);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+        for (int i = 0; i < batchSize; ++i)
+        {
+            try
+            {
+                FrameParallelSlot &slot = *slots[i];
+                t_pbc             *ppbc = bPBC ? &slot.pbc_ : NULL;
+                module_->analyzeFrame(nframes + i, slot.frame_, ppbc,
+                                      slot.pdata_.get());
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        for (int i = 0; i < batchSize; ++i)
+        {
+            module_->finishFrameSerial(nframes + i);
+        }
+        nframes += batchSize;
+    }
+
+    for (int i = 0; i < nthreads; ++i)
+    {
+        TrajectoryAnalysisModuleData *pdata = slots[i]->pdata_.get();
+        module_->finishFrames(pdata);
+        if (pdata != NULL)
+        {
+            pdata->finish();
+        }
+        slots[i]->pdata_.reset();
+    }
+    return nframes;
+}
+
 }   // namespace
 
 /********************************************************************
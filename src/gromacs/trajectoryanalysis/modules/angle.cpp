@@ -359,6 +359,7 @@ Angle::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *setti
     { "none", "vector", "plane", "t0", "z", "sphnorm" };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("oav").filetype(eftPlot).outputFile()
                            .store(&fnAverage_).defaultBasename("angaver")
@@ -391,7 +392,7 @@ Angle::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *setti
 
 
 void
-Angle::optionsFinished(TrajectoryAnalysisSettings * /* settings */)
+Angle::optionsFinished(TrajectoryAnalysisSettings *settings)
 {
     const bool bSingle = (g1type_[0] == 'a' || g1type_[0] == 'd');
 
@@ -410,6 +411,11 @@ Angle::optionsFinished(TrajectoryAnalysisSettings * /* settings */)
         GMX_THROW(InconsistentInputError("Should specify a second group (-g2) "
                                          "if the first group is not an angle or a dihedral"));
     }
+    if (g2type_[0] == 't')
+    {
+        // The vectors of the first frame are needed by all later frames.
+        settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel, false);
+    }
 
     // Set up the number of positions per angle.
     switch (g1type_[0])
@@ -701,7 +707,7 @@ Angle::analyzeFrame(int frnr, const t_trxframe &fr, t_pbc *pbc,
                 v2[ZZ] = 1.0;
                 break;
             case 's':
-                copy_rvec(sel2_[g].position(0).x(), c2);
+                copy_rvec(sel2[g].position(0).x(), c2);
                 break;
             default:
                 // do nothing
@@ -774,7 +780,8 @@ Angle::analyzeFrame(int frnr, const t_trxframe &fr, t_pbc *pbc,
                             calc_vec(natoms2_, x, pbc, v2, c2);
                             break;
                         case 't':
-                            // FIXME: This is not parallelizable.
+                            // Frames are analyzed serially with t0,
+                            // see optionsFinished().
                             if (frnr == 0)
                             {
                                 copy_rvec(v1, vt0_[g][n]);
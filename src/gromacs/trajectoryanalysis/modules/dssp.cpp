@@ -0,0 +1,1134 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::analysismodules::Dssp.
+ *
+ * \ingroup module_trajectoryanalysis
+ */
+#include "gmxpre.h"
+
+#include "dssp.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "gromacs/analysisdata/analysisdata.h"
+#include "gromacs/analysisdata/dataframe.h"
+#include "gromacs/analysisdata/modules/plot.h"
+#include "gromacs/fileio/filenm.h"
+#include "gromacs/fileio/matio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trx.h"
+#include "gromacs/fileio/xvgr.h"
+#include "gromacs/legacyheaders/copyrite.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/options/basicoptions.h"
+#include "gromacs/options/filenameoption.h"
+#include "gromacs/options/ioptionscontainer.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/selection/nbsearch.h"
+#include "gromacs/selection/selection.h"
+#include "gromacs/selection/selectionoption.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/trajectoryanalysis/analysissettings.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/programcontext.h"
+#include "gromacs/utility/scoped_cptr.h"
+
+namespace gmx
+{
+
+namespace analysismodules
+{
+
+namespace
+{
+
+//! \addtogroup module_trajectoryanalysis
+//! \{
+
+/*! \brief
+ * Secondary structure types.
+ *
+ * The values are indices into c_secondaryStructureMap, and are the values
+ * stored in the output data.
+ */
+enum SecondaryStructureType
+{
+    eSS_Coil,
+    eSS_Strand,
+    eSS_Bridge,
+    eSS_Bend,
+    eSS_Turn,
+    eSS_AlphaHelix,
+    eSS_PiHelix,
+    eSS_310Helix,
+    eSS_ChainSeparator,
+    eSS_NR
+};
+
+//! Codes, descriptions and colors for SecondaryStructureType (as in ss.map).
+const t_mapping c_secondaryStructureMap[eSS_NR] = {
+    { { '~', 0 }, "Coil",            { 1,   1,   1   } },
+    { { 'E', 0 }, "B-Sheet",         { 1,   0,   0   } },
+    { { 'B', 0 }, "B-Bridge",        { 0,   0,   0   } },
+    { { 'S', 0 }, "Bend",            { 0,   0.5, 0   } },
+    { { 'T', 0 }, "Turn",            { 1,   1,   0   } },
+    { { 'H', 0 }, "A-Helix",         { 0,   0,   1   } },
+    { { 'I', 0 }, "5-Helix",         { 0.5, 0,   0.5 } },
+    { { 'G', 0 }, "3-Helix",         { 0.5, 0.5, 0.5 } },
+    { { '=', 0 }, "Chain_Separator", { 0.9, 0.9, 0.9 } }
+};
+
+/*! \brief
+ * Electrostatic coupling constant of the DSSP H-bond energy (kcal/mol nm).
+ *
+ * Corresponds to partial charges of 0.42e and 0.20e on the C=O and N-H
+ * groups and a dimensional factor of 332 kcal/mol A.
+ */
+const double c_couplingConstant   = 0.1*0.42*0.20*332;
+//! Distances shorter than this are treated as a clash (nm).
+const double c_minimalDistance    = 0.05;
+//! Energy assigned to clashing donor-acceptor pairs (kcal/mol).
+const double c_minHBondEnergy     = -9.9;
+//! H-bonds need to have an energy below this (kcal/mol).
+const double c_maxHBondEnergy     = -0.5;
+//! Residue pairs with a longer CA-CA distance are not considered (nm).
+const real   c_maxCADistance      = 0.9;
+/*! \brief
+ * Cutoff for the N-O distance in the H-bond search (nm).
+ *
+ * No geometry with normal N-H and C=O bond lengths reaches an energy below
+ * c_maxHBondEnergy beyond an N-O distance of 0.54 nm.
+ */
+const real   c_hbondCutoff        = 0.6;
+//! Length of the constructed N-H bond (nm).
+const real   c_nhBondLength       = 0.1;
+//! Peptide bonds longer than this are treated as chain breaks (nm).
+const real   c_maxPeptideBondLength = 0.25;
+//! Residues with a larger CA angle (in degrees) are bends.
+const real   c_minBendAngle       = 70;
+
+//! Computes a distance vector, using PBC if available.
+void computeDx(const t_pbc *pbc, const rvec x1, const rvec x2, rvec dx)
+{
+    if (pbc != NULL)
+    {
+        pbc_dx_aiuc(pbc, x1, x2, dx);
+    }
+    else
+    {
+        rvec_sub(x1, x2, dx);
+    }
+}
+
+/*! \brief
+ * Computes the DSSP electrostatic H-bond energy between two residues.
+ *
+ * \param[in] pbc   PBC information (can be NULL).
+ * \param[in] xN    Donor N position.
+ * \param[in] h     Donor N-H bond vector.
+ * \param[in] xC    Acceptor C position.
+ * \param[in] xO    Acceptor O position.
+ * \returns   Energy in kcal/mol, rounded to three decimals as in DSSP.
+ */
+double computeHBondEnergy(const t_pbc *pbc, const rvec xN, const rvec h,
+                          const rvec xC, const rvec xO)
+{
+    rvec dON, dCN, dOH, dCH;
+
+    computeDx(pbc, xO, xN, dON);
+    computeDx(pbc, xC, xN, dCN);
+    rvec_sub(dON, h, dOH);
+    rvec_sub(dCN, h, dCH);
+    const double rON = norm(dON);
+    const double rCN = norm(dCN);
+    const double rOH = norm(dOH);
+    const double rCH = norm(dCH);
+    if (rON < c_minimalDistance || rCN < c_minimalDistance
+        || rOH < c_minimalDistance || rCH < c_minimalDistance)
+    {
+        return c_minHBondEnergy;
+    }
+    double energy = c_couplingConstant*(1/rON + 1/rCH - 1/rOH - 1/rCN);
+    energy = std::floor(energy*1000 + 0.5)/1000;
+    return std::max(energy, c_minHBondEnergy);
+}
+
+/*! \brief
+ * Backbone H-bond from the N-H of one residue to the C=O of another.
+ */
+struct BackboneHBond
+{
+    //! Initializes an H-bond.
+    BackboneHBond(int donor, int acceptor, double energy)
+        : donor(donor), acceptor(acceptor), energy(energy)
+    {
+    }
+
+    //! Orders H-bonds in the order DSSP evaluates them.
+    bool operator<(const BackboneHBond &other) const
+    {
+        return donor < other.donor
+               || (donor == other.donor && acceptor < other.acceptor);
+    }
+
+    //! Residue index of the donor.
+    int    donor;
+    //! Residue index of the acceptor.
+    int    acceptor;
+    //! H-bond energy (kcal/mol).
+    double energy;
+};
+
+/*! \brief
+ * Beta ladder: a set of one or more consecutive bridges.
+ *
+ * Residues in \p i are always increasing; residues in \p j increase for
+ * parallel and decrease for antiparallel ladders.
+ */
+struct BetaLadder
+{
+    //! Whether the strands are parallel.
+    bool             bParallel;
+    //! Residues in the first strand.
+    std::deque<int>  i;
+    //! Residues in the second strand.
+    std::deque<int>  j;
+};
+
+//! Orders ladders by their first residue.
+bool ladderStartsBefore(const BetaLadder &a, const BetaLadder &b)
+{
+    return a.i.front() < b.i.front();
+}
+
+//! Helix flags for one residue and helix stride.
+enum HelixFlag
+{
+    eHelix_None,
+    eHelix_Start,
+    eHelix_End,
+    eHelix_StartAndEnd,
+    eHelix_Middle
+};
+
+/*! \brief
+ * Assigns DSSP secondary structure from backbone H-bonds.
+ *
+ * Implements the assignment rules of Kabsch and Sander (1983) in the
+ * same order and with the same tie-breaking as the DSSP program, such that
+ * the results agree with those of DSSP 2.0 for identical H-bond energies.
+ *
+ * Holds the work arrays for one frame, so one instance is needed per
+ * thread.
+ */
+class SecondaryStructureAssigner
+{
+    public:
+        /*! \brief
+         * Assigns secondary structure for one frame.
+         *
+         * \param[in]  segment  Continuous segment index for each residue;
+         *     differs between residues separated by a chain break.
+         * \param[in]  hbonds   H-bonds with energy below c_maxHBondEnergy,
+         *     sorted with BackboneHBond::operator<().
+         * \param[in]  bBend    Whether each residue is a bend.
+         * \param[out] ss       SecondaryStructureType for each residue.
+         */
+        void assign(const std::vector<int>           &segment,
+                    const std::vector<BackboneHBond> &hbonds,
+                    const std::vector<bool>          &bBend,
+                    std::vector<int>                 *ss);
+
+    private:
+        //! Whether the N-H of \p donor is H-bonded to the C=O of \p acceptor.
+        bool testBond(int donor, int acceptor) const
+        {
+            return (acceptor_[2*donor] == acceptor || acceptor_[2*donor+1] == acceptor);
+        }
+        //! Whether residues \p a to \p b (inclusive) have no chain breaks.
+        bool noChainBreak(int a, int b) const
+        {
+            return (*segment_)[a] == (*segment_)[b];
+        }
+        //! Returns helix flag for residue \p i and \p stride (3, 4, or 5).
+        int &helixFlag(int i, int stride)
+        {
+            return helixFlags_[3*i + stride - 3];
+        }
+        //! Whether residue \p i starts a helical turn of \p stride.
+        bool isHelixStart(int i, int stride)
+        {
+            const int flag = helixFlag(i, stride);
+            return flag == eHelix_Start || flag == eHelix_StartAndEnd;
+        }
+
+        void assignBetaSheets(std::vector<int> *ss);
+        void assignHelices(const std::vector<bool> &bBend, std::vector<int> *ss);
+
+        //! Segment indices passed to assign().
+        const std::vector<int>  *segment_;
+        /*! \brief
+         * Two best acceptors for the N-H of each residue, or -1.
+         *
+         * Only acceptors with an energy below c_maxHBondEnergy are stored.
+         */
+        std::vector<int>         acceptor_;
+        //! Energies for \p acceptor_.
+        std::vector<double>      energy_;
+        //! HelixFlag values for each residue and stride.
+        std::vector<int>         helixFlags_;
+        //! Beta ladders found in the current frame.
+        std::vector<BetaLadder>  ladders_;
+};
+
+void SecondaryStructureAssigner::assign(const std::vector<int>           &segment,
+                                        const std::vector<BackboneHBond> &hbonds,
+                                        const std::vector<bool>          &bBend,
+                                        std::vector<int>                 *ss)
+{
+    const int nres = segment.size();
+
+    segment_ = &segment;
+    acceptor_.assign(2*nres, -1);
+    energy_.assign(2*nres, 0.0);
+    // DSSP keeps the two lowest-energy acceptors for each donor, keeping
+    // the earlier one on ties.  Weaker bonds can only replace other bonds
+    // above c_maxHBondEnergy, so they do not need to be considered.
+    for (size_t b = 0; b < hbonds.size(); ++b)
+    {
+        const int    d = hbonds[b].donor;
+        const double e = hbonds[b].energy;
+        if (e < energy_[2*d])
+        {
+            acceptor_[2*d+1] = acceptor_[2*d];
+            energy_[2*d+1]   = energy_[2*d];
+            acceptor_[2*d]   = hbonds[b].acceptor;
+            energy_[2*d]     = e;
+        }
+        else if (e < energy_[2*d+1])
+        {
+            acceptor_[2*d+1] = hbonds[b].acceptor;
+            energy_[2*d+1]   = e;
+        }
+    }
+
+    ss->assign(nres, eSS_Coil);
+    assignBetaSheets(ss);
+    assignHelices(bBend, ss);
+}
+
+void SecondaryStructureAssigner::assignBetaSheets(std::vector<int> *ss)
+{
+    const int nres = segment_->size();
+
+    ladders_.clear();
+    for (int i = 1; i + 4 < nres; ++i)
+    {
+        for (int j = i + 3; j + 1 < nres; ++j)
+        {
+            if (!noChainBreak(i - 1, i + 1) || !noChainBreak(j - 1, j + 1))
+            {
+                continue;
+            }
+            bool bParallel;
+            if ((testBond(i + 1, j) && testBond(j, i - 1))
+                || (testBond(j + 1, i) && testBond(i, j - 1)))
+            {
+                bParallel = true;
+            }
+            else if ((testBond(i + 1, j - 1) && testBond(j + 1, i - 1))
+                     || (testBond(j, i) && testBond(i, j)))
+            {
+                bParallel = false;
+            }
+            else
+            {
+                continue;
+            }
+
+            bool bExtended = false;
+            for (size_t l = 0; l < ladders_.size() && !bExtended; ++l)
+            {
+                BetaLadder &ladder = ladders_[l];
+                if (ladder.bParallel != bParallel || i != ladder.i.back() + 1)
+                {
+                    continue;
+                }
+                if (bParallel && ladder.j.back() + 1 == j)
+                {
+                    ladder.i.push_back(i);
+                    ladder.j.push_back(j);
+                    bExtended = true;
+                }
+                else if (!bParallel && ladder.j.front() - 1 == j)
+                {
+                    ladder.i.push_back(i);
+                    ladder.j.push_front(j);
+                    bExtended = true;
+                }
+            }
+            if (!bExtended)
+            {
+                BetaLadder ladder;
+                ladder.bParallel = bParallel;
+                ladder.i.push_back(i);
+                ladder.j.push_back(j);
+                ladders_.push_back(ladder);
+            }
+        }
+    }
+
+    // Join ladders that are separated by a beta bulge.  The gaps are
+    // unsigned in DSSP, so a negative gap is never a bulge.
+    std::stable_sort(ladders_.begin(), ladders_.end(), &ladderStartsBefore);
+    for (size_t a = 0; a < ladders_.size(); ++a)
+    {
+        for (size_t b = a + 1; b < ladders_.size(); ++b)
+        {
+            BetaLadder &la  = ladders_[a];
+            BetaLadder &lb  = ladders_[b];
+            const int   ibi = la.i.front(), iei = la.i.back();
+            const int   jbi = la.j.front(), jei = la.j.back();
+            const int   ibj = lb.i.front(), iej = lb.i.back();
+            const int   jbj = lb.j.front(), jej = lb.j.back();
+
+            if (la.bParallel != lb.bParallel
+                || !noChainBreak(std::min(ibi, ibj), std::max(iei, iej))
+                || !noChainBreak(std::min(jbi, jbj), std::max(jei, jej))
+                || ibj - iei >= 6
+                || (iei >= ibj && ibi <= iej))
+            {
+                continue;
+            }
+            bool bBulge;
+            if (la.bParallel)
+            {
+                bBulge = jbj >= jei && ((jbj - jei < 6 && ibj - iei < 3) || jbj - jei < 3);
+            }
+            else
+            {
+                bBulge = jbi >= jej && ((jbi - jej < 6 && ibj - iei < 3) || jbi - jej < 3);
+            }
+            if (bBulge)
+            {
+                la.i.insert(la.i.end(), lb.i.begin(), lb.i.end());
+                if (la.bParallel)
+                {
+                    la.j.insert(la.j.end(), lb.j.begin(), lb.j.end());
+                }
+                else
+                {
+                    la.j.insert(la.j.begin(), lb.j.begin(), lb.j.end());
+                }
+                ladders_.erase(ladders_.begin() + b);
+                --b;
+            }
+        }
+    }
+
+    for (size_t l = 0; l < ladders_.size(); ++l)
+    {
+        const BetaLadder &ladder = ladders_[l];
+        const int         type   = (ladder.i.size() > 1 ? eSS_Strand : eSS_Bridge);
+        for (int i = ladder.i.front(); i <= ladder.i.back(); ++i)
+        {
+            if ((*ss)[i] != eSS_Strand)
+            {
+                (*ss)[i] = type;
+            }
+        }
+        for (int j = ladder.j.front(); j <= ladder.j.back(); ++j)
+        {
+            if ((*ss)[j] != eSS_Strand)
+            {
+                (*ss)[j] = type;
+            }
+        }
+    }
+}
+
+void SecondaryStructureAssigner::assignHelices(const std::vector<bool> &bBend,
+                                               std::vector<int>        *ss)
+{
+    const int nres = segment_->size();
+
+    helixFlags_.assign(3*nres, eHelix_None);
+    for (int stride = 3; stride <= 5; ++stride)
+    {
+        for (int i = 0; i + stride < nres; ++i)
+        {
+            if (noChainBreak(i, i + stride) && testBond(i + stride, i))
+            {
+                helixFlag(i + stride, stride) = eHelix_End;
+                for (int j = i + 1; j < i + stride; ++j)
+                {
+                    if (helixFlag(j, stride) == eHelix_None)
+                    {
+                        helixFlag(j, stride) = eHelix_Middle;
+                    }
+                }
+                if (helixFlag(i, stride) == eHelix_End)
+                {
+                    helixFlag(i, stride) = eHelix_StartAndEnd;
+                }
+                else
+                {
+                    helixFlag(i, stride) = eHelix_Start;
+                }
+            }
+        }
+    }
+
+    for (int i = 1; i + 4 < nres; ++i)
+    {
+        if (isHelixStart(i, 4) && isHelixStart(i - 1, 4))
+        {
+            for (int j = i; j <= i + 3; ++j)
+            {
+                (*ss)[j] = eSS_AlphaHelix;
+            }
+        }
+    }
+    // 3-10 and pi helices only replace coil, and 3-10 takes precedence.
+    const int strides[2] = { 3, 5 };
+    const int types[2]   = { eSS_310Helix, eSS_PiHelix };
+    for (int s = 0; s < 2; ++s)
+    {
+        const int stride = strides[s];
+        for (int i = 1; i + stride < nres; ++i)
+        {
+            if (isHelixStart(i, stride) && isHelixStart(i - 1, stride))
+            {
+                bool bEmpty = true;
+                for (int j = i; j < i + stride && bEmpty; ++j)
+                {
+                    bEmpty = ((*ss)[j] == eSS_Coil || (*ss)[j] == types[s]);
+                }
+                if (bEmpty)
+                {
+                    for (int j = i; j < i + stride; ++j)
+                    {
+                        (*ss)[j] = types[s];
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 1; i + 1 < nres; ++i)
+    {
+        if ((*ss)[i] != eSS_Coil)
+        {
+            continue;
+        }
+        bool bTurn = false;
+        for (int stride = 3; stride <= 5 && !bTurn; ++stride)
+        {
+            for (int k = 1; k < stride && !bTurn; ++k)
+            {
+                bTurn = (i >= k) && isHelixStart(i - k, stride);
+            }
+        }
+        if (bTurn)
+        {
+            (*ss)[i] = eSS_Turn;
+        }
+        else if (bBend[i])
+        {
+            (*ss)[i] = eSS_Bend;
+        }
+    }
+}
+
+/*! \brief
+ * Implements `gmx dssp` trajectory analysis module.
+ */
+class Dssp : public TrajectoryAnalysisModule
+{
+    public:
+        Dssp();
+
+        virtual void initOptions(IOptionsContainer          *options,
+                                 TrajectoryAnalysisSettings *settings);
+        virtual void initAnalysis(const TrajectoryAnalysisSettings &settings,
+                                  const TopologyInformation        &top);
+
+        virtual TrajectoryAnalysisModuleDataPointer startFrames(
+            const AnalysisDataParallelOptions &opt,
+            const SelectionCollection         &selections);
+        virtual void analyzeFrame(int frnr, const t_trxframe &fr, t_pbc *pbc,
+                                  TrajectoryAnalysisModuleData *pdata);
+
+        virtual void finishAnalysis(int nframes);
+        virtual void writeOutput();
+
+    private:
+        /*! \brief
+         * Secondary structure as a function of time.
+         *
+         * Each column is a row of the output matrix: one for each residue,
+         * plus one chain separator between each pair of chains.  The values
+         * are SecondaryStructureType values.  All frames are stored for
+         * writing the output in writeOutput().
+         */
+        AnalysisData                ss_;
+
+        //! Selection of atoms that specifies the residues to analyze.
+        Selection                   sel_;
+        std::string                 fnMatrix_;
+        std::string                 fnCount_;
+        std::string                 ssString_;
+
+        //! Settings for writing the output files.
+        AnalysisDataPlotSettings    plotSettings_;
+        //! Neighborhood search for backbone N-O pairs.
+        AnalysisNeighborhood        nb_;
+        //! N atom index for each residue.
+        std::vector<int>            atomN_;
+        //! CA atom index for each residue.
+        std::vector<int>            atomCA_;
+        //! C atom index for each residue.
+        std::vector<int>            atomC_;
+        //! O atom index for each residue.
+        std::vector<int>            atomO_;
+        /*! \brief
+         * Index of the residue that provides the N-H direction, or -1.
+         *
+         * This is the preceding residue in the same chain, except for
+         * prolines and for the first residue, which cannot donate H-bonds.
+         */
+        std::vector<int>            hydrogenFrom_;
+        //! Whether each residue starts a new chain.
+        std::vector<bool>           bChainStart_;
+        //! Output row for each residue.
+        std::vector<int>            row_;
+        //! Output rows that are chain separators.
+        std::vector<int>            separatorRows_;
+
+        // Copy and assign disallowed by base.
+};
+
+Dssp::Dssp()
+    : TrajectoryAnalysisModule(DsspInfo::name, DsspInfo::shortDescription),
+      ssString_("HEBT")
+{
+    registerAnalysisDataset(&ss_, "ss");
+}
+
+void
+Dssp::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *settings)
+{
+    static const char *const desc[] = {
+        "[THISMODULE] assigns secondary structure for each residue and",
+        "frame with the algorithm of the DSSP program",
+        "(Kabsch and Sander, 1983).",
+        "It computes the same electrostatic backbone H-bond energies and",
+        "applies the same rules to find helices, beta bridges and ladders,",
+        "turns and bends, but runs directly on the trajectory, without",
+        "writing temporary files or starting an external program.",
+        "Frames can be analyzed in parallel with [TT]-nt[tt].[PAR]",
+        "The residues are taken from the atoms in [TT]-sel[tt]; residues",
+        "without backbone atoms named N, CA, C and O are ignored.",
+        "Backbone hydrogens are placed from the preceding C=O as in DSSP,",
+        "so they do not need to be present. Chains are split where the",
+        "chain identifier changes or where a peptide bond is longer than",
+        "0.25 nm. With [TT]-pbc[tt] (the default), distances use",
+        "periodic boundary conditions and molecules do not need to be",
+        "whole.[PAR]",
+        "The structure assignment for each residue and time is written to an",
+        "[REF].xpm[ref] matrix file ([TT]-o[tt]), in the same format as",
+        "[gmx-do_dssp]. Chains are separated by light grey lines.",
+        "The number of residues with each secondary structure type and the",
+        "total secondary structure ([TT]-sss[tt]) count as a function of",
+        "time can also be written to a file ([TT]-sc[tt])."
+    };
+
+    settings->setHelpText(desc);
+
+    options->addOption(FileNameOption("o").legacyType(efXPM).outputFile()
+                           .required().store(&fnMatrix_).defaultBasename("ss")
+                           .description("Secondary structure matrix"));
+    options->addOption(FileNameOption("sc").filetype(eftPlot).outputFile()
+                           .store(&fnCount_).defaultBasename("scount")
+                           .description("Secondary structure counts as a function of time"));
+    options->addOption(SelectionOption("sel").store(&sel_)
+                           .defaultSelectionText("all").onlyAtoms().onlyStatic()
+                           .description("Atoms of the residues to analyze"));
+    options->addOption(StringOption("sss").store(&ssString_)
+                           .description("Secondary structures for structure count"));
+
+    settings->setFlags(TrajectoryAnalysisSettings::efRequireTop
+                       | TrajectoryAnalysisSettings::efUseTopX
+                       | TrajectoryAnalysisSettings::efFrameParallel);
+}
+
+void
+Dssp::initAnalysis(const TrajectoryAnalysisSettings &settings,
+                   const TopologyInformation        &top)
+{
+    const t_atoms      &atoms       = top.topology()->atoms;
+    ConstArrayRef<int>  atomIndices = sel_.atomIndices();
+
+    for (size_t a = 0; a < atomIndices.size(); )
+    {
+        const int resind = atoms.atom[atomIndices[a]].resind;
+        int       n      = -1, ca = -1, c = -1, o = -1, oterm = -1;
+        for (; a < atomIndices.size() && atoms.atom[atomIndices[a]].resind == resind; ++a)
+        {
+            const int   ai   = atomIndices[a];
+            const char *name = *atoms.atomname[ai];
+            if (std::strcmp(name, "N") == 0)
+            {
+                n = ai;
+            }
+            else if (std::strcmp(name, "CA") == 0)
+            {
+                ca = ai;
+            }
+            else if (std::strcmp(name, "C") == 0)
+            {
+                c = ai;
+            }
+            else if (std::strcmp(name, "O") == 0)
+            {
+                o = ai;
+            }
+            else if (std::strcmp(name, "OXT") == 0 || std::strcmp(name, "O1") == 0
+                     || std::strcmp(name, "OC1") == 0)
+            {
+                oterm = ai;
+            }
+        }
+        if (o < 0)
+        {
+            o = oterm;
+        }
+        if (n < 0 || ca < 0 || c < 0 || o < 0)
+        {
+            continue;
+        }
+        const int  prev        = static_cast<int>(atomN_.size()) - 1;
+        const bool bChainStart =
+            (prev < 0
+             || atoms.resinfo[atoms.atom[atomN_[prev]].resind].chainid
+             != atoms.resinfo[resind].chainid);
+        const bool bProline    = (std::strcmp(*atoms.resinfo[resind].name, "PRO") == 0);
+        atomN_.push_back(n);
+        atomCA_.push_back(ca);
+        atomC_.push_back(c);
+        atomO_.push_back(o);
+        bChainStart_.push_back(bChainStart);
+        hydrogenFrom_.push_back(bChainStart || bProline ? -1 : prev);
+    }
+    if (atomN_.empty())
+    {
+        GMX_THROW(InconsistentInputError("No residues with backbone atoms N, CA, C and O found in the selection"));
+    }
+    fprintf(stderr, "There are %d residues in your selected group\n",
+            static_cast<int>(atomN_.size()));
+
+    // Chain separators are placed based on the topology coordinates, such
+    // that the output has the same rows for every frame.
+    rvec  *xtop;
+    matrix boxtop;
+    t_pbc  pbctop;
+    top.getTopologyConf(&xtop, boxtop);
+    set_pbc(&pbctop, top.ePBC(), boxtop);
+    const t_pbc *ppbc = settings.hasPBC() ? &pbctop : NULL;
+    int          row  = 0;
+    for (size_t i = 0; i < atomN_.size(); ++i)
+    {
+        if (i > 0)
+        {
+            rvec dx;
+            computeDx(ppbc, xtop[atomN_[i]], xtop[atomC_[i-1]], dx);
+            if (bChainStart_[i] || norm(dx) > c_maxPeptideBondLength)
+            {
+                separatorRows_.push_back(row);
+                ++row;
+            }
+        }
+        row_.push_back(row);
+        ++row;
+    }
+
+    nb_.setCutoff(c_hbondCutoff);
+    plotSettings_ = settings.plotSettings();
+    ss_.setColumnCount(0, row);
+    if (!ss_.requestStorage(-1))
+    {
+        GMX_THROW(InternalError("Secondary structure data could not be stored"));
+    }
+}
+
+/*! \brief
+ * Temporary memory for use within a single-frame calculation.
+ */
+class DsspModuleData : public TrajectoryAnalysisModuleData
+{
+    public:
+        //! Reserves memory for the frame-local data.
+        DsspModuleData(TrajectoryAnalysisModule          *module,
+                       const AnalysisDataParallelOptions &opt,
+                       const SelectionCollection         &selections,
+                       int                                residueCount)
+            : TrajectoryAnalysisModuleData(module, opt, selections)
+        {
+            segment_.resize(residueCount);
+            hydrogen_.resize(residueCount);
+            bBend_.resize(residueCount);
+            ss_.resize(residueCount);
+        }
+
+        virtual void finish() { finishDataHandles(); }
+
+        //! Continuous segment index for each residue.
+        std::vector<int>            segment_;
+        //! N-H bond vector for each residue.
+        std::vector<RVec>           hydrogen_;
+        //! H-bonds found in the frame.
+        std::vector<BackboneHBond>  hbonds_;
+        //! Whether each residue is a bend.
+        std::vector<bool>           bBend_;
+        //! Assigned SecondaryStructureType for each residue.
+        std::vector<int>            ss_;
+        //! Assignment algorithm with its work arrays.
+        SecondaryStructureAssigner  assigner_;
+};
+
+TrajectoryAnalysisModuleDataPointer Dssp::startFrames(
+        const AnalysisDataParallelOptions &opt,
+        const SelectionCollection         &selections)
+{
+    return TrajectoryAnalysisModuleDataPointer(
+            new DsspModuleData(this, opt, selections, atomN_.size()));
+}
+
+void
+Dssp::analyzeFrame(int frnr, const t_trxframe &fr, t_pbc *pbc,
+                   TrajectoryAnalysisModuleData *pdata)
+{
+    AnalysisDataHandle  dh        = pdata->dataHandle(ss_);
+    DsspModuleData     &frameData = *static_cast<DsspModuleData *>(pdata);
+    const rvec         *x         = fr.x;
+    const int           nres      = atomN_.size();
+
+    // Find chain breaks and construct the N-H bond vectors.
+    for (int i = 0; i < nres; ++i)
+    {
+        int segment = 0;
+        if (i > 0)
+        {
+            rvec dx;
+            computeDx(pbc, x[atomN_[i]], x[atomC_[i-1]], dx);
+            segment = frameData.segment_[i-1];
+            if (bChainStart_[i] || norm(dx) > c_maxPeptideBondLength)
+            {
+                ++segment;
+            }
+        }
+        frameData.segment_[i] = segment;
+        const int prev = hydrogenFrom_[i];
+        if (prev >= 0)
+        {
+            rvec co;
+            computeDx(pbc, x[atomC_[prev]], x[atomO_[prev]], co);
+            svmul(c_nhBondLength/norm(co), co, frameData.hydrogen_[i]);
+        }
+    }
+
+    // Search for N-O pairs within the cutoff with a grid, and keep those
+    // that form an H-bond.
+    frameData.hbonds_.clear();
+    AnalysisNeighborhoodSearch     nbsearch
+        = nb_.initSearch(pbc, AnalysisNeighborhoodPositions(fr.x, fr.natoms)
+                             .indexed(atomO_));
+    AnalysisNeighborhoodPairSearch pairSearch
+        = nbsearch.startPairSearch(AnalysisNeighborhoodPositions(fr.x, fr.natoms)
+                                       .indexed(atomN_));
+    AnalysisNeighborhoodPair       pair;
+    while (pairSearch.findNextPair(&pair))
+    {
+        const int donor    = pair.testIndex();
+        const int acceptor = pair.refIndex();
+        if (hydrogenFrom_[donor] < 0 || donor == acceptor || donor == acceptor + 1)
+        {
+            continue;
+        }
+        rvec dx;
+        computeDx(pbc, x[atomCA_[donor]], x[atomCA_[acceptor]], dx);
+        if (norm2(dx) >= c_maxCADistance*c_maxCADistance)
+        {
+            continue;
+        }
+        const double energy
+            = computeHBondEnergy(pbc, x[atomN_[donor]], frameData.hydrogen_[donor],
+                                 x[atomC_[acceptor]], x[atomO_[acceptor]]);
+        if (energy < c_maxHBondEnergy)
+        {
+            frameData.hbonds_.push_back(BackboneHBond(donor, acceptor, energy));
+        }
+    }
+    std::sort(frameData.hbonds_.begin(), frameData.hbonds_.end());
+
+    // Bends from the CA angle at each residue.
+    for (int i = 0; i < nres; ++i)
+    {
+        bool bBend = false;
+        if (i >= 2 && i + 2 < nres
+            && frameData.segment_[i-2] == frameData.segment_[i+2])
+        {
+            rvec v1, v2;
+            computeDx(pbc, x[atomCA_[i]], x[atomCA_[i-2]], v1);
+            computeDx(pbc, x[atomCA_[i+2]], x[atomCA_[i]], v2);
+            bBend = (gmx_angle(v1, v2)*RAD2DEG > c_minBendAngle);
+        }
+        frameData.bBend_[i] = bBend;
+    }
+
+    frameData.assigner_.assign(frameData.segment_, frameData.hbonds_,
+                               frameData.bBend_, &frameData.ss_);
+
+    dh.startFrame(frnr, fr.time);
+    for (int i = 0; i < nres; ++i)
+    {
+        dh.setPoint(row_[i], frameData.ss_[i]);
+    }
+    for (size_t s = 0; s < separatorRows_.size(); ++s)
+    {
+        dh.setPoint(separatorRows_[s], eSS_ChainSeparator);
+    }
+    dh.finishFrame();
+}
+
+void
+Dssp::finishAnalysis(int /*nframes*/)
+{
+    please_cite(stdout, "Kabsch83");
+}
+
+/*! \brief
+ * Writes secondary structure counts as a function of time.
+ *
+ * Produces the same output as `gmx do_dssp -sc`.
+ */
+void writeStructureCounts(const char *fn, const t_matrix &mat,
+                          const char *ssString, const gmx_output_env_t *oenv)
+{
+    const t_mapping          *map = mat.map;
+    std::vector<const char *> legend;
+
+    legend.push_back("Structure");
+    for (int s = 0; s < mat.nmap; s++)
+    {
+        legend.push_back(map[s].desc);
+    }
+
+    FILE *fp = xvgropen(fn, "Secondary Structure",
+                        output_env_get_xvgr_tlabel(oenv), "Number of Residues", oenv);
+    if (output_env_get_print_xvgr_codes(oenv))
+    {
+        fprintf(fp, "@ subtitle \"Structure = ");
+    }
+    for (size_t s = 0; s < std::strlen(ssString); s++)
+    {
+        if (s > 0)
+        {
+            fprintf(fp, " + ");
+        }
+        for (int f = 0; f < mat.nmap; f++)
+        {
+            if (ssString[s] == map[f].code.c1)
+            {
+                fprintf(fp, "%s", map[f].desc);
+            }
+        }
+    }
+    fprintf(fp, "\"\n");
+    xvgr_legend(fp, legend.size(), &legend[0], oenv);
+
+    std::vector<int> count(mat.nmap), total(mat.nmap, 0);
+    int              totalCount = 0;
+    for (int f = 0; f < mat.nx; f++)
+    {
+        int ssCount = 0;
+        std::fill(count.begin(), count.end(), 0);
+        for (int r = 0; r < mat.ny; r++)
+        {
+            count[mat.matrix[f][r]]++;
+            total[mat.matrix[f][r]]++;
+        }
+        for (int s = 0; s < mat.nmap; s++)
+        {
+            if (std::strchr(ssString, map[s].code.c1))
+            {
+                ssCount    += count[s];
+                totalCount += count[s];
+            }
+        }
+        fprintf(fp, "%8g %5d", mat.axis_x[f], ssCount);
+        for (int s = 0; s < mat.nmap; s++)
+        {
+            fprintf(fp, " %5d", count[s]);
+        }
+        fprintf(fp, "\n");
+    }
+    fprintf(fp, "%-8s %5d", "# Totals", totalCount);
+    for (int s = 0; s < mat.nmap; s++)
+    {
+        fprintf(fp, " %5d", total[s]);
+    }
+    fprintf(fp, "\n");
+
+    const real nelem = static_cast<real>(mat.nx * mat.ny);
+    fprintf(fp, "%-8s %5.2f", "# SS %", totalCount / nelem);
+    for (int s = 0; s < mat.nmap; s++)
+    {
+        fprintf(fp, " %5.2f", total[s] / nelem);
+    }
+    fprintf(fp, "\n");
+
+    xvgrclose(fp);
+}
+
+void
+Dssp::writeOutput()
+{
+    const int nframes = ss_.frameCount();
+    const int nrows   = ss_.columnCount();
+
+    time_unit_t      timeUnit
+        = static_cast<time_unit_t>(plotSettings_.timeUnit() + 1);
+    xvg_format_t     xvgFormat
+        = (plotSettings_.plotFormat() > 0
+           ? static_cast<xvg_format_t>(plotSettings_.plotFormat())
+           : exvgNONE);
+    gmx_output_env_t                              *oenv;
+    output_env_init(&oenv, getProgramContext(), timeUnit, FALSE, xvgFormat, 0);
+    scoped_cptr<gmx_output_env_t, output_env_done> oenvGuard(oenv);
+
+    // Only keep the legend entries for the structures that occur.
+    std::vector<bool> bPresent(eSS_NR, false);
+    for (int f = 0; f < nframes; ++f)
+    {
+        AnalysisDataFrameRef frame = ss_.getDataFrame(f);
+        for (int r = 0; r < nrows; ++r)
+        {
+            bPresent[static_cast<int>(frame.y(r))] = true;
+        }
+    }
+    std::vector<t_mapping> map;
+    std::vector<int>       mapIndex(eSS_NR, -1);
+    for (int s = 0; s < eSS_NR; ++s)
+    {
+        if (bPresent[s])
+        {
+            mapIndex[s] = map.size();
+            map.push_back(c_secondaryStructureMap[s]);
+        }
+    }
+
+    std::vector<real>        axisX(nframes), axisY(nrows);
+    std::vector<t_matelmt>   values(static_cast<size_t>(nframes)*nrows);
+    std::vector<t_matelmt *> columns(nframes);
+    for (int f = 0; f < nframes; ++f)
+    {
+        AnalysisDataFrameRef frame = ss_.getDataFrame(f);
+        axisX[f]   = output_env_conv_time(oenv, frame.x());
+        columns[f] = &values[static_cast<size_t>(f)*nrows];
+        for (int r = 0; r < nrows; ++r)
+        {
+            columns[f][r] = mapIndex[static_cast<int>(frame.y(r))];
+        }
+    }
+    for (int r = 0; r < nrows; ++r)
+    {
+        axisY[r] = r + 1;
+    }
+
+    t_matrix mat;
+    mat.flags     = 0;
+    mat.nx        = nframes;
+    mat.ny        = nrows;
+    mat.y0        = 0;
+    std::sprintf(mat.title, "Secondary structure");
+    mat.legend[0] = 0;
+    std::sprintf(mat.label_x, "%s", output_env_get_time_label(oenv));
+    std::sprintf(mat.label_y, "Residue");
+    mat.bDiscrete = TRUE;
+    mat.axis_x    = nframes > 0 ? &axisX[0] : NULL;
+    mat.axis_y    = &axisY[0];
+    mat.matrix    = nframes > 0 ? &columns[0] : NULL;
+    mat.nmap      = map.size();
+    mat.map       = map.empty() ? NULL : &map[0];
+
+    FILE *fp = gmx_ffopen(fnMatrix_.c_str(), "w");
+    write_xpm_m(fp, mat);
+    gmx_ffclose(fp);
+
+    if (!fnCount_.empty())
+    {
+        writeStructureCounts(fnCount_.c_str(), mat, ssString_.c_str(), oenv);
+    }
+}
+
+//! \}
+
+}       // namespace
+
+const char DsspInfo::name[]             = "dssp";
+const char DsspInfo::shortDescription[] =
+    "Assign secondary structure with the DSSP algorithm";
+
+TrajectoryAnalysisModulePointer DsspInfo::create()
+{
+    return TrajectoryAnalysisModulePointer(new Dssp);
+}
+
+} // namespace analysismodules
+
+} // namespace gmx
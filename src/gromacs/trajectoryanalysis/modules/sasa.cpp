@@ -446,6 +446,7 @@ Sasa::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *settin
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("o").filetype(eftPlot).outputFile().required()
                            .store(&fnArea_).defaultBasename("area")
@@ -393,6 +393,7 @@ Select::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *sett
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("os").filetype(eftPlot).outputFile()
                            .store(&fnSize_).defaultBasename("size")
@@ -62,6 +62,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
@@ -114,6 +115,8 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         bool                        bStartTimeSet_;
         bool                        bEndTimeSet_;
         bool                        bDeltaTimeSet_;
+        //! Number of frames to analyze concurrently (0 = automatic).
+        int                         nthreads_;
 
         bool                        bTrajOpen_;
         //! The current frame, or \p NULL if no frame loaded yet.
@@ -129,7 +132,7 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings *settings)
     : settings_(*settings),
       startTime_(0.0), endTime_(0.0), deltaTime_(0.0),
       bStartTimeSet_(false), bEndTimeSet_(false), bDeltaTimeSet_(false),
-      bTrajOpen_(false), fr(NULL), gpbc_(NULL), status_(NULL), oenv_(NULL)
+      nthreads_(1), bTrajOpen_(false), fr(NULL), gpbc_(NULL), status_(NULL), oenv_(NULL)
 {
 }
 
@@ -336,6 +339,11 @@ TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer *options,
         options->addOption(BooleanOption("pbc").store(&settings.impl_->bPBC)
                                .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt").store(&impl_->nthreads_)
+                               .description("Number of frames to analyze in parallel (0 is guess)"));
+    }
 }
 
 
@@ -361,6 +369,15 @@ TrajectoryAnalysisRunnerCommon::optionsFinished()
     {
         setTimeValue(TDELTA, impl_->deltaTime_);
     }
+
+    if (impl_->nthreads_ < 0)
+    {
+        GMX_THROW(InvalidInputError("Number of threads (-nt) cannot be negative"));
+    }
+    if (impl_->nthreads_ == 0)
+    {
+        impl_->nthreads_ = gmx_omp_get_max_threads();
+    }
 }
 
 
@@ -413,6 +430,18 @@ TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 }
 
 
+int
+TrajectoryAnalysisRunnerCommon::frameThreadCount() const
+{
+    // The module can still clear the flag in optionsFinished().
+    if (!impl_->settings_.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        return 1;
+    }
+    return impl_->nthreads_;
+}
+
+
 const TopologyInformation &
 TrajectoryAnalysisRunnerCommon::topologyInformation() const
 {
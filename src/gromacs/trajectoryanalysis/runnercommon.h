@@ -114,6 +114,13 @@ class TrajectoryAnalysisRunnerCommon
 
         //! Returns true if input data comes from a trajectory.
         bool hasTrajectory() const;
+        /*! \brief
+         * Returns the number of frames to analyze concurrently.
+         *
+         * Always returns one unless the module has specified
+         * TrajectoryAnalysisSettings::efFrameParallel.
+         */
+        int frameThreadCount() const;
         //! Returns the topology information object.
         const TopologyInformation &topologyInformation() const;
         //! Returns the currently loaded frame.
@@ -145,6 +145,22 @@ TEST_F(AngleModuleTest, ComputesVectorTimeZeroAngles)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(AngleModuleTest, ComputesVectorTimeZeroAnglesWithFrameThreads)
+{
+    const char *const cmdline[] = {
+        "angle",
+        "-g1", "vector", "-group1", "resname RV1 RV2 RV3 RV4 and name A1 A2",
+        "-g2", "t0",
+        "-binw", "60"
+    };
+    setTopology("angle.gro");
+    setTrajectory("angle.gro");
+    // -g2 t0 needs the first frame, so the frames should still be
+    // analyzed serially, giving the same data as without -nt.
+    commandLine().addOption("-nt", 2);
+    runTest(CommandLine(cmdline));
+}
+
 TEST_F(AngleModuleTest, ComputesMultipleAngles)
 {
     const char *const cmdline[] = {
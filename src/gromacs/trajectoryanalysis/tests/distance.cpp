@@ -96,4 +96,19 @@ TEST_F(DistanceModuleTest, HandlesDynamicSelections)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(DistanceModuleTest, HandlesFrameParallelAnalysis)
+{
+    const char *const cmdline[] = {
+        "distance",
+        "-select", "atomname S1 S2 and res_cog x < 2.8",
+        "-len", "2", "-binw", "0.5"
+    };
+    setTopology("simple.gro");
+    setTrajectory("simple-frames.gro");
+    // The reference data is from a serial run; -nt is not part of the
+    // checked command line.
+    commandLine().addOption("-nt", 3);
+    runTest(CommandLine(cmdline));
+}
+
 } // namespace
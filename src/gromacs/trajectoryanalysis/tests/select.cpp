@@ -86,6 +86,23 @@ TEST_F(SelectModuleTest, BasicTest)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(SelectModuleTest, HandlesFrameParallelAnalysis)
+{
+    const char *const cmdline[] = {
+        "select",
+        "-select", "y < 2.5", "resname RA"
+    };
+    setTopology("simple.gro");
+    setTrajectory("simple-frames.gro");
+    // The reference data is from a serial run; -nt is not part of the
+    // checked command line.
+    commandLine().addOption("-nt", 3);
+    setOutputFile("-oi", "index.dat", ExactTextMatch());
+    setOutputFile("-on", "index.ndx", ExactTextMatch());
+    excludeDataset("cfrac");
+    runTest(CommandLine(cmdline));
+}
+
 TEST_F(SelectModuleTest, HandlesPDBOutputWithNonPDBInput)
 {
     const char *const cmdline[] = {
@@ -94,6 +94,15 @@ void gmx_omp_set_num_threads(int num_threads)
 #endif
 }
 
+void gmx_omp_set_nested(gmx_bool bNested)
+{
+#ifdef GMX_OPENMP
+    omp_set_nested(bNested);
+#else
+    GMX_UNUSED_VALUE(bNested);
+#endif
+}
+
 gmx_bool gmx_omp_check_thread_affinity(char **message)
 {
     bool shouldSetAffinity = true;
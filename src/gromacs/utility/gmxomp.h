@@ -109,6 +109,13 @@ int gmx_omp_get_thread_num(void);
  */
 void gmx_omp_set_num_threads(int num_threads);
 
+/*! \brief
+ * Enables or disables nested parallel regions for the current task.
+ *
+ * Acts as a wrapper for omp_set_nested().
+ */
+void gmx_omp_set_nested(gmx_bool bNested);
+
 /*! \brief
  * Check for externally set thread affinity to avoid conflicts with \Gromacs
  * internal setting.
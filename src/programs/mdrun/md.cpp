@@ -535,6 +535,12 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, int nfile, const t_filenm fnm[],
         gmx_fatal(FARGS, "The replica exchange period (%d) is not divisible by nstcalclr (%d)", repl_ex_nst, ir->nstcalclr);
     }
 
+    if (fr->bMtsLongRange && repl_ex_nst % ir->mts_level2_factor != 0)
+    {
+        /* We should exchange at multiple time steps to get correct integration */
+        gmx_fatal(FARGS, "The replica exchange period (%d) is not divisible by mts-level2-factor (%d)", repl_ex_nst, ir->mts_level2_factor);
+    }
+
     if (ir->efep != efepNO)
     {
         /* Set free energy calculation frequency as the greatest common
@@ -1057,6 +1063,18 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, int nfile, const t_filenm fnm[],
                 force_flags |= GMX_FORCE_DO_LR;
             }
         }
+        if (fr->bMtsLongRange)
+        {
+            /* The long-range forces are needed at multiple time steps,
+             * but also for energies, virial, dH/dl and force output.
+             */
+            if (do_per_step(step, ir->mts_level2_factor) ||
+                bCalcVir || bCalcEner || bDoFEP || bRerunMD ||
+                do_per_step(step, ir->nstfout))
+            {
+                force_flags |= GMX_FORCE_DO_LR;
+            }
+        }
 
         if (shellfc)
         {
@@ -1437,7 +1455,8 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, int nfile, const t_filenm fnm[],
                 }
                 copy_rvecn(state->x, cbuf, 0, state->natoms);
             }
-            bUpdateDoLR = (fr->bTwinRange && do_per_step(step, ir->nstcalclr));
+            bUpdateDoLR = ((fr->bTwinRange && do_per_step(step, ir->nstcalclr)) ||
+                           (fr->bMtsLongRange && (force_flags & GMX_FORCE_DO_LR)));
 
             update_coords(fplog, step, ir, mdatoms, state, fr->bMolPBC, f,
                           bUpdateDoLR, fr->f_twin, bCalcVir ? &fr->vir_twin_constr : NULL, fcd,
@@ -1450,7 +1469,7 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, int nfile, const t_filenm fnm[],
                                cr, nrnb, wcycle, upd, constr,
                                FALSE, bCalcVir);
 
-            if (bCalcVir && bUpdateDoLR && ir->nstcalclr > 1)
+            if (bCalcVir && bUpdateDoLR && (ir->nstcalclr > 1 || fr->bMtsLongRange))
             {
                 /* Correct the virial for multiple time stepping */
                 m_sub(shake_vir, fr->vir_twin_constr, shake_vir);
@@ -166,6 +166,10 @@ int gmx_mdrun(int argc, char *argv[])
         "even when the simulation is terminated while writing a checkpoint.",
         "With [TT]-cpnum[tt] all checkpoint files are kept and appended",
         "with the step number.",
+        "With [TT]-cptdist[tt] and domain decomposition, each PP rank writes",
+        "the coordinates and velocities of its home atoms directly into the",
+        "checkpoint file, which avoids collecting the full state on the",
+        "master rank at each checkpoint.",
         "A simulation can be continued by reading the full state from file",
         "with option [TT]-cpi[tt]. This option is intelligent in the way that",
         "if no checkpoint file is found, GROMACS just assumes a normal run and",
@@ -304,6 +308,7 @@ int gmx_mdrun(int argc, char *argv[])
     real              cpt_period            = 15.0, max_hours = -1;
     gmx_bool          bTryToAppendFiles     = TRUE;
     gmx_bool          bKeepAndNumCPT        = FALSE;
+    gmx_bool          bDistributedCPT       = FALSE;
     gmx_bool          bResetCountersHalfWay = FALSE;
     gmx_output_env_t *oenv                  = NULL;
 
@@ -385,6 +390,8 @@ int gmx_mdrun(int argc, char *argv[])
           "Checkpoint interval (minutes)" },
         { "-cpnum",   FALSE, etBOOL, {&bKeepAndNumCPT},
           "Keep and number checkpoint files" },
+        { "-cptdist", FALSE, etBOOL, {&bDistributedCPT},
+          "Write the atom data to checkpoint files in parallel from all PP ranks" },
         { "-append",  FALSE, etBOOL, {&bTryToAppendFiles},
           "Append to previous output files when continuing from checkpoint instead of adding the simulation part number to all file names" },
         { "-nsteps",  FALSE, etINT64, {&nsteps},
@@ -511,6 +518,7 @@ int gmx_mdrun(int argc, char *argv[])
     Flags = Flags | (bDoAppendFiles ? MD_APPENDFILES  : 0);
     Flags = Flags | (opt2parg_bSet("-append", asize(pa), pa) ? MD_APPENDFILESSET : 0);
     Flags = Flags | (bKeepAndNumCPT ? MD_KEEPANDNUMCPT : 0);
+    Flags = Flags | (bDistributedCPT ? MD_DISTRIBUTEDCPT : 0);
     Flags = Flags | (bStartFromCpt ? MD_STARTFROMCPT : 0);
     Flags = Flags | (bResetCountersHalfWay ? MD_RESETCOUNTERSHALFWAY : 0);
     Flags = Flags | (opt2parg_bSet("-ntomp", asize(pa), pa) ? MD_NTOMPSET : 0);
@@ -1244,6 +1244,10 @@ int mdrunner(gmx_hw_opt_t *hw_opt,
         /* Set the CPU affinity */
         gmx_set_thread_affinity(fplog, cr, hw_opt, hwinfo);
     }
+    if (fr != NULL)
+    {
+        check_force_tasks_affinity(fplog, fr, cr);
+    }
 
     /* Initiate PME if necessary,
      * either on all nodes or on dedicated PME nodes only. */
@@ -1268,7 +1272,8 @@ int mdrunner(gmx_hw_opt_t *hw_opt,
         {
             status = gmx_pme_init(pmedata, cr, npme_major, npme_minor, inputrec,
                                   mtop ? mtop->natoms : 0, nChargePerturbed, nTypePerturbed,
-                                  (Flags & MD_REPRODUCIBLE), nthreads_pme);
+                                  (Flags & MD_REPRODUCIBLE),
+                                  (fr != NULL && fr->bForceTasks) ? fr->nthread_pme_task : nthreads_pme);
             if (status != 0)
             {
                 gmx_fatal(FARGS, "Error %d initializing PME", status);
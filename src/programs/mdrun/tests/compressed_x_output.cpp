@@ -52,6 +52,7 @@
 #include "testutils/cmdlinetest.h"
 
 #include "moduletest.h"
+#include "runcomparison.h"
 
 namespace
 {
@@ -108,4 +109,33 @@ INSTANTIATE_TEST_CASE_P(WithDifferentMdpOptions, CompressedXOutputTest,
                             "compressed-x-grps = SecondWaterMolecule\n"
                             ));
 
+//! Test fixture for asynchronous writing of the compressed trajectory
+typedef gmx::test::MdrunTestFixture CompressedXAsyncOutputTest;
+
+/* Writing with the xtc writer thread (GMX_XTC_ASYNC) should give
+ * exactly the same file as writing from the master thread. */
+TEST_F(CompressedXAsyncOutputTest, WritesSameFileAsSynchronousOutput)
+{
+    runner_.useStringAsMdpFile("cutoff-scheme = Group\n"
+                               "nsteps = 20\n"
+                               "nstxout-compressed = 2\n");
+    runner_.useTopGroAndNdxFromDatabase("spc2");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    std::string syncFileName = fileManager_.getTemporaryFilePath("sync.xtc");
+    {
+        gmx::test::ScopedEnvironmentVariable sync("GMX_XTC_ASYNC", NULL);
+        runner_.reducedPrecisionTrajectoryFileName_ = syncFileName;
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+    std::string asyncFileName = fileManager_.getTemporaryFilePath("async.xtc");
+    {
+        gmx::test::ScopedEnvironmentVariable async("GMX_XTC_ASYNC", "1");
+        runner_.reducedPrecisionTrajectoryFileName_ = asyncFileName;
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+
+    gmx::test::expectFilesAreIdentical(syncFileName, asyncFileName);
+}
+
 } // namespace
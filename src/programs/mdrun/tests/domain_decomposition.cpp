@@ -43,16 +43,90 @@
 #include "gmxpre.h"
 
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trx.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/smalloc.h"
+
 #include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
 
 #include "moduletest.h"
 
 namespace
 {
 
+//! The state in a trajectory or checkpoint frame that we compare
+struct StateFrame
+{
+    //! The MD step
+    gmx_int64_t       step;
+    //! The box
+    matrix            box;
+    //! The coordinates
+    std::vector<real> x;
+    //! The velocities
+    std::vector<real> v;
+};
+
+//! Reads all frames with coordinates and velocities from \p fileName
+std::vector<StateFrame> readStateFrames(const std::string &fileName)
+{
+    std::vector<StateFrame> frames;
+    gmx_output_env_t       *oenv;
+    t_trxstatus            *status;
+    t_trxframe              fr;
+
+    output_env_init_default(&oenv);
+    if (read_first_frame(oenv, &status, fileName.c_str(), &fr,
+                         TRX_NEED_X | TRX_NEED_V))
+    {
+        do
+        {
+            StateFrame frame;
+            frame.step = fr.step;
+            copy_mat(fr.box, frame.box);
+            frame.x.assign(fr.x[0], fr.x[0] + fr.natoms*DIM);
+            frame.v.assign(fr.v[0], fr.v[0] + fr.natoms*DIM);
+            frames.push_back(frame);
+        }
+        while (read_next_frame(oenv, status, &fr));
+        close_trj(status);
+        sfree(fr.x);
+        sfree(fr.v);
+    }
+    output_env_done(oenv);
+
+    return frames;
+}
+
+//! Expects that two state frames are equal within \p tolerance
+void expectStateFramesAreEqual(const StateFrame                      &reference,
+                               const StateFrame                      &test,
+                               const gmx::test::FloatingPointTolerance &tolerance)
+{
+    EXPECT_EQ(reference.step, test.step);
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int e = 0; e < DIM; e++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.box[d][e], test.box[d][e], tolerance);
+        }
+    }
+    ASSERT_EQ(reference.x.size(), test.x.size());
+    ASSERT_EQ(reference.v.size(), test.v.size());
+    for (size_t i = 0; i < reference.x.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.x[i], test.x[i], tolerance);
+        EXPECT_REAL_EQ_TOL(reference.v[i], test.v[i], tolerance);
+    }
+}
+
 //! Test fixture for domain decomposition special cases
 class DomainDecompositionSpecialCasesTest : public gmx::test::MdrunTestFixture
 {
@@ -74,4 +148,64 @@ TEST_F(DomainDecompositionSpecialCasesTest, AnEmptyDomainWorks)
     ASSERT_EQ(0, runner_.callMdrun());
 }
 
+/*! \brief Ensures that a checkpoint written by all ranks contains
+ * the state of the run and that a run continues from that state */
+TEST_F(DomainDecompositionSpecialCasesTest, DistributedCheckpointCanBeContinued)
+{
+    runner_.useStringAsMdpFile("cutoff-scheme = Verlet\n"
+                               "rcoulomb = 0.7\n"
+                               "rvdw = 0.7\n"
+                               "nsteps = 8\n"
+                               "nstxout = 4\n"
+                               "nstvout = 4\n");
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    // Do an uninterrupted reference run
+    std::string referenceFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    runner_.fullPrecisionTrajectoryFileName_ = referenceFileName;
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    // Do the first half of the run, writing a distributed checkpoint file
+    runner_.cptFileName_                     = fileManager_.getTemporaryFilePath(".cpt");
+    runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+    ::gmx::test::CommandLine firstCaller;
+    firstCaller.append("mdrun");
+    firstCaller.addOption("-cpo", runner_.cptFileName_);
+    firstCaller.append("-cptdist");
+    runner_.nsteps_ = 4;
+    ASSERT_EQ(0, runner_.callMdrun(firstCaller));
+
+    // The trajectory has the state at the last step collected on
+    // the master rank, the checkpoint the state written by all ranks
+    std::vector<StateFrame> written = readStateFrames(runner_.fullPrecisionTrajectoryFileName_);
+    ASSERT_EQ(2U, written.size());
+    std::vector<StateFrame> checkpoint = readStateFrames(runner_.cptFileName_);
+    ASSERT_EQ(1U, checkpoint.size());
+    {
+        SCOPED_TRACE("Checkpoint compared to the trajectory frame at the same step");
+        expectStateFramesAreEqual(written.back(), checkpoint[0], gmx::test::ulpTolerance(0));
+    }
+
+    // Continue mdrun from that checkpoint file to the end of the run
+    ::gmx::test::CommandLine secondCaller;
+    secondCaller.append("mdrun");
+    secondCaller.addOption("-cpi", runner_.cptFileName_);
+    runner_.nsteps_ = -2;
+    ASSERT_EQ(0, runner_.callMdrun(secondCaller));
+
+    // The domain decomposition after the restart changes the order
+    // of the force summation, so the continued run can differ from
+    // the reference run in the last bits.
+    std::vector<StateFrame> reference = readStateFrames(referenceFileName);
+    std::vector<StateFrame> continued = readStateFrames(runner_.fullPrecisionTrajectoryFileName_);
+    ASSERT_EQ(3U, reference.size());
+    ASSERT_EQ(3U, continued.size());
+    {
+        SCOPED_TRACE("Continued run compared to the uninterrupted run");
+        expectStateFramesAreEqual(reference.back(), continued.back(),
+                                  gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4));
+    }
+}
+
 } // namespace
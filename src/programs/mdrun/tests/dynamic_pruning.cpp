@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for dynamic pruning of the Verlet pair list
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "moduletest.h"
+#include "runcomparison.h"
+
+namespace
+{
+
+//! Test fixture for dynamic pruning, with the pruning interval as parameter
+class DynamicPruningTest : public gmx::test::MdrunTestFixture,
+                           public testing::WithParamInterface<const char*>
+{
+};
+
+/* The pruned inner list has a buffer for the pruning interval, so
+ * energies and forces over several pruning intervals should agree with
+ * those of a run without pruning, up to the pairs that the buffer
+ * tolerance allows to be missed. We use PME, since a plain cut-off has
+ * a large force jump at the cut-off for each missed pair. */
+TEST_P(DynamicPruningTest, GivesSameEnergiesAndForcesAsWithoutPruning)
+{
+    runner_.useStringAsMdpFile("cutoff-scheme = Verlet\n"
+                               "coulombtype = PME\n"
+                               "rcoulomb = 0.7\n"
+                               "rvdw = 0.7\n"
+                               "nsteps = 20\n"
+                               "nstlist = 20\n"
+                               "nstcalcenergy = 1\n"
+                               "nstenergy = 4\n"
+                               "nstfout = 4\n"
+                               "tcoupl = berendsen\n"
+                               "tc-grps = System\n"
+                               "tau-t = 0.1\n"
+                               "ref-t = 300\n"
+                               "gen-vel = yes\n"
+                               "gen-temp = 300\n"
+                               "gen-seed = 1993\n");
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    {
+        gmx::test::ScopedEnvironmentVariable disable("GMX_DISABLE_DYNAMICPRUNING", "1");
+        runner_.edrFileName_                     = referenceEdrFileName;
+        runner_.fullPrecisionTrajectoryFileName_ = referenceTrrFileName;
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+
+    {
+        gmx::test::ScopedEnvironmentVariable disable("GMX_DISABLE_DYNAMICPRUNING", NULL);
+        gmx::test::ScopedEnvironmentVariable interval("GMX_NSTLIST_DYNAMICPRUNING", GetParam());
+        runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(".edr");
+        runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+
+    std::vector<std::string> terms;
+    terms.push_back("LJ (SR)");
+    terms.push_back("Coulomb (SR)");
+    terms.push_back("Potential");
+    terms.push_back("Kinetic En.");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-4);
+    gmx::test::expectForcesAreEqual(referenceTrrFileName,
+                                    runner_.fullPrecisionTrajectoryFileName_, 1e-3);
+}
+
+#ifdef __INTEL_COMPILER
+#pragma warning( disable : 177 )
+#endif
+
+INSTANTIATE_TEST_CASE_P(WithDifferentPruningIntervals, DynamicPruningTest,
+                            ::testing::Values("1", "2", "4", "5"));
+
+} // namespace
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for task-based scheduling of the CPU force work
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/textreader.h"
+
+#include "moduletest.h"
+#include "runcomparison.h"
+
+namespace
+{
+
+//! Test fixture for task-based force computation
+class ForceTasksTest : public gmx::test::MdrunTestFixture
+{
+};
+
+/* With GMX_FORCE_TASKS the PME mesh, listed and non-bonded forces are
+ * computed concurrently, with the mesh part on a nested team of PME
+ * threads taken out of the task team. Only the summation order of the forces differs from
+ * a normal run with the same number of threads. */
+TEST_F(ForceTasksTest, GivesSameEnergiesAndForcesAsWithoutTasks)
+{
+    runner_.useStringAsMdpFile("cutoff-scheme = Verlet\n"
+                               "coulombtype = PME\n"
+                               "rcoulomb = 0.9\n"
+                               "rvdw = 0.9\n"
+                               "nsteps = 20\n"
+                               "nstcalcenergy = 1\n"
+                               "nstenergy = 4\n"
+                               "nstfout = 4\n"
+                               "tcoupl = berendsen\n"
+                               "tc-grps = System\n"
+                               "tau-t = 0.1\n"
+                               "ref-t = 300\n"
+                               "gen-vel = yes\n"
+                               "gen-temp = 300\n"
+                               "gen-seed = 1993\n");
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    /* With four threads, two are taken out of the task team for the
+     * nested PME team */
+    runner_.numOpenMPThreads_ = 4;
+
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    {
+        gmx::test::ScopedEnvironmentVariable tasks("GMX_FORCE_TASKS", NULL);
+        runner_.edrFileName_                     = referenceEdrFileName;
+        runner_.fullPrecisionTrajectoryFileName_ = referenceTrrFileName;
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+
+    {
+        gmx::test::ScopedEnvironmentVariable tasks("GMX_FORCE_TASKS", "1");
+        runner_.logFileName_                     = fileManager_.getTemporaryFilePath("tasks.log");
+        runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(".edr");
+        runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+
+#if defined _OPENMP && _OPENMP >= 201307
+    /* Check that the comparison is not against the normal path */
+    std::string log = gmx::TextReader::readFileToString(runner_.logFileName_);
+    EXPECT_NE(std::string::npos, log.find("as concurrent OpenMP tasks"));
+    EXPECT_NE(std::string::npos, log.find("The tasks run on 3 OpenMP threads, the PME mesh task uses a nested team of 2 threads"));
+#endif
+
+    std::vector<std::string> terms;
+    terms.push_back("LJ (SR)");
+    terms.push_back("Coulomb (SR)");
+    terms.push_back("Coul. recip.");
+    terms.push_back("Potential");
+    terms.push_back("Kinetic En.");
+    terms.push_back("Vir-XX");
+    terms.push_back("Vir-YY");
+    terms.push_back("Vir-ZZ");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-4);
+    gmx::test::expectForcesAreEqual(referenceTrrFileName,
+                                    runner_.fullPrecisionTrajectoryFileName_, 1e-4);
+}
+
+} // namespace
@@ -43,6 +43,8 @@
 
 #include "moduletest.h"
 
+#include <algorithm>
+
 #include "config.h"
 
 #include "gromacs/gmxpreprocess/grompp.h"
@@ -106,7 +108,8 @@ SimulationRunner::SimulationRunner(IntegrationTestFixture *fixture) :
     tprFileName_(fixture_->fileManager_.getTemporaryFilePath(".tpr")),
     logFileName_(fixture_->fileManager_.getTemporaryFilePath(".log")),
     edrFileName_(fixture_->fileManager_.getTemporaryFilePath(".edr")),
-    nsteps_(-2)
+    nsteps_(-2),
+    numOpenMPThreads_(0)
 {
 #ifdef GMX_LIB_MPI
     GMX_RELEASE_ASSERT(gmx_mpi_initialized(), "MPI system not initialized for mdrun tests");
@@ -230,11 +233,16 @@ SimulationRunner::callMdrun(const CommandLine &callerRef)
 #endif
 
 #ifdef GMX_THREAD_MPI
-    caller.addOption("-nt", g_numThreads);
+    /* -nt is the total thread count, so it needs to include
+     * the OpenMP threads set by the test.
+     */
+    caller.addOption("-nt", g_numThreads*std::max(numOpenMPThreads_, 1));
+    /* Separate PME ranks require the rank count to be set explicitly. */
+    caller.addOption("-ntmpi", g_numThreads);
 #endif
 
 #ifdef GMX_OPENMP
-    caller.addOption("-ntomp", g_numOpenMPThreads);
+    caller.addOption("-ntomp", numOpenMPThreads_ > 0 ? numOpenMPThreads_ : g_numOpenMPThreads);
 #endif
 
     return gmx_mdrun(caller.argc(), caller.argv());
@@ -129,6 +129,11 @@ class SimulationRunner
         std::string swapFileName_;
         int         nsteps_;
         //@}
+        /*! \brief Number of OpenMP threads per rank for mdrun
+         *
+         * When not positive, the value of the -nt_omp test option is used.
+         */
+        int         numOpenMPThreads_;
 };
 
 /*! \libinternal \brief Declares test fixture base class for
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for multiple time stepping of the PME mesh forces
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "moduletest.h"
+#include "runcomparison.h"
+
+namespace
+{
+
+//! Mdp settings for NVE of SPC water with PME
+const char *g_nveWithPme =
+    "cutoff-scheme = Verlet\n"
+    "coulombtype = PME\n"
+    "rcoulomb = 0.7\n"
+    "rvdw = 0.7\n"
+    "dt = 0.002\n"
+    "gen-vel = yes\n"
+    "gen-temp = 300\n"
+    "gen-seed = 1993\n";
+
+//! Mdp settings for computing the mesh forces every second step
+const char *g_meshEverySecondStep =
+    "mts-level2-forces = longrange-nonbonded\n"
+    "mts-level2-factor = 2\n";
+
+//! Test fixture for multiple time stepping
+typedef gmx::test::MdrunTestFixture MultipleTimeSteppingTest;
+
+/* At steps with energy and force output, the mesh is computed, so the
+ * energies and forces at the first step are those of a run without MTS. */
+TEST_F(MultipleTimeSteppingTest, GivesFullSystemEnergiesAndForcesAtOutputSteps)
+{
+    std::string mdp = std::string(g_nveWithPme) + "nsteps = 0\nnstfout = 1\n";
+
+    runner_.useStringAsMdpFile(mdp);
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    runner_.edrFileName_                     = referenceEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = referenceTrrFileName;
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    runner_.useStringAsMdpFile(mdp + g_meshEverySecondStep);
+    ASSERT_EQ(0, runner_.callGrompp());
+    runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(".edr");
+    runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    std::vector<std::string> terms;
+    terms.push_back("LJ (SR)");
+    terms.push_back("Coulomb (SR)");
+    terms.push_back("Coul. recip.");
+    terms.push_back("Potential");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-5);
+    gmx::test::expectForcesAreEqual(referenceTrrFileName,
+                                    runner_.fullPrecisionTrajectoryFileName_, 1e-5);
+
+    /* The update applies twice the mesh force, the constraint virial of
+     * the extra mesh force is subtracted. What is left differs because
+     * the constraints are not linear, which is about 1 kJ/mol here,
+     * whereas a wrong correction gives differences of about 60 kJ/mol. */
+    std::vector<std::string> virialTerms;
+    virialTerms.push_back("Vir-XX");
+    virialTerms.push_back("Vir-YY");
+    virialTerms.push_back("Vir-ZZ");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         virialTerms, 0.05);
+}
+
+/* With the mesh computed every second step and 2 fs time steps, the
+ * energy should be conserved nearly as well as without MTS. Larger
+ * factors give a much larger drift, due to resonances. */
+TEST_F(MultipleTimeSteppingTest, ConservesEnergy)
+{
+    std::string mdp = (std::string(g_nveWithPme) +
+                       "nsteps = 100\n"
+                       "nstcalcenergy = 2\n"
+                       "nstenergy = 2\n" +
+                       g_meshEverySecondStep);
+
+    runner_.useStringAsMdpFile(mdp);
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    std::vector<real> energy = gmx::test::readEnergyTerm(runner_.edrFileName_, "Total Energy");
+    ASSERT_EQ(51U, energy.size());
+    real              maxDeviation = 0;
+    for (size_t i = 1; i < energy.size(); i++)
+    {
+        maxDeviation = std::max(maxDeviation, std::fabs(energy[i] - energy[0]));
+    }
+    EXPECT_LT(maxDeviation, 2e-3*std::fabs(energy[0]));
+}
+
+} // namespace
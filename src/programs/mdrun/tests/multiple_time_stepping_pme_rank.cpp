@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests for multiple time stepping of the PME mesh forces with a
+ * separate PME rank
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "testutils/cmdlinetest.h"
+
+#include "moduletest.h"
+#include "runcomparison.h"
+
+namespace
+{
+
+//! Mdp settings for NVE of SPC water with PME
+const char *g_nveWithPme =
+    "cutoff-scheme = Verlet\n"
+    "coulombtype = PME\n"
+    "rcoulomb = 0.7\n"
+    "rvdw = 0.7\n"
+    "dt = 0.002\n"
+    "gen-vel = yes\n"
+    "gen-temp = 300\n"
+    "gen-seed = 1993\n";
+
+//! Mdp settings for computing the mesh forces every second step
+const char *g_meshEverySecondStep =
+    "mts-level2-forces = longrange-nonbonded\n"
+    "mts-level2-factor = 2\n";
+
+//! Test fixture for multiple time stepping with a PME rank
+typedef gmx::test::MdrunTestFixture MultipleTimeSteppingPmeRankTest;
+
+/* With a PME-only rank, the PP rank tells the PME rank at which steps
+ * to compute the mesh. At the first step the mesh is computed, so the
+ * energies and forces are those of a run without MTS. */
+TEST_F(MultipleTimeSteppingPmeRankTest, GivesFullSystemEnergiesAndForcesAtFirstStep)
+{
+    std::string mdp = std::string(g_nveWithPme) + "nsteps = 0\nnstfout = 1\n";
+
+    runner_.useStringAsMdpFile(mdp);
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+    ::gmx::test::CommandLine caller;
+    caller.append("mdrun");
+    caller.addOption("-npme", 1);
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    runner_.edrFileName_                     = referenceEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = referenceTrrFileName;
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    runner_.useStringAsMdpFile(mdp + g_meshEverySecondStep);
+    ASSERT_EQ(0, runner_.callGrompp());
+    runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(".edr");
+    runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    std::vector<std::string> terms;
+    terms.push_back("LJ (SR)");
+    terms.push_back("Coulomb (SR)");
+    terms.push_back("Coul. recip.");
+    terms.push_back("Potential");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-5);
+    gmx::test::expectForcesAreEqual(referenceTrrFileName,
+                                    runner_.fullPrecisionTrajectoryFileName_, 1e-5);
+}
+
+/* Over several steps, computing the mesh on a PME-only rank should give
+ * the same MTS trajectory as computing it on the PP ranks. Only the
+ * summation order differs between the two runs. */
+TEST_F(MultipleTimeSteppingPmeRankTest, PmeRankGivesSameResultsAsPpRanks)
+{
+    runner_.useStringAsMdpFile(std::string(g_nveWithPme) +
+                               "nsteps = 10\n"
+                               "nstcalcenergy = 1\n"
+                               "nstenergy = 1\n"
+                               "nstfout = 2\n" +
+                               g_meshEverySecondStep);
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    ::gmx::test::CommandLine referenceCaller;
+    referenceCaller.append("mdrun");
+    referenceCaller.addOption("-npme", 0);
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    runner_.edrFileName_                     = referenceEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = referenceTrrFileName;
+    ASSERT_EQ(0, runner_.callMdrun(referenceCaller));
+
+    ::gmx::test::CommandLine caller;
+    caller.append("mdrun");
+    caller.addOption("-npme", 1);
+    runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(".edr");
+    runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".trr");
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    std::vector<std::string> terms;
+    terms.push_back("Coul. recip.");
+    terms.push_back("Potential");
+    terms.push_back("Kinetic En.");
+    terms.push_back("Total Energy");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-4);
+    gmx::test::expectForcesAreEqual(referenceTrrFileName,
+                                    runner_.fullPrecisionTrajectoryFileName_, 1e-4);
+}
+
+} // namespace
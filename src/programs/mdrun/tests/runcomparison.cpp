@@ -0,0 +1,244 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements helpers for comparing the output of mdrun runs.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include "runcomparison.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/enxio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trx.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! Sets (or with \p value NULL, unsets) an environment variable.
+void setEnvironmentVariable(const char *name, const char *value)
+{
+#ifdef _MSC_VER
+    _putenv_s(name, value != NULL ? value : "");
+#else
+    if (value != NULL)
+    {
+        setenv(name, value, 1);
+    }
+    else
+    {
+        unsetenv(name);
+    }
+#endif
+}
+
+//! Reads the whole contents of a binary file.
+std::string readBinaryFile(const std::string &fileName)
+{
+    std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+    EXPECT_TRUE(in.good()) << "Could not open " << fileName;
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+}
+
+//! Reads the forces in all frames of a trajectory file.
+std::vector<std::vector<real> > readForceFrames(const std::string &fileName)
+{
+    std::vector<std::vector<real> > frames;
+    gmx_output_env_t               *oenv;
+    t_trxstatus                    *status;
+    t_trxframe                      fr;
+
+    output_env_init_default(&oenv);
+    if (read_first_frame(oenv, &status, fileName.c_str(), &fr, TRX_NEED_F))
+    {
+        do
+        {
+            frames.push_back(std::vector<real>(fr.f[0], fr.f[0] + fr.natoms*DIM));
+        }
+        while (read_next_frame(oenv, status, &fr));
+        close_trj(status);
+        sfree(fr.x);
+        sfree(fr.v);
+        sfree(fr.f);
+    }
+    output_env_done(oenv);
+
+    return frames;
+}
+
+//! Returns the largest magnitude of the elements of \p values.
+real maxMagnitude(const std::vector<real> &values)
+{
+    real max = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        max = std::max(max, std::fabs(values[i]));
+    }
+    return max;
+}
+
+}   // namespace
+
+ScopedEnvironmentVariable::ScopedEnvironmentVariable(const char *name,
+                                                     const char *value)
+    : name_(name), bHadValue_(false)
+{
+    const char *oldValue = std::getenv(name);
+    if (oldValue != NULL)
+    {
+        oldValue_  = oldValue;
+        bHadValue_ = true;
+    }
+    setEnvironmentVariable(name, value);
+}
+
+ScopedEnvironmentVariable::~ScopedEnvironmentVariable()
+{
+    setEnvironmentVariable(name_.c_str(), bHadValue_ ? oldValue_.c_str() : NULL);
+}
+
+void expectFilesAreIdentical(const std::string &referenceFileName,
+                             const std::string &testFileName)
+{
+    std::string reference = readBinaryFile(referenceFileName);
+    std::string test      = readBinaryFile(testFileName);
+
+    EXPECT_FALSE(reference.empty()) << referenceFileName << " is empty";
+    EXPECT_EQ(reference.size(), test.size())
+    << testFileName << " differs in size from " << referenceFileName;
+    EXPECT_TRUE(reference == test)
+    << testFileName << " differs from " << referenceFileName;
+}
+
+std::vector<real> readEnergyTerm(const std::string &fileName,
+                                 const std::string &termName)
+{
+    std::vector<real> values;
+    ener_file_t       ef  = open_enx(fileName.c_str(), "r");
+    int               nre = 0;
+    gmx_enxnm_t      *enm = NULL;
+    t_enxframe       *fr;
+
+    do_enxnms(ef, &nre, &enm);
+    int index = -1;
+    for (int i = 0; i < nre; i++)
+    {
+        if (termName == enm[i].name)
+        {
+            index = i;
+        }
+    }
+    EXPECT_NE(-1, index) << "No energy term " << termName << " in " << fileName;
+    snew(fr, 1);
+    while (index >= 0 && do_enx(ef, fr))
+    {
+        values.push_back(fr->ener[index].e);
+    }
+    free_enxframe(fr);
+    sfree(fr);
+    free_enxnms(nre, enm);
+    close_enx(ef);
+
+    return values;
+}
+
+void expectEnergyTermsAreEqual(const std::string              &referenceFileName,
+                               const std::string              &testFileName,
+                               const std::vector<std::string> &termNames,
+                               double                          relativeTolerance)
+{
+    for (size_t t = 0; t < termNames.size(); t++)
+    {
+        SCOPED_TRACE("Comparing energy term " + termNames[t]);
+        std::vector<real> reference = readEnergyTerm(referenceFileName, termNames[t]);
+        std::vector<real> test      = readEnergyTerm(testFileName, termNames[t]);
+        EXPECT_FALSE(reference.empty());
+        ASSERT_EQ(reference.size(), test.size());
+        FloatingPointTolerance tolerance =
+            relativeToleranceAsFloatingPoint(maxMagnitude(reference), relativeTolerance);
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            EXPECT_REAL_EQ_TOL(reference[i], test[i], tolerance) << "In frame " << i;
+        }
+    }
+}
+
+void expectForcesAreEqual(const std::string &referenceFileName,
+                          const std::string &testFileName,
+                          double             relativeTolerance)
+{
+    std::vector<std::vector<real> > reference = readForceFrames(referenceFileName);
+    std::vector<std::vector<real> > test      = readForceFrames(testFileName);
+    EXPECT_FALSE(reference.empty());
+    ASSERT_EQ(reference.size(), test.size());
+    for (size_t frame = 0; frame < reference.size(); frame++)
+    {
+        SCOPED_TRACE(testing::Message() << "Comparing forces in frame " << frame);
+        ASSERT_EQ(reference[frame].size(), test[frame].size());
+        FloatingPointTolerance tolerance =
+            relativeToleranceAsFloatingPoint(maxMagnitude(reference[frame]), relativeTolerance);
+        for (size_t i = 0; i < reference[frame].size(); i++)
+        {
+            EXPECT_REAL_EQ_TOL(reference[frame][i], test[frame][i], tolerance)
+            << "For force component " << i;
+        }
+    }
+}
+
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares helpers for comparing the output of mdrun runs that should
+ * give the same results.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#ifndef GMX_MDRUN_TESTS_RUNCOMPARISON_H
+#define GMX_MDRUN_TESTS_RUNCOMPARISON_H
+
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+/*! \libinternal \brief
+ * Sets an environment variable for the lifetime of the object.
+ *
+ * Many experimental code paths in mdrun are selected with environment
+ * variables. This makes it possible to run mdrun with and without
+ * such a variable in the same test. The previous value is restored
+ * on destruction.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+class ScopedEnvironmentVariable
+{
+    public:
+        //! Sets \p name to \p value.
+        ScopedEnvironmentVariable(const char *name, const char *value);
+        ~ScopedEnvironmentVariable();
+
+    private:
+        std::string name_;
+        std::string oldValue_;
+        bool        bHadValue_;
+};
+
+/*! \brief
+ * Expects that two files have identical contents.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+void expectFilesAreIdentical(const std::string &referenceFileName,
+                             const std::string &testFileName);
+
+/*! \brief
+ * Returns the values of energy term \p termName in all frames of an
+ * energy file.
+ *
+ * Adds a test failure and returns no values when the term is not present.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+std::vector<real> readEnergyTerm(const std::string &fileName,
+                                 const std::string &termName);
+
+/*! \brief
+ * Expects that energy terms agree in all frames of two energy files.
+ *
+ * Each term in \p termNames is compared with a tolerance of
+ * \p relativeTolerance times the largest magnitude of the term in the
+ * reference file.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+void expectEnergyTermsAreEqual(const std::string              &referenceFileName,
+                               const std::string              &testFileName,
+                               const std::vector<std::string> &termNames,
+                               double                          relativeTolerance);
+
+/*! \brief
+ * Expects that the forces agree in all frames of two trr files.
+ *
+ * The force components in each frame are compared with a tolerance of
+ * \p relativeTolerance times the largest force component in the
+ * reference frame.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+void expectForcesAreEqual(const std::string &referenceFileName,
+                          const std::string &testFileName,
+                          double             relativeTolerance);
+
+} // namespace test
+} // namespace gmx
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2015, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests for the flat update kernels with constraints
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/stringutil.h"
+
+#include "moduletest.h"
+#include "runcomparison.h"
+
+namespace
+{
+
+//! Mdp settings for SD of SPC water, with SETTLE constraints
+const char *g_sdWithConstraints =
+    "cutoff-scheme = Verlet\n"
+    "integrator = sd\n"
+    "rcoulomb = 0.7\n"
+    "rvdw = 0.7\n"
+    "nsteps = 20\n"
+    "nstcalcenergy = 1\n"
+    "nstenergy = 1\n"
+    "tc-grps = System\n"
+    "tau-t = 1\n"
+    "ref-t = 300\n"
+    "ld-seed = 1993\n"
+    "gen-vel = yes\n"
+    "gen-temp = 300\n"
+    "gen-seed = 1993\n";
+
+/*! \brief Mdp settings for two freeze groups that are not frozen
+ *
+ * Freeze groups do not change the dynamics here, but make the update
+ * use the general instead of the flat kernels.
+ */
+const char *g_unfrozenFreezeGroups =
+    "freezegrps = FirstHalf SecondHalf\n"
+    "freezedim = N N N N N N\n";
+
+//! Test fixture for the update with constraints
+typedef gmx::test::MdrunTestFixture UpdateWithConstraintsTest;
+
+/* With constraints, the SD integrator updates in two parts, with the
+ * second part of the update done after constraining. Both parts should
+ * give the same trajectory with the flat kernels as with the general ones.
+ */
+TEST_F(UpdateWithConstraintsTest, StochasticDynamicsFlatKernelsMatchGeneralKernels)
+{
+    const int   numAtoms = 648;
+    std::string ndx      = "[ System ]\n";
+    for (int i = 0; i < numAtoms; i++)
+    {
+        ndx += gmx::formatString("%d ", i + 1);
+    }
+    ndx += "\n[ FirstHalf ]\n";
+    for (int i = 0; i < numAtoms; i++)
+    {
+        if (i == numAtoms/2)
+        {
+            ndx += "\n[ SecondHalf ]\n";
+        }
+        ndx += gmx::formatString("%d ", i + 1);
+    }
+    ndx += "\n";
+
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.ndxFileName_ = fileManager_.getTemporaryFilePath("halves.ndx");
+    runner_.useStringAsNdxFile(ndx.c_str());
+    runner_.useStringAsMdpFile(std::string(g_sdWithConstraints) + g_unfrozenFreezeGroups);
+    ASSERT_EQ(0, runner_.callGrompp());
+    std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    runner_.edrFileName_ = referenceEdrFileName;
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    runner_.useStringAsMdpFile(g_sdWithConstraints);
+    ASSERT_EQ(0, runner_.callGrompp());
+    runner_.edrFileName_ = fileManager_.getTemporaryFilePath(".edr");
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    /* The flat kernels can use FMA, which gives differences that grow
+     * slowly over the steps. A wrong second part of the update gives
+     * differences in the kinetic energy of several percent.
+     */
+    std::vector<std::string> terms;
+    terms.push_back("Kinetic En.");
+    terms.push_back("Potential");
+    gmx::test::expectEnergyTermsAreEqual(referenceEdrFileName, runner_.edrFileName_,
+                                         terms, 1e-4);
+}
+
+} // namespace